@@ -0,0 +1,689 @@
+//
+// Created on 16/10/26.
+//
+
+// pfba-bench: emulate a list of drivers without the gui, as fast as possible,
+// and report the emulation speed, the frame time distribution and the time
+// spent in each cpu, heavy draw and sound chip. A line per driver goes to stderr, the full
+// results go to stdout (or -o file) as json; everything the core and the
+// frontend code print is sent to stderr so stdout stays valid json.
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <skeleton/input.h>
+#include "burner.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
+#include "burn_state.h"
+#include "burn_sound.h"
+#include "burn_blit.h"
+#include "m68000_intf.h"
+#include "m68000_debug.h"
+#include "sh2_intf.h"
+#include "pacer.h"
+#include "bench_sound.h"
+#include "bench_cpu.h"
+#include "bench_pacer.h"
+
+#define BENCH_HISTOGRAM_STEP    5       // histogram bucket, in percent of the frame period
+#define BENCH_HISTOGRAM_COUNT   41      // last bucket: 200% and above
+
+// needed by the burn library (see main.cpp)
+char szAppBurnVer[16] = VERSION;
+bool bDoIpsPatch = 0;
+
+void IpsApplyPatches(UINT8 *base, char *rom_name) {}
+
+void Reinitialise() {}
+
+void wav_exit() {}
+
+int bRunPause;
+
+// needed by bzip.cpp (romset verification, unused here)
+class RomList;
+
+RomList *romList = NULL;
+
+// replaces drv.cpp
+int bDrvOkay = 0;
+
+int ProgressUpdateBurner(double dProgress, const TCHAR *pszText, bool bAbs) {
+    return 0;
+}
+
+int AppError(TCHAR *szText, int bWarning) {
+    fprintf(stderr, "%s\n", szText);
+    return 1;
+}
+
+extern UINT8 NeoSystem;
+extern int InpInit();
+extern int InpExit();
+extern void InpDIP();
+extern int InpSet(Input::Player *players);
+extern BURN_THREAD INT32 nSekCount;
+
+struct Options {
+    int frames = 1200;
+    int warmup = 120;
+    bool video = true;
+    bool audio = true;
+    bool prof = true;
+    bool trace = false;
+    int resampler = 0;
+    int kernel = -1;                    // BurnSoundCopy* kernels, -1: the fastest available
+    int depth = 16;                     // 16: rgb565, 32: xrgb8888
+    int m68k = 1;                       // 0: recompiler (M68K_X64_DRC builds), 1: interpreter
+    int sh2 = SH2_CORE_C;               // SH2_CORE_C, SH2_CORE_BLOCK or SH2_CORE_DRC
+    bool idle = true;                   // skip the cpus' idle loops
+    bool state = false;                 // time the in-memory state save / load after the frames
+    bool m68k_check = false;            // run the driver in the interpreter first, the m68k_crc must match
+    bool kernels = false;
+    bool switches = false;
+    bool pacer = false;
+    const char *output = NULL;
+    std::vector<std::string> drivers;
+};
+
+struct Result {
+    std::string driver;
+    std::string name;
+    std::string hardware;
+    const char *error = NULL;
+    double fps = 0;                     // native refresh rate
+    double speed = 0;                   // emulated frames per second
+    double mean = 0;                    // frame time (us)
+    int p50 = 0;
+    int p99 = 0;
+    int max = 0;
+    int frame_bytes = 0;
+    double copy = 0;                    // time to copy a frame to an other buffer, the texture upload (us)
+    UINT32 m68k_crc = 0;                // crc of the first 68000 registers after every frame, 0 without 68000
+    UINT32 sh2_crc = 0;                 // crc of the first SH-2 pc and cycles after every frame, 0 without SH-2
+    UINT32 sound_crc = 0;               // crc of the sound output, the runs of a driver with every -k must match
+    int state = 0;                      // --state: 1 a load gave the same state back, -1 it didn't
+    int m68k_same = 0;                  // --m68k-check: 1 the recompiler gave the interpreter's m68k_crc, -1 it didn't
+    int m68k_blocks = 0;                // 68000 blocks translated, M68K_X64_DRC builds
+    double prof[BURN_PROF_MAX];         // time per frame spent in each profiler scope (us)
+    double idle[BURN_IDLE_MAX];         // cycles per frame skipped in idle loops
+    int histogram[BENCH_HISTOGRAM_COUNT];
+};
+
+// the core's messages, for the benchmarks it has itself (bprintf is a no-op otherwise)
+static INT32 __cdecl BenchPrintf(INT32 /* nStatus */, TCHAR *szFormat, ...) {
+    va_list args;
+    va_start(args, szFormat);
+    int ret = vfprintf(stderr, szFormat, args);
+    va_end(args);
+    return ret;
+}
+
+static INT64 BenchClock() {
+    return Pacer::GetMicros();
+}
+
+static unsigned int HighCol16(int r, int g, int b, int /* i */) {
+    return (unsigned int) (((r << 8) & 0xf800) | ((g << 3) & 0x07e0) | ((b >> 3) & 0x001f));
+}
+
+static unsigned int HighCol32(int r, int g, int b, int /* i */) {
+    return (unsigned int) ((r << 16) | (g << 8) | b);
+}
+
+// crc of the first 68000 registers, the runs of a driver with -m c and -m drc must match
+static UINT32 SekRegistersCrc(UINT32 crc) {
+
+    if (nSekCount < 0) {
+        return crc;
+    }
+
+    UINT32 regs[SEK_REG_SR + 1];
+    SekOpen(0);
+    for (int i = 0; i <= SEK_REG_SR; i++) {
+        regs[i] = SekDbgGetRegister((SekRegister) i);
+    }
+    SekClose();
+
+    return (UINT32) crc32(crc, (const Bytef *) regs, sizeof(regs));
+}
+
+// crc of the first SH-2 pc and cycle count, the same for all the -s cores
+static UINT32 Sh2StateCrc(UINT32 crc) {
+
+    if (!has_sh2) {
+        return crc;
+    }
+
+    UINT32 state[2];
+    Sh2Open(0);
+    state[0] = Sh2GetPC(0);
+    state[1] = (UINT32) Sh2TotalCycles();
+    Sh2Close();
+
+    return (UINT32) crc32(crc, (const Bytef *) state, sizeof(state));
+}
+
+static int FindDriver(const char *name) {
+
+    UINT32 active = nBurnDrvActive;
+
+    for (UINT32 i = 0; i < nBurnDrvCount; i++) {
+        nBurnDrvActive = i;
+        if (strcmp(BurnDrvGetTextA(DRV_NAME), name) == 0) {
+            nBurnDrvActive = active;
+            return (int) i;
+        }
+    }
+
+    nBurnDrvActive = active;
+    return -1;
+}
+
+static void Run(const Options &options, Result *result) {
+
+    int drv = FindDriver(result->driver.c_str());
+    if (drv < 0) {
+        result->error = "unknown driver";
+        return;
+    }
+
+    nBurnDrvActive = nBurnDrvSelect[0] = (UINT32) drv;
+    result->name = BurnDrvGetTextA(DRV_FULLNAME);
+    result->hardware = BurnDrvGetHardwareName();
+
+    // same setup as RunEmulator, minus the nvram so every run starts the same
+    nMaxPlayers = BurnDrvGetMaxPlayers();
+    bForce60Hz = true;
+    nBurnSoundRate = options.audio ? 48000 : 0;
+    nFMInterpolation = options.resampler > 0 ? 4 : 0;
+    nResampleQuality = options.resampler > 0 ? options.resampler - 1 : 0;
+    NeoSystem &= ~(UINT8) 0x1f;
+    NeoSystem |= 0x0f; // UNIBIOS 3.2, the gui default
+
+    InpInit();
+    InpDIP();
+#ifdef M68K_X64_DRC
+    SekUseRecompiler(options.m68k == 0);
+#endif
+    Sh2SetCore(options.sh2);
+    bBurnIdleSkip = options.idle;
+
+    if (BzipOpen(false) != 0) {
+        BzipClose();
+        InpExit();
+        result->error = "missing roms";
+        return;
+    }
+    int ret = BurnDrvInit();
+    BzipClose();
+    if (ret != 0) {
+        InpExit();
+        result->error = "init failed";
+        return;
+    }
+    bDrvOkay = 1;
+
+    int w, h;
+    BurnDrvGetFullSize(&w, &h);
+    nBurnBpp = options.depth == 32 ? 4 : 2;
+    nBurnPitch = w * nBurnBpp;
+    BurnHighCol = options.depth == 32 ? HighCol32 : HighCol16;
+    BurnRecalcPal();
+    result->frame_bytes = nBurnPitch * h;
+    std::vector<UINT8> frame((size_t) result->frame_bytes), upload((size_t) result->frame_bytes);
+    int64_t copy = 0;
+
+    std::vector<INT16> sound;
+    if (nBurnSoundRate > 0) {
+        nBurnSoundLen = (nBurnSoundRate * 100 + nBurnFPS / 2) / nBurnFPS;
+        sound.resize((size_t) nBurnSoundLen * 2);
+        pBurnSoundOut = sound.data();
+    } else {
+        nBurnSoundLen = 0;
+        pBurnSoundOut = NULL;
+    }
+
+    Input::Player players[PLAYER_COUNT];
+    for (int i = 0; i < PLAYER_COUNT; i++) {
+        players[i].state = 0;
+    }
+
+    std::vector<int> times;
+    times.reserve((size_t) options.frames);
+
+    for (int i = 0; i < options.warmup + options.frames; i++) {
+
+        if (i == options.warmup) {
+            BurnIdleReset();
+            if (options.prof) {
+                BurnProfInit(BenchClock, 1000000);
+                if (options.trace) {
+                    BurnProfTraceStart(options.frames * 256);
+                }
+            }
+        }
+
+        int64_t start = Pacer::GetMicros();
+        InpSet(players);
+        pBurnDraw = options.video ? frame.data() : NULL;
+        BurnDrvFrame();
+        if (i >= options.warmup) {
+            times.push_back((int) (Pacer::GetMicros() - start));
+            if (options.video) {
+                start = Pacer::GetMicros();
+                memcpy(upload.data(), frame.data(), frame.size());
+                copy += Pacer::GetMicros() - start;
+            }
+        }
+        result->m68k_crc = SekRegistersCrc(result->m68k_crc);
+        result->sh2_crc = Sh2StateCrc(result->sh2_crc);
+        if (pBurnSoundOut != NULL) {
+            result->sound_crc = (UINT32) crc32(result->sound_crc, (const Bytef *) pBurnSoundOut,
+                                               (uInt) (nBurnSoundLen * 2 * sizeof(INT16)));
+        }
+    }
+
+    if (options.prof && options.trace) {
+        std::string path = result->driver + "_trace.json";
+        BurnProfTraceStop(path.c_str());
+    }
+    pBurnDraw = NULL;
+    pBurnSoundOut = NULL;
+
+    // results
+    int64_t total = 0;
+    for (size_t i = 0; i < times.size(); i++) {
+        total += times[i];
+    }
+    double period = 100000000.0 / nBurnFPS;
+    for (size_t i = 0; i < times.size(); i++) {
+        int bucket = (int) (times[i] * 100 / period) / BENCH_HISTOGRAM_STEP;
+        result->histogram[std::min(bucket, BENCH_HISTOGRAM_COUNT - 1)]++;
+    }
+    std::sort(times.begin(), times.end());
+
+    int count = (int) times.size();
+    result->fps = nBurnFPS / 100.0;
+    result->speed = total > 0 ? count * 1000000.0 / total : 0;
+    result->mean = count > 0 ? (double) total / count : 0;
+    result->p50 = count > 0 ? times[count * 50 / 100] : 0;
+    result->p99 = count > 0 ? times[std::min(count - 1, count * 99 / 100)] : 0;
+    result->max = count > 0 ? times[count - 1] : 0;
+    result->copy = count > 0 ? (double) copy / count : 0;
+    for (int i = 0; i < BURN_PROF_MAX; i++) {
+        result->prof[i] = count > 0 ? (double) nBurnProfTime[i] / count : 0;
+    }
+    BurnProfExit();
+    for (int i = 0; i < BURN_IDLE_MAX; i++) {
+        result->idle[i] = count > 0 ? (double) nBurnIdleCycles[i] / count : 0;
+    }
+
+    if (options.state) {
+        // it prints its own line
+        bprintf = BenchPrintf;
+        result->state = BurnStateMemBench(0) == 0 ? 1 : -1;
+    }
+
+    result->m68k_blocks = SekRecompiledBlocks();
+
+    BurnDrvExit();
+    bDrvOkay = 0;
+    InpExit();
+}
+
+static void PrintResult(const Result &r) {
+
+    if (r.error != NULL) {
+        fprintf(stderr, "%-12s %s\n", r.driver.c_str(), r.error);
+        return;
+    }
+
+    fprintf(stderr, "%-12s %-9s %8.1f fps (%5.0f%%), frame = %.0fus, p50 = %ius, p99 = %ius, max = %ius",
+            r.driver.c_str(), r.hardware.c_str(), r.speed, r.speed * 100 / r.fps, r.mean, r.p50, r.p99, r.max);
+    if (r.copy > 0) {
+        fprintf(stderr, ", copy %ik = %.0fus", r.frame_bytes / 1024, r.copy);
+    }
+    if (r.m68k_crc != 0) {
+        fprintf(stderr, ", m68k crc = %08x", r.m68k_crc);
+    }
+    if (r.sh2_crc != 0) {
+        fprintf(stderr, ", sh2 crc = %08x", r.sh2_crc);
+    }
+    if (r.sound_crc != 0) {
+        fprintf(stderr, ", sound crc = %08x", r.sound_crc);
+    }
+    if (r.m68k_same != 0) {
+        fprintf(stderr, ", m68k %s the interpreter (%i blocks)", r.m68k_same > 0 ? "same as" : "DIFFERS FROM", r.m68k_blocks);
+    }
+
+    double other = r.mean;
+    for (int i = 0; i < BURN_PROF_MAX; i++) {
+        if (r.prof[i] > 0) {
+            fprintf(stderr, ", %s = %.0f%%", szBurnProfName[i], r.prof[i] * 100 / r.mean);
+            other -= r.prof[i];
+        }
+    }
+    if (other < r.mean) {
+        fprintf(stderr, ", other = %.0f%%", other * 100 / r.mean);
+    }
+    for (int i = 0; i < BURN_IDLE_MAX; i++) {
+        if (r.idle[i] > 0) {
+            fprintf(stderr, ", %s idle = %.0f cycles", szBurnIdleName[i], r.idle[i]);
+        }
+    }
+    fprintf(stderr, "\n");
+}
+
+static std::string JsonString(const std::string &s) {
+
+    std::string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = (unsigned char) s[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char) c;
+        } else if (c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        } else {
+            out += (char) c;
+        }
+    }
+    out += "\"";
+
+    return out;
+}
+
+static void WriteJson(FILE *fp, const Options &options, const std::vector<Result> &results) {
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"version\": %s,\n", JsonString(szAppBurnVer).c_str());
+    fprintf(fp, "  \"frames\": %i,\n", options.frames);
+    fprintf(fp, "  \"warmup\": %i,\n", options.warmup);
+    fprintf(fp, "  \"video\": %s,\n", options.video ? "true" : "false");
+    fprintf(fp, "  \"audio\": %s,\n", options.audio ? "true" : "false");
+    fprintf(fp, "  \"resampler\": %i,\n", options.resampler);
+    fprintf(fp, "  \"sound_kernel\": \"%s\",\n", szBurnSoundKernelName[options.kernel]);
+    fprintf(fp, "  \"depth\": %i,\n", options.depth);
+#ifdef M68K_X64_DRC
+    fprintf(fp, "  \"m68k\": \"%s\",\n", options.m68k == 0 ? "drc" : "c");
+#else
+    fprintf(fp, "  \"m68k\": \"c\",\n");
+#endif
+    fprintf(fp, "  \"sh2\": \"%s\",\n", options.sh2 == SH2_CORE_C ? "c" : options.sh2 == SH2_CORE_BLOCK ? "block" : "drc");
+    fprintf(fp, "  \"idle\": %s,\n", options.idle ? "true" : "false");
+    fprintf(fp, "  \"drivers\": [");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(fp, "%s\n    {\"driver\": %s", i > 0 ? "," : "", JsonString(r.driver).c_str());
+        if (r.error != NULL) {
+            fprintf(fp, ", \"error\": %s}", JsonString(r.error).c_str());
+            continue;
+        }
+        fprintf(fp, ", \"name\": %s, \"hardware\": %s,\n", JsonString(r.name).c_str(), JsonString(r.hardware).c_str());
+        fprintf(fp, "     \"fps\": %.2f, \"emulated_fps\": %.1f, \"speed\": %.1f,\n",
+                r.fps, r.speed, r.speed * 100 / r.fps);
+        fprintf(fp, "     \"frame_us\": {\"mean\": %.1f, \"p50\": %i, \"p99\": %i, \"max\": %i},\n",
+                r.mean, r.p50, r.p99, r.max);
+        fprintf(fp, "     \"video\": {\"frame_bytes\": %i, \"mb_per_s\": %.1f, \"copy_us\": %.1f},\n",
+                r.frame_bytes, r.frame_bytes * r.fps / 1000000.0, r.copy);
+        fprintf(fp, "     \"m68k_crc\": \"%08x\",\n", r.m68k_crc);
+        fprintf(fp, "     \"sh2_crc\": \"%08x\",\n", r.sh2_crc);
+        fprintf(fp, "     \"sound_crc\": \"%08x\",\n", r.sound_crc);
+        if (r.state != 0) {
+            fprintf(fp, "     \"state_same\": %s,\n", r.state > 0 ? "true" : "false");
+        }
+        if (r.m68k_same != 0) {
+            fprintf(fp, "     \"m68k_same\": %s, \"m68k_blocks\": %i,\n", r.m68k_same > 0 ? "true" : "false", r.m68k_blocks);
+        }
+        fprintf(fp, "     \"time_us\": {");
+        double other = r.mean;
+        for (int c = 0; c < BURN_PROF_MAX; c++) {
+            if (r.prof[c] > 0) {
+                fprintf(fp, "\"%s\": %.1f, ", szBurnProfName[c], r.prof[c]);
+                other -= r.prof[c];
+            }
+        }
+        fprintf(fp, "\"other\": %.1f},\n", other);
+        fprintf(fp, "     \"idle_cycles\": {");
+        for (int c = 0; c < BURN_IDLE_MAX; c++) {
+            fprintf(fp, "%s\"%s\": %.0f", c > 0 ? ", " : "", szBurnIdleName[c], r.idle[c]);
+        }
+        fprintf(fp, "},\n");
+        fprintf(fp, "     \"histogram\": {\"step_pct\": %i, \"counts\": [", BENCH_HISTOGRAM_STEP);
+        for (int b = 0; b < BENCH_HISTOGRAM_COUNT; b++) {
+            fprintf(fp, "%s%i", b > 0 ? ", " : "", r.histogram[b]);
+        }
+        fprintf(fp, "]}}");
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+static bool ReadList(const char *path, std::vector<std::string> *drivers) {
+
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char name[64];
+        if (line[0] != '#' && sscanf(line, "%63s", name) == 1) {
+            drivers->push_back(name);
+        }
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static void Usage() {
+    fprintf(stderr,
+            "usage: pfba-bench [options] driver [driver...]\n"
+            "  -f frames    frames to measure (1200)\n"
+            "  -w frames    frames to emulate before measuring (120)\n"
+            "  -r path      romset directory, can be repeated (./roms/)\n"
+            "  -l file      read the drivers from file, one per line\n"
+            "  -o file      write the json results to file instead of stdout\n"
+            "  -q level     sound resampler: 0 off for the fm chips (8 taps for pcm), 1-3 band-limited with 8/16/32 taps (0)\n"
+            "  -d depth     frame buffer depth: 16 (rgb565) or 32 (xrgb8888) (16)\n"
+            "  -m core      68000 core: c or drc (x86-64 recompiler builds) (c)\n"
+            "  -s core      SH-2 core: c, block or drc (blocks without the x86-64 recompiler) (c)\n"
+            "  -k kernel    sound copy kernels: c, sse2 or neon (the fastest available)\n"
+            "  --no-video   don't draw the frames\n"
+            "  --no-audio   don't render the audio\n"
+            "  --no-prof    don't time the cpus, draws and sound chips (no timing overhead)\n"
+            "  --no-idle    don't skip the cpus' idle loops\n"
+            "  --trace      write a chrome trace of the measured frames to <driver>_trace.json\n"
+            "  --state      time the in-memory state save and load once the frames are run\n"
+            "  --m68k-check run each driver in the 68000 interpreter first, then in the recompiler:\n"
+            "               the registers after every frame from power on must be the same, and\n"
+            "               some code must have been translated\n"
+            "  --kernels    no driver: check the sound copy and palette blit kernels against the c\n"
+            "               ones and time them, -f sets the calls per kernel (blits: frames / 10)\n"
+            "  --switch     no driver: time the 68000 / z80 open and close and the frame of some\n"
+            "               multi cpu boards run in slices, -f sets the frames (BUILD_MACHINES: also\n"
+            "               on two threads and on a second machine)\n"
+            "  --pacer      no driver: check the audio sync pacer against a simulated audio device\n");
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+    int paths = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool more = i + 1 < argc;
+        if (strcmp(arg, "-f") == 0 && more) {
+            options.frames = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "-w") == 0 && more) {
+            options.warmup = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(arg, "-r") == 0 && more) {
+            if (paths < DIRS_MAX) {
+                snprintf(szAppRomPaths[paths], MAX_PATH, "%s", argv[++i]);
+                size_t len = strlen(szAppRomPaths[paths]);
+                if (len > 0 && len < MAX_PATH - 1 && szAppRomPaths[paths][len - 1] != '/') {
+                    strcat(szAppRomPaths[paths], "/");
+                }
+                paths++;
+            } else {
+                i++;
+            }
+        } else if (strcmp(arg, "-l") == 0 && more) {
+            if (!ReadList(argv[++i], &options.drivers)) {
+                fprintf(stderr, "could not read %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(arg, "-o") == 0 && more) {
+            options.output = argv[++i];
+        } else if (strcmp(arg, "-q") == 0 && more) {
+            options.resampler = std::min(3, std::max(0, atoi(argv[++i])));
+        } else if (strcmp(arg, "-d") == 0 && more) {
+            options.depth = atoi(argv[++i]) == 32 ? 32 : 16;
+        } else if (strcmp(arg, "-m") == 0 && more) {
+            options.m68k = strcmp(argv[++i], "drc") == 0 ? 0 : 1;
+        } else if (strcmp(arg, "-s") == 0 && more) {
+            const char *core = argv[++i];
+            options.sh2 = strcmp(core, "c") == 0 ? SH2_CORE_C : strcmp(core, "block") == 0 ? SH2_CORE_BLOCK : SH2_CORE_DRC;
+        } else if (strcmp(arg, "-k") == 0 && more) {
+            const char *name = argv[++i];
+            options.kernel = BURN_SOUND_KERNEL_MAX;
+            for (int k = 0; k < BURN_SOUND_KERNEL_MAX; k++) {
+                if (strcmp(name, szBurnSoundKernelName[k]) == 0 && BurnSoundKernelAvailable(k)) {
+                    options.kernel = k;
+                }
+            }
+            if (options.kernel == BURN_SOUND_KERNEL_MAX) {
+                fprintf(stderr, "sound kernel %s is not available\n", name);
+                return 1;
+            }
+        } else if (strcmp(arg, "--kernels") == 0) {
+            options.kernels = true;
+        } else if (strcmp(arg, "--switch") == 0) {
+            options.switches = true;
+        } else if (strcmp(arg, "--pacer") == 0) {
+            options.pacer = true;
+        } else if (strcmp(arg, "--no-video") == 0) {
+            options.video = false;
+        } else if (strcmp(arg, "--no-audio") == 0) {
+            options.audio = false;
+        } else if (strcmp(arg, "--no-prof") == 0) {
+            options.prof = false;
+        } else if (strcmp(arg, "--no-idle") == 0) {
+            options.idle = false;
+        } else if (strcmp(arg, "--trace") == 0) {
+            options.trace = true;
+        } else if (strcmp(arg, "--state") == 0) {
+            options.state = true;
+        } else if (strcmp(arg, "--m68k-check") == 0) {
+            options.m68k_check = true;
+        } else if (arg[0] == '-') {
+            Usage();
+            return 1;
+        } else {
+            options.drivers.push_back(arg);
+        }
+    }
+
+    if (options.drivers.empty() && !options.kernels && !options.switches && !options.pacer) {
+        Usage();
+        return 1;
+    }
+    if (paths == 0) {
+        strcpy(szAppRomPaths[0], "./roms/");
+    }
+
+    // keep stdout for the json
+    FILE *fp = NULL;
+    if (options.output != NULL) {
+        fp = fopen(options.output, "w");
+    } else {
+        fflush(stdout);
+        fp = fdopen(dup(STDOUT_FILENO), "w");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    if (fp == NULL) {
+        fprintf(stderr, "could not write %s\n", options.output != NULL ? options.output : "stdout");
+        return 1;
+    }
+
+    if (options.pacer) {
+        int failed = BenchPacer(fp);
+        fclose(fp);
+        return failed > 0 ? 2 : 0;
+    }
+
+    BurnPathsInit();
+    BurnLibInit();
+    options.kernel = BurnSoundKernelInit(options.kernel);
+
+    if (options.kernels) {
+        int failed = BenchSoundKernels(fp, options.frames);
+        // the blitters print their own results, BurnTransferCopy's whole frames are slower
+        bprintf = BenchPrintf;
+        failed += BurnBlitBench(std::max(1, options.frames / 10));
+        BurnLibExit();
+        fclose(fp);
+        return failed > 0 ? 2 : 0;
+    }
+
+    if (options.switches) {
+        SekUseRecompiler(options.m68k == 0);
+        int failed = BenchCpuSwitch(fp, options.frames);
+        BurnLibExit();
+        fclose(fp);
+        return failed > 0 ? 2 : 0;
+    }
+
+    std::vector<Result> results(options.drivers.size());
+    for (size_t i = 0; i < options.drivers.size(); i++) {
+        Result &r = results[i];
+        memset(r.prof, 0, sizeof(r.prof));
+        memset(r.histogram, 0, sizeof(r.histogram));
+        r.driver = options.drivers[i];
+        if (options.m68k_check) {
+            // the interpreter's trace is the reference
+            Options c = options;
+            c.m68k = 1;
+            c.prof = c.trace = c.state = false;
+            Result ref;
+            memset(ref.prof, 0, sizeof(ref.prof));
+            memset(ref.histogram, 0, sizeof(ref.histogram));
+            ref.driver = r.driver;
+            Run(c, &ref);
+            c = options;
+            c.m68k = 0;
+            Run(c, &r);
+            r.m68k_same = ref.error == NULL && ref.m68k_crc == r.m68k_crc && r.m68k_blocks > 0 ? 1 : -1;
+        } else {
+            Run(options, &r);
+        }
+        PrintResult(r);
+    }
+
+    BurnLibExit();
+
+    WriteJson(fp, options, results);
+    fclose(fp);
+
+    int failed = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        failed += results[i].error != NULL || results[i].state < 0 || results[i].m68k_same < 0;
+    }
+
+    return failed > 0 ? 2 : 0;
+}
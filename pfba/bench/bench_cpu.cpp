@@ -0,0 +1,387 @@
+//
+// Created on 17/10/26.
+//
+
+// pfba-bench --switch: what going from one cpu of a board to another costs.
+// The 68000 and Z80 open / close pairs are timed next to the register context
+// copies they used to make, then boards of a few 68000s and Z80s, each counting
+// in its ram, are run for a number of frames three ways: in one slice per cpu,
+// in 256 slices with the open / run / close loop the drivers use, and in 256
+// slices with BurnSchedRun(). The difference to the single slice run is what
+// the interleave costs per frame; the counters must match in the three runs.
+// In BURN_MACHINES builds each board is then run on two threads at once, and
+// on a second machine swapped in while the thread's own one is set up: the
+// counters must match the single slice run there too. These boards are bare
+// cpus, nothing but the per machine modules: two games can't run at once, they
+// share the globals listed in machinesShared.
+
+#include <cstring>
+#include <vector>
+#ifdef BURN_MACHINES
+#include <thread>
+#endif
+
+#include "burner.h"
+#include "burn_idle.h"
+#include "burn_sched.h"
+#include "m68000_intf.h"
+#include "z80_intf.h"
+#include "pacer.h"
+#include "bench_cpu.h"
+
+#define BENCH_CPU_SLICES        256
+#define BENCH_CPU_M68K_MAX      4
+#define BENCH_CPU_Z80_MAX       2
+#define BENCH_CPU_M68K_CYCLES   (10000000 / 60)
+#define BENCH_CPU_Z80_CYCLES    (4000000 / 60)
+#define BENCH_CPU_SWITCHES      1000    // open / close pairs timed per frame asked for
+
+enum {
+    RUN_SINGLE = 0,                     // one slice per cpu
+    RUN_LOOP,                           // the driver loop
+    RUN_SCHED,                          // BurnSchedRun()
+    RUN_MAX
+};
+
+static const char *runNames[RUN_MAX] = {"single", "loop", "sched"};
+
+struct Board {
+    const char *name;
+    int m68k;
+    int z80;
+};
+
+static const Board boards[] = {
+        {"68000+z80", 1, 1},            // cps1
+        {"2x68000+z80", 2, 1},          // taito f2 / b, konami twin 68000
+        {"3x68000+2xz80", 3, 2},
+        {"4x68000", 4, 0}
+};
+
+struct BoardMemory {
+    UINT8 m68kRom[BENCH_CPU_M68K_MAX][0x10000];
+    UINT8 m68kRam[BENCH_CPU_M68K_MAX][0x10000];
+    UINT8 z80Rom[BENCH_CPU_Z80_MAX][0x8000];
+    UINT8 z80Ram[BENCH_CPU_Z80_MAX][0x8000];
+};
+
+// one per machine running a board at the same time
+static BoardMemory memory[2];
+
+static void Init(const Board &b, BoardMemory *m) {
+
+    // at $100, after the reset vectors: addq.w #1,($ff0000).l; bra.s back
+    static const UINT16 m68kCode[] = {0x5279, 0x00ff, 0x0000, 0x60f8};
+    // ld hl,$8000; inc (hl); jr back
+    static const UINT8 z80Code[] = {0x21, 0x00, 0x80, 0x34, 0x18, 0xfd};
+
+    for (int i = 0; i < b.m68k; i++) {
+        UINT16 *rom = (UINT16 *) m->m68kRom[i];
+        memset(m->m68kRom[i], 0, sizeof(m->m68kRom[i]));
+        rom[0] = 0x00ff;
+        rom[1] = 0x8000;
+        rom[2] = 0x0000;
+        rom[3] = 0x0100;
+        memcpy(&rom[0x80], m68kCode, sizeof(m68kCode));
+
+        SekInit(i, 0x68000);
+        SekOpen(i);
+        SekMapMemory(m->m68kRom[i], 0x000000, 0x00ffff, MAP_ROM);
+        SekMapMemory(m->m68kRam[i], 0xff0000, 0xffffff, MAP_RAM);
+        SekClose();
+    }
+
+    for (int i = 0; i < b.z80; i++) {
+        memset(m->z80Rom[i], 0, sizeof(m->z80Rom[i]));
+        memcpy(m->z80Rom[i], z80Code, sizeof(z80Code));
+
+        ZetInit(i);
+        ZetOpen(i);
+        ZetMapMemory(m->z80Rom[i], 0x0000, 0x7fff, MAP_ROM);
+        ZetMapMemory(m->z80Ram[i], 0x8000, 0xffff, MAP_RAM);
+        ZetClose();
+    }
+}
+
+static void Exit(const Board &b) {
+
+    if (b.m68k > 0) {
+        SekExit();
+    }
+    if (b.z80 > 0) {
+        ZetExit();
+    }
+}
+
+static void Reset(const Board &b, BoardMemory *m) {
+
+    for (int i = 0; i < b.m68k; i++) {
+        memset(m->m68kRam[i], 0, sizeof(m->m68kRam[i]));
+        SekOpen(i);
+        SekReset();
+        SekClose();
+    }
+    for (int i = 0; i < b.z80; i++) {
+        memset(m->z80Ram[i], 0, sizeof(m->z80Ram[i]));
+        ZetOpen(i);
+        ZetReset();
+        ZetClose();
+    }
+}
+
+// run the board for frames frames, us per frame, the counters go to state
+static double Run(const Board &b, BoardMemory *m, int frames, int run, std::vector<UINT32> *state) {
+
+    BurnSchedCpu cpus[BENCH_CPU_M68K_MAX + BENCH_CPU_Z80_MAX];
+    int count = 0;
+
+    for (int i = 0; i < b.m68k; i++) {
+        BurnSchedCpu cpu = BURN_SCHED_SEK(i, BENCH_CPU_M68K_CYCLES);
+        cpus[count++] = cpu;
+    }
+    for (int i = 0; i < b.z80; i++) {
+        BurnSchedCpu cpu = BURN_SCHED_ZET(i, BENCH_CPU_Z80_CYCLES);
+        cpus[count++] = cpu;
+    }
+
+    Reset(b, m);
+
+    INT64 start = Pacer::GetMicros();
+
+    for (int f = 0; f < frames; f++) {
+        if (b.m68k > 0) {
+            SekNewFrame();
+        }
+        if (b.z80 > 0) {
+            ZetNewFrame();
+        }
+
+        if (run == RUN_LOOP) {
+            for (int i = 0; i < BENCH_CPU_SLICES; i++) {
+                for (int j = 0; j < b.m68k; j++) {
+                    INT32 next = (INT32) ((INT64) BENCH_CPU_M68K_CYCLES * (i + 1) / BENCH_CPU_SLICES);
+                    SekOpen(j);
+                    if (next > cpus[j].nCyclesDone) {
+                        cpus[j].nCyclesDone += SekRun(next - cpus[j].nCyclesDone);
+                    }
+                    SekClose();
+                }
+                for (int j = 0; j < b.z80; j++) {
+                    BurnSchedCpu *cpu = &cpus[b.m68k + j];
+                    INT32 next = (INT32) ((INT64) BENCH_CPU_Z80_CYCLES * (i + 1) / BENCH_CPU_SLICES);
+                    ZetOpen(j);
+                    if (next > cpu->nCyclesDone) {
+                        cpu->nCyclesDone += ZetRun(next - cpu->nCyclesDone);
+                    }
+                    ZetClose();
+                }
+            }
+            for (int j = 0; j < count; j++) {
+                cpus[j].nCyclesDone -= cpus[j].nCyclesFrame;
+            }
+        } else {
+            BurnSchedRun(cpus, count, run == RUN_SCHED ? BENCH_CPU_SLICES : 1, NULL);
+        }
+    }
+
+    INT64 end = Pacer::GetMicros();
+
+    state->clear();
+    for (int i = 0; i < b.m68k; i++) {
+        state->push_back(*(UINT16 *) m->m68kRam[i]);
+    }
+    for (int i = 0; i < b.z80; i++) {
+        state->push_back(m->z80Ram[i][0]);
+    }
+
+    return (double) (end - start) / frames;
+}
+
+#ifdef BURN_MACHINES
+
+// what BURN_MACHINES doesn't make per machine (src/burn/burn_machine.h)
+static const char *machinesShared[] = {
+        "burn.cpp: nBurnDrvActive, nCurrentFrame, pBurnDraw, nBurnPitch, nBurnBpp, pBurnSoundOut, "
+                "nBurnSoundLen, nBurnSoundRate, nBurnCPUSpeedAdjust, pBurnDrvPalette, BurnAcb",
+        "the drivers' globals and statics (rom / ram pointers, inputs, frame state)",
+        "the sound cores and their resamplers (ym*, msm6295, qsound, ymz280b, burn_sound)",
+        "the devices (eeprom, tc0140syt, ...), palette, cheats, hiscore, gun and led",
+        "Musashi's opcode table, built on the first SekInit()",
+        "the 68000 and SH-2 recompilers, not built",
+};
+
+// the board on the calling thread's machine, from Init() to Exit()
+static void RunThread(const Board *b, BoardMemory *m, int frames, std::vector<UINT32> *state) {
+
+    Init(*b, m);
+    Run(*b, m, frames, RUN_SCHED, state);
+    Exit(*b);
+}
+
+// the board on two threads at once, then on a second machine the thread swaps
+// to between setting its own one up and running it, false if out of memory
+static bool RunMachines(const Board &b, int frames, std::vector<UINT32> threads[2],
+                        std::vector<UINT32> swapped[2]) {
+
+    std::thread thread(RunThread, &b, &memory[1], frames, &threads[1]);
+    RunThread(&b, &memory[0], frames, &threads[0]);
+    thread.join();
+
+    BurnMachine *machine = BurnMachineCreate();
+    if (machine == NULL) {
+        return false;
+    }
+    Init(b, &memory[0]);
+    BurnMachineSwap(machine);
+    RunThread(&b, &memory[1], frames, &swapped[1]);
+    BurnMachineSwap(machine);
+    Run(b, &memory[0], frames, RUN_SCHED, &swapped[0]);
+    Exit(b);
+    BurnMachineDestroy(machine);
+
+    return true;
+}
+
+#endif
+
+// ns per open / close pair of two cpus in turn (copy: the context copies instead)
+static double TimeSek(int iterations, bool copy) {
+
+    std::vector<UINT8> context(m68k_context_size());
+
+    INT64 start = Pacer::GetMicros();
+    if (copy) {
+        SekOpen(0);
+        for (int i = 0; i < iterations; i++) {
+            m68k_get_context(&context[0]);
+            m68k_set_context(&context[0]);
+        }
+        SekClose();
+    } else {
+        for (int i = 0; i < iterations; i++) {
+            SekOpen(i & 1);
+            SekClose();
+        }
+    }
+    INT64 end = Pacer::GetMicros();
+
+    return (double) (end - start) * 1000.0 / iterations;
+}
+
+static double TimeZet(int iterations, bool copy) {
+
+    Z80_Regs context;
+
+    INT64 start = Pacer::GetMicros();
+    if (copy) {
+        ZetOpen(0);
+        for (int i = 0; i < iterations; i++) {
+            Z80GetContext(&context);
+            Z80SetContext(&context);
+        }
+        ZetClose();
+    } else {
+        for (int i = 0; i < iterations; i++) {
+            ZetOpen(i & 1);
+            ZetClose();
+        }
+    }
+    INT64 end = Pacer::GetMicros();
+
+    return (double) (end - start) * 1000.0 / iterations;
+}
+
+int BenchCpuSwitch(FILE *fp, int frames) {
+
+    bool idle = bBurnIdleSkip;
+    bBurnIdleSkip = false;              // the counting loops aren't idle, but don't let it look
+
+    int failed = 0;
+    int iterations = frames * BENCH_CPU_SWITCHES;
+
+    // two of each to switch between
+    Board pair = {"", 2, 2};
+    Init(pair, &memory[0]);
+    Reset(pair, &memory[0]);
+    double sek = TimeSek(iterations, false), sekCopy = TimeSek(iterations, true);
+    double zet = TimeZet(iterations, false), zetCopy = TimeZet(iterations, true);
+    Exit(pair);
+
+    fprintf(stderr, "68000 open / close %.1fns (context copies %.1fns), z80 open / close %.1fns (context copies %.1fns)\n",
+            sek, sekCopy, zet, zetCopy);
+#ifdef BURN_MACHINES
+    fprintf(stderr, "machines: only the cpu interfaces, timers, tiles, memory manager and idle skip are per thread,\n"
+            "the boards below are bare cpus; two games can't run at once, these are shared:\n");
+    for (size_t i = 0; i < sizeof(machinesShared) / sizeof(machinesShared[0]); i++) {
+        fprintf(stderr, "  %s\n", machinesShared[i]);
+    }
+#endif
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"frames\": %i,\n", frames);
+    fprintf(fp, "  \"slices\": %i,\n", BENCH_CPU_SLICES);
+    fprintf(fp, "  \"switch_ns\": {\"m68k\": %.2f, \"m68k_context_copy\": %.2f, \"z80\": %.2f, \"z80_context_copy\": %.2f},\n",
+            sek, sekCopy, zet, zetCopy);
+#ifdef BURN_MACHINES
+    fprintf(fp, "  \"machines\": {\"games_at_once\": false, \"shared\": [");
+    for (size_t i = 0; i < sizeof(machinesShared) / sizeof(machinesShared[0]); i++) {
+        fprintf(fp, "%s\"%s\"", i > 0 ? ", " : "", machinesShared[i]);
+    }
+    fprintf(fp, "]},\n");
+#endif
+    fprintf(fp, "  \"boards\": [");
+
+    for (size_t i = 0; i < sizeof(boards) / sizeof(boards[0]); i++) {
+        const Board &b = boards[i];
+        std::vector<UINT32> state[RUN_MAX];
+        double us[RUN_MAX];
+
+        Init(b, &memory[0]);
+        for (int r = 0; r < RUN_MAX; r++) {
+            us[r] = Run(b, &memory[0], frames, r, &state[r]);
+        }
+        Exit(b);
+
+        bool same = state[RUN_LOOP] == state[RUN_SINGLE] && state[RUN_SCHED] == state[RUN_SINGLE];
+        failed += !same;
+
+#ifdef BURN_MACHINES
+        std::vector<UINT32> threads[2], swapped[2];
+        bool machines = RunMachines(b, frames, threads, swapped);
+        bool threadsSame = machines && threads[0] == state[RUN_SINGLE] && threads[1] == state[RUN_SINGLE];
+        bool swapSame = machines && swapped[0] == state[RUN_SINGLE] && swapped[1] == state[RUN_SINGLE];
+        failed += !threadsSame + !swapSame;
+#endif
+
+        // each cpu is opened and closed once per slice
+        int switches = (b.m68k + b.z80) * BENCH_CPU_SLICES;
+
+        fprintf(stderr, "%-14s %s %.1fus, %i slices: loop +%.1fus, sched +%.1fus (%.1fns per cpu slice)\n",
+                b.name, same ? "frame" : "MISMATCH, frame", us[RUN_SINGLE], BENCH_CPU_SLICES,
+                us[RUN_LOOP] - us[RUN_SINGLE], us[RUN_SCHED] - us[RUN_SINGLE],
+                (us[RUN_SCHED] - us[RUN_SINGLE]) * 1000.0 / switches);
+#ifdef BURN_MACHINES
+        fprintf(stderr, "%-14s machines: 2 threads %s, swapped %s\n",
+                "", threadsSame ? "same" : "MISMATCH", swapSame ? "same" : "MISMATCH");
+#endif
+
+        fprintf(fp, "%s\n    {\"board\": \"%s\", \"m68k\": %i, \"z80\": %i, \"same\": %s, \"frame_us\": {",
+                i > 0 ? "," : "", b.name, b.m68k, b.z80, same ? "true" : "false");
+        for (int r = 0; r < RUN_MAX; r++) {
+            fprintf(fp, "%s\"%s\": %.2f", r > 0 ? ", " : "", runNames[r], us[r]);
+        }
+        fprintf(fp, "}, \"overhead_us\": {\"loop\": %.2f, \"sched\": %.2f}",
+                us[RUN_LOOP] - us[RUN_SINGLE], us[RUN_SCHED] - us[RUN_SINGLE]);
+#ifdef BURN_MACHINES
+        fprintf(fp, ", \"machines\": {\"threads_same\": %s, \"swapped_same\": %s}",
+                threadsSame ? "true" : "false", swapSame ? "true" : "false");
+#endif
+        fprintf(fp, "}");
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+
+    bBurnIdleSkip = idle;
+
+    return failed;
+}
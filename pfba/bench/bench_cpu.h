@@ -0,0 +1,15 @@
+//
+// Created on 17/10/26.
+//
+
+#ifndef _BENCH_CPU_H_
+#define _BENCH_CPU_H_
+
+#include <cstdio>
+
+// time the 68000 and Z80 open / close pairs and the frame of some multi cpu boards
+// run in slices, the results go to fp as json, returns the number of boards whose
+// cpus didn't end up in the same state with every way of running them
+int BenchCpuSwitch(FILE *fp, int frames);
+
+#endif //_BENCH_CPU_H_
@@ -0,0 +1,131 @@
+//
+// Created on 17/10/26.
+//
+
+// pfba-bench --pacer: the pacer in audio sync mode, against an audio device that
+// plays its queue in real time. Frames are "emulated" by spinning for a fixed
+// time and queue a frame of audio each. With a fast emulation the pacer must
+// (nearly) never skip nor let the queue run low at any AUDIO_LATENCY setting,
+// even the ones under a frame; with drawn frames longer than the frame period it
+// must skip some of them, but keep drawing the others.
+
+#include "pacer.h"
+#include "bench_pacer.h"
+
+#define BENCH_PACER_FRAMES      90
+#define BENCH_PACER_FPS         6000    // nBurnFPS
+#define BENCH_PACER_RATE        48000
+
+// the device: plays BENCH_PACER_RATE samples per second of what was queued
+class BenchAudio : public Audio {
+
+public:
+
+    BenchAudio() : Audio(BENCH_PACER_RATE, BENCH_PACER_FPS / 100) {
+        bytes_per_sec = (int64_t) frequency * channels * 2;
+    }
+
+    void Start(int bytes) {
+        start = Pacer::GetMicros();
+        queued = bytes;
+    }
+
+    void Queue(int bytes) {
+        Drain();
+        queued += bytes;
+    }
+
+    int GetBufferedBytes() override {
+        return (int) (Drain() - Played());
+    }
+
+private:
+
+    int64_t Played() {
+        return ((Pacer::GetMicros() - start) * bytes_per_sec) / 1000000;
+    }
+
+    // once starved, the device plays silence: nothing to catch up
+    int64_t Drain() {
+        int64_t played = Played();
+        if (queued < played) {
+            queued = played;
+        }
+        return queued;
+    }
+
+    int64_t bytes_per_sec = 0;
+    int64_t start = 0;
+    int64_t queued = 0;                 // bytes queued since Start(), played ones included
+};
+
+struct PacerCase {
+    int latency;                        // ms, the AUDIO_LATENCY values
+    int draw_us;                        // cost of a drawn frame
+    int skip_us;                        // cost of a skipped frame
+    bool slow;                          // the drawn frames don't fit in the frame period
+};
+
+static const PacerCase cases[] = {
+        {4,  1000,  500,  false},
+        {8,  1000,  500,  false},
+        {16, 1000,  500,  false},
+        {32, 1000,  500,  false},
+        {8,  22000, 4000, true}
+};
+
+static void Spin(int us) {
+    int64_t end = Pacer::GetMicros() + us;
+    while (Pacer::GetMicros() < end);
+}
+
+int BenchPacer(FILE *fp) {
+
+    int failed = 0;
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"frames\": %i,\n", BENCH_PACER_FRAMES);
+    fprintf(fp, "  \"pacer\": [");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const PacerCase &c = cases[i];
+
+        BenchAudio audio;
+        audio.SetSync(true, c.latency);
+
+        Pacer pacer(BENCH_PACER_FPS);
+        pacer.SetAudio(&audio);
+        audio.Start(audio.latency);
+
+        for (int f = 0; f < BENCH_PACER_FRAMES; f++) {
+            bool draw = pacer.Wait(true);
+            pacer.BeginFrame();
+            Spin(draw ? c.draw_us : c.skip_us);
+            pacer.EndFrame();
+            audio.Queue(audio.buffer_size);
+        }
+
+        const Pacer::Stats &stats = pacer.GetStats();
+        bool ok;
+        if (c.slow) {
+            ok = stats.skipped > 0 && stats.skipped <= BENCH_PACER_FRAMES * 2 / 3;
+        } else {
+            // a few frames the host was busy elsewhere
+            ok = stats.skipped <= BENCH_PACER_FRAMES / 20 && stats.underruns <= BENCH_PACER_FRAMES / 20;
+        }
+        failed += !ok;
+
+        fprintf(stderr, "latency %2ims, frames %5ius: %s skipped %u / %i, underruns %u, queued %i bytes (target %i)\n",
+                c.latency, c.draw_us, ok ? "ok," : "FAILED,", stats.skipped, BENCH_PACER_FRAMES,
+                stats.underruns, stats.audio_buffered, audio.latency);
+
+        fprintf(fp, "%s\n    {\"latency_ms\": %i, \"draw_us\": %i, \"skip_us\": %i, \"ok\": %s, "
+                    "\"skipped\": %u, \"underruns\": %u, \"queued\": %i, \"target\": %i}",
+                i > 0 ? "," : "", c.latency, c.draw_us, c.skip_us, ok ? "true" : "false",
+                stats.skipped, stats.underruns, stats.audio_buffered, audio.latency);
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+
+    return failed;
+}
@@ -0,0 +1,16 @@
+//
+// Created on 17/10/26.
+//
+
+#ifndef _BENCH_PACER_H_
+#define _BENCH_PACER_H_
+
+#include <cstdio>
+
+// run the pacer in audio sync mode against a simulated audio device, at every
+// AUDIO_LATENCY setting, the results go to fp as json, returns the number of
+// cases where it skipped or starved the device when it shouldn't (or didn't skip
+// when it should)
+int BenchPacer(FILE *fp);
+
+#endif //_BENCH_PACER_H_
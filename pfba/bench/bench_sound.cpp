@@ -0,0 +1,172 @@
+//
+// Created on 16/10/26.
+//
+
+// pfba-bench --kernels: the simd BurnSoundCopy* kernels must give the same
+// samples as the c ones, checked on random data with saturating values, odd
+// lengths and unaligned buffers, then each set is timed on a frame sized buffer.
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "burner.h"
+#include "burn_sound.h"
+#include "pacer.h"
+#include "bench_sound.h"
+
+#define BENCH_SOUND_LEN     4000        // samples per call, opn buffers are 4096 long
+#define BENCH_SOUND_FUNCS   8
+
+static const char *names[BENCH_SOUND_FUNCS] = {
+        "copy_clamp", "copy_clamp_add", "copy_clamp_mono", "copy_clamp_mono_add",
+        "fm", "fm_add", "fm_opn", "fm_opn_add"
+};
+
+struct SoundBuffers {
+    std::vector<INT32> src;             // stereo 24.8, or mono
+    std::vector<INT16> l, r;
+    std::vector<INT16> opn;             // left, then right at + 4096
+    std::vector<INT32> psg;
+    std::vector<INT16> dest;
+};
+
+static unsigned int seed = 1;
+
+static int Random() {
+    seed = seed * 1103515245 + 12345;
+    return (int) (seed >> 8);
+}
+
+// mostly in range, some samples past 16 bits once scaled so the clamps get used
+static INT32 Random32() {
+    int r = Random();
+    return (r & 7) == 0 ? (INT32) ((r << 4) ^ Random()) : (INT32) ((INT16) Random()) << (r & 1 ? 8 : 9);
+}
+
+static void Fill(SoundBuffers *b) {
+
+    b->src.resize(BENCH_SOUND_LEN * 2 + 8);
+    b->l.resize(BENCH_SOUND_LEN + 8);
+    b->r.resize(BENCH_SOUND_LEN + 8);
+    b->opn.resize(4096 * 2 + 8);
+    b->psg.resize(BENCH_SOUND_LEN + 8);
+    b->dest.resize(BENCH_SOUND_LEN * 2 + 8);
+
+    for (size_t i = 0; i < b->src.size(); i++) b->src[i] = Random32();
+    for (size_t i = 0; i < b->l.size(); i++) b->l[i] = (INT16) Random();
+    for (size_t i = 0; i < b->r.size(); i++) b->r[i] = (INT16) Random();
+    for (size_t i = 0; i < b->opn.size(); i++) b->opn[i] = (INT16) Random();
+    for (size_t i = 0; i < b->psg.size(); i++) b->psg[i] = Random32() >> 6;
+    for (size_t i = 0; i < b->dest.size(); i++) b->dest[i] = (INT16) Random();
+}
+
+// call function f of the current kernel set (or of the c one) on buffers offset by o samples
+static void Call(int f, bool c, SoundBuffers *b, INT16 *dest, int o, int len, INT32 volL, INT32 volR) {
+
+    INT32 *src = &b->src[o];
+    INT16 *l = &b->l[o], *r = &b->r[o], *opn = &b->opn[o];
+    INT32 *psg = &b->psg[o];
+
+    switch (f) {
+        case 0: (c ? BurnSoundCopyClamp_C : BurnSoundCopyClamp)(src, dest, len); break;
+        case 1: (c ? BurnSoundCopyClamp_Add_C : BurnSoundCopyClamp_Add)(src, dest, len); break;
+        case 2: (c ? BurnSoundCopyClamp_Mono_C : BurnSoundCopyClamp_Mono)(src, dest, len); break;
+        case 3: (c ? BurnSoundCopyClamp_Mono_Add_C : BurnSoundCopyClamp_Mono_Add)(src, dest, len); break;
+        case 4: (c ? BurnSoundCopy_FM_C : BurnSoundCopy_FM)(l, r, dest, len, volL, volR); break;
+        case 5: (c ? BurnSoundCopy_FM_Add_C : BurnSoundCopy_FM_Add)(l, r, dest, len, volL, volR); break;
+        case 6: (c ? BurnSoundCopy_FM_OPN_C : BurnSoundCopy_FM_OPN)(opn, psg, dest, len, volL, volR); break;
+        default: (c ? BurnSoundCopy_FM_OPN_Add_C : BurnSoundCopy_FM_OPN_Add)(opn, psg, dest, len, volL, volR); break;
+    }
+}
+
+// returns the first function that doesn't match the c one, -1 if they all do
+static int Check(SoundBuffers *b) {
+
+    static const int lens[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 800, BENCH_SOUND_LEN};
+    static const INT32 vols[][2] = {{0x7fff, 0x7fff}, {0x4000, 0x1000}, {-0x8000, 0x7fff}, {0x12345, -0x23456}, {0, 1}};
+
+    std::vector<INT16> ref(BENCH_SOUND_LEN * 2 + 16), out(BENCH_SOUND_LEN * 2 + 16);
+
+    for (int f = 0; f < BENCH_SOUND_FUNCS; f++) {
+        for (size_t n = 0; n < sizeof(lens) / sizeof(lens[0]); n++) {
+            for (size_t v = 0; v < sizeof(vols) / sizeof(vols[0]); v++) {
+                for (int o = 0; o < 3; o++) {
+                    int len = lens[n] - (lens[n] == BENCH_SOUND_LEN ? o : 0);
+                    // the output is unaligned too, and what is around it must be left alone
+                    memcpy(&ref[0], &b->dest[0], ref.size() * sizeof(INT16));
+                    memcpy(&out[0], &b->dest[0], out.size() * sizeof(INT16));
+                    Call(f, true, b, &ref[o + 1], o, len, vols[v][0], vols[v][1]);
+                    Call(f, false, b, &out[o + 1], o, len, vols[v][0], vols[v][1]);
+                    if (memcmp(&ref[0], &out[0], ref.size() * sizeof(INT16)) != 0) {
+                        return f;
+                    }
+                }
+            }
+        }
+    }
+
+    return -1;
+}
+
+// ns per stereo sample
+static double Time(int f, SoundBuffers *b, int iterations) {
+
+    INT64 start = Pacer::GetMicros();
+    for (int i = 0; i < iterations; i++) {
+        Call(f, false, b, &b->dest[0], 0, BENCH_SOUND_LEN, 0x3000, 0x5000);
+    }
+    INT64 end = Pacer::GetMicros();
+
+    return (double) (end - start) * 1000.0 / ((double) iterations * BENCH_SOUND_LEN);
+}
+
+int BenchSoundKernels(FILE *fp, int iterations) {
+
+    SoundBuffers b;
+    Fill(&b);
+
+    int failed = 0;
+    bool first = true;
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"samples\": %i,\n", BENCH_SOUND_LEN);
+    fprintf(fp, "  \"iterations\": %i,\n", iterations);
+    fprintf(fp, "  \"default\": \"%s\",\n", szBurnSoundKernelName[BurnSoundKernelInit(-1)]);
+    fprintf(fp, "  \"kernels\": [");
+
+    for (int k = 0; k < BURN_SOUND_KERNEL_MAX; k++) {
+        if (!BurnSoundKernelAvailable(k)) {
+            continue;
+        }
+        BurnSoundKernelInit(k);
+
+        int mismatch = Check(&b);
+        failed += mismatch >= 0;
+
+        fprintf(stderr, "%-5s %s", szBurnSoundKernelName[k], mismatch < 0 ? "exact" : "MISMATCH");
+        if (mismatch >= 0) {
+            fprintf(stderr, " (%s)", names[mismatch]);
+        }
+        fprintf(fp, "%s\n    {\"name\": \"%s\", \"exact\": %s", first ? "" : ",",
+                szBurnSoundKernelName[k], mismatch < 0 ? "true" : "false");
+        if (mismatch >= 0) {
+            fprintf(fp, ", \"mismatch\": \"%s\"", names[mismatch]);
+        }
+        fprintf(fp, ", \"ns_per_sample\": {");
+        for (int f = 0; f < BENCH_SOUND_FUNCS; f++) {
+            double ns = Time(f, &b, iterations);
+            fprintf(stderr, ", %s = %.2fns", names[f], ns);
+            fprintf(fp, "%s\"%s\": %.3f", f > 0 ? ", " : "", names[f], ns);
+        }
+        fprintf(stderr, "\n");
+        fprintf(fp, "}}");
+        first = false;
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+
+    BurnSoundKernelInit(-1);
+
+    return failed;
+}
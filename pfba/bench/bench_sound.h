@@ -0,0 +1,14 @@
+//
+// Created on 16/10/26.
+//
+
+#ifndef _BENCH_SOUND_H_
+#define _BENCH_SOUND_H_
+
+#include <cstdio>
+
+// check every available BurnSoundCopy* kernel set against the c one and time them,
+// the results go to fp as json, returns the number of kernels that don't match
+int BenchSoundKernels(FILE *fp, int iterations);
+
+#endif //_BENCH_SOUND_H_
@@ -152,6 +152,18 @@ INT32 BzipExit();
 
 INT32 BzipStatus();
 
+// background romset verification, status cached in <home>/romsets.cache
+#define BZIP_VERIFY_UNKNOWN     (0)
+#define BZIP_VERIFY_OK          (1)
+#define BZIP_VERIFY_BADCRC      (2)
+#define BZIP_VERIFY_INCOMPLETE  (3)
+
+INT32 BzipVerifyStart();
+
+INT32 BzipVerifyStop();
+
+INT32 BzipVerifyGetStatus(UINT32 nDrv);
+
 // paths.cpp
 extern char szAppHomePath[MAX_PATH];
 extern char szAppSavePath[MAX_PATH];
@@ -160,8 +172,10 @@ extern char szAppSamplesPath[MAX_PATH]; // for burn/snd/samples.cpp
 extern char szAppPreviewPath[MAX_PATH];
 extern char szAppTitlePath[MAX_PATH];
 extern char szAppBlendPath[MAX_PATH];
+extern char szAppCachePath[MAX_PATH];
 extern char szAppNvPath[MAX_PATH];
 extern char szAppSkinPath[MAX_PATH];
+extern char szAppRomPaths[DIRS_MAX][MAX_PATH];
 
 void BurnPathsInit();
 
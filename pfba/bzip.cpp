@@ -1,23 +1,35 @@
 // Burner Zip module
 #include <gui/gui.h>
 #include <malloc.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
 #include "burner.h"
 
+#ifndef __3DS__
+#include <SDL2/SDL.h>
+#endif
+
 int nBzipError = 0;												// non-zero if there is a problem with the opened romset
 
 static TCHAR* szBzipName[BZIP_MAX] = { NULL, };					// Zip files to search through
 
-struct RomFind { int nState; int nZip; int nPos; };				// State is non-zero if found. 1 = found totally okay.
+struct RomFind { int nState; int nZip; int nPos; UINT32 nCrc; UINT32 nLen; };	// State is non-zero if found. 1 = found totally okay.
 static struct RomFind* RomFind = NULL;
 static int nRomCount = 0; static int nTotalSize = 0;
 static struct ZipEntry* List = NULL; static int nListCount = 0;	// List of entries for current zip file
 static int nCurrentZip = -1;									// Zip which is currently open
 static int nZipsFound = 0;
 
+static std::unordered_map<UINT32, int> CrcIndex;				// crc -> List entry, for the current zip file
+static std::unordered_map<std::string, int> NameIndex;			// lower case file name -> List entry
+
 StringSet BzipText;												// Text which describes any problems with loading the zip
 StringSet BzipDetail;											// Text which describes in detail any problems with loading the zip
 
-extern Gui *gui;
+extern RomList *romList;
 
 void BzipListFree()
 {
@@ -67,33 +79,47 @@ static TCHAR* GetFilenameW(TCHAR* szFull)
     return szFull;
 }
 
-static int FindRomByName(TCHAR* szName)
+static std::string GetIndexName(const char* szName)
 {
-    struct ZipEntry* pl;
-    int i;
+    std::string name = GetFilenameA((char*)szName);
+    for (size_t i = 0; i < name.size(); i++) {
+        name[i] = (char)tolower((unsigned char)name[i]);
+    }
+    return name;
+}
 
-    // Find the rom named szName in the List
-    for (i = 0, pl = List; i < nListCount; i++, pl++) {
-        TCHAR szCurrentName[MAX_PATH];
-        if (_tcsicmp(szName, GetFilenameW(ANSIToTCHAR(pl->szName, szCurrentName, MAX_PATH))) == 0) {
-            return i;
+// Hash the List entries by crc and name, first entry wins like the old linear search did
+static void BzipIndexList()
+{
+    CrcIndex.clear();
+    NameIndex.clear();
+    CrcIndex.reserve(nListCount);
+    NameIndex.reserve(nListCount);
+
+    for (int i = 0; i < nListCount; i++) {
+        if (List[i].szName == NULL) {							// 7z directory entries
+            continue;
         }
+        CrcIndex.emplace(List[i].nCrc, i);
+        NameIndex.emplace(GetIndexName(List[i].szName), i);
+    }
+}
+
+static int FindRomByName(TCHAR* szName)
+{
+    std::unordered_map<std::string, int>::const_iterator it = NameIndex.find(GetIndexName(TCHARToANSI(szName, NULL, 0)));
+    if (it != NameIndex.end()) {
+        return it->second;
     }
     return -1;													// couldn't find the rom
 }
 
 static int FindRomByCrc(unsigned int nCrc)
 {
-    struct ZipEntry* pl;
-    int i;
-
-    // Find the rom named szName in the List
-    for (i = 0, pl = List; i< nListCount; i++, pl++)	{
-        if (nCrc == pl->nCrc) {
-            return i;
-        }
+    std::unordered_map<UINT32, int>::const_iterator it = CrcIndex.find(nCrc);
+    if (it != CrcIndex.end()) {
+        return it->second;
     }
-
     return -1;													// couldn't find the rom
 }
 
@@ -240,6 +266,362 @@ static int CheckRoms()
     return 0;
 }
 
+// Romset verification: every available set is checked in the background from the
+// archives central directory crcs, and the result cached per set with a signature
+// of the archives mtime/size so that only changed sets are checked again.
+
+struct VerifyEntry { int nStatus; UINT32 nSig; };
+
+// What the worker needs to know about a driver, taken on the gui thread: the burn
+// driver functions go through nBurnDrvActive, so the worker never calls them
+struct VerifyRom { UINT32 nCrc; UINT32 nLen; std::vector<std::string> names; };
+struct VerifyJob { UINT32 nDrv; std::string name; std::vector<std::string> zips; std::vector<VerifyRom> roms; };
+
+static std::unordered_map<std::string, VerifyEntry> VerifyCache;	// set name -> last known status
+static std::atomic<UINT8>* VerifyStatus = NULL;					// per driver BZIP_VERIFY_*
+static std::vector<VerifyJob> VerifyJobs;
+static std::string VerifyPaths[DIRS_MAX];
+static bool bVerifyDirty = false;
+
+#ifndef __3DS__
+static SDL_Thread* VerifyThread = NULL;
+static SDL_mutex* VerifyMutex = NULL;							// guards VerifyCache, BzipOpen updates it too
+static std::atomic<bool> bVerifyStop(false);
+#endif
+
+static void BzipVerifyLock()
+{
+#ifndef __3DS__
+    if (VerifyMutex != NULL) {
+        SDL_LockMutex(VerifyMutex);
+    }
+#endif
+}
+
+static void BzipVerifyUnlock()
+{
+#ifndef __3DS__
+    if (VerifyMutex != NULL) {
+        SDL_UnlockMutex(VerifyMutex);
+    }
+#endif
+}
+
+static std::string GetVerifyCachePath()
+{
+    std::string path = szAppHomePath;
+    path += "romsets.cache";
+    return path;
+}
+
+// Signature of the archives a set is loaded from (same search order as BzipOpen),
+// missing archives count too so adding one changes it
+static UINT32 BzipSignature(const std::vector<std::string>& zips, std::vector<std::string>* pArchives)
+{
+    UINT32 nSig = 2166136261U;
+
+    for (unsigned int z = 0; z < zips.size(); z++) {
+        UINT32 nTime = 0, nSize = 0;
+        for (int d = 0; d < DIRS_MAX; d++) {
+            if (VerifyPaths[d].empty()) {
+                continue;
+            }
+            std::string path = VerifyPaths[d] + zips[z];
+            struct stat st;
+            if (stat((path + ".zip").c_str(), &st) == 0 || stat((path + ".7z").c_str(), &st) == 0) {
+                nTime = (UINT32)st.st_mtime;
+                nSize = (UINT32)st.st_size;
+                if (pArchives) {
+                    pArchives->push_back(path);
+                }
+                break;
+            }
+        }
+        nSig = (nSig ^ nTime) * 16777619U;
+        nSig = (nSig ^ nSize) * 16777619U;
+    }
+
+    return nSig;
+}
+
+// Is this rom needed to call the set complete
+static bool BzipVerifyNeeded(struct BurnRomInfo* pri)
+{
+    return pri->nType && pri->nCrc && (pri->nType & (BRF_OPT | BRF_NODUMP)) == 0;
+}
+
+// Set status from the RomFind states of the currently opened driver
+static int BzipVerifyRomFind()
+{
+    int nStatus = BZIP_VERIFY_OK;
+
+    for (int i = 0; i < nRomCount; i++) {
+        struct BurnRomInfo ri;
+        memset(&ri, 0, sizeof(ri));
+        BurnDrvGetRomInfo(&ri, i);
+        if (!BzipVerifyNeeded(&ri)) {
+            continue;
+        }
+        if (RomFind[i].nState == 0 || RomFind[i].nState == 3) {		// Missing or too small
+            nStatus = BZIP_VERIFY_INCOMPLETE;
+        } else if (RomFind[i].nState != 1 && nStatus == BZIP_VERIFY_OK) {
+            nStatus = BZIP_VERIFY_BADCRC;
+        }
+    }
+
+    return nStatus;
+}
+
+static void BzipVerifySet(UINT32 nDrv, const std::string& name, int nStatus, UINT32 nSig)
+{
+    if (VerifyStatus == NULL || nDrv >= nBurnDrvCount) {
+        return;
+    }
+
+    BzipVerifyLock();
+    VerifyEntry& entry = VerifyCache[name];
+    if (entry.nStatus != nStatus || entry.nSig != nSig) {
+        entry.nStatus = nStatus;
+        entry.nSig = nSig;
+        bVerifyDirty = true;
+    }
+    BzipVerifyUnlock();
+    VerifyStatus[nDrv] = (UINT8)nStatus;
+}
+
+// Take what the worker needs to check driver nDrv (gui thread)
+static void BzipVerifyAddJob(UINT32 nDrv)
+{
+    UINT32 nOldDrv = nBurnDrvActive;
+    nBurnDrvActive = nDrv;
+
+    VerifyJob job;
+    job.nDrv = nDrv;
+    job.name = BurnDrvGetTextA(DRV_NAME);
+
+    for (int z = 0; z < BZIP_MAX; z++) {
+        char* szName = NULL;
+        if (BurnDrvGetZipName(&szName, z)) {
+            break;
+        }
+        job.zips.push_back(szName);
+    }
+
+    for (int i = 0; ; i++) {
+        struct BurnRomInfo ri;
+        memset(&ri, 0, sizeof(ri));
+        if (BurnDrvGetRomInfo(&ri, i)) {
+            break;
+        }
+        if (!BzipVerifyNeeded(&ri)) {
+            continue;
+        }
+
+        VerifyRom rom;
+        rom.nCrc = ri.nCrc;
+        rom.nLen = ri.nLen;
+        for (int nAka = 0; nAka < 0x10000; nAka++) {
+            char* szPossibleName = NULL;
+            if (BurnDrvGetRomName(&szPossibleName, i, nAka)) {
+                break;
+            }
+            rom.names.push_back(GetIndexName(szPossibleName));
+        }
+        job.roms.push_back(rom);
+    }
+
+    nBurnDrvActive = nOldDrv;
+    VerifyJobs.push_back(job);
+}
+
+// Check a driver from its archives central directory, without loading anything
+static void BzipVerifyDriver(const VerifyJob& job)
+{
+    std::vector<std::string> archives;
+    UINT32 nSig = BzipSignature(job.zips, &archives);
+
+    BzipVerifyLock();
+    std::unordered_map<std::string, VerifyEntry>::const_iterator it = VerifyCache.find(job.name);
+    bool bCached = it != VerifyCache.end() && it->second.nSig == nSig;
+    int nCached = bCached ? it->second.nStatus : BZIP_VERIFY_UNKNOWN;
+    BzipVerifyUnlock();
+    if (bCached) {
+        VerifyStatus[job.nDrv] = (UINT8)nCached;
+        return;
+    }
+
+    // crc -> length and name -> (length, crc) of every entry of every archive
+    std::unordered_map<UINT32, UINT32> crcs;
+    std::unordered_map<std::string, std::pair<UINT32, UINT32> > names;
+    for (unsigned int a = 0; a < archives.size(); a++) {
+        struct ZipEntry* pList = NULL;
+        int nCount = 0;
+        if (ZipGetListFile((char*)archives[a].c_str(), &pList, &nCount) == 0) {
+            for (int i = 0; i < nCount; i++) {
+                if (pList[i].szName == NULL) {
+                    continue;
+                }
+                crcs.emplace(pList[i].nCrc, pList[i].nLen);
+                names.emplace(GetIndexName(pList[i].szName), std::make_pair(pList[i].nLen, pList[i].nCrc));
+                free(pList[i].szName);
+            }
+            free(pList);
+        }
+    }
+
+    int nStatus = BZIP_VERIFY_OK;
+    for (unsigned int i = 0; i < job.roms.size(); i++) {
+        const VerifyRom& rom = job.roms[i];
+        UINT32 nLen = 0;
+        bool bFound = false, bCrcOk = false;
+        std::unordered_map<UINT32, UINT32>::const_iterator c = crcs.find(rom.nCrc);
+        if (c != crcs.end()) {
+            nLen = c->second;
+            bFound = bCrcOk = true;
+        } else {
+            for (unsigned int nAka = 0; nAka < rom.names.size() && !bFound; nAka++) {
+                std::unordered_map<std::string, std::pair<UINT32, UINT32> >::const_iterator n = names.find(rom.names[nAka]);
+                if (n != names.end()) {
+                    nLen = n->second.first;
+                    bFound = true;
+                }
+            }
+        }
+
+        if (!bFound || nLen < rom.nLen) {
+            nStatus = BZIP_VERIFY_INCOMPLETE;
+        } else if ((!bCrcOk || nLen != rom.nLen) && nStatus == BZIP_VERIFY_OK) {
+            nStatus = BZIP_VERIFY_BADCRC;
+        }
+    }
+
+    BzipVerifySet(job.nDrv, job.name, nStatus, nSig);
+}
+
+#ifndef __3DS__
+// only uses VerifyJobs, its own zip handles and VerifyCache under VerifyMutex:
+// the gui and a running game keep the burn driver and zip functions to themselves
+static int BzipVerifyThread(void*)
+{
+    for (unsigned int i = 0; i < VerifyJobs.size() && !bVerifyStop; i++) {
+        BzipVerifyDriver(VerifyJobs[i]);
+    }
+
+    return 0;
+}
+#endif
+
+static void BzipVerifyLoadCache()
+{
+    FILE* fp = fopen(GetVerifyCachePath().c_str(), "r");
+    if (fp == NULL) {
+        return;
+    }
+
+    char szName[128];
+    int nStatus;
+    unsigned int nSig;
+    while (fscanf(fp, "%127s %i %u", szName, &nStatus, &nSig) == 3) {
+        if (nStatus > BZIP_VERIFY_UNKNOWN && nStatus <= BZIP_VERIFY_INCOMPLETE) {
+            VerifyEntry entry = { nStatus, nSig };
+            VerifyCache[szName] = entry;
+        }
+    }
+
+    fclose(fp);
+}
+
+static void BzipVerifySaveCache()
+{
+    FILE* fp = fopen(GetVerifyCachePath().c_str(), "w");
+    if (fp == NULL) {
+        return;
+    }
+
+    for (std::unordered_map<std::string, VerifyEntry>::const_iterator it = VerifyCache.begin(); it != VerifyCache.end(); ++it) {
+        fprintf(fp, "%s %i %u\n", it->first.c_str(), it->second.nStatus, it->second.nSig);
+    }
+
+    fclose(fp);
+    bVerifyDirty = false;
+}
+
+int BzipVerifyStart()
+{
+    BzipVerifyStop();
+
+    for (int d = 0; d < DIRS_MAX; d++) {
+        VerifyPaths[d] = szAppRomPaths[d];
+    }
+
+    VerifyStatus = new std::atomic<UINT8>[nBurnDrvCount];
+    for (UINT32 i = 0; i < nBurnDrvCount; i++) {
+        VerifyStatus[i] = BZIP_VERIFY_UNKNOWN;
+    }
+
+    // show the last known status right away, the worker will fix the ones that changed
+    VerifyCache.clear();
+    BzipVerifyLoadCache();
+    for (unsigned int i = 0; i < romList->list.size(); i++) {
+        const RomList::Rom& rom = romList->list[i];
+        std::unordered_map<std::string, VerifyEntry>::const_iterator it = VerifyCache.find(rom.zip);
+        if (rom.state != RomList::RomState::MISSING && it != VerifyCache.end()) {
+            VerifyStatus[rom.drv] = (UINT8)it->second.nStatus;
+        }
+    }
+
+#ifndef __3DS__
+    VerifyJobs.clear();
+    for (unsigned int i = 0; i < romList->list.size(); i++) {
+        if (romList->list[i].state != RomList::RomState::MISSING) {
+            BzipVerifyAddJob(romList->list[i].drv);
+        }
+    }
+
+    bVerifyStop = false;
+    VerifyMutex = SDL_CreateMutex();
+    VerifyThread = SDL_CreateThread(BzipVerifyThread, "pfba_verify", NULL);
+    if (VerifyThread == NULL) {
+        printf("BzipVerifyStart: could not create thread: %s\n", SDL_GetError());
+    }
+#endif
+
+    return 0;
+}
+
+int BzipVerifyStop()
+{
+#ifndef __3DS__
+    if (VerifyThread != NULL) {
+        bVerifyStop = true;
+        SDL_WaitThread(VerifyThread, NULL);
+        VerifyThread = NULL;
+    }
+    VerifyJobs.clear();
+    if (VerifyMutex != NULL) {
+        SDL_DestroyMutex(VerifyMutex);
+        VerifyMutex = NULL;
+    }
+#endif
+
+    if (bVerifyDirty) {
+        BzipVerifySaveCache();
+    }
+
+    delete[] VerifyStatus;
+    VerifyStatus = NULL;
+
+    return 0;
+}
+
+int BzipVerifyGetStatus(UINT32 nDrv)
+{
+    if (VerifyStatus == NULL || nDrv >= nBurnDrvCount) {
+        return BZIP_VERIFY_UNKNOWN;
+    }
+    return VerifyStatus[nDrv];
+}
+
 static int __cdecl BzipBurnLoadRom(unsigned char* Dest, int* pnWrote, int i)
 {
 #if defined (BUILD_WIN32)
@@ -323,6 +705,19 @@ static int __cdecl BzipBurnLoadRom(unsigned char* Dest, int* pnWrote, int i)
     return 0;
 }
 
+// the crc and length of the file rom i is loaded from, as the archive has them
+static int __cdecl BzipBurnRomCrc(UINT32* pnCrc, UINT32* pnLen, int i)
+{
+    if (i < 0 || i >= nRomCount || RomFind[i].nState == 0) {
+        return 1;
+    }
+
+    *pnCrc = RomFind[i].nCrc;
+    *pnLen = RomFind[i].nLen;
+
+    return 0;
+}
+
 int BzipOpen(bool bootApp)
 {
     int nMemLen;											// Zip name number
@@ -359,18 +754,20 @@ int BzipOpen(bool bootApp)
     }
     memset(RomFind, 0, nMemLen);
 
+    std::vector<std::string> zips;
     for (int z = 0; z < BZIP_MAX; z++) {
         char* szName = NULL;
 
         if (BurnDrvGetZipName(&szName, z)) {
             break;
         }
+        zips.push_back(szName);
 
         for (int d = 0; d < DIRS_MAX; d++) {
             free(szBzipName[z]);
             szBzipName[z] = (TCHAR*)malloc(MAX_PATH * sizeof(TCHAR));
 
-            _stprintf(szBzipName[z], _T("%s%s"), gui->GetConfig()->GetRomPath(d), szName);
+            _stprintf(szBzipName[z], _T("%s%s"), szAppRomPaths[d], szName);
 
             if (ZipOpen(TCHARToANSI(szBzipName[z], NULL, 0)) == 0) {	// Open the rom zip file
                 nZipsFound++;
@@ -384,6 +781,7 @@ int BzipOpen(bool bootApp)
                 BzipText.Add(_T("Found %s;\n"), szBzipName[z]);
             }
             ZipGetList(&List, &nListCount);						// Get the list of entries
+            BzipIndexList();
 
             for (int i = 0; i < nRomCount; i++) {
                 struct BurnRomInfo ri;
@@ -413,6 +811,8 @@ int BzipOpen(bool bootApp)
                 RomFind[i].nZip = z;							// Remember which zip file it is in
                 RomFind[i].nPos = nFind;
                 RomFind[i].nState = 1;							// Set to found okay
+                RomFind[i].nCrc = List[nFind].nCrc;				// What the file really is
+                RomFind[i].nLen = List[nFind].nLen;
 
                 BurnDrvGetRomInfo(&ri, i);						// Get info about the rom
 
@@ -452,6 +852,8 @@ int BzipOpen(bool bootApp)
             }
 
             BzipListFree();
+            CrcIndex.clear();
+            NameIndex.clear();
 
         } else {
             if (!bootApp) {
@@ -463,6 +865,9 @@ int BzipOpen(bool bootApp)
         nCurrentZip = -1;
     }
 
+    // we know this set status now, remember it for the rom list
+    BzipVerifySet(nBurnDrvActive, BurnDrvGetTextA(DRV_NAME), BzipVerifyRomFind(), BzipSignature(zips, NULL));
+
     if (!bootApp) {
         // Check the roms to see if they code, graphics etc are complete
         CheckRoms();
@@ -511,6 +916,7 @@ int BzipOpen(bool bootApp)
         }
 
         BurnExtLoadRom = BzipBurnLoadRom;						// Okay to call our function to load each rom
+        BurnExtRomCrc = BzipBurnRomCrc;
 
     } else {
         return CheckRomsBoot();
@@ -525,6 +931,7 @@ int BzipClose()
     nCurrentZip = -1;											// Close the last zip file if open
 
     BurnExtLoadRom = NULL;										// Can't call our function to load each rom anymore
+    BurnExtRomCrc = NULL;
     nBzipError = 0;												// reset romset errors
 
     free(RomFind);
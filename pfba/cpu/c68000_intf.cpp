@@ -2,6 +2,8 @@
 #include "burnint.h"
 #include "m68000_intf.h"
 #include "m68000_debug.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
 
 #ifdef __PSP2_DEBUG__
 #include <psp2/kernel/clib.h>
@@ -15,23 +17,23 @@
 INT32 nSekCpuCore = SEK_CORE_C68K;  // 0 - c68k, 1 - m68k
 
 #ifdef EMU_M68K
-INT32 nSekM68KContextSize[SEK_MAX];
-INT8* SekM68KContext[SEK_MAX];
+BURN_THREAD INT32 nSekM68KContextSize[SEK_MAX];
+BURN_THREAD INT8* SekM68KContext[SEK_MAX];
 #endif
 
 #ifdef EMU_C68K
 #include "Cyclone.h"
-struct Cyclone c68k[SEK_MAX];
+BURN_THREAD struct Cyclone c68k[SEK_MAX];
 static bool bCycloneInited = false;
 #endif
 
-INT32 nSekCount = -1;							// Number of allocated 68000s
-struct SekExt *SekExt[SEK_MAX] = { NULL, }, *pSekExt = NULL;
+BURN_THREAD INT32 nSekCount = -1;				// Number of allocated 68000s
+BURN_THREAD struct SekExt *SekExt[SEK_MAX] = { NULL, }, *pSekExt = NULL;
 
-INT32 nSekActive = -1;								// The cpu which is currently being emulated
-INT32 nSekCyclesTotal, nSekCyclesScanline, nSekCyclesSegment, nSekCyclesDone, nSekCyclesToDo;
+BURN_THREAD INT32 nSekActive = -1;					// The cpu which is currently being emulated
+BURN_THREAD INT32 nSekCyclesTotal, nSekCyclesScanline, nSekCyclesSegment, nSekCyclesDone, nSekCyclesToDo;
 
-INT32 nSekCPUType[SEK_MAX], nSekCycles[SEK_MAX], nSekIRQPending[SEK_MAX];
+BURN_THREAD INT32 nSekCPUType[SEK_MAX], nSekCycles[SEK_MAX], nSekIRQPending[SEK_MAX];
 
 // ----------------------------------------------------------------------------
 // Default memory access handlers
@@ -554,6 +556,17 @@ static INT32 SekInitCPUM68K(INT32 nCount, INT32 nCPUType)
 	printf("EMU_M68K: SekInitCPUM68K(%i, %x)\n", nCount, nCPUType);
 	nSekCPUType[nCount] = nCPUType;
 
+	// the core runs on the context in place, SekOpen() only points it there
+	nSekM68KContextSize[nCount] = m68k_context_size();
+	SekM68KContext[nCount] = (INT8*)malloc(nSekM68KContextSize[nCount]);
+	if (SekM68KContext[nCount] == NULL) {
+		return 1;
+	}
+	memset(SekM68KContext[nCount], 0, nSekM68KContextSize[nCount]);
+	m68k_set_context_ptr(SekM68KContext[nCount]);
+
+	m68k_init();
+
 	switch (nCPUType) {
 		case 0x68000:
 			m68k_set_cpu_type(M68K_CPU_TYPE_68000);
@@ -568,14 +581,6 @@ static INT32 SekInitCPUM68K(INT32 nCount, INT32 nCPUType)
 			return 1;
 	}
 
-	nSekM68KContextSize[nCount] = m68k_context_size();
-	SekM68KContext[nCount] = (INT8*)malloc(nSekM68KContextSize[nCount]);
-	if (SekM68KContext[nCount] == NULL) {
-		return 1;
-	}
-	memset(SekM68KContext[nCount], 0, nSekM68KContextSize[nCount]);
-	m68k_get_context(SekM68KContext[nCount]);
-
 	return 0;
 }
 #endif
@@ -608,6 +613,60 @@ static UINT8 SekCheatRead(UINT32 a)
 	return SekReadByte(a);
 }
 
+static UINT8 *SekIdleFetch(UINT32 a)
+{
+	a &= 0xFFFFFF;
+
+	UINT8* pr = FIND_F(a);
+	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
+		return pr;
+	}
+	return NULL;
+}
+
+static UINT8 *SekIdleRead(UINT32 a)
+{
+	a &= 0xFFFFFF;
+
+	UINT8* pr = FIND_R(a);
+	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
+		return pr;
+	}
+	return NULL;
+}
+
+static UINT32 SekIdleReg(INT32 n)
+{
+#ifdef EMU_C68K
+	if ((nSekCpuCore == SEK_CORE_C68K) && nSekCPUType[nSekActive] == 0x68000) {
+		return (n < 8) ? c68k[nSekActive].d[n] : c68k[nSekActive].a[n - 8];
+	}
+#endif
+
+#ifdef EMU_M68K
+	return m68k_get_reg(NULL, (m68k_register_t)(M68K_REG_D0 + n));
+#else
+	return 0;
+#endif
+}
+
+static UINT32 SekIdlePC()
+{
+	return SekGetPC(-1);
+}
+
+static BurnIdleCpu SekIdleCpu =
+{
+	BURN_IDLE_M68K,
+	SekIdleFetch,
+	SekIdleRead,
+	SEK_PAGE_SIZE,
+	1,		// pages are word swapped
+	SekIdleReg,
+	SekIdlePC,
+	SekIdle
+};
+
 static cpu_core_config SekCheatCpuConfig =
 {
 	SekOpen,
@@ -736,9 +795,6 @@ INT32 SekInit(INT32 nCount, INT32 nCPUType)
 	}
 #endif
 
-	// Map the normal memory handlers
-	SekDbgDisableBreakpoints();
-
 #ifdef EMU_C68K
 	if ((nSekCpuCore == SEK_CORE_C68K) && nCPUType == 0x68000) {
 		if (SekInitCPUC68K(nCount, nCPUType)) {
@@ -749,7 +805,6 @@ INT32 SekInit(INT32 nCount, INT32 nCPUType)
 #endif
 
 #ifdef EMU_M68K
-        m68k_init();
 		if (SekInitCPUM68K(nCount, nCPUType)) {
 			SekExit();
 			return 1;
@@ -760,6 +815,9 @@ INT32 SekInit(INT32 nCount, INT32 nCPUType)
 	}
 #endif
 
+	// Map the normal memory handlers (after the init, the hook is in the new cpu's context)
+	SekDbgDisableBreakpoints();
+
 	nSekCycles[nCount] = 0;
 	nSekIRQPending[nCount] = 0;
 
@@ -804,6 +862,10 @@ INT32 SekExit()
 
 	pSekExt = NULL;
 
+#ifdef EMU_M68K
+	m68k_set_context_ptr(NULL);
+#endif
+
 	nSekActive = -1;
 	nSekCount = -1;
 
@@ -812,6 +874,31 @@ INT32 SekExit()
 	return 0;
 }
 
+// the interface state of a machine (burn_machine.h), the registers of an open Musashi cpu aren't part of it
+void SekMachineAreas(BurnMachineAreaCallback pArea)
+{
+#ifdef EMU_M68K
+	BURN_MACHINE_AREA(nSekM68KContextSize);
+	BURN_MACHINE_AREA(SekM68KContext);
+#endif
+#ifdef EMU_C68K
+	BURN_MACHINE_AREA(c68k);
+#endif
+	BURN_MACHINE_AREA(nSekCount);
+	BURN_MACHINE_AREA(SekExt);
+	BURN_MACHINE_AREA(pSekExt);
+	BURN_MACHINE_AREA(nSekActive);
+	BURN_MACHINE_AREA(nSekCyclesTotal);
+	BURN_MACHINE_AREA(nSekCyclesScanline);
+	BURN_MACHINE_AREA(nSekCyclesSegment);
+	BURN_MACHINE_AREA(nSekCyclesDone);
+	BURN_MACHINE_AREA(nSekCyclesToDo);
+	BURN_MACHINE_AREA(nSekCPUType);
+	BURN_MACHINE_AREA(nSekCycles);
+	BURN_MACHINE_AREA(nSekIRQPending);
+	BURN_MACHINE_AREA(DebugCPU_SekInitted);
+}
+
 void SekReset()
 {
 #ifdef EMU_C68K
@@ -855,7 +942,7 @@ void SekOpen(const INT32 i)
 #endif
 
 #ifdef EMU_M68K
-			m68k_set_context(SekM68KContext[nSekActive]);
+			m68k_set_context_ptr(SekM68KContext[nSekActive]);
 #endif
 
 #ifdef EMU_C68K
@@ -869,19 +956,7 @@ void SekOpen(const INT32 i)
 // Close the active cpu
 void SekClose()
 {
-#ifdef EMU_C68K
-	if ((nSekCpuCore == SEK_CORE_C68K) && nSekCPUType[nSekActive] == 0x68000) {
-		//...
-	} else {
-#endif
-
-#ifdef EMU_M68K
-		m68k_get_context(SekM68KContext[nSekActive]);
-#endif
-
-#ifdef EMU_C68K
-	}
-#endif
+	// Cyclone and Musashi ran on the cpu's context itself, there's nothing to copy back
 
 	nSekCycles[nSekActive] = nSekCyclesTotal;
 
@@ -1007,8 +1082,7 @@ void SekRunEnd()
 
 }
 
-// Run the active CPU
-INT32 SekRun(const INT32 nCycles)
+static INT32 SekRunSlice(INT32 nCycles)
 {
 #ifdef EMU_C68K
 	if ((nSekCpuCore == SEK_CORE_C68K) && nSekCPUType[nSekActive] == 0x68000) {
@@ -1051,13 +1125,23 @@ INT32 SekRun(const INT32 nCycles)
 
 }
 
+// Run the active CPU
+INT32 SekRun(const INT32 nCycles)
+{
+	BURN_PROF_SCOPE(BURN_PROF_M68K);
+
+	return BurnIdleRun(&SekIdleCpu, SekRunSlice, nCycles);
+}
+
 // ----------------------------------------------------------------------------
 // Breakpoint support
 
 void SekDbgDisableBreakpoints()
 {
 #if defined FBA_DEBUG && defined EMU_M68K
-		m68k_set_instr_hook_callback(NULL);
+		if (m68k_get_context_ptr()) {				// NULL before the first Musashi cpu
+			m68k_set_instr_hook_callback(NULL);
+		}
 
 		M68KReadByteDebug = M68KReadByte;
 		M68KReadWordDebug = M68KReadWord;
@@ -1131,6 +1215,12 @@ INT32 SekMapHandler(uintptr_t nHandler, UINT32 nStart, UINT32 nEnd, INT32 nType)
 	return 0;
 }
 
+// no recompiler here, Cyclone is already native code
+INT32 SekUseRecompiler(bool)
+{
+	return 0;
+}
+
 // Set callbacks
 INT32 SekSetResetCallback(pSekResetCallback pCallback)
 {
@@ -61,7 +61,8 @@ void CTRRenderer::DrawFont(Font *font, int x, int y, const char *fmt, ...) {
 /////////////
 // TEXTURE //
 /////////////
-Texture *CTRRenderer::CreateTexture(int w, int h) {
+// rgb565 only, the tiling transfer and the memory are sized for it
+Texture *CTRRenderer::CreateTexture(int w, int h, int format) {
     CTRTexture *texture = new CTRTexture(w, h);
     if (texture->tex == NULL) {
         delete (texture);
@@ -86,9 +87,12 @@ void CTRRenderer::DrawTexture(Texture *texture, int x, int y, int w, int h, floa
 
     if (sf2d_tex) {
 
-        // tile buffer for 3ds...
-        if (ctr_tex->pixels) {
+        // tile buffer for 3ds, only if we got a new frame since last time
+        if (ctr_tex->pixels && ctr_tex->dirty) {
+            texture->UploadBegin();
             ctr_tex->Tile();
+            texture->UploadEnd();
+            ctr_tex->dirty = false;
         }
 
         StartDrawing();
@@ -126,6 +130,10 @@ int CTRRenderer::LockTexture(Texture *texture, const Rect &rect, void **pixels,
     return 0;
 }
 
+void CTRRenderer::UnlockTexture(Texture *texture) {
+    ((CTRTexture *) texture)->dirty = true;
+}
+
 /////////////
 // TEXTURE //
 /////////////
@@ -19,10 +19,11 @@ public:
     Font *LoadFont(const char *path, int size);
     void DrawFont(Font *font, int x, int y, const char *fmt, ...);
 
-    Texture *CreateTexture(int w, int h);
+    Texture *CreateTexture(int w, int h, int format = TEXTURE_FORMAT_RGB565);
     Texture *LoadTexture(const char *file);
     void DrawTexture(Texture *texture, int x, int y, int w, int h, float rotation);
     int LockTexture(Texture * texture, const Rect &rect, void **pixels, int *pitch);
+    void UnlockTexture(Texture * texture);
     
     void DrawLine(int x1, int y1, int x2, int y2, const Color &color);
     void DrawRect(const Rect &rect, const Color &color, bool fill = true);
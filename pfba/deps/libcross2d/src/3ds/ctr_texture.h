@@ -22,6 +22,7 @@ public:
 
     sf2d_texture *tex = NULL;
     u8 *pixels = NULL;
+    bool dirty = true;  // pixels changed since the last Tile()
 };
 
 #endif //_CTR_TEXTURE_H_
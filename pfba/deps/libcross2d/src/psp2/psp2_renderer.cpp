@@ -65,8 +65,8 @@ void PSP2Renderer::DrawFont(Font *font, int x, int y, const char *fmt, ...) {
 /////////////
 // TEXTURE //
 /////////////
-Texture *PSP2Renderer::CreateTexture(int w, int h) {
-    PSP2Texture *texture = new PSP2Texture(w, h);
+Texture *PSP2Renderer::CreateTexture(int w, int h, int format) {
+    PSP2Texture *texture = new PSP2Texture(w, h, format);
     if (texture->tex == NULL) {
         delete (texture);
         return NULL;
@@ -98,11 +98,25 @@ void PSP2Renderer::DrawTexture(Texture *texture, int x, int y, int w, int h, flo
 }
 
 int PSP2Renderer::LockTexture(Texture *texture, const Rect &rect, void **pixels, int *pitch) {
-    *pixels = vita2d_texture_get_datap(((PSP2Texture *) texture)->tex);
-    *pitch = vita2d_texture_get_stride(((PSP2Texture *) texture)->tex);
+    PSP2Texture *t = (PSP2Texture *) texture;
+    vita2d_texture *tex = t->back != NULL ? t->back : t->tex;
+    *pixels = vita2d_texture_get_datap(tex);
+    *pitch = vita2d_texture_get_stride(tex);
     return 0;
 }
 
+void PSP2Renderer::UnlockTexture(Texture *texture) {
+    PSP2Texture *t = (PSP2Texture *) texture;
+    if (t->back != NULL) {
+        // nothing to upload, just show the one we drew in
+        texture->UploadBegin();
+        vita2d_texture *tex = t->tex;
+        t->tex = t->back;
+        t->back = tex;
+        texture->UploadEnd();
+    }
+}
+
 /////////////
 // TEXTURE //
 /////////////
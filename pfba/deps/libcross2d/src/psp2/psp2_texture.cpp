@@ -34,16 +34,28 @@ PSP2Texture::PSP2Texture(const char *path) : Texture(path) {
     height = vita2d_texture_get_height(tex);
 }
 
-PSP2Texture::PSP2Texture(int w, int h) : Texture(w, h) {
+PSP2Texture::PSP2Texture(int w, int h, int format) : Texture(w, h) {
+
+    SceGxmTextureFormat gxm_format = SCE_GXM_TEXTURE_FORMAT_R5G6B5;
+    if (format == TEXTURE_FORMAT_XRGB8888) {
+        this->format = format;
+        bpp = 4;
+        gxm_format = SCE_GXM_TEXTURE_FORMAT_X8U8U8U8_1RGB;
+    }
 
     tex = vita2d_create_empty_texture_format(
-            (unsigned int) w, (unsigned int) h, SCE_GXM_TEXTURE_FORMAT_R5G6B5);
+            (unsigned int) w, (unsigned int) h, gxm_format);
     if (!tex) {
         printf("PSP2Texture: couldn't create texture\n");
         return;
     }
     width = vita2d_texture_get_width(tex);
     height = vita2d_texture_get_height(tex);
+
+    // texture memory is gpu mapped, so we draw directly in it. Use a second
+    // texture to never write in the one the gpu may still be reading.
+    back = vita2d_create_empty_texture_format(
+            (unsigned int) w, (unsigned int) h, gxm_format);
 }
 
 void PSP2Texture::SetFiltering(int filter) {
@@ -52,6 +64,12 @@ void PSP2Texture::SetFiltering(int filter) {
                                SCE_GXM_TEXTURE_FILTER_POINT,
                                filter == TEXTURE_FILTER_POINT ?
                                SCE_GXM_TEXTURE_FILTER_POINT : SCE_GXM_TEXTURE_FILTER_LINEAR);
+    if (back != NULL) {
+        vita2d_texture_set_filters(back,
+                                   SCE_GXM_TEXTURE_FILTER_POINT,
+                                   filter == TEXTURE_FILTER_POINT ?
+                                   SCE_GXM_TEXTURE_FILTER_POINT : SCE_GXM_TEXTURE_FILTER_LINEAR);
+    }
 }
 
 PSP2Texture::~PSP2Texture() {
@@ -61,4 +79,8 @@ PSP2Texture::~PSP2Texture() {
         vita2d_free_texture(tex);
         tex = NULL;
     }
+    if (back != NULL) {
+        vita2d_free_texture(back);
+        back = NULL;
+    }
 }
@@ -13,13 +13,14 @@ class PSP2Texture : Texture {
 public:
     PSP2Texture(const char *path);
 
-    PSP2Texture(int w, int h);
+    PSP2Texture(int w, int h, int format);
 
     ~PSP2Texture();
 
     void SetFiltering(int filter);
 
     vita2d_texture *tex = NULL;
+    vita2d_texture *back = NULL;    // streaming textures: the one being drawn in
 };
 
 #endif //_PSP2_TEXTURE_H_
@@ -12,6 +12,14 @@ bool Utility::FileExist(const char *file) {
     return (stat(file, &buf) == 0);
 }
 
+long Utility::GetModTime(const char *path) {
+    struct stat buf;
+    if (stat(path, &buf) != 0) {
+        return 0;
+    }
+    return (long) buf.st_mtime;
+}
+
 std::vector<std::string> Utility::GetFileList(const char *path) {
 
     std::vector<std::string> files;
@@ -15,6 +15,9 @@ public:
 
     static std::vector<std::string> GetFileList(const char *path);
 
+    // last modification time of a file or directory, 0 if it doesn't exist
+    static long GetModTime(const char *path);
+
 };
 
 #endif //FBA_PSP2_UTILITY_H
@@ -3,6 +3,7 @@
 //
 
 #include <malloc.h>
+#include <atomic>
 #include <SDL2/SDL.h>
 #include "sdl2_audio.h"
 
@@ -11,72 +12,72 @@
 #define printf sceClibPrintf
 #endif
 
-static bool use_mutex = false;
-
-static int buf_size;
+// single producer (emulation) / single consumer (sdl callback) ring buffer.
+// positions are free running byte counters, the ring size is a power of two
+// so "pos & buf_mask" wraps them, and neither side ever takes a lock.
+static unsigned int buf_size;
+static unsigned int buf_mask;
 static unsigned char *buffer_sdl;
-static unsigned int buf_read_pos = 0;
-static unsigned int buf_write_pos = 0;
-static int buffered_bytes = 0;
+static std::atomic<unsigned int> buf_read_pos(0);
+static std::atomic<unsigned int> buf_write_pos(0);
 
-static SDL_mutex *sound_mutex;
-static SDL_cond *sound_cv;
+static std::atomic<unsigned int> underruns(0);
+static std::atomic<unsigned int> overruns(0);
+static Uint64 push_count = 0;
+static Uint64 push_ticks = 0;
+// callback side, only touched by the audio thread until the device is paused
+static Uint64 pull_count = 0;
+static Uint64 pull_ticks = 0;
+static Uint64 pull_max = 0;
 
-static void write_buffer(unsigned char *data, int len) {
+static void write_buffer(unsigned char *data, unsigned int len) {
 
-    if (use_mutex) {
-        SDL_LockMutex(sound_mutex);
-    } else {
-        SDL_LockAudio();
-    }
+    unsigned int write = buf_write_pos.load(std::memory_order_relaxed);
+    unsigned int read = buf_read_pos.load(std::memory_order_acquire);
+    unsigned int space = buf_size - (write - read);
 
-    for (int i = 0; i < len; i += 4) {
-        if (!use_mutex) {
-            if (buffered_bytes == buf_size) {
-                //printf("audio drop: write_pos=%i - buffered=%i (write_len=%i)\n", buf_write_pos, buffered_bytes, len);
-                break; // drop samples
-            }
-        } else {
-            while (buffered_bytes == buf_size) {
-                SDL_CondWait(sound_cv, sound_mutex);
-            }
-        }
-
-        *(int *) ((char *) (buffer_sdl + buf_write_pos)) = *(int *) ((char *) (data + i));
-        buf_write_pos = (buf_write_pos + 4) % buf_size;
-        buffered_bytes += 4;
+    if (len > space) {
+        //printf("audio drop: write_pos=%i - buffered=%i (write_len=%i)\n", write, write - read, len);
+        overruns++;
+        len = space & ~3U; // drop samples
     }
 
-    if (use_mutex) {
-        SDL_CondSignal(sound_cv);
-        SDL_UnlockMutex(sound_mutex);
-    } else {
-        SDL_UnlockAudio();
-    }
+    unsigned int pos = write & buf_mask;
+    unsigned int first = len < buf_size - pos ? len : buf_size - pos;
+    memcpy(buffer_sdl + pos, data, first);
+    memcpy(buffer_sdl, data + first, len - first);
+
+    buf_write_pos.store(write + len, std::memory_order_release);
 }
 
 static void read_buffer(void *unused, unsigned char *data, int len) {
 
-    if (use_mutex) {
-        SDL_LockMutex(sound_mutex);
-    }
+    Uint64 start = SDL_GetPerformanceCounter();
 
-    if (buffered_bytes >= len) {
-        if (buf_read_pos + len <= buf_size) {
-            memcpy(data, buffer_sdl + buf_read_pos, len);
-        } else {
-            int tail = buf_size - buf_read_pos;
-            memcpy(data, buffer_sdl + buf_read_pos, tail);
-            memcpy(data + tail, buffer_sdl, len - tail);
-        }
-        buf_read_pos = (buf_read_pos + len) % buf_size;
-        buffered_bytes -= len;
+    unsigned int read = buf_read_pos.load(std::memory_order_relaxed);
+    unsigned int write = buf_write_pos.load(std::memory_order_acquire);
+    unsigned int available = write - read;
+    unsigned int size = (unsigned int) len;
+
+    if (available < size) {
+        underruns++;
+        memset(data + available, 0, size - available);
+        size = available;
     }
 
-    if (use_mutex) {
-        SDL_CondSignal(sound_cv);
-        SDL_UnlockMutex(sound_mutex);
+    unsigned int pos = read & buf_mask;
+    unsigned int first = size < buf_size - pos ? size : buf_size - pos;
+    memcpy(data, buffer_sdl + pos, first);
+    memcpy(data + first, buffer_sdl, size - first);
+
+    buf_read_pos.store(read + size, std::memory_order_release);
+
+    Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    pull_ticks += ticks;
+    if (ticks > pull_max) {
+        pull_max = ticks;
     }
+    pull_count++;
 }
 
 SDL2Audio::SDL2Audio(int freq, int fps) : Audio(freq, fps) {
@@ -91,13 +92,20 @@ SDL2Audio::SDL2Audio(int freq, int fps) : Audio(freq, fps) {
     // Find the value which is slighly bigger than buffer_len*2
     for (sample_size = 512; sample_size < (buffer_len * 2); sample_size <<= 1);
     sample_size /= 4; // fix audio delay
-    buf_size = sample_size * channels * 2 * 8;
+    for (buf_size = 1; buf_size < (unsigned int) (sample_size * channels * 2 * 8); buf_size <<= 1);
+    buf_mask = buf_size - 1;
     buffer_sdl = (unsigned char *) malloc((size_t) buf_size);
     memset(buffer_sdl, 0, (size_t) buf_size);
 
-    buffered_bytes = 0;
     buf_read_pos = 0;
     buf_write_pos = 0;
+    underruns = 0;
+    overruns = 0;
+    push_count = 0;
+    push_ticks = 0;
+    pull_count = 0;
+    pull_ticks = 0;
+    pull_max = 0;
 
     aspec.format = AUDIO_S16;
     aspec.freq = freq;
@@ -118,12 +126,6 @@ SDL2Audio::SDL2Audio(int freq, int fps) : Audio(freq, fps) {
         return;
     }
 
-    if (use_mutex) {
-        sound_mutex = SDL_CreateMutex();
-        sound_cv = SDL_CreateCond();
-        printf("SDL2Audio: using mutexes for synchro\n");
-    }
-
     printf("SDL2Audio: frequency %d\n", obtained.freq);
     printf("SDL2Audio: samples %d\n", obtained.samples);
     printf("SDL2Audio: channels %d\n", obtained.channels);
@@ -138,15 +140,18 @@ SDL2Audio::~SDL2Audio() {
     }
     SDL_PauseAudio(1);
 
-    if (use_mutex) {
-        SDL_LockMutex(sound_mutex);
-        buffered_bytes = buf_size;
-        SDL_CondSignal(sound_cv);
-        SDL_UnlockMutex(sound_mutex);
-        SDL_Delay(100);
-
-        SDL_DestroyCond(sound_cv);
-        SDL_DestroyMutex(sound_mutex);
+    if (push_count > 0) {
+        printf("SDL2Audio: %llu frames pushed, %i ns per push, %u underruns, %u overruns\n",
+               (unsigned long long) push_count,
+               (int) ((push_ticks * 1000000000) / (push_count * SDL_GetPerformanceFrequency())),
+               underruns.load(), overruns.load());
+    }
+    if (pull_count > 0) {
+        Uint64 freq = SDL_GetPerformanceFrequency();
+        printf("SDL2Audio: %llu callbacks, %i ns per pull, %i ns worst\n",
+               (unsigned long long) pull_count,
+               (int) ((pull_ticks * 1000000000) / (pull_count * freq)),
+               (int) ((pull_max * 1000000000) / freq));
     }
 
     SDL_CloseAudio();
@@ -163,8 +168,30 @@ void SDL2Audio::Play() {
         return;
     }
 
-    write_buffer((unsigned char *) buffer, buffer_size);
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    if (sync) {
+        int size = RateControl(GetBufferedBytes());
+        write_buffer((unsigned char *) sync_buffer, (unsigned int) size);
+    } else {
+        write_buffer((unsigned char *) buffer, (unsigned int) buffer_size);
+    }
+
+    push_ticks += SDL_GetPerformanceCounter() - start;
+    push_count++;
+}
+
+int SDL2Audio::GetBufferedBytes() {
+    return (int) (buf_write_pos.load(std::memory_order_acquire)
+                  - buf_read_pos.load(std::memory_order_acquire));
+}
+
+int SDL2Audio::GetUnderruns() {
+    return (int) underruns.load();
+}
 
+int SDL2Audio::GetOverruns() {
+    return (int) overruns.load();
 }
 
 void SDL2Audio::Pause(int pause) {
@@ -175,22 +202,4 @@ void SDL2Audio::Pause(int pause) {
 
     Audio::Pause(pause);
     SDL_PauseAudio(pause);
-
-    if (use_mutex) {
-        if (pause) {
-            SDL_LockMutex(sound_mutex);
-            buffered_bytes = 0;
-            SDL_CondSignal(sound_cv);
-            SDL_UnlockMutex(sound_mutex);
-            SDL_Delay(100);
-
-            SDL_DestroyCond(sound_cv);
-            sound_cv = NULL;
-            SDL_DestroyMutex(sound_mutex);
-            sound_mutex = NULL;
-        } else {
-            sound_mutex = SDL_CreateMutex();
-            sound_cv = SDL_CreateCond();
-        }
-    }
 }
@@ -15,6 +15,9 @@ public:
 
     virtual void Play();
     virtual void Pause(int pause);
+    virtual int GetBufferedBytes();
+    virtual int GetUnderruns();
+    virtual int GetOverruns();
 
 };
 
@@ -82,12 +82,12 @@ void SDL2Renderer::DrawFont(Font *font, int x, int y, const char *fmt, ...) {
 /////////////
 // TEXTURE //
 /////////////
-Texture *SDL2Renderer::CreateTexture(int w, int h) {
+Texture *SDL2Renderer::CreateTexture(int w, int h, int format) {
     if (renderer == NULL) {
         return NULL;
     }
 
-    SDL2Texture *texture = new SDL2Texture(renderer, w, h);
+    SDL2Texture *texture = new SDL2Texture(renderer, w, h, format);
     if (texture->tex == NULL) {
         delete (texture);
         return NULL;
@@ -114,16 +114,45 @@ void SDL2Renderer::DrawTexture(Texture *texture, int x, int y, int w, int h, flo
 }
 
 int SDL2Renderer::LockTexture(Texture *texture, const Rect &rect, void **pixels, int *pitch) {
+    SDL2Texture *t = (SDL2Texture *) texture;
+    // streaming textures: sdl keeps a persistent staging buffer per texture
+    SDL_Texture *tex = t->back != NULL ? t->back : t->tex;
     if (rect.x != 0 || rect.y != 0 || rect.w != 0 || rect.h != 0) {
         SDL_Rect r{rect.x, rect.y, rect.w, rect.h};
-        return SDL_LockTexture(((SDL2Texture *) texture)->tex, &r, pixels, pitch);
+        return SDL_LockTexture(tex, &r, pixels, pitch);
     } else {
-        return SDL_LockTexture(((SDL2Texture *) texture)->tex, NULL, pixels, pitch);
+        return SDL_LockTexture(tex, NULL, pixels, pitch);
     }
 }
 
 void SDL2Renderer::UnlockTexture(Texture *texture) {
-    SDL_UnlockTexture(((SDL2Texture *) texture)->tex);
+    SDL2Texture *t = (SDL2Texture *) texture;
+    texture->UploadBegin();
+    if (t->back != NULL) {
+        // upload, then show it while the next frame goes in the other one
+        SDL_UnlockTexture(t->back);
+        SDL_Texture *tex = t->tex;
+        t->tex = t->back;
+        t->back = tex;
+    } else {
+        SDL_UnlockTexture(t->tex);
+    }
+    texture->UploadEnd();
+}
+
+void SDL2Renderer::UpdateTexture(Texture *texture, const void *pixels, int pitch) {
+    SDL2Texture *t = (SDL2Texture *) texture;
+    texture->UploadBegin();
+    // uploaded from the caller's pixels, not copied in the lock buffer first
+    if (t->back != NULL) {
+        SDL_UpdateTexture(t->back, NULL, pixels, pitch);
+        SDL_Texture *tex = t->tex;
+        t->tex = t->back;
+        t->back = tex;
+    } else {
+        SDL_UpdateTexture(t->tex, NULL, pixels, pitch);
+    }
+    texture->UploadEnd();
 }
 /////////////
 // TEXTURE //
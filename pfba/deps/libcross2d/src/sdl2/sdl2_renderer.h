@@ -22,11 +22,12 @@ public:
     virtual Font *LoadFont(const char *path, int size);
     void DrawFont(Font *font, int x, int y, const char *fmt, ...);
 
-    virtual Texture *CreateTexture(int w, int h);
+    virtual Texture *CreateTexture(int w, int h, int format = TEXTURE_FORMAT_RGB565);
     virtual Texture *LoadTexture(const char *file);
     virtual void DrawTexture(Texture *texture, int x, int y, int w, int h, float rotation);
     virtual int LockTexture(Texture * texture, const Rect &rect, void **pixels, int *pitch);
     virtual void UnlockTexture(Texture * texture);
+    virtual void UpdateTexture(Texture * texture, const void *pixels, int pitch);
 
     virtual void DrawLine(int x1, int y1, int x2, int y2, const Color &color);
     virtual void DrawRect(const Rect &rect, const Color &color, bool fill = true);
@@ -27,16 +27,26 @@ SDL2Texture::SDL2Texture(SDL_Renderer *renderer, const char *path) : Texture(pat
     SDL_FreeSurface(temp);
 }
 
-SDL2Texture::SDL2Texture(SDL_Renderer *renderer, int w, int h) : Texture(w, h) {
+SDL2Texture::SDL2Texture(SDL_Renderer *renderer, int w, int h, int format) : Texture(w, h) {
 
     this->renderer = renderer;
 
+    if (format == TEXTURE_FORMAT_XRGB8888) {
+        // SDL_PIXELFORMAT_RGB888 is xrgb, native endian
+        this->format = format;
+        bpp = 4;
+        sdl_format = SDL_PIXELFORMAT_RGB888;
+    }
+
     tex = SDL_CreateTexture(renderer,
-                            SDL_PIXELFORMAT_RGB565, SDL_TEXTUREACCESS_STREAMING, w, h);
+                            sdl_format, SDL_TEXTUREACCESS_STREAMING, w, h);
     if (!tex) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create texture: %s\n", SDL_GetError());
     } else {
         SDL_QueryTexture(tex, NULL, NULL, &width, &height);
+        // second texture, so we never update the one the gpu may still be drawing
+        back = SDL_CreateTexture(renderer,
+                                 sdl_format, SDL_TEXTUREACCESS_STREAMING, w, h);
     }
 }
 
@@ -49,10 +59,17 @@ void SDL2Texture::SetFiltering(int filter) {
         SDL_DestroyTexture(tex);
         tex = NULL;
     }
+    if(back != NULL) {
+        SDL_DestroyTexture(back);
+        back = NULL;
+    }
     tex = SDL_CreateTexture(renderer,
-                            SDL_PIXELFORMAT_RGB565, SDL_TEXTUREACCESS_STREAMING, width, height);
+                            sdl_format, SDL_TEXTUREACCESS_STREAMING, width, height);
     if (!tex) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create texture: %s\n", SDL_GetError());
+    } else {
+        back = SDL_CreateTexture(renderer,
+                                 sdl_format, SDL_TEXTUREACCESS_STREAMING, width, height);
     }
 }
 
@@ -61,4 +78,8 @@ SDL2Texture::~SDL2Texture() {
         SDL_DestroyTexture(tex);
         tex = NULL;
     }
+    if(back != NULL) {
+        SDL_DestroyTexture(back);
+        back = NULL;
+    }
 }
@@ -11,12 +11,14 @@ class SDL2Texture : Texture {
 
 public:
     SDL2Texture(SDL_Renderer *renderer, const char *path);
-    SDL2Texture(SDL_Renderer *renderer, int w, int h);
+    SDL2Texture(SDL_Renderer *renderer, int w, int h, int format);
     void SetFiltering(int filter);
     ~SDL2Texture();
 
     SDL_Texture *tex = NULL;
+    SDL_Texture *back = NULL;   // streaming textures: the one being drawn in
     SDL_Renderer *renderer = NULL;
+    Uint32 sdl_format = SDL_PIXELFORMAT_RGB565;
 };
 
 #endif //_SDL2_TEXTURE_H_
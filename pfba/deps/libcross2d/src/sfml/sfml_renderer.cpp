@@ -84,8 +84,8 @@ void SFMLRenderer::DrawFont(Font *font, int x, int y, const char *fmt, ...) {
 /////////////
 // TEXTURE //
 /////////////
-Texture *SFMLRenderer::CreateTexture(int w, int h) {
-    SFMLTexture *texture = new SFMLTexture(w, h);
+Texture *SFMLRenderer::CreateTexture(int w, int h, int format) {
+    SFMLTexture *texture = new SFMLTexture(w, h, format);
     if (!texture->pixels) {
         return NULL;
     }
@@ -119,10 +119,15 @@ void SFMLRenderer::DrawTexture(Texture *texture, int x, int y, int w, int h, flo
     transform.rotate(rotation, {(float) (x + w / 2), (float) (y + h / 2)});
     states.transform = transform;
 
+    // the x byte of xrgb pixels is not an alpha
+    if (texture->format == TEXTURE_FORMAT_XRGB8888) {
+        states.blendMode = sf::BlendNone;
+    }
+
     // set sprite shader
     sf::Shader *shader = (sf::Shader *) shaders->Get()->data;
     if (shader) {
-        shader->setUniform("Texture", ((SFMLTexture *) texture)->texture);
+        shader->setUniform("Texture", *sprite.getTexture());
         shader->setUniform("MVPMatrix", sf::Glsl::Mat4(window.getView().getTransform().getMatrix()));
         shader->setUniform("TextureSize", sf::Glsl::Vec2(texture->width, texture->height));
         shader->setUniform("InputSize", sf::Glsl::Vec2(w, h));
@@ -136,17 +141,39 @@ void SFMLRenderer::DrawTexture(Texture *texture, int x, int y, int w, int h, flo
 
 int SFMLRenderer::LockTexture(Texture *texture, const Rect &rect, void **pixels, int *pitch) {
     *pixels = ((SFMLTexture *) texture)->pixels;
-    *pitch = texture->width * 2;
+    *pitch = texture->width * texture->bpp;
     return 0;
 }
 
 void SFMLRenderer::UnlockTexture(Texture *texture) {
+    UpdateTexture(texture, ((SFMLTexture *) texture)->pixels, texture->width * texture->bpp);
+}
+
+void SFMLRenderer::UpdateTexture(Texture *texture, const void *pixels, int pitch) {
+    SFMLTexture *t = (SFMLTexture *) texture;
+    // upload in the texture not on screen, then show it
+    sf::Texture *tex = &t->texture;
+    if (t->back.getSize().x > 0 && t->sprite.getTexture() == &t->texture) {
+        tex = &t->back;
+    }
+
+    texture->UploadBegin();
     GLint textureBinding;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding);
-    sf::Texture::bind(&((SFMLTexture *) texture)->texture);
+    sf::Texture::bind(tex);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / texture->bpp);
+#ifdef GL_BGRA
+    if (texture->format == TEXTURE_FORMAT_XRGB8888) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture->width, texture->height,
+                        GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+    } else
+#endif
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture->width, texture->height,
-                    GL_RGB, GL_UNSIGNED_SHORT_5_6_5, ((SFMLTexture *) texture)->pixels);
+                    GL_RGB, GL_UNSIGNED_SHORT_5_6_5, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glBindTexture(GL_TEXTURE_2D, (GLuint) textureBinding);
+    t->sprite.setTexture(*tex);
+    texture->UploadEnd();
 }
 
 /////////////
@@ -20,7 +20,7 @@ public:
 
     void DrawFont(Font *font, int x, int y, const char *fmt, ...);
 
-    virtual Texture *CreateTexture(int w, int h);
+    virtual Texture *CreateTexture(int w, int h, int format = TEXTURE_FORMAT_RGB565);
 
     virtual Texture *LoadTexture(const char *file);
 
@@ -30,6 +30,8 @@ public:
 
     virtual void UnlockTexture(Texture *texture);
 
+    virtual void UpdateTexture(Texture *texture, const void *pixels, int pitch);
+
     virtual void DrawLine(int x1, int y1, int x2, int y2, const Color &color);
 
     virtual void DrawRect(const Rect &rect, const Color &color, bool fill = true);
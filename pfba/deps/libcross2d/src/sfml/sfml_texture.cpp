@@ -2,7 +2,7 @@
 // Created by cpasjuste on 01/12/16.
 //
 
-
+#include "GL/gl.h"
 #include "sfml_texture.h"
 
 SFMLTexture::SFMLTexture(const char *path) : Texture(path) {
@@ -17,13 +17,24 @@ SFMLTexture::SFMLTexture(const char *path) : Texture(path) {
     }
 }
 
-SFMLTexture::SFMLTexture(int w, int h) : Texture(w, h) {
+SFMLTexture::SFMLTexture(int w, int h, int format) : Texture(w, h) {
+
+#ifdef GL_BGRA
+    if (format == TEXTURE_FORMAT_XRGB8888) {
+        this->format = format;
+        bpp = 4;
+    }
+#endif
 
     if(texture.create(w, h)) {
         width = w;
         height = h;
-        pixels = new sf::Uint8[width * height * 2];
+        pixels = new sf::Uint8[width * height * bpp];
         sprite.setTexture(texture);
+        // second texture, so we never update the one the gpu may still be drawing
+        if (!back.create(w, h)) {
+            printf("Couldn't create back texture, single buffered\n");
+        }
     } else {
         printf("Couldn't create texture\n");
     }
@@ -31,6 +42,7 @@ SFMLTexture::SFMLTexture(int w, int h) : Texture(w, h) {
 
 void SFMLTexture::SetFiltering(int filter) {
     texture.setSmooth((bool)filter);
+    back.setSmooth((bool)filter);
 }
 
 SFMLTexture::~SFMLTexture() {
@@ -12,12 +12,13 @@ class SFMLTexture : Texture {
 
 public:
     SFMLTexture(const char *path);
-    SFMLTexture(int w, int h);
+    SFMLTexture(int w, int h, int format);
     void SetFiltering(int filter);
     ~SFMLTexture();
 
     sf::Sprite sprite;
     sf::Texture texture;
+    sf::Texture back;           // streaming textures: the other one, sprite shows the last uploaded
     sf::Uint8* pixels = NULL;
 };
 
@@ -28,6 +28,57 @@ Audio::Audio(int freq, int fps) {
     printf("Audio: rate = %i, buf size = %i, buf len = %i\n", freq, buffer_size, buffer_len);
 }
 
+void Audio::SetSync(bool sync, int latency) {
+
+    this->sync = sync && available;
+    this->latency = ((frequency * latency) / 1000) * channels * 2;
+    sync_pos = 0;
+
+    if (this->sync && sync_buffer == NULL) {
+        // room for a 0.5% longer frame
+        sync_buffer_size = ((buffer_len + buffer_len / 200 + 2) * channels * 2);
+        sync_buffer = (short *) malloc((size_t) sync_buffer_size);
+        memset(sync_buffer, 0, (size_t) sync_buffer_size);
+    }
+
+    printf("Audio: sync = %i, latency = %i bytes\n", this->sync, this->latency);
+}
+
+int Audio::RateControl(int buffered) {
+
+    // stretch the frame when the queue is below target, shrink it when above
+    double delta = (double) (latency - buffered) / (double) latency;
+    if (delta > 1.0) {
+        delta = 1.0;
+    } else if (delta < -1.0) {
+        delta = -1.0;
+    }
+    double step = 1.0 / (1.0 + delta * 0.005);
+
+    // linear interpolation, the phase carries over to the next frame
+    int max = sync_buffer_size / (channels * 2);
+    int count = 0;
+    double pos = sync_pos;
+    while (pos < buffer_len && count < max) {
+        int i = (int) pos;
+        int n = i + 1 < buffer_len ? i + 1 : i;
+        int f = (int) ((pos - i) * 65536.0);
+        for (int c = 0; c < channels; c++) {
+            int s0 = buffer[i * channels + c];
+            int s1 = buffer[n * channels + c];
+            sync_buffer[count * channels + c] = (short) (s0 + (((s1 - s0) * f) >> 16));
+        }
+        count++;
+        pos += step;
+    }
+    sync_pos = pos - buffer_len;
+    if (sync_pos < 0) {
+        sync_pos = 0;
+    }
+
+    return count * channels * 2;
+}
+
 void Audio::Pause(int pause) {
     paused = pause;
 }
@@ -38,5 +89,9 @@ Audio::~Audio() {
             free(buffer);
             buffer = NULL;
         }
+        if (sync_buffer != NULL) {
+            free(sync_buffer);
+            sync_buffer = NULL;
+        }
     }
 }
@@ -17,6 +17,18 @@ public:
     virtual void Play() {};
     virtual void Pause(int pause);
 
+    // bytes queued for the audio device, not yet played
+    virtual int GetBufferedBytes() { return 0; };  // to implement
+
+    // device starved / emulation too far ahead (samples dropped)
+    virtual int GetUnderruns() { return 0; };  // to implement
+    virtual int GetOverruns() { return 0; };  // to implement
+
+    // audio sync: the frame pacer follows the device queue instead of the clock,
+    // and each frame is resampled by up to +/- 0.5% to keep "latency" (ms) queued
+    void SetSync(bool sync, int latency = 8);
+    int RateControl(int buffered);
+
     int frequency = 48000;
     int channels = 2;
     short *buffer = NULL;
@@ -24,6 +36,12 @@ public:
     int buffer_len = 0;
     int paused = 0;
     int available = 0;
+
+    bool sync = false;
+    int latency = 0;            // target queue size, in bytes
+    short *sync_buffer = NULL;  // resampled frame
+    int sync_buffer_size = 0;
+    double sync_pos = 0;
 };
 
 #ifdef __PSP2__
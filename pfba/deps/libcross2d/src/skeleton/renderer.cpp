@@ -42,6 +42,26 @@ void Renderer::DrawTexture(Texture *texture, int x, int y) {
     DrawTexture(texture, x, y, texture->width, texture->height);
 }
 
+void Renderer::UpdateTexture(Texture *texture, const void *pixels, int pitch) {
+
+    unsigned char *dst = NULL;
+    int dst_pitch = 0;
+    int size = texture->width * texture->bpp;
+
+    LockTexture(texture, Rect(), (void **) &dst, &dst_pitch);
+    if (dst != NULL) {
+        const unsigned char *src = (const unsigned char *) pixels;
+        if (pitch == dst_pitch && pitch == size) {
+            memcpy(dst, src, (size_t) (size * texture->height));
+        } else {
+            for (int y = 0; y < texture->height; y++) {
+                memcpy(dst + y * dst_pitch, src + y * pitch, (size_t) size);
+            }
+        }
+    }
+    UnlockTexture(texture);
+}
+
 void
 Renderer::DrawFont(Font *font, const Rect &dst, const Color &c, bool centerX, bool centerY, const char *fmt, ...) {
 
@@ -33,14 +33,21 @@ public:
     virtual void DrawFont(Font *font, const Rect &dst, const Color &color, const char *fmt, ...);
     virtual void DrawFont(Font *font, const Rect &dst, const Color &color, bool centerX, bool centerY, const char *fmt, ...);
 
-    virtual Texture *CreateTexture(int w, int h) {return NULL;};  // to implement
+    virtual Texture *CreateTexture(int w, int h, int format = TEXTURE_FORMAT_RGB565) {return NULL;};  // to implement
     virtual Texture *LoadTexture(const char *file) {return NULL;};  // to implement
     virtual void DrawTexture(Texture *texture, int x, int y, int w, int h, float rotation) {}; // to implement
     virtual void DrawTexture(Texture *texture, int x, int y, int w, int h);
     virtual void DrawTexture(Texture *texture, int x, int y);
     virtual Rect DrawTexture(Texture *texture, const Rect &rect, bool fit = true);
+    // streaming textures are double buffered on sdl2, sfml and psp2 (3ds re-tiles its one buffer
+    // when drawn): LockTexture returns the buffer to draw the next frame in, UnlockTexture
+    // uploads it and makes it the one DrawTexture shows. The buffer is gpu memory on psp2
+    // only, sdl2 and sfml copy it to the gpu on unlock.
     virtual int LockTexture(Texture * texture, const Rect &rect, void **pixels, int *pitch) {return 0;};  // to implement
     virtual void UnlockTexture(Texture * texture) {};  // to implement
+    // upload a frame drawn in a buffer of our own (pitch bytes per line) to a streaming texture,
+    // sdl2 and sfml upload straight from it, others copy it in the locked buffer
+    virtual void UpdateTexture(Texture * texture, const void *pixels, int pitch);
 
     virtual void SetShader(int shader) {};  // to implement
 
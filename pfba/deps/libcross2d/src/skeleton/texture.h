@@ -8,7 +8,12 @@
 #define TEXTURE_FILTER_POINT 0
 #define TEXTURE_FILTER_LINEAR 1
 
+// streaming textures pixel formats, native endian
+#define TEXTURE_FORMAT_RGB565 0
+#define TEXTURE_FORMAT_XRGB8888 1
+
 #include <cstdio>
+#include "timer.h"
 
 class Texture {
 
@@ -21,8 +26,35 @@ public:
         printf("Texture::SetFiltering: not implemented\n");
     };
 
+    // streaming textures (CreateTexture): LockTexture gives a persistent buffer,
+    // UnlockTexture makes it visible to the gpu. Renderers wrap that upload with
+    // these so the cost can be compared between backends.
+    void UploadBegin() {
+        upload_timer.Reset();
+    }
+
+    void UploadEnd() {
+        unsigned long t = upload_timer.GetMicros();
+        upload_time += t;
+        if (t > upload_max) {
+            upload_max = t;
+        }
+        uploads++;
+    }
+
     int width = 0;
     int height = 0;
+    // the format a streaming texture was created with, renderers without
+    // 32 bits support fall back to TEXTURE_FORMAT_RGB565
+    int format = TEXTURE_FORMAT_RGB565;
+    int bpp = 2;
+
+    unsigned int uploads = 0;
+    unsigned long upload_time = 0;      // total (us)
+    unsigned long upload_max = 0;       // slowest upload (us)
+
+private:
+    Timer upload_timer;
 };
 
 #endif //_TEXTURE_H_
@@ -18,6 +18,9 @@ public:
     static bool FileExist(const char *file);
 
     static std::vector<std::string> GetFileList(const char *path);
+
+    // last modification time of a file or directory, 0 if it doesn't exist
+    static long GetModTime(const char *path);
 };
 
 #endif //__PSP2__
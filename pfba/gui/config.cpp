@@ -88,15 +88,52 @@ Config::Config(const std::string &cfgPath, Renderer *renderer) {
             Option("SHADER", renderer->shaders->GetNames(), 0, Option::Index::ROM_SHADER));
     options_gui.push_back(
             Option("ROTATION", {"OFF", "ON", "OFF+FLIP", "OFF+CAB MODE"}, 0, Option::Index::ROM_ROTATION));
+#ifdef __3DS__
+    options_gui.push_back(Option("COLOR_DEPTH", {"16", "32"}, 0, Option::Index::ROM_COLOR_DEPTH, Option::Type::HIDDEN));
+#else
+    options_gui.push_back(Option("COLOR_DEPTH", {"16", "32"}, 0, Option::Index::ROM_COLOR_DEPTH));
+#endif
     options_gui.push_back(Option("SHOW_FPS", {"NO", "YES"}, 0, Option::Index::ROM_SHOW_FPS));
+#ifdef M68K_X64_DRC
+    // C until the recompiler's traces are checked against the interpreter's (pfba-bench --m68k-check)
+    options_gui.push_back(Option("M68K", {"DRC", "C"}, 1, Option::Index::ROM_M68K));
+#else
+    options_gui.push_back(Option("M68K", {"DRC", "C"}, 1, Option::Index::ROM_M68K, Option::Type::HIDDEN));
+#endif
+    // the values are the SH2_CORE_* ones, BLOCK is the block interpreter
+#ifdef SH2_X64_DRC
+    options_gui.push_back(Option("SH2", {"C", "BLOCK", "DRC"}, 0, Option::Index::ROM_SH2));
+#else
+    options_gui.push_back(Option("SH2", {"C", "BLOCK"}, 0, Option::Index::ROM_SH2));
+#endif
+    options_gui.push_back(Option("IDLE_SKIP", {"OFF", "ON"}, 1, Option::Index::ROM_IDLE_SKIP));
     options_gui.push_back(Option("FRAMESKIP", {"OFF", "ON"}, 0, Option::Index::ROM_FRAMESKIP));
-    //options_gui.push_back(Option("M68K", {"ASM", "C"}, 0, Option::Index::ROM_M68K));
     options_gui.push_back(Option("NEOBIOS", {"UNIBIOS_3_2", "AES_ASIA", "AES_JPN", "DEVKIT", "MVS_ASIA_EUR_V6S1",
                                              "MVS_ASIA_EUR_V5S1", "MVS_ASIA_EUR_V3S4", "MVS_USA_V5S2",
                                              "MVS_USA_V5S4", "MVS_USA_V5S6", "MVS_JPN_V6", "MVS_JPN_V5",
                                              "MVS_JPN_V3S4", "NEO_MVH_MV1C", "MVS_JPN_J3", "DECK_V6"},
                                  0, Option::Index::ROM_NEOBIOS));
     options_gui.push_back(Option("AUDIO", {"OFF", "ON"}, 1, Option::Index::ROM_AUDIO));
+    options_gui.push_back(Option("AUDIO_SYNC", {"OFF", "ON"}, 0, Option::Index::ROM_AUDIO_SYNC));
+    options_gui.push_back(Option("AUDIO_LATENCY", {"4", "8", "16", "32"}, 1, Option::Index::ROM_AUDIO_LATENCY));
+    options_gui.push_back(Option("AUDIO_RESAMPLER", {"OFF", "FAST", "GOOD", "BEST"}, 0, Option::Index::ROM_AUDIO_RESAMPLER));
+#ifdef __3DS__
+    options_gui.push_back(Option("THREADED", {"OFF", "ON"}, 0, Option::Index::ROM_THREADED, Option::Type::HIDDEN));
+#else
+    options_gui.push_back(Option("THREADED", {"OFF", "ON"}, 0, Option::Index::ROM_THREADED));
+#endif
+    options_gui.push_back(Option("REWIND", {"OFF", "16MB", "32MB", "64MB"}, 0, Option::Index::ROM_REWIND));
+    options_gui.push_back(Option("RUNAHEAD", {"OFF", "1", "2", "3"}, 0, Option::Index::ROM_RUNAHEAD));
+#if defined(__PSP2__) || defined(__3DS__)
+    options_gui.push_back(Option("NETPLAY", {"OFF", "HOST", "JOIN"}, 0, Option::Index::ROM_NETPLAY, Option::Type::HIDDEN));
+#else
+    options_gui.push_back(Option("NETPLAY", {"OFF", "HOST", "JOIN"}, 0, Option::Index::ROM_NETPLAY));
+#endif
+#ifdef BURN_PROF
+    options_gui.push_back(Option("PROFILER", {"OFF", "ON", "TRACE"}, 0, Option::Index::ROM_PROFILER));
+#else
+    options_gui.push_back(Option("PROFILER", {"OFF", "ON", "TRACE"}, 0, Option::Index::ROM_PROFILER, Option::Type::HIDDEN));
+#endif
 
     // joystick
     options_gui.push_back(Option("JOYPAD", {"JOYPAD"}, 0, Option::Index::MENU_JOYPAD, Option::Type::MENU));
@@ -215,6 +252,20 @@ void Config::Load(RomList::Rom *rom) {
                 } else {
                     //printf("rom_paths setting not found\n");
                 }
+
+                settings = config_setting_lookup(settings_root, "NETPLAY");
+                if (settings) {
+                    const char *value;
+                    if (config_setting_lookup_string(settings, "PEER", &value)) {
+                        netplay.peer = value;
+                    }
+                    config_setting_lookup_int(settings, "PORT", &netplay.port);
+                    config_setting_lookup_int(settings, "DELAY", &netplay.delay);
+                    config_setting_lookup_int(settings, "ROLLBACK", &netplay.rollback);
+                    config_setting_lookup_int(settings, "LAG", &netplay.lag);
+                    config_setting_lookup_int(settings, "JITTER", &netplay.jitter);
+                    config_setting_lookup_int(settings, "LOSS", &netplay.loss);
+                }
             }
 
             for (unsigned long i = 0; i < options->size(); i++) {
@@ -244,6 +295,13 @@ void Config::Load(RomList::Rom *rom) {
     }
 
     config_destroy(&cfg);
+
+    // bzip looks for romsets in these
+    if (!isRomCfg) {
+        for (int i = 0; i < DIRS_MAX && i < roms_paths.size(); i++) {
+            strncpy(szAppRomPaths[i], roms_paths[i].c_str(), MAX_PATH - 1);
+        }
+    }
 }
 
 void Config::Save(RomList::Rom *rom) {
@@ -276,6 +334,15 @@ void Config::Save(RomList::Rom *rom) {
             config_setting_t *setting = config_setting_add(sub_setting, p, CONFIG_TYPE_STRING);
             config_setting_set_string(setting, roms_paths[i].c_str());
         }
+
+        sub_setting = config_setting_add(setting_fba, "NETPLAY", CONFIG_TYPE_GROUP);
+        config_setting_set_string(config_setting_add(sub_setting, "PEER", CONFIG_TYPE_STRING), netplay.peer.c_str());
+        config_setting_set_int(config_setting_add(sub_setting, "PORT", CONFIG_TYPE_INT), netplay.port);
+        config_setting_set_int(config_setting_add(sub_setting, "DELAY", CONFIG_TYPE_INT), netplay.delay);
+        config_setting_set_int(config_setting_add(sub_setting, "ROLLBACK", CONFIG_TYPE_INT), netplay.rollback);
+        config_setting_set_int(config_setting_add(sub_setting, "LAG", CONFIG_TYPE_INT), netplay.lag);
+        config_setting_set_int(config_setting_add(sub_setting, "JITTER", CONFIG_TYPE_INT), netplay.jitter);
+        config_setting_set_int(config_setting_add(sub_setting, "LOSS", CONFIG_TYPE_INT), netplay.loss);
     }
 
     for (unsigned long i = 0; i < options->size(); i++) {
@@ -76,6 +76,17 @@ class Config {
 
 public:
 
+    // netplay settings, only in the config file ("NETPLAY" group)
+    struct NetplayOptions {
+        std::string peer;               // host to join
+        int port = 7845;
+        int delay = 1;                  // local input delay (frames)
+        int rollback = 8;               // most frames to roll back
+        int lag = 0;                    // injected latency (ms), for testing
+        int jitter = 0;                 // injected latency jitter (ms), for testing
+        int loss = 0;                   // injected packet loss (percent), for testing
+    };
+
     Config(const std::string &cfgPath, Renderer *renderer);
 
     ~Config() {};
@@ -92,6 +103,10 @@ public:
 
     std::vector<std::string> GetRomPaths();
 
+    const NetplayOptions &GetNetplayOptions() const {
+        return netplay;
+    }
+
     std::vector<Option> *GetGuiOptions();
 
     std::vector<Option> *GetRomOptions();
@@ -112,6 +127,7 @@ public:
 
 private:
     std::vector<std::string> roms_paths;
+    NetplayOptions netplay;
     std::vector<Option> options_gui;
     std::vector<Option> options_rom;
     std::string configPath;
@@ -88,6 +88,24 @@ void Gui::DrawRomInfo(RomList::Rom *rom) {
     }
     r.y += skin->font_small->size;
 
+    if (rom->state != RomList::RomState::MISSING) {
+        switch (BzipVerifyGetStatus(rom->drv)) {
+            case BZIP_VERIFY_OK:
+                renderer->DrawFont(skin->font_small, r, WHITE, "ROMSET: OK");
+                break;
+            case BZIP_VERIFY_BADCRC:
+                renderer->DrawFont(skin->font_small, r, WHITE, "ROMSET: BAD CRC");
+                break;
+            case BZIP_VERIFY_INCOMPLETE:
+                renderer->DrawFont(skin->font_small, r, WHITE, "ROMSET: INCOMPLETE");
+                break;
+            default:
+                renderer->DrawFont(skin->font_small, r, WHITE, "ROMSET: CHECKING...");
+                break;
+        }
+        r.y += skin->font_small->size;
+    }
+
     renderer->DrawFont(skin->font_small, r, WHITE, "SYSTEM: %s", rom->system);
     r.y += skin->font_small->size;
 
@@ -32,11 +32,22 @@ public:
         ROM_FILTER,
         ROM_SHADER,
         ROM_ROTATION,
+        ROM_COLOR_DEPTH,
         ROM_SHOW_FPS,
-        //ROM_M68K,
+        ROM_M68K,
+        ROM_SH2,
+        ROM_IDLE_SKIP,
         ROM_FRAMESKIP,
         ROM_NEOBIOS,
         ROM_AUDIO,
+        ROM_AUDIO_SYNC,
+        ROM_AUDIO_LATENCY,
+        ROM_AUDIO_RESAMPLER,
+        ROM_THREADED,
+        ROM_REWIND,
+        ROM_RUNAHEAD,
+        ROM_NETPLAY,
+        ROM_PROFILER,
         MENU_JOYPAD,
         JOY_UP,
         JOY_DOWN,
@@ -4,34 +4,185 @@
 
 #include <vector>
 #include <string>
-#include <algorithm>
+#include <cstring>
+#include <unordered_set>
 #include "skeleton/utility.h"
+#include "skeleton/timer.h"
+
+#ifndef __3DS__
+#include <SDL2/SDL.h>
+#endif
 
 #include "burner.h"
 #include "romlist.h"
 
+#define CACHE_MAGIC "pfba romlist cache 1"
+
+struct RomDir {
+    std::string path;
+    long mtime = 0;
+    std::vector<std::string> files;
+};
+
+// cache format: magic line, then for each directory a
+// "<mtime> <file count> <path>" line followed by one file name per line
+static std::vector<RomDir> LoadCache(const std::string &cachePath) {
+
+    std::vector<RomDir> dirs;
+
+    FILE *fp = fopen(cachePath.c_str(), "r");
+    if (fp == NULL) {
+        return dirs;
+    }
+
+    char line[MAX_PATH + 32];
+    if (fgets(line, sizeof(line), fp) == NULL
+        || strncmp(line, CACHE_MAGIC, strlen(CACHE_MAGIC)) != 0) {
+        fclose(fp);
+        return dirs;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        long mtime = 0;
+        int count = 0, offset = 0;
+        if (sscanf(line, "%li %i %n", &mtime, &count, &offset) != 2 || count < 0) {
+            break;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        RomDir dir;
+        dir.path = line + offset;
+        dir.mtime = mtime;
+        dir.files.reserve((size_t) count);
+        for (int i = 0; i < count && fgets(line, sizeof(line), fp) != NULL; i++) {
+            line[strcspn(line, "\r\n")] = '\0';
+            dir.files.push_back(line);
+        }
+        if ((int) dir.files.size() != count) {
+            // truncated cache
+            dirs.clear();
+            break;
+        }
+        dirs.push_back(dir);
+    }
+
+    fclose(fp);
+    return dirs;
+}
+
+static void SaveCache(const std::string &cachePath, const RomDir *dirs, int count) {
+
+    FILE *fp = fopen(cachePath.c_str(), "w");
+    if (fp == NULL) {
+        printf("RomList: could not write cache `%s`\n", cachePath.c_str());
+        return;
+    }
+
+    fprintf(fp, "%s\n", CACHE_MAGIC);
+    for (int i = 0; i < count; i++) {
+        if (dirs[i].path.empty() || dirs[i].mtime == 0) {
+            continue;
+        }
+        fprintf(fp, "%li %i %s\n", dirs[i].mtime, (int) dirs[i].files.size(), dirs[i].path.c_str());
+        for (unsigned int j = 0; j < dirs[i].files.size(); j++) {
+            fprintf(fp, "%s\n", dirs[i].files[j].c_str());
+        }
+    }
+
+    fclose(fp);
+}
+
+static int ScanThread(void *data) {
+    RomDir *dir = (RomDir *) data;
+    dir->files = Utility::GetFileList(dir->path.c_str());
+    return 0;
+}
+
 RomList::RomList(std::vector<Hardware> *hwList, const std::vector<std::string> &paths) {
 
     hardwareList = hwList;
 
     printf("RomList: building list...\n");
-    clock_t begin = clock();
+    Timer timer;
+
+    std::string cachePath = szAppHomePath;
+    cachePath += "romlist.cache";
+    std::vector<RomDir> cache = LoadCache(cachePath);
 
-    std::vector<std::string> files[DIRS_MAX];
-    for (unsigned int i = 0; i < paths.size(); i++) {
-        if (!paths[i].empty()) {
-            files[i] = Utility::GetFileList(paths[i].c_str());
-            printf("RomList: found %i files in `%s`\n", (int) files[i].size(), paths[i].c_str());
+    // reuse cached directories whose mtime didn't change, rescan the others
+    RomDir dirs[DIRS_MAX];
+    bool dirty = false;
+    unsigned int cachedCount = 0;
+#ifndef __3DS__
+    SDL_Thread *threads[DIRS_MAX] = {NULL};
+#endif
+    for (unsigned int i = 0; i < paths.size() && i < DIRS_MAX; i++) {
+        if (paths[i].empty()) {
+            continue;
+        }
+        dirs[i].path = paths[i];
+        dirs[i].mtime = Utility::GetModTime(paths[i].c_str());
+
+        bool cached = false;
+        for (unsigned int j = 0; j < cache.size(); j++) {
+            if (dirs[i].mtime != 0 && cache[j].mtime == dirs[i].mtime && cache[j].path == paths[i]) {
+                dirs[i].files.swap(cache[j].files);
+                cached = true;
+                cachedCount++;
+                break;
+            }
+        }
+        if (cached) {
+            continue;
+        }
+
+        dirty = true;
+#ifndef __3DS__
+        // directories may live on different devices, scan them in parallel
+        threads[i] = SDL_CreateThread(ScanThread, "pfba_romscan", &dirs[i]);
+        if (threads[i] == NULL) {
+            ScanThread(&dirs[i]);
+        }
+#else
+        ScanThread(&dirs[i]);
+#endif
+    }
+
+#ifndef __3DS__
+    for (int i = 0; i < DIRS_MAX; i++) {
+        if (threads[i] != NULL) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+#endif
+
+    size_t fileCount = 0;
+    for (int i = 0; i < DIRS_MAX; i++) {
+        if (!dirs[i].path.empty()) {
+            printf("RomList: found %i files in `%s`\n", (int) dirs[i].files.size(), dirs[i].path.c_str());
+            fileCount += dirs[i].files.size();
         }
     }
 
-    char path[MAX_PATH];
-    // TODO: fix sorting speed so we don't skip first 24 roms
-    for (UINT32 i = 24; i < nBurnDrvCount; i++) {
+    // something changed, or a cached directory isn't configured anymore
+    if (dirty || cachedCount != cache.size()) {
+        SaveCache(cachePath, dirs, DIRS_MAX);
+    }
+
+    std::unordered_set<std::string> files;
+    files.reserve(fileCount);
+    for (int i = 0; i < DIRS_MAX; i++) {
+        files.insert(dirs[i].files.begin(), dirs[i].files.end());
+        dirs[i].files.clear();
+    }
+
+    list.reserve(nBurnDrvCount);
+    std::string zip;
+    for (UINT32 i = 0; i < nBurnDrvCount; i++) {
 
         nBurnDrvActive = i;
 
         Rom rom;
+        rom.drv = i;
         rom.zip = BurnDrvGetTextA(DRV_NAME);
         rom.parent = BurnDrvGetTextA(DRV_PARENT);
         rom.name = BurnDrvGetTextA(DRV_FULLNAME);
@@ -58,24 +209,19 @@ RomList::RomList(std::vector<Hardware> *hwList, const std::vector<std::string> &
             }
         }
 
-        for (int j = 0; j < DIRS_MAX; j++) {
-            if (files[j].empty()) {
-                continue;
+        zip = rom.zip;
+        zip += ".zip";
+        if (files.count(zip)) {
+            rom.state = BurnDrvIsWorking() ? RomState::WORKING : RomState::NOT_WORKING;
+            hardwareList->at(0).available_count++;
+            if (rom.parent) {
+                hardwareList->at(0).available_clone_count++;
             }
-            sprintf(path, "%s.zip", rom.zip);
-            if (std::find(files[j].begin(), files[j].end(), path) != files[j].end()) {
-                rom.state = BurnDrvIsWorking() ? RomState::WORKING : RomState::NOT_WORKING;
-                hardwareList->at(0).available_count++;
+            if (hardware) {
+                hardware->available_count++;
                 if (rom.parent) {
-                    hardwareList->at(0).available_clone_count++;
-                }
-                if (hardware) {
-                    hardware->available_count++;
-                    if (rom.parent) {
-                        hardware->available_clone_count++;
-                    }
+                    hardware->available_clone_count++;
                 }
-                break;
             }
         }
 
@@ -104,13 +250,7 @@ RomList::RomList(std::vector<Hardware> *hwList, const std::vector<std::string> &
     }
     */
 
-    for (int i = 0; i < DIRS_MAX; i++) {
-        files[i].clear();
-    }
-
-    clock_t end = clock();
-    double time_spent = (double) (end - begin) / CLOCKS_PER_SEC;
-    printf("RomList: list built in %f\n", time_spent);
+    printf("RomList: list built in %lu ms\n", timer.GetMillis());
 }
 
 RomList::~RomList() {
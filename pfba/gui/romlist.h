@@ -53,6 +53,7 @@ public:
         char *system;
         int genre;
         int size;
+        unsigned int drv;
     };
 
     std::vector<Rom> list;
@@ -268,6 +268,8 @@ int InpExit() {
     return 0;
 }
 
+int InpSet(Input::Player *players);
+
 int InpMake(Input::Player *players) {
 
     if (!bInputOk)
@@ -278,6 +280,15 @@ int InpMake(Input::Player *players) {
     if (skip > 1) skip = 0;
     if (skip != 1) return 1;
 
+    return InpSet(players);
+}
+
+// write the players state to the driver inputs, every call (netplay needs every frame)
+int InpSet(Input::Player *players) {
+
+    if (!bInputOk)
+        return 1;
+
     unsigned int i = 0;
     unsigned int down = 0;
     if (ServiceDip) {
@@ -0,0 +1,64 @@
+//
+// Created on 16/10/26.
+//
+
+#ifndef _MAILBOX_H_
+#define _MAILBOX_H_
+
+#include <atomic>
+
+// Lock-free triple buffer index mailbox, one producer and one consumer.
+// The producer always owns "back", the consumer always owns "front",
+// and the third index lives in "state" along with a "fresh" bit telling
+// if it holds a buffer the consumer has not seen yet.
+class Mailbox {
+
+public:
+
+    Mailbox() {
+        Reset();
+    }
+
+    void Reset() {
+        back = 0;
+        state.store(1);
+        front = 2;
+    }
+
+    // producer: buffer to fill
+    int GetBack() const {
+        return back;
+    }
+
+    // producer: hand the filled buffer over, get the previous mailbox one back
+    void Publish() {
+        back = state.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // consumer: swap in the newest published buffer, false if none since last call
+    bool Acquire() {
+        if (!(state.load(std::memory_order_acquire) & FRESH)) {
+            return false;
+        }
+        front = state.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    // consumer: buffer to read
+    int GetFront() const {
+        return front;
+    }
+
+private:
+
+    enum {
+        INDEX = 0x3,
+        FRESH = 0x4
+    };
+
+    std::atomic<int> state;
+    int back = 0;
+    int front = 2;
+};
+
+#endif //_MAILBOX_H_
@@ -69,6 +69,7 @@ int main(int argc, char **argv) {
     sceIoMkdir("ux0:/data/pfba/samples", 0777);
     sceIoMkdir("ux0:/data/pfba/previews", 0777);
     sceIoMkdir("ux0:/data/pfba/blend", 0777);
+    sceIoMkdir("ux0:/data/pfba/cache", 0777);
     sceIoMkdir("ux0:/data/pfba/roms", 0777);
     sceIoMkdir("ux0:/data/pfba/config", 0777);
     sceIoMkdir("ux0:/data/pfba/config/games", 0777);
@@ -119,8 +120,13 @@ int main(int argc, char **argv) {
     gui->SetTitleLoadDelay(500);
 #endif
 
+    // check available romsets in the background
+    BzipVerifyStart();
+
     gui->Run();
 
+    BzipVerifyStop();
+
     BurnLibExit();
 
     delete (gui);
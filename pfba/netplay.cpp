@@ -0,0 +1,550 @@
+//
+// Created on 16/10/26.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "burner.h"
+#include "burn_state.h"
+#include "netplay.h"
+#include "pacer.h"
+
+#ifdef NETPLAY_UDP
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __PSP2_DEBUG__
+#include <psp2/kernel/clib.h>
+#define printf sceClibPrintf
+#endif
+
+#define NET_MAGIC           0x504e4650  // "PFNP"
+#define NET_RING            128         // inputs kept, well above rollback + delay + resends
+#define NET_MAX_SEND        32          // most inputs in a datagram
+#define NET_HASH_INTERVAL   30          // frames between two state hashes
+
+int InpSet(Input::Player *players);
+
+// ----------------------------------------------------------------------------
+// udp
+
+UdpTransport::UdpTransport(const char *host, int port) {
+
+#ifdef NETPLAY_UDP
+    memset(&peer, 0, sizeof(peer));
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        printf("UdpTransport: could not create socket\n");
+        return;
+    }
+
+    if (host == NULL) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons((uint16_t) port);
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+            printf("UdpTransport: could not bind port %i\n", port);
+            close(fd);
+            fd = -1;
+            return;
+        }
+        printf("UdpTransport: waiting for a peer on port %i\n", port);
+    } else {
+        struct addrinfo hints, *res = NULL;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        if (getaddrinfo(host, NULL, &hints, &res) != 0 || res == NULL) {
+            printf("UdpTransport: could not resolve %s\n", host);
+            close(fd);
+            fd = -1;
+            return;
+        }
+        memcpy(&peer, res->ai_addr, sizeof(peer));
+        peer.sin_port = htons((uint16_t) port);
+        freeaddrinfo(res);
+        connected = true;
+        printf("UdpTransport: joining %s:%i\n", inet_ntoa(peer.sin_addr), port);
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#else
+    printf("UdpTransport: not supported on this platform\n");
+#endif
+}
+
+UdpTransport::~UdpTransport() {
+#ifdef NETPLAY_UDP
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+bool UdpTransport::IsOpen() {
+#ifdef NETPLAY_UDP
+    return fd >= 0;
+#else
+    return false;
+#endif
+}
+
+bool UdpTransport::Send(const void *data, int size) {
+#ifdef NETPLAY_UDP
+    if (fd < 0 || !connected) {
+        return false;
+    }
+    return sendto(fd, data, (size_t) size, 0, (struct sockaddr *) &peer, sizeof(peer)) == size;
+#else
+    return false;
+#endif
+}
+
+int UdpTransport::Receive(void *data, int size) {
+#ifdef NETPLAY_UDP
+    if (fd < 0) {
+        return 0;
+    }
+
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t len = sizeof(from);
+        ssize_t n = recvfrom(fd, data, (size_t) size, 0, (struct sockaddr *) &from, &len);
+        if (n <= 0) {
+            return 0;
+        }
+        if (!connected) {
+            // hosting: the first one to talk is our peer
+            peer = from;
+            connected = true;
+            printf("UdpTransport: peer %s:%i connected\n", inet_ntoa(peer.sin_addr), ntohs(peer.sin_port));
+        } else if (from.sin_addr.s_addr != peer.sin_addr.s_addr || from.sin_port != peer.sin_port) {
+            continue;
+        }
+        return (int) n;
+    }
+#else
+    return 0;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// injected latency and loss
+
+LagTransport::LagTransport(NetTransport *transport, int latency, int jitter, int loss) {
+    this->transport = transport;
+    this->latency = latency;
+    this->jitter = jitter;
+    this->loss = loss;
+    printf("LagTransport: latency = %ims +- %ims, loss = %i%%\n", latency, jitter, loss);
+}
+
+LagTransport::~LagTransport() {
+    delete (transport);
+}
+
+bool LagTransport::IsOpen() {
+    return transport->IsOpen();
+}
+
+uint32_t LagTransport::Random() {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+void LagTransport::Flush() {
+
+    int64_t now = Pacer::GetMicros();
+
+    // jitter may reorder datagrams, as a real network would
+    for (std::deque<Packet>::iterator it = packets.begin(); it != packets.end();) {
+        if (it->time <= now) {
+            transport->Send(it->data.data(), (int) it->data.size());
+            it = packets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool LagTransport::Send(const void *data, int size) {
+
+    if (loss > 0 && (int) (Random() % 100) < loss) {
+        Flush();
+        return true;
+    }
+
+    Packet packet;
+    int delay = latency * 1000;
+    if (jitter > 0) {
+        delay += (int) (Random() % (uint32_t) (jitter * 2000 + 1)) - jitter * 1000;
+    }
+    packet.time = Pacer::GetMicros() + (delay > 0 ? delay : 0);
+    packet.data.assign((const uint8_t *) data, (const uint8_t *) data + size);
+    packets.push_back(packet);
+
+    Flush();
+    return true;
+}
+
+int LagTransport::Receive(void *data, int size) {
+    Flush();
+    return transport->Receive(data, size);
+}
+
+// ----------------------------------------------------------------------------
+// rollback
+
+struct NetPacket {
+    uint32_t magic;
+    int32_t frame;                      // frame of inputs[0]
+    int32_t count;
+    int32_t ack;                        // newest input received from the peer
+    int32_t advantage;                  // frames the sender is ahead of the inputs it received
+    int32_t hash_frame;                 // -1: no hash
+    uint32_t hash;
+    uint32_t pad;
+    int64_t ping;                       // sender clock
+    int64_t pong;                       // last ping received, echoed back
+};
+
+Netplay::Netplay(NetTransport *transport, int local, int delay, int rollback) {
+
+    this->transport = transport;
+    this->local = local ? 1 : 0;
+    this->delay = delay > 0 ? delay : 0;
+    this->max_rollback = rollback > 0 ? rollback : 1;
+    if (this->max_rollback + this->delay + NET_MAX_SEND > NET_RING / 2) {
+        this->max_rollback = NET_RING / 2 - this->delay - NET_MAX_SEND;
+    }
+
+    local_inputs.resize(NET_RING);
+    remote_inputs.resize(NET_RING);
+    used_inputs.resize(NET_RING);
+    memset(local_hashes, 0xff, sizeof(local_hashes));
+    memset(remote_hashes, 0xff, sizeof(remote_hashes));
+
+    int size = BurnStateMemGetSize();
+    if (size <= 0) {
+        printf("Netplay: the driver has no savestate support\n");
+        return;
+    }
+
+    // the state each frame starts from, back to the oldest we may roll back to
+    state_count = this->max_rollback + 2;
+    states = (uint8_t *) malloc((size_t) size * state_count);
+    if (states == NULL) {
+        printf("Netplay: could not allocate %i KB\n", size * state_count / 1024);
+        return;
+    }
+    state_frames.assign((size_t) state_count, -1);
+    state_size = size;
+
+    printf("Netplay: player %i, input delay = %i, rollback = %i frames, state = %i bytes\n",
+           this->local + 1, this->delay, this->max_rollback, state_size);
+}
+
+Netplay::~Netplay() {
+    free(states);
+    delete (transport);
+}
+
+void Netplay::SaveState(int f) {
+
+    int slot = f % state_count;
+    BurnStateMemSave(states + (size_t) slot * state_size, state_size);
+    state_frames[slot] = f;
+}
+
+bool Netplay::LoadState(int f) {
+
+    int slot = f % state_count;
+    if (state_frames[slot] != f) {
+        return false;
+    }
+    return BurnStateMemLoad(states + (size_t) slot * state_size, state_size) == 0;
+}
+
+// predicted (the last one we got) if it didn't arrive yet
+const Netplay::NetInput &Netplay::GetRemoteInput(int f) {
+
+    static const NetInput none = {0, 0, 0, 0, 0};
+
+    if (f <= remote_last) {
+        return remote_inputs[f % NET_RING];
+    }
+    return remote_last >= 0 ? remote_inputs[remote_last % NET_RING] : none;
+}
+
+void Netplay::SetInputs(Input::Player *players, int f) {
+
+    Input::Player net[PLAYER_COUNT];
+    memcpy(net, players, sizeof(net));
+
+    const NetInput &remote = GetRemoteInput(f);
+    used_inputs[f % NET_RING] = remote;
+
+    for (int p = 0; p < PLAYER_COUNT; p++) {
+        const NetInput *in = NULL;
+        if (p == local) {
+            in = &local_inputs[f % NET_RING];
+        } else if (p == 1 - local) {
+            in = &remote;
+        }
+        net[p].enabled = true;
+        net[p].state = in ? in->state : 0;
+        net[p].lx.value = in ? in->lx : (short) 0;
+        net[p].ly.value = in ? in->ly : (short) 0;
+        net[p].ry.value = in ? in->ry : (short) 0;
+    }
+
+    InpSet(net);
+}
+
+static uint32_t HashBuffer(const uint8_t *data, int size) {
+
+    uint32_t hash = 2166136261u;
+    int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        uint32_t w;
+        memcpy(&w, data + i, 4);
+        hash = (hash ^ w) * 16777619u;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+// hash the newest saved state every input before it is confirmed for
+void Netplay::HashState() {
+
+    int f = ((remote_last + 1) / NET_HASH_INTERVAL) * NET_HASH_INTERVAL;
+    if (f <= hashed_frame || f > frame || state_frames[f % state_count] != f) {
+        return;
+    }
+
+    Hash &h = local_hashes[(f / NET_HASH_INTERVAL) % 16];
+    h.frame = f;
+    h.hash = HashBuffer(states + (size_t) (f % state_count) * state_size, state_size);
+    hashed_frame = f;
+
+    CheckHash(f);
+}
+
+void Netplay::CheckHash(int f) {
+
+    const Hash &l = local_hashes[(f / NET_HASH_INTERVAL) % 16];
+    const Hash &r = remote_hashes[(f / NET_HASH_INTERVAL) % 16];
+
+    if (l.frame == f && r.frame == f && l.hash != r.hash && desync_frame < 0) {
+        desync_frame = f;
+        printf("Netplay: desync at frame %i (%08x != %08x)\n", f, l.hash, r.hash);
+    }
+}
+
+void Netplay::Poll() {
+
+    uint8_t buffer[sizeof(NetPacket) + NET_MAX_SEND * sizeof(NetInput)];
+    int size;
+
+    while ((size = transport->Receive(buffer, sizeof(buffer))) > 0) {
+
+        NetPacket p;
+        if (size < (int) sizeof(p)) {
+            continue;
+        }
+        memcpy(&p, buffer, sizeof(p));
+        if (p.magic != NET_MAGIC || p.count < 0 || p.count > NET_MAX_SEND
+            || size < (int) (sizeof(p) + p.count * sizeof(NetInput))) {
+            continue;
+        }
+        stats.received++;
+
+        // take the inputs in order, a gap waits for the resend
+        const NetInput *inputs = (const NetInput *) (buffer + sizeof(p));
+        for (int i = 0; i < p.count; i++) {
+            int f = p.frame + i;
+            if (f <= remote_last) {
+                continue;
+            }
+            if (f != remote_last + 1) {
+                break;
+            }
+            if (f < frame && memcmp(&used_inputs[f % NET_RING], &inputs[i], sizeof(NetInput)) != 0) {
+                if (rollback_to < 0 || f < rollback_to) {
+                    rollback_to = f;
+                }
+            }
+            remote_inputs[f % NET_RING] = inputs[i];
+            remote_last = f;
+        }
+
+        if (p.ack > remote_ack) {
+            remote_ack = p.ack;
+        }
+        remote_advantage = p.advantage;
+
+        if (p.pong > 0) {
+            int rtt = (int) (Pacer::GetMicros() - p.pong);
+            stats.rtt = stats.rtt == 0 ? rtt : stats.rtt + (rtt - stats.rtt) / 8;
+        }
+        remote_ping = p.ping;
+
+        if (p.hash_frame >= 0) {
+            Hash &h = remote_hashes[(p.hash_frame / NET_HASH_INTERVAL) % 16];
+            h.frame = p.hash_frame;
+            h.hash = p.hash;
+            CheckHash(p.hash_frame);
+        }
+    }
+}
+
+// send every input the peer didn't acknowledge yet
+void Netplay::Send() {
+
+    uint8_t buffer[sizeof(NetPacket) + NET_MAX_SEND * sizeof(NetInput)];
+    NetPacket p;
+
+    int first = remote_ack + 1;
+    int count = local_last - first + 1;
+    if (count > NET_MAX_SEND) {
+        count = NET_MAX_SEND;
+    }
+    if (count < 0) {
+        count = 0;
+    }
+
+    p.magic = NET_MAGIC;
+    p.frame = first;
+    p.count = count;
+    p.ack = remote_last;
+    p.advantage = frame - (remote_last + 1);
+    p.hash_frame = hashed_frame;
+    p.hash = hashed_frame >= 0 ? local_hashes[(hashed_frame / NET_HASH_INTERVAL) % 16].hash : 0;
+    p.pad = 0;
+    p.ping = Pacer::GetMicros();
+    p.pong = remote_ping;
+
+    memcpy(buffer, &p, sizeof(p));
+    for (int i = 0; i < count; i++) {
+        memcpy(buffer + sizeof(p) + i * sizeof(NetInput), &local_inputs[(first + i) % NET_RING], sizeof(NetInput));
+    }
+
+    if (transport->Send(buffer, (int) (sizeof(p) + count * sizeof(NetInput)))) {
+        stats.sent++;
+    }
+}
+
+// go back to the first mispredicted frame and emulate up to the current one again, hidden
+void Netplay::Rollback(Input::Player *players) {
+
+    int target = rollback_to;
+    rollback_to = -1;
+
+    if (!LoadState(target)) {
+        printf("Netplay: frame %i state is gone, can't roll back\n", target);
+        if (desync_frame < 0) {
+            desync_frame = target;
+        }
+        return;
+    }
+
+    UINT8 *draw = pBurnDraw;
+    INT16 *sound = pBurnSoundOut;
+    pBurnDraw = NULL;
+    pBurnSoundOut = NULL;
+
+    for (int f = target; f < frame; f++) {
+        if (f > target) {
+            SaveState(f);
+        }
+        SetInputs(players, f);
+        nCurrentFrame++;
+        BurnDrvFrame();
+    }
+
+    pBurnDraw = draw;
+    pBurnSoundOut = sound;
+
+    stats.rollbacks++;
+    stats.resimulated += frame - target;
+    if (frame - target > stats.max_rollback) {
+        stats.max_rollback = frame - target;
+    }
+}
+
+bool Netplay::Begin(Input::Player *players) {
+
+    if (!IsAvailable()) {
+        InpSet(players);
+        return true;
+    }
+
+    Poll();
+
+    // local inputs take effect "delay" frames later
+    if (local_last < 0) {
+        memset(&local_inputs[0], 0, sizeof(NetInput) * local_inputs.size());
+        local_last = delay - 1;
+    }
+    while (local_last < frame + delay) {
+        local_last++;
+        NetInput &in = local_inputs[local_last % NET_RING];
+        in.state = players[0].state;
+        in.lx = players[0].lx.value;
+        in.ly = players[0].ly.value;
+        in.ry = players[0].ry.value;
+        in.pad = 0;
+    }
+
+    Send();
+
+    if (rollback_to >= 0) {
+        Rollback(players);
+    }
+
+    // don't get more than "max_rollback" frames ahead of the peer inputs
+    if (frame - (remote_last + 1) >= max_rollback) {
+        stats.stalls++;
+        return false;
+    }
+
+    // time sync: the side further ahead waits a frame now and then so both see the same lag
+    int advantage = frame - (remote_last + 1);
+    if (advantage - remote_advantage >= 2 && (frame % 4) == 0) {
+        stats.stalls++;
+        return false;
+    }
+
+    SaveState(frame);
+    HashState();
+    SetInputs(players, frame);
+
+    return true;
+}
+
+void Netplay::End() {
+    frame++;
+    stats.frames++;
+}
+
+void Netplay::PrintStats() {
+
+    printf("Netplay: frames = %u, stalls = %u, rollbacks = %u, resimulated = %u, longest rollback = %i\n",
+           stats.frames, stats.stalls, stats.rollbacks, stats.resimulated, stats.max_rollback);
+    printf("Netplay: sent = %u, received = %u, rtt = %ius%s\n",
+           stats.sent, stats.received, stats.rtt, desync_frame >= 0 ? ", DESYNC" : "");
+}
@@ -0,0 +1,208 @@
+//
+// Created on 16/10/26.
+//
+
+#ifndef _NETPLAY_H_
+#define _NETPLAY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <vector>
+#include <skeleton/input.h>
+
+#if !defined(__PSP2__) && !defined(__3DS__)
+#define NETPLAY_UDP
+#include <netinet/in.h>
+#endif
+
+// Datagram transport used by netplay: unreliable, unordered and non blocking
+class NetTransport {
+
+public:
+
+    virtual ~NetTransport() {}
+
+    virtual bool IsOpen() = 0;
+
+    // send a datagram to the peer, false if it couldn't be sent
+    virtual bool Send(const void *data, int size) = 0;
+
+    // receive a pending datagram, return its size or 0 if there is none
+    virtual int Receive(void *data, int size) = 0;
+};
+
+// UDP transport. Hosting (host == NULL) binds "port" and talks to the first
+// peer that sends something, joining talks to host:port from any local port.
+class UdpTransport : public NetTransport {
+
+public:
+
+    UdpTransport(const char *host, int port);
+
+    ~UdpTransport();
+
+    bool IsOpen();
+
+    bool Send(const void *data, int size);
+
+    int Receive(void *data, int size);
+
+private:
+
+#ifdef NETPLAY_UDP
+    int fd = -1;
+    bool connected = false;
+    struct sockaddr_in peer;
+#endif
+};
+
+// Test stand-in: delays the datagrams sent through "transport" by latency
+// (+- jitter) ms and drops "loss" percent of them, so netplay can be tried
+// against a second instance on the same box (owns "transport").
+class LagTransport : public NetTransport {
+
+public:
+
+    LagTransport(NetTransport *transport, int latency, int jitter, int loss);
+
+    ~LagTransport();
+
+    bool IsOpen();
+
+    bool Send(const void *data, int size);
+
+    int Receive(void *data, int size);
+
+private:
+
+    struct Packet {
+        int64_t time;
+        std::vector<uint8_t> data;
+    };
+
+    void Flush();
+
+    uint32_t Random();
+
+    NetTransport *transport;
+    int latency;
+    int jitter;
+    int loss;
+    uint32_t seed = 0x9e3779b9;
+    std::deque<Packet> packets;
+};
+
+// Rollback netplay for two players. Inputs are exchanged every frame (with
+// the unacknowledged ones resent), the peer input is predicted when it hasn't
+// arrived yet, and when it arrives different from the prediction the game is
+// rolled back to that frame through a memory savestate and emulated again,
+// hidden, up to the current frame. Confirmed states are hashed now and then
+// and the hashes exchanged to detect a desync.
+class Netplay {
+
+public:
+
+    struct Stats {
+        unsigned int frames = 0;        // frames emulated
+        unsigned int stalls = 0;        // frames waited for the peer
+        unsigned int rollbacks = 0;     // mispredictions rolled back
+        unsigned int resimulated = 0;   // frames emulated again
+        int max_rollback = 0;           // longest rollback (frames)
+        unsigned int sent = 0;          // datagrams sent
+        unsigned int received = 0;      // datagrams received
+        int rtt = 0;                    // average round trip time (us)
+    };
+
+    // local: player we control (0: P1, 1: P2), delay: frames of local input delay,
+    // rollback: most frames we may run ahead of the peer inputs (owns "transport")
+    Netplay(NetTransport *transport, int local, int delay, int rollback);
+
+    ~Netplay();
+
+    bool IsAvailable() const {
+        return state_size > 0 && transport->IsOpen();
+    }
+
+    // call in place of InpMake before emulating a frame: exchanges inputs, rolls
+    // back if needed and sets the driver inputs. players[0] is the local controller.
+    // Returns false if the frame can't be emulated yet (waiting for the peer).
+    bool Begin(Input::Player *players);
+
+    // call after the frame was emulated
+    void End();
+
+    bool IsDesynced() const {
+        return desync_frame >= 0;
+    }
+
+    const Stats &GetStats() const {
+        return stats;
+    }
+
+    void PrintStats();
+
+private:
+
+    struct NetInput {
+        uint32_t state;
+        int16_t lx;
+        int16_t ly;
+        int16_t ry;
+        int16_t pad;
+    };
+
+    struct Hash {
+        int frame;
+        uint32_t hash;
+    };
+
+    void Poll();
+
+    void Send();
+
+    void Rollback(Input::Player *players);
+
+    void SetInputs(Input::Player *players, int frame);
+
+    const NetInput &GetRemoteInput(int frame);
+
+    void SaveState(int frame);
+
+    bool LoadState(int frame);
+
+    void HashState();
+
+    void CheckHash(int frame);
+
+    NetTransport *transport;
+    int local = 0;
+    int delay = 0;
+    int max_rollback = 8;
+
+    int frame = 0;                      // next frame to emulate
+    int local_last = -1;                // newest local input
+    int remote_last = -1;               // newest remote input, all the ones before it received too
+    int remote_ack = -1;                // newest local input the peer has
+    int remote_advantage = 0;           // how many frames the peer is ahead of our inputs
+    int rollback_to = -1;               // oldest frame emulated with a wrong prediction
+    int64_t remote_ping = 0;            // peer clock to echo back
+
+    std::vector<NetInput> local_inputs;
+    std::vector<NetInput> remote_inputs;
+    std::vector<NetInput> used_inputs;  // remote inputs the frames were emulated with
+
+    int state_size = 0;
+    int state_count = 0;
+    uint8_t *states = NULL;
+    std::vector<int> state_frames;
+
+    int hashed_frame = -1;
+    Hash local_hashes[16];
+    Hash remote_hashes[16];
+    int desync_frame = -1;
+
+    Stats stats;
+};
+
+#endif //_NETPLAY_H_
@@ -0,0 +1,220 @@
+//
+// Created on 16/10/26.
+//
+
+#include <cstdio>
+#include <cerrno>
+#include <time.h>
+
+#ifdef __PSP2__
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+#elif __3DS__
+#include <3ds.h>
+#include <sys/time.h>
+#endif
+
+#include "pacer.h"
+
+#ifdef __PSP2_DEBUG__
+#include <psp2/kernel/clib.h>
+#define printf sceClibPrintf
+#endif
+
+Pacer::Pacer(int fps) {
+    this->fps = fps > 0 ? fps : 6000;
+    period = 100000000 / this->fps;
+    Reset();
+}
+
+void Pacer::Reset() {
+    start = GetMicros();
+    frame = 0;
+    skip_count = 0;
+    draw = true;
+    late = false;
+}
+
+int64_t Pacer::GetMicros() {
+#ifdef __PSP2__
+    return (int64_t) sceKernelGetProcessTimeWide();
+#elif __3DS__
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (int64_t) now.tv_sec * 1000000 + now.tv_usec;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+// deadlines are computed from the frame count, not accumulated,
+// so the period rounding (16683.35us at 59.94Hz) never drifts
+int64_t Pacer::GetDeadline(int64_t f) {
+    return start + (f * 100000000) / fps;
+}
+
+void Pacer::SleepUntil(int64_t deadline) {
+
+    int64_t now = GetMicros();
+
+    // let the os sleep until "spin" us before the deadline...
+    if (deadline - now > spin) {
+        int64_t target = deadline - spin;
+#ifdef __PSP2__
+        sceKernelDelayThread((SceUInt) (target - now));
+#elif __3DS__
+        svcSleepThread((s64) (target - now) * 1000);
+#else
+        struct timespec ts;
+        ts.tv_sec = (time_t) (target / 1000000);
+        ts.tv_nsec = (long) ((target % 1000000) * 1000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#endif
+        int64_t after = GetMicros();
+        int error = (int) (after - target);
+        stats.sleep_error += (error - stats.sleep_error) / 8;
+        // keep the margin a bit above the os sleep error
+        spin = stats.sleep_error * 2 + 100;
+        if (spin < 100) {
+            spin = 100;
+        } else if (spin > 4000) {
+            spin = 4000;
+        }
+        stats.slept += after - now;
+        now = after;
+    }
+
+    // ...then spin the remaining sub-millisecond
+    int64_t spin_start = now;
+    while (now < deadline) {
+        now = GetMicros();
+    }
+    stats.spun += now - spin_start;
+}
+
+void Pacer::SetAudio(Audio *audio) {
+    this->audio = audio;
+}
+
+bool Pacer::WaitAudio(bool frameskip) {
+
+    int64_t bytes_per_sec = (int64_t) audio->frequency * audio->channels * 2;
+    int64_t timeout = GetMicros() + period * 2;
+
+    // wait for the device to drain the queue down to its target
+    int buffered = audio->GetBufferedBytes();
+    while (buffered > audio->latency) {
+        int64_t now = GetMicros();
+        if (now >= timeout) {
+            break;
+        }
+        int64_t wait = ((int64_t) (buffered - audio->latency) * 1000000) / bytes_per_sec;
+        SleepUntil(now + (wait < timeout - now ? wait : timeout - now));
+        buffered = audio->GetBufferedBytes();
+    }
+
+    stats.audio_buffered += (buffered - stats.audio_buffered) / 8;
+
+    // the device (nearly) starved during the last frame, skip drawing to catch up
+    draw = !frameskip
+           || skip_count >= max_skip
+           || !late;
+
+    if (draw) {
+        skip_count = 0;
+    } else {
+        skip_count++;
+        stats.skipped++;
+    }
+
+    return draw;
+}
+
+bool Pacer::Wait(bool frameskip) {
+
+    if (audio != NULL && audio->sync && !audio->paused) {
+        return WaitAudio(frameskip);
+    }
+
+    int64_t deadline = GetDeadline(frame);
+    int64_t now = GetMicros();
+
+    if (now < deadline) {
+        SleepUntil(deadline);
+        now = GetMicros();
+    } else if (now - deadline > period * (max_skip + 1)) {
+        // too far behind (menu, loading, slow host), don't try to catch up
+        stats.resyncs++;
+        start = now;
+        frame = 0;
+    } else if (now - deadline > period) {
+        stats.late++;
+    }
+
+    // draw if the measured cost lets us finish before the next deadline
+    draw = !frameskip
+           || skip_count >= max_skip
+           || now + stats.frame_cost <= GetDeadline(frame + 1);
+
+    if (draw) {
+        skip_count = 0;
+    } else {
+        skip_count++;
+        stats.skipped++;
+    }
+
+    return draw;
+}
+
+void Pacer::BeginFrame() {
+    frame_start = GetMicros();
+}
+
+void Pacer::EndFrame() {
+
+    int cost = (int) (GetMicros() - frame_start);
+
+    // audio sync: what is left in the queue once the frame is emulated, before its audio
+    // is queued. The target can be less than a frame (4 / 8 / 16 ms), the queue was at
+    // the target when the frame started, so it's late if the frame ate most of it
+    if (audio != NULL && audio->sync && !audio->paused) {
+        late = audio->GetBufferedBytes() < audio->latency / 4;
+        if (late) {
+            stats.underruns++;
+        }
+    }
+
+    if (draw) {
+        stats.frame_cost += (cost - stats.frame_cost) / 8;
+    } else {
+        stats.skip_cost += (cost - stats.skip_cost) / 8;
+    }
+    stats.busy += cost;
+    stats.frames++;
+    frame++;
+}
+
+int Pacer::GetLoad() {
+    return (int) ((stats.frame_cost * 100) / period);
+}
+
+void Pacer::PrintStats() {
+
+    int64_t total = stats.busy + stats.slept + stats.spun;
+    if (total <= 0) {
+        total = 1;
+    }
+
+    printf("Pacer: frames = %u, skipped = %u, late = %u, resyncs = %u\n",
+           stats.frames, stats.skipped, stats.late, stats.resyncs);
+    printf("Pacer: frame cost = %ius (skipped: %ius), period = %ius, sleep error = %ius\n",
+           stats.frame_cost, stats.skip_cost, (int) period, stats.sleep_error);
+    if (audio != NULL && audio->sync) {
+        printf("Pacer: audio sync, latency = %i bytes, queued = %i bytes, underruns = %u\n",
+               audio->latency, stats.audio_buffered, stats.underruns);
+    }
+    printf("Pacer: busy = %i%%, sleep = %i%%, spin = %i%%\n",
+           (int) (stats.busy * 100 / total), (int) (stats.slept * 100 / total), (int) (stats.spun * 100 / total));
+}
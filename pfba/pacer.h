@@ -0,0 +1,84 @@
+//
+// Created on 16/10/26.
+//
+
+#ifndef _PACER_H_
+#define _PACER_H_
+
+#include <stdint.h>
+#include <skeleton/audio.h>
+
+// Frame pacer: sleeps until each frame deadline (then spins the last
+// sub-millisecond), computes deadlines from the frame count so rounding
+// never accumulates, and decides which frames to skip from the measured
+// cost of BurnDrvFrame. In audio sync mode the audio device queue is the
+// clock: frames are emulated whenever the queue drops to its target size.
+class Pacer {
+
+public:
+
+    struct Stats {
+        unsigned int frames = 0;        // frames emulated
+        unsigned int skipped = 0;       // frames emulated without drawing
+        unsigned int resyncs = 0;       // times we gave up catching up
+        unsigned int late = 0;          // frames started after their deadline
+        int frame_cost = 0;             // average BurnDrvFrame cost (drawn frames, us)
+        int skip_cost = 0;              // average BurnDrvFrame cost (skipped frames, us)
+        int sleep_error = 0;            // average oversleep of the os sleep (us)
+        int audio_buffered = 0;         // average audio queue size when starting a frame (bytes)
+        unsigned int underruns = 0;     // frames that left less than 1/4 of the latency queued
+        int64_t slept = 0;              // total time slept (us)
+        int64_t spun = 0;               // total time spent spinning (us)
+        int64_t busy = 0;               // total time spent emulating (us)
+    };
+
+    // fps: nBurnFPS (frames per second * 100)
+    Pacer(int fps);
+
+    void Reset();
+
+    // follow the audio device queue instead of the clock (audio->sync)
+    void SetAudio(Audio *audio);
+
+    // wait for the next frame deadline, return true if the frame should be drawn
+    bool Wait(bool frameskip);
+
+    void BeginFrame();
+
+    // call before queuing the frame's audio
+    void EndFrame();
+
+    // percentage of the frame period spent emulating
+    int GetLoad();
+
+    const Stats &GetStats() const {
+        return stats;
+    }
+
+    void PrintStats();
+
+    static int64_t GetMicros();
+
+private:
+
+    int64_t GetDeadline(int64_t frame);
+
+    void SleepUntil(int64_t deadline);
+
+    bool WaitAudio(bool frameskip);
+
+    int fps = 6000;
+    int64_t period = 0;
+    int64_t start = 0;
+    int64_t frame = 0;
+    int64_t frame_start = 0;
+    int spin = 1000;                    // sleep margin, adapted to the os sleep error
+    int max_skip = 9;
+    int skip_count = 0;
+    bool draw = true;
+    bool late = false;                  // audio sync: the last frame nearly starved the device
+    Audio *audio = NULL;
+    Stats stats;
+};
+
+#endif //_PACER_H_
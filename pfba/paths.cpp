@@ -13,6 +13,7 @@ char szAppHiscorePath[MAX_PATH] = "ux0:/data/pfba/hiscore";
 char szAppSamplesPath[MAX_PATH] = "ux0:/data/pfba/samples";
 char szAppPreviewPath[MAX_PATH] = "ux0:/data/pfba/previews";
 char szAppBlendPath[MAX_PATH] = "ux0:/data/pfba/blend/";
+char szAppCachePath[MAX_PATH] = "ux0:/data/pfba/cache/";
 char szAppNvPath[MAX_PATH] = "ux0:/data/pfba/config/games";
 char szAppSkinPath[MAX_PATH] = "app0:/skin";
 #else
@@ -23,9 +24,11 @@ char szAppHiscorePath[MAX_PATH];
 char szAppSamplesPath[MAX_PATH];
 char szAppPreviewPath[MAX_PATH];
 char szAppBlendPath[MAX_PATH];
+char szAppCachePath[MAX_PATH];
 char szAppNvPath[MAX_PATH];
 char szAppSkinPath[MAX_PATH];
 #endif
+char szAppRomPaths[DIRS_MAX][MAX_PATH];
 
 void BurnPathsInit()
 {
@@ -63,6 +66,9 @@ void BurnPathsInit()
     mkdir(szAppBlendPath, 0777);
     //printf("szAppBlendPath: %s\n", szAppBlendPath);
 
+    snprintf(szAppCachePath, MAX_PATH, "%s%s/", szAppHomePath, "cache");
+    mkdir(szAppCachePath, 0777);
+
     snprintf(szAppSkinPath, MAX_PATH, "%s%s", szAppHomePath, "skin");
     mkdir(szAppSkinPath, 0777);
     //printf("szAppSkinPath: %s\n", szAppSkinPath);
@@ -0,0 +1,391 @@
+//
+// Created on 16/10/26.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "burner.h"
+#include "burn_state.h"
+#include "rewind.h"
+#include "pacer.h"
+
+#ifdef __PSP2_DEBUG__
+#include <psp2/kernel/clib.h>
+#define printf sceClibPrintf
+#endif
+
+#define REWIND_MAX_ENTRIES  8192
+
+Rewind::Rewind(size_t budget, int interval) {
+
+    this->interval = interval > 0 ? interval : 1;
+
+    int size = BurnStateMemGetSize();
+    if (size <= 0 || budget == 0) {
+        return;
+    }
+
+    capture[0] = (uint8_t *) malloc((size_t) size);
+    capture[1] = (uint8_t *) malloc((size_t) size);
+    prev = (uint8_t *) malloc((size_t) size);
+    // worst case: literals split by 8 byte runs, two varints per token
+    scratch = (uint8_t *) malloc((size_t) size + ((size_t) size / 9 + 2) * 20);
+    ring = (uint8_t *) malloc(budget);
+    if (capture[0] == NULL || capture[1] == NULL || prev == NULL || scratch == NULL || ring == NULL) {
+        printf("Rewind: could not allocate %i KB\n", (int) (budget / 1024));
+        return;
+    }
+
+    entries.resize(REWIND_MAX_ENTRIES);
+    ring_size = budget;
+    state_size = size;
+
+#ifndef __3DS__
+    mutex = SDL_CreateMutex();
+    cond = SDL_CreateCond();
+    running = true;
+    thread = SDL_CreateThread(WorkerThread, "pfba_rewind", this);
+    if (thread == NULL) {
+        // pack on the emulation thread instead
+        printf("Rewind: could not create helper thread: %s\n", SDL_GetError());
+        running = false;
+    }
+#endif
+}
+
+Rewind::~Rewind() {
+
+#ifndef __3DS__
+    if (thread != NULL) {
+        SDL_LockMutex(mutex);
+        running = false;
+        SDL_CondBroadcast(cond);
+        SDL_UnlockMutex(mutex);
+        SDL_WaitThread(thread, NULL);
+    }
+    if (cond != NULL) {
+        SDL_DestroyCond(cond);
+    }
+    if (mutex != NULL) {
+        SDL_DestroyMutex(mutex);
+    }
+#endif
+
+    free(capture[0]);
+    free(capture[1]);
+    free(prev);
+    free(scratch);
+    free(ring);
+}
+
+static uint8_t *PutVarint(uint8_t *out, size_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t) value;
+    return out;
+}
+
+static const uint8_t *GetVarint(const uint8_t *in, const uint8_t *end, size_t *value) {
+    size_t v = 0;
+    int shift = 0;
+    while (in < end && shift < 64) {
+        uint8_t b = *in++;
+        v |= (size_t) (b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *value = v;
+            return in;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+// delta = cur ^ prev, stored as (zero run, literal length, literals) tokens.
+// Literals only end on 8 equal bytes so short matches don't cost a token.
+size_t Rewind::Pack(const uint8_t *cur, const uint8_t *prev, size_t size, uint8_t *out) {
+
+    uint8_t *o = out;
+    size_t i = 0;
+
+    while (i < size) {
+
+        size_t start = i;
+        while (i + 8 <= size) {
+            uint64_t a, b;
+            memcpy(&a, cur + i, 8);
+            memcpy(&b, prev + i, 8);
+            if (a != b) {
+                break;
+            }
+            i += 8;
+        }
+        while (i < size && cur[i] == prev[i]) {
+            i++;
+        }
+        o = PutVarint(o, i - start);
+
+        start = i;
+        size_t equal = 0;
+        while (i < size && equal < 8) {
+            equal = cur[i] == prev[i] ? equal + 1 : 0;
+            i++;
+        }
+        if (equal >= 8) {
+            i -= equal;
+        }
+        o = PutVarint(o, i - start);
+        for (size_t k = start; k < i; k++) {
+            *o++ = cur[k] ^ prev[k];
+        }
+    }
+
+    // identical states still take a byte, entries are never empty
+    if (o == out) {
+        o = PutVarint(o, 0);
+        o = PutVarint(o, 0);
+    }
+
+    return (size_t) (o - out);
+}
+
+// state ^= delta
+void Rewind::Unpack(const uint8_t *in, size_t in_size, uint8_t *state, size_t size) {
+
+    const uint8_t *end = in + in_size;
+    size_t pos = 0;
+
+    while (in < end) {
+        size_t zeros, literals;
+        if ((in = GetVarint(in, end, &zeros)) == NULL
+            || (in = GetVarint(in, end, &literals)) == NULL) {
+            return;
+        }
+        pos += zeros;
+        if (pos > size || literals > size - pos || literals > (size_t) (end - in)) {
+            return;
+        }
+        for (size_t k = 0; k < literals; k++) {
+            state[pos + k] ^= in[k];
+        }
+        in += literals;
+        pos += literals;
+    }
+}
+
+void Rewind::Evict() {
+
+    used -= entries[first].size;
+    first = (first + 1) % entries.size();
+    count--;
+    stats.evicted++;
+}
+
+// append a delta after the newest one, wrapping to the start of the ring
+// and evicting the oldest deltas in the way
+void Rewind::Push(const uint8_t *data, size_t size) {
+
+    // a delta bigger than the whole ring breaks the chain, start over from the newest capture
+    if (size > ring_size) {
+        while (count > 0) {
+            Evict();
+        }
+        return;
+    }
+
+    if (count == entries.size()) {
+        Evict();
+    }
+
+    bool wrap = write_pos + size > ring_size;
+    size_t pos = wrap ? 0 : write_pos;
+
+    while (count > 0) {
+        const Entry &e = entries[first];
+        bool tail = wrap && e.offset >= write_pos;
+        bool overlap = e.offset < pos + size && e.offset + e.size > pos;
+        if (!tail && !overlap) {
+            break;
+        }
+        Evict();
+    }
+
+    memcpy(ring + pos, data, size);
+    Entry &e = entries[(first + count) % entries.size()];
+    e.offset = pos;
+    e.size = size;
+    count++;
+    used += size;
+    write_pos = pos + size;
+}
+
+void Rewind::PopNewest() {
+
+    const Entry &e = entries[(first + count - 1) % entries.size()];
+    write_pos = e.offset;
+    used -= e.size;
+    count--;
+}
+
+void Rewind::Process(int index) {
+
+    int64_t start = Pacer::GetMicros();
+
+    if (!have_prev) {
+        memcpy(prev, capture[index], (size_t) state_size);
+        have_prev = true;
+        return;
+    }
+
+    size_t size = Pack(capture[index], prev, (size_t) state_size, scratch);
+    Push(scratch, size);
+    memcpy(prev, capture[index], (size_t) state_size);
+
+    stats.raw += state_size;
+    stats.packed += size;
+    int cost = (int) (Pacer::GetMicros() - start);
+    stats.pack_time += (cost - stats.pack_time) / 8;
+}
+
+#ifndef __3DS__
+
+int Rewind::WorkerThread(void *data) {
+
+    Rewind *rewind = (Rewind *) data;
+
+    SDL_LockMutex(rewind->mutex);
+    while (rewind->running) {
+        if (rewind->pending < 0) {
+            SDL_CondWait(rewind->cond, rewind->mutex);
+            continue;
+        }
+        rewind->processing = rewind->pending;
+        rewind->pending = -1;
+        SDL_UnlockMutex(rewind->mutex);
+
+        rewind->Process(rewind->processing);
+
+        SDL_LockMutex(rewind->mutex);
+        rewind->processing = -1;
+        SDL_CondBroadcast(rewind->cond);
+    }
+    SDL_UnlockMutex(rewind->mutex);
+
+    return 0;
+}
+
+#endif
+
+void Rewind::Frame() {
+
+    if (!IsAvailable() || ++frame_count < interval) {
+        return;
+    }
+    frame_count = 0;
+
+#ifndef __3DS__
+    if (thread != NULL) {
+        // never wait for the helper thread, skip this capture if it's behind
+        SDL_LockMutex(mutex);
+        if (pending >= 0) {
+            stats.dropped++;
+            SDL_UnlockMutex(mutex);
+            return;
+        }
+        int index = processing == 0 ? 1 : 0;
+        SDL_UnlockMutex(mutex);
+
+        if (BurnStateMemSave(capture[index], state_size) != 0) {
+            return;
+        }
+
+        SDL_LockMutex(mutex);
+        pending = index;
+        stats.captures++;
+        SDL_CondBroadcast(cond);
+        SDL_UnlockMutex(mutex);
+        return;
+    }
+#endif
+
+    if (BurnStateMemSave(capture[0], state_size) == 0) {
+        stats.captures++;
+        Process(0);
+    }
+}
+
+bool Rewind::Step() {
+
+    if (!IsAvailable()) {
+        return false;
+    }
+
+#ifndef __3DS__
+    SDL_LockMutex(mutex);
+    while (pending >= 0 || processing >= 0) {
+        SDL_CondWait(cond, mutex);
+    }
+#endif
+
+    bool restored = have_prev && BurnStateMemLoad(prev, state_size) == 0;
+    if (restored) {
+        stats.hits++;
+        // step the newest capture back, the oldest one stays when the ring is empty
+        if (count > 0) {
+            const Entry &e = entries[(first + count - 1) % entries.size()];
+            Unpack(ring + e.offset, e.size, prev, (size_t) state_size);
+            PopNewest();
+        }
+    } else {
+        stats.misses++;
+    }
+    frame_count = 0;
+
+#ifndef __3DS__
+    SDL_UnlockMutex(mutex);
+#endif
+
+    return restored;
+}
+
+int Rewind::GetCount() {
+
+#ifndef __3DS__
+    SDL_LockMutex(mutex);
+#endif
+    int c = (int) count;
+#ifndef __3DS__
+    SDL_UnlockMutex(mutex);
+#endif
+
+    return c;
+}
+
+size_t Rewind::GetUsed() {
+
+#ifndef __3DS__
+    SDL_LockMutex(mutex);
+#endif
+    size_t u = used;
+#ifndef __3DS__
+    SDL_UnlockMutex(mutex);
+#endif
+
+    return u;
+}
+
+void Rewind::PrintStats() {
+
+    if (!IsAvailable()) {
+        return;
+    }
+
+    printf("Rewind: captures = %u, dropped = %u, evicted = %u, hits = %u, misses = %u\n",
+           stats.captures, stats.dropped, stats.evicted, stats.hits, stats.misses);
+    printf("Rewind: %i deltas, %i/%i KB used, state = %i bytes, packed to %i%% in %ius\n",
+           GetCount(), (int) (GetUsed() / 1024), (int) (ring_size / 1024), state_size,
+           stats.raw > 0 ? (int) (stats.packed * 100 / stats.raw) : 0, stats.pack_time);
+}
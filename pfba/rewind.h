@@ -0,0 +1,116 @@
+//
+// Created on 16/10/26.
+//
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#ifndef __3DS__
+#include <SDL2/SDL.h>
+#endif
+
+// Rewind ring: a full state is captured every "interval" frames (a plain
+// memcpy of the driver areas on the emulation thread), a helper thread then
+// xor's it against the previous capture, packs the zero runs of the delta and
+// appends it to a fixed size byte ring, evicting the oldest deltas as needed.
+// Only the newest capture is kept whole; stepping back loads it and applies
+// the newest delta to it, which gives the capture before it.
+class Rewind {
+
+public:
+
+    struct Stats {
+        unsigned int captures = 0;      // states captured
+        unsigned int dropped = 0;       // captures skipped, the helper thread was still busy
+        unsigned int evicted = 0;       // oldest deltas dropped to stay within the budget
+        unsigned int hits = 0;          // rewind steps that restored a state
+        unsigned int misses = 0;        // rewind steps with nothing to restore
+        int64_t raw = 0;                // total size of the packed states (bytes)
+        int64_t packed = 0;             // total size of their packed deltas (bytes)
+        int pack_time = 0;              // average delta + pack time (us)
+    };
+
+    // budget: ring size (bytes), interval: frames between two captures
+    Rewind(size_t budget, int interval);
+
+    ~Rewind();
+
+    // false if the driver has no state or the buffers couldn't be allocated
+    bool IsAvailable() const {
+        return state_size > 0;
+    }
+
+    // call after every emulated frame, captures a state every "interval" frames
+    void Frame();
+
+    // restore the previous capture, false if there is none
+    bool Step();
+
+    // number of deltas in the ring
+    int GetCount();
+
+    // bytes of the ring in use
+    size_t GetUsed();
+
+    const Stats &GetStats() const {
+        return stats;
+    }
+
+    void PrintStats();
+
+private:
+
+    struct Entry {
+        size_t offset;
+        size_t size;
+    };
+
+    static size_t Pack(const uint8_t *cur, const uint8_t *prev, size_t size, uint8_t *out);
+
+    static void Unpack(const uint8_t *in, size_t in_size, uint8_t *state, size_t size);
+
+    void Process(int index);
+
+    void Push(const uint8_t *data, size_t size);
+
+    void PopNewest();
+
+    void Evict();
+
+#ifndef __3DS__
+    static int WorkerThread(void *data);
+
+    SDL_Thread *thread = NULL;
+    SDL_mutex *mutex = NULL;
+    SDL_cond *cond = NULL;
+    bool running = false;
+#endif
+
+    int state_size = 0;
+    int interval = 1;
+    int frame_count = 0;
+
+    uint8_t *capture[2] = {NULL, NULL};
+    int pending = -1;                   // capture waiting for the helper thread
+    int processing = -1;                // capture being packed
+
+    uint8_t *prev = NULL;               // newest capture, whole
+    bool have_prev = false;
+    uint8_t *scratch = NULL;            // packed delta
+
+    uint8_t *ring = NULL;
+    size_t ring_size = 0;
+    size_t write_pos = 0;
+    std::vector<Entry> entries;         // deltas, oldest first
+    size_t first = 0;                   // oldest entry
+    size_t count = 0;
+    size_t used = 0;
+
+    Stats stats;
+};
+
+#endif //_REWIND_H_
@@ -18,39 +18,59 @@
  */
 
 #include <stdio.h>
-#include <sys/time.h>
 
 #include "burner.h"
 #include "run.h"
 #include <skeleton/audio.h>
 #include <video.h>
+#include "mailbox.h"
+#include "pacer.h"
+#include "rewind.h"
+#include "runahead.h"
+#include "netplay.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
+#include "sh2_intf.h"
+
+#ifndef __3DS__
+#include <atomic>
+#include <SDL2/SDL.h>
+#endif
 
 static Gui *gui;
 Video *video;
 Audio *audio;
+static Pacer *pacer;
+static Rewind *rewindRing;
+static RunAhead *runAhead;
+static Netplay *netplay;
+
+// frames between two rewind captures
+#define REWIND_INTERVAL 4
+
+// frames averaged by the profiler overlay, and scopes kept for its trace
+#define PROFILE_FRAMES 60
+#define PROFILE_TRACE_EVENTS (512 * 1024)
+
+static int profiler;
 
 extern unsigned char inputServiceSwitch;
 extern unsigned char inputP1P2Switch;
 extern int nSekCpuCore;
+#ifdef M68K_X64_DRC
+extern int SekUseRecompiler(bool bUse);
+#endif
 
 bool GameLooping;
 bool bPauseOn = false;
 
 int InpMake(Input::Player *players);
 
-struct timeval start;
-
-void StartTicks(void) {
-    gettimeofday(&start, NULL);
-}
-
-unsigned int GetTicks(void) {
-    unsigned int ticks;
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    ticks = (unsigned int) ((now.tv_sec - start.tv_sec) * 1000000 + now.tv_usec - start.tv_usec);
-    return ticks;
-}
+// switches turned on by a hotkey (ProcessInput)
+#define INPUT_SERVICE_SWITCH    0x1
+#define INPUT_P1P2_SWITCH       0x2
+// the Input::Key bits, not the EV_* events sharing Player::state
+#define INPUT_KEYS              0x3fff
 
 int RunReset() {
     nFramesEmulated = 0;
@@ -59,10 +79,80 @@ int RunReset() {
     return 0;
 }
 
-int RunOneFrame(bool bDraw, int bDrawFps, int fps) {
+#ifndef __3DS__
+// threaded mode: emulation runs on its own thread, drawing into the video "frames",
+// while this (render) thread polls inputs, handles menus and presents the newest frame
+struct InputFrame {
+    Input::Player players[PLAYER_COUNT];
+    bool rewind;
+};
+
+static InputFrame inputFrames[3];
+static Mailbox inputMailbox;
+
+// the mailbox only keeps the newest poll: presses and switches seen since the
+// emulation thread last took them are or'ed here, so a short one isn't lost
+static std::atomic<unsigned int> inputPressed[PLAYER_COUNT];
+static std::atomic<int> inputSwitches(0);
+static unsigned int inputLastState[PLAYER_COUNT];
+
+static SDL_Thread *emuThread = NULL;
+static SDL_mutex *emuMutex = NULL;
+static SDL_cond *emuCond = NULL;
+static std::atomic<bool> emuRunning(false);
+static std::atomic<bool> emuPause(false);
+static bool emuParked = false;
+static int emuParkCount = 0;
+#endif
+
+// stop (or restart) the emulation thread, if any, so the gui can safely use the driver
+static void EmuThreadPark(bool park) {
+#ifndef __3DS__
+    if (emuThread == NULL) {
+        return;
+    }
+
+    // menus may be nested (forced frame from a menu), only the outer one counts
+    emuParkCount += park ? 1 : -1;
+    if ((park && emuParkCount != 1) || (!park && emuParkCount != 0)) {
+        return;
+    }
+
+    SDL_LockMutex(emuMutex);
+    emuPause = park;
+    if (park) {
+        while (!emuParked) {
+            SDL_CondWait(emuCond, emuMutex);
+        }
+    } else {
+        SDL_CondBroadcast(emuCond);
+    }
+    SDL_UnlockMutex(emuMutex);
+#endif
+}
+
+static void PauseEmulation(bool pause) {
+
+    if (pause) {
+        bPauseOn = true;
+        EmuThreadPark(true);
+        if (audio) {
+            audio->Pause(1);
+        }
+        // set default control scheme
+        gui->UpdateInputMapping(false);
+    } else {
+        // restore rom control scheme
+        gui->UpdateInputMapping(true);
+        if (audio) {
+            audio->Pause(0);
+        }
+        bPauseOn = false;
+        EmuThreadPark(false);
+    }
+}
 
-    inputServiceSwitch = 0;
-    inputP1P2Switch = 0;
+static Input::Player *UpdateInput() {
 
     int rotation = gui->GetConfig()->GetRomValue(Option::Index::ROM_ROTATION);
     int rotate = 0;
@@ -76,45 +166,38 @@ int RunOneFrame(bool bDraw, int bDrawFps, int fps) {
         rotate = 3;
       }
     }
-    Input::Player *players = gui->GetInput()->Update(rotate);
+
+    return gui->GetInput()->Update(rotate);
+}
+
+// rewind while MENU2 + FIRE6 are held
+static bool IsRewinding(Input::Player *players) {
+    return rewindRing != NULL
+           && (players[0].state & Input::Key::KEY_MENU2)
+           && (players[0].state & Input::Key::KEY_FIRE6);
+}
+
+static int ProcessInput(Input::Player *players) {
+
+    int switches = 0;
 
     // process menu
     if ((players[0].state & Input::Key::KEY_MENU1)
         && (players[0].state & Input::Key::KEY_MENU2)) {
-        bPauseOn = true;
-        if (audio) {
-            audio->Pause(1);
-        }
-        // set default control scheme
-        gui->UpdateInputMapping(false);
+        PauseEmulation(true);
         gui->RunOptionMenu(true);
-        // restore rom control scheme
-        gui->UpdateInputMapping(true);
-        if (audio) {
-            audio->Pause(0);
-        }
-        bPauseOn = false;
+        PauseEmulation(false);
     } else if ((players[0].state & Input::Key::KEY_MENU2)
                && (players[0].state & Input::Key::KEY_FIRE5)) {
-        bPauseOn = true;
-        if (audio) {
-            audio->Pause(1);
-        }
-        // set default control scheme
-        gui->UpdateInputMapping(false);
+        PauseEmulation(true);
         gui->RunStatesMenu();
-        // restore rom control scheme
-        gui->UpdateInputMapping(true);
-        if (audio) {
-            audio->Pause(0);
-        }
-        bPauseOn = false;
+        PauseEmulation(false);
     } else if ((players[0].state & Input::Key::KEY_MENU2)
                && (players[0].state & Input::Key::KEY_FIRE3)) {
-        inputServiceSwitch = 1;
+        switches |= INPUT_SERVICE_SWITCH;
     } else if ((players[0].state & Input::Key::KEY_MENU2)
                && (players[0].state & Input::Key::KEY_FIRE4)) {
-        inputP1P2Switch = 1;
+        switches |= INPUT_P1P2_SWITCH;
     } else if ((players[0].state & Input::Key::KEY_MENU2)
                && (players[0].state & Input::Key::KEY_UP)) {
         int scaling = gui->GetConfig()->GetRomValue(Option::Index::ROM_SCALING) + 1;
@@ -159,9 +242,120 @@ int RunOneFrame(bool bDraw, int bDrawFps, int fps) {
         video->Scale();
     }
 
-    InpMake(players);
+    return switches;
+}
+
+static void DrawFps(int fps) {
+    gui->GetSkin()->font_small->color = YELLOW;
+    video->renderer->DrawFont(gui->GetSkin()->font_small, 8, 8, "FPS: %2d/%2d (%i%%)",
+                              fps, (nBurnFPS / 100), pacer ? pacer->GetLoad() : 0);
+    gui->GetSkin()->font_small->color = WHITE;
+}
+
+#ifdef BURN_PROF
+static INT64 ProfileClock() {
+    return Pacer::GetMicros();
+}
+
+// average time spent per frame in the profiled cpus, draws and sound chips, under the fps
+static void DrawProfile() {
+
+    static BurnProfFrame frames[PROFILE_FRAMES];
+    int count = BurnProfGetFrames(frames, PROFILE_FRAMES);
+    if (count <= 0) {
+        return;
+    }
+
+    double total = 0;
+    double time[BURN_PROF_MAX] = {0};
+    for (int i = 0; i < count; i++) {
+        total += frames[i].nTotal;
+        for (int id = 0; id < BURN_PROF_MAX; id++) {
+            time[id] += frames[i].nTime[id];
+        }
+    }
+    double scale = 1000.0 / ((double) nBurnProfClockRate * count);
+
+    Font *font = gui->GetSkin()->font_small;
+    int height = font->GetHeight("FPS") + 2;
+    int y = 8 + height;
+
+    font->color = YELLOW;
+    video->renderer->DrawFont(font, 8, y, "FRAME: %.2fms", total * scale);
+    double other = total;
+    for (int id = 0; id < BURN_PROF_MAX; id++) {
+        if (time[id] > 0) {
+            y += height;
+            video->renderer->DrawFont(font, 8, y, "%s: %.2fms (%i%%)", szBurnProfName[id],
+                                      time[id] * scale, (int) (time[id] * 100 / total));
+            other -= time[id];
+        }
+    }
+    y += height;
+    video->renderer->DrawFont(font, 8, y, "other: %.2fms (%i%%)", other * scale, (int) (other * 100 / total));
+    font->color = WHITE;
+}
+#endif
+
+static void DrawOverlays(int bDrawFps, int fps) {
+    if (bDrawFps) {
+        DrawFps(fps);
+    }
+#ifdef BURN_PROF
+    if (profiler) {
+        DrawProfile();
+    }
+#endif
+}
+
+static void ProfilerInit() {
+    profiler = gui->GetConfig()->GetRomValue(Option::Index::ROM_PROFILER);
+#ifdef BURN_PROF
+    if (profiler) {
+        BurnProfInit(ProfileClock, 1000000);
+        if (profiler == 2 && BurnProfTraceStart(PROFILE_TRACE_EVENTS) != 0) {
+            printf("ProfilerInit: could not allocate the trace buffer\n");
+        }
+    }
+#else
+    profiler = 0;
+#endif
+}
+
+static void ProfilerExit() {
+#ifdef BURN_PROF
+    if (profiler == 2) {
+        std::string path = szAppHomePath;
+        path += BurnDrvGetTextA(DRV_NAME);
+        path += "_trace.json";
+        BurnProfTraceStop(path.c_str());
+    }
+    BurnProfExit();
+#endif
+    profiler = 0;
+}
+
+int RunOneFrame(bool bDraw, int bDrawFps, int fps) {
+
+    Input::Player *players = UpdateInput();
+    int switches = ProcessInput(players);
+    inputServiceSwitch = (unsigned char) ((switches & INPUT_SERVICE_SWITCH) ? 1 : 0);
+    inputP1P2Switch = (unsigned char) ((switches & INPUT_P1P2_SWITCH) ? 1 : 0);
+
+    // netplay sets the inputs itself, and may have to wait for the peer
+    bool stalled = false;
+    if (netplay) {
+        stalled = !bPauseOn && !netplay->Begin(players);
+    } else {
+        InpMake(players);
+    }
+
+    if (!bPauseOn && !stalled) {
+        bool rewinding = IsRewinding(players);
+        if (rewinding) {
+            rewindRing->Step();
+        }
 
-    if (!bPauseOn) {
         nFramesEmulated++;
         nCurrentFrame++;
 
@@ -170,19 +364,31 @@ int RunOneFrame(bool bDraw, int bDrawFps, int fps) {
             nFramesRendered++;
             video->Lock();
         }
-        BurnDrvFrame();
+        if (pacer) {
+            pacer->BeginFrame();
+        }
+        if (runAhead) {
+            runAhead->Frame();
+        } else {
+            BurnDrvFrame();
+        }
+        if (pacer) {
+            pacer->EndFrame();
+        }
+        if (rewindRing && !rewinding) {
+            rewindRing->Frame();
+        }
+        if (netplay) {
+            netplay->End();
+        }
 
         if (bDraw) {
-            if (bDrawFps) {
+            if (bDrawFps || profiler) {
                 video->Clear();
             }
             video->Unlock();
             video->Render();
-            if (bDrawFps) {
-                gui->GetSkin()->font_small->color = YELLOW;
-                video->renderer->DrawFont(gui->GetSkin()->font_small, 8, 8, "FPS: %2d/%2d", fps, (nBurnFPS / 100));
-                gui->GetSkin()->font_small->color = WHITE;
-            }
+            DrawOverlays(bDrawFps, fps);
             video->Flip();
         }
     }
@@ -190,6 +396,163 @@ int RunOneFrame(bool bDraw, int bDrawFps, int fps) {
     return 0;
 }
 
+#ifndef __3DS__
+
+static int EmuThread(void *data) {
+
+    pacer->Reset();
+
+    while (emuRunning) {
+
+        if (emuPause) {
+            SDL_LockMutex(emuMutex);
+            emuParked = true;
+            SDL_CondBroadcast(emuCond);
+            while (emuPause && emuRunning) {
+                SDL_CondWait(emuCond, emuMutex);
+            }
+            emuParked = false;
+            SDL_UnlockMutex(emuMutex);
+            // don't try to catch up on the time spent in menus
+            pacer->Reset();
+            continue;
+        }
+
+        bool draw = pacer->Wait((bool) gui->GetConfig()->GetRomValue(Option::Index::ROM_FRAMESKIP));
+
+        // the switches are only written here while the game runs
+        inputMailbox.Acquire();
+        InputFrame *input = &inputFrames[inputMailbox.GetFront()];
+        Input::Player players[PLAYER_COUNT];
+        memcpy(players, input->players, sizeof(players));
+        for (int i = 0; i < PLAYER_COUNT; i++) {
+            players[i].state |= inputPressed[i].exchange(0);
+        }
+        int switches = inputSwitches.exchange(0);
+        inputServiceSwitch = (unsigned char) ((switches & INPUT_SERVICE_SWITCH) ? 1 : 0);
+        inputP1P2Switch = (unsigned char) ((switches & INPUT_P1P2_SWITCH) ? 1 : 0);
+        InpMake(players);
+
+        if (input->rewind) {
+            rewindRing->Step();
+        }
+
+        nFramesEmulated++;
+        nCurrentFrame++;
+
+        pBurnDraw = draw ? video->GetBackFrame() : NULL;
+        pacer->BeginFrame();
+        if (runAhead) {
+            runAhead->Frame();
+        } else {
+            BurnDrvFrame();
+        }
+        pacer->EndFrame();
+        if (rewindRing && !input->rewind) {
+            rewindRing->Frame();
+        }
+        if (draw) {
+            video->PublishFrame();
+        }
+
+        if (audio) {
+            audio->Play();
+        }
+    }
+
+    SDL_LockMutex(emuMutex);
+    emuParked = true;
+    SDL_CondBroadcast(emuCond);
+    SDL_UnlockMutex(emuMutex);
+
+    return 0;
+}
+
+static void RunThreaded() {
+
+    int64_t timer = 0, tick = 0;
+    int fps = 0;
+
+    video->CreateFrames();
+    inputMailbox.Reset();
+    memset(inputFrames, 0, sizeof(inputFrames));
+    for (int i = 0; i < PLAYER_COUNT; i++) {
+        inputPressed[i] = 0;
+        inputLastState[i] = 0;
+    }
+    inputSwitches = 0;
+
+    emuMutex = SDL_CreateMutex();
+    emuCond = SDL_CreateCond();
+    emuPause = false;
+    emuParked = false;
+    emuParkCount = 0;
+    emuRunning = true;
+    emuThread = SDL_CreateThread(EmuThread, "pfba_emu", NULL);
+    if (emuThread == NULL) {
+        printf("RunThreaded: could not create emulation thread: %s\n", SDL_GetError());
+        emuRunning = false;
+        SDL_DestroyCond(emuCond);
+        SDL_DestroyMutex(emuMutex);
+        video->DestroyFrames();
+        return;
+    }
+
+    while (GameLooping) {
+
+        int showFps = gui->GetConfig()->GetRomValue(Option::Index::ROM_SHOW_FPS);
+        if (showFps) {
+            timer = Pacer::GetMicros();
+            if (timer - tick > 1000000) {
+                fps = nFramesRendered;
+                nFramesRendered = 0;
+                tick = timer;
+            }
+        }
+
+        Input::Player *players = UpdateInput();
+        inputSwitches.fetch_or(ProcessInput(players));
+        for (int i = 0; i < PLAYER_COUNT; i++) {
+            inputPressed[i].fetch_or(players[i].state & ~inputLastState[i] & INPUT_KEYS);
+            inputLastState[i] = players[i].state;
+        }
+
+        InputFrame *input = &inputFrames[inputMailbox.GetBack()];
+        memcpy(input->players, players, sizeof(input->players));
+        input->rewind = IsRewinding(players);
+        inputMailbox.Publish();
+
+        if (video->UploadFrame()) {
+            nFramesRendered++;
+            if (showFps || profiler) {
+                video->Clear();
+            }
+            video->Render();
+            DrawOverlays(showFps, fps);
+            video->Flip();
+        } else {
+            gui->GetRenderer()->Delay(1);
+        }
+    }
+
+    emuRunning = false;
+    SDL_LockMutex(emuMutex);
+    emuPause = false;
+    SDL_CondBroadcast(emuCond);
+    SDL_UnlockMutex(emuMutex);
+    SDL_WaitThread(emuThread, NULL);
+    emuThread = NULL;
+    SDL_DestroyCond(emuCond);
+    emuCond = NULL;
+    SDL_DestroyMutex(emuMutex);
+    emuMutex = NULL;
+
+    pBurnDraw = NULL;
+    video->DestroyFrames();
+}
+
+#endif
+
 #if defined(__PSP2__) || defined(__RPI__)
 
 static int GetSekCpuCore(Gui *g) {
@@ -249,12 +612,7 @@ static int GetSekCpuCore(Gui *g) {
 
 void AudioInit(Config *cfg) {
 
-    // disable interpolation as it produce "cracking" sound
-    // on some games (cps1 (SF2), cave ...)
-    nInterpolation = 1;
-    //cfg->GetRomValue(Option::Index::ROM_AUDIO_INTERPOLATION) == 0 ? 1 : 3;
-    nFMInterpolation = 0;
-    //cfg->GetRomValue(Option::Index::ROM_AUDIO_FMINTERPOLATION) == 0 ? 0 : 3;
+    // the resampler (nFMInterpolation, nResampleQuality) is set before the driver init, see RunEmulator
 
 #ifdef __3DS__
     nBurnSoundRate = 0;
@@ -267,6 +625,10 @@ void AudioInit(Config *cfg) {
         nBurnSoundRate = audio->frequency;
         nBurnSoundLen = audio->buffer_len;
         pBurnSoundOut = audio->buffer;
+        // slave the frame pacer to the audio queue instead of the clock
+        if (cfg->GetRomValue(Option::Index::ROM_AUDIO_SYNC)) {
+            audio->SetSync(true, 4 << cfg->GetRomValue(Option::Index::ROM_AUDIO_LATENCY));
+        }
     } else {
         nBurnSoundRate = 0;
         nBurnSoundLen = 0;
@@ -285,12 +647,24 @@ void RunEmulator(Gui *g, int drvnum) {
 #if defined(__PSP2__) || defined(__RPI__)
     nSekCpuCore = GetSekCpuCore(gui);
 #endif
+#ifdef M68K_X64_DRC
+    // drivers needing the interpreter turn the recompiler off again in their init
+    SekUseRecompiler(gui->GetConfig()->GetRomValue(Option::Index::ROM_M68K) == 0);
+#endif
+    Sh2SetCore(gui->GetConfig()->GetRomValue(Option::Index::ROM_SH2));
+    bBurnIdleSkip = gui->GetConfig()->GetRomValue(Option::Index::ROM_IDLE_SKIP) == 1;
     bForce60Hz = true;
     nBurnSoundRate = 0;
     if(gui->GetConfig()->GetRomValue(Option::Index::ROM_AUDIO) ) {
         nBurnSoundRate = 48000;
     }
 
+    // the fm chips either render at the output rate, or at their own rate
+    // through the band-limited resampler (FAST/GOOD/BEST: 8/16/32 taps)
+    int resampler = gui->GetConfig()->GetRomValue(Option::Index::ROM_AUDIO_RESAMPLER);
+    nFMInterpolation = resampler > 0 ? 4 : 0;
+    nResampleQuality = resampler > 0 ? resampler - 1 : 0;
+
     InpInit();
     InpDIP();
 
@@ -322,61 +696,100 @@ void RunEmulator(Gui *g, int drvnum) {
 
     RunReset();
 
-    int frame_limit = nBurnFPS / 100, frametime = 100000000 / nBurnFPS;
-    int now = 0, done = 0, timer = 0, tick = 0, ticks = 0, fps = 0;
+    pacer = new Pacer(nBurnFPS);
+    pacer->SetAudio(audio);
+
+    // netplay drives the frames itself, rewind and run-ahead would desync it
+    netplay = NULL;
+    int netplayMode = gui->GetConfig()->GetRomValue(Option::Index::ROM_NETPLAY);
+    if (netplayMode > 0) {
+        const Config::NetplayOptions &options = gui->GetConfig()->GetNetplayOptions();
+        NetTransport *transport = new UdpTransport(netplayMode == 2 ? options.peer.c_str() : NULL, options.port);
+        if (options.lag > 0 || options.jitter > 0 || options.loss > 0) {
+            transport = new LagTransport(transport, options.lag, options.jitter, options.loss);
+        }
+        netplay = new Netplay(transport, netplayMode == 2 ? 1 : 0, options.delay, options.rollback);
+        if (!netplay->IsAvailable()) {
+            delete (netplay);
+            netplay = NULL;
+        }
+    }
 
-    printf("---- PFBA EMU START ----\n\n");
+    rewindRing = NULL;
+    int rewindSize = gui->GetConfig()->GetRomValue(Option::Index::ROM_REWIND);
+    if (rewindSize > 0 && !netplay) {
+        rewindRing = new Rewind((size_t) (8 << rewindSize) * 1024 * 1024, REWIND_INTERVAL);
+        if (!rewindRing->IsAvailable()) {
+            delete (rewindRing);
+            rewindRing = NULL;
+        }
+    }
+
+    runAhead = NULL;
+    int runAheadFrames = gui->GetConfig()->GetRomValue(Option::Index::ROM_RUNAHEAD);
+    if (runAheadFrames > 0 && !netplay) {
+        runAhead = new RunAhead(runAheadFrames);
+    }
+
+    ProfilerInit();
 
-    StartTicks(); // no frameskip
+    int64_t timer = 0, tick = 0;
+    int fps = 0;
+
+    printf("---- PFBA EMU START ----\n\n");
 
     GameLooping = true;
+
+#ifndef __3DS__
+    if (gui->GetConfig()->GetRomValue(Option::Index::ROM_THREADED) && !netplay) {
+        printf("Running emulation in its own thread\n");
+        RunThreaded();
+    }
+#endif
+
     while (GameLooping) {
 
         int showFps = gui->GetConfig()->GetRomValue(Option::Index::ROM_SHOW_FPS);
         int frameSkip = gui->GetConfig()->GetRomValue(Option::Index::ROM_FRAMESKIP);
 
-        if (frameSkip) {
-            timer = GetTicks() / frametime;
-            if (timer - tick > frame_limit && showFps) {
+        if (showFps) {
+            timer = Pacer::GetMicros();
+            if (timer - tick > 1000000) {
                 fps = nFramesRendered;
                 nFramesRendered = 0;
                 tick = timer;
             }
-            now = timer;
-            ticks = now - done;
-            if (ticks < 1) continue;
-            if (ticks > 10) ticks = 10;
-            for (int i = 0; i < ticks - 1; i++) {
-                RunOneFrame(false, showFps, fps);
-                if (audio) {
-                    audio->Play();
-                }
-            }
-            if (ticks >= 1) {
-                RunOneFrame(true, showFps, fps);
-                if (audio) {
-                    audio->Play();
-                }
-            }
-            done = now;
-        } else {
-            if (showFps) {
-                timer = GetTicks();
-                if (timer - tick > 1000000) {
-                    fps = nFramesRendered;
-                    nFramesRendered = 0;
-                    tick = timer;
-                }
-            }
-            RunOneFrame(true, showFps, fps);
-            if (audio) {
-                audio->Play();
-            }
+        }
+
+        bool draw = pacer->Wait((bool) frameSkip);
+        RunOneFrame(draw, showFps, fps);
+        if (audio) {
+            audio->Play();
         }
     }
 
     printf("---- PFBA EMU END ----\n\n");
 
+    pacer->PrintStats();
+    delete (pacer);
+    pacer = NULL;
+    if (rewindRing) {
+        rewindRing->PrintStats();
+        delete (rewindRing);
+        rewindRing = NULL;
+    }
+    if (runAhead) {
+        runAhead->PrintStats();
+        delete (runAhead);
+        runAhead = NULL;
+    }
+    if (netplay) {
+        netplay->PrintStats();
+        delete (netplay);
+        netplay = NULL;
+    }
+    ProfilerExit();
+
     DrvExit();
     InpExit();
     delete (video);
@@ -0,0 +1,140 @@
+//
+// Created on 16/10/26.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "burner.h"
+#include "burn_state.h"
+#include "runahead.h"
+#include "pacer.h"
+
+#ifdef __PSP2_DEBUG__
+#include <psp2/kernel/clib.h>
+#define printf sceClibPrintf
+#endif
+
+RunAhead::RunAhead(int frames) {
+
+    this->frames = frames > 0 ? frames : 1;
+
+    int size = BurnStateMemGetSize();
+    if (size <= 0) {
+        return;
+    }
+
+    state = (unsigned char *) malloc((size_t) size);
+    check = (unsigned char *) malloc((size_t) size);
+    if (state == NULL || check == NULL) {
+        free(state);
+        free(check);
+        state = check = NULL;
+        return;
+    }
+
+    state_size = size;
+}
+
+RunAhead::~RunAhead() {
+    free(state);
+    free(check);
+}
+
+// emulate the same frame twice from the same state, the resulting states must match.
+// Both runs render their audio to pBurnSoundOut, the second one overwrites the
+// first, and only the second one is drawn. The state load puts nCurrentFrame
+// back, so both runs see the same frame number.
+bool RunAhead::Check() {
+
+    UINT8 *draw = pBurnDraw;
+
+    if (BurnStateMemSave(state, state_size) != 0) {
+        return false;
+    }
+    pBurnDraw = NULL;
+    BurnDrvFrame();
+    pBurnDraw = draw;
+    if (BurnStateMemSave(check, state_size) != 0) {
+        return false;
+    }
+
+    if (BurnStateMemLoad(state, state_size) != 0) {
+        return false;
+    }
+    BurnDrvFrame();
+    if (BurnStateMemSave(state, state_size) != 0) {
+        return false;
+    }
+
+    return memcmp(state, check, (size_t) state_size) == 0;
+}
+
+void RunAhead::Frame() {
+
+    UINT8 *draw = pBurnDraw;
+    INT16 *sound = pBurnSoundOut;
+
+    if (!IsAvailable()) {
+        BurnDrvFrame();
+        return;
+    }
+
+    if (!checked && --check_delay <= 0) {
+        checked = true;
+        safe = Check();
+        pBurnDraw = draw;
+        if (!safe) {
+            printf("RunAhead: '%s' savestate is incomplete, run-ahead disabled\n", BurnDrvGetTextA(DRV_NAME));
+        }
+        return;
+    }
+
+    // nothing to show, don't bother running ahead
+    if (draw == NULL) {
+        BurnDrvFrame();
+        return;
+    }
+
+    // the real frame: audio, no video
+    pBurnDraw = NULL;
+    BurnDrvFrame();
+
+    int64_t start = Pacer::GetMicros();
+    BurnStateMemSave(state, state_size);
+    int64_t saved = Pacer::GetMicros();
+
+    // the frames ahead: no audio, only the last one drawn. They advance
+    // nCurrentFrame like real frames, the state load puts it back
+    pBurnSoundOut = NULL;
+    for (int i = 0; i < frames; i++) {
+        pBurnDraw = i == frames - 1 ? draw : NULL;
+        nCurrentFrame++;
+        BurnDrvFrame();
+    }
+    pBurnSoundOut = sound;
+
+    int64_t loading = Pacer::GetMicros();
+    BurnStateMemLoad(state, state_size);
+    int64_t end = Pacer::GetMicros();
+
+    stats.frames++;
+    stats.hidden += frames;
+    stats.overhead += ((int) (end - start) - stats.overhead) / 8;
+    stats.save_time += ((int) (saved - start) - stats.save_time) / 8;
+    stats.load_time += ((int) (end - loading) - stats.load_time) / 8;
+}
+
+void RunAhead::PrintStats() {
+
+    if (state == NULL) {
+        printf("RunAhead: no savestate support, disabled\n");
+        return;
+    }
+
+    printf("RunAhead: %i frames ahead%s, frames = %u, hidden frames = %u\n",
+           this->frames, safe ? "" : " (disabled)", stats.frames, stats.hidden);
+    printf("RunAhead: overhead = %ius per frame (save = %ius, load = %ius)\n",
+           stats.overhead, stats.save_time, stats.load_time);
+}
@@ -0,0 +1,65 @@
+//
+// Created on 16/10/26.
+//
+
+#ifndef _RUNAHEAD_H_
+#define _RUNAHEAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Run-ahead: every drawn frame is emulated normally (audio, no video),
+// saved to memory, then "frames" more frames are emulated with the same
+// inputs, audio muted and only the last one drawn, before the saved state
+// is restored. What is shown is "frames" frames in the future, which hides
+// that much of the game's own input lag. Once the game is running, a frame
+// is emulated twice from the same state to make sure the driver savestate
+// is complete; run-ahead turns itself off for this driver if it isn't.
+// The hidden frames advance nCurrentFrame as real frames do, the state
+// load restores it along with the rest of the state.
+class RunAhead {
+
+public:
+
+    struct Stats {
+        unsigned int frames = 0;        // frames run ahead
+        unsigned int hidden = 0;        // extra frames emulated
+        int overhead = 0;               // average cost added to a frame (us)
+        int save_time = 0;              // average state save (us)
+        int load_time = 0;              // average state load (us)
+    };
+
+    // frames: how many frames to run ahead
+    RunAhead(int frames);
+
+    ~RunAhead();
+
+    // false if the driver has no state or run-ahead was found unsafe for it
+    bool IsAvailable() const {
+        return state != NULL && safe;
+    }
+
+    // emulate one frame in place of BurnDrvFrame, drawing to pBurnDraw (if set)
+    void Frame();
+
+    const Stats &GetStats() const {
+        return stats;
+    }
+
+    void PrintStats();
+
+private:
+
+    bool Check();
+
+    int frames = 1;
+    int state_size = 0;
+    unsigned char *state = NULL;
+    unsigned char *check = NULL;
+    int check_delay = 120;              // frames before checking the driver savestate
+    bool checked = false;
+    bool safe = true;
+    Stats stats;
+};
+
+#endif //_RUNAHEAD_H_
@@ -78,13 +78,17 @@ INT32 MakeScreenShot(const char *dest)
 
 	pSShot = pBurnDraw;
 
-	// Convert the image to 32-bit
-	if (nBurnBpp < 4) {
+	// Convert the image to 32-bit, or pack the rows if the texture pitch is larger
+	if (nBurnBpp < 4 || nBurnPitch != w * 4) {
 		UINT8* pTemp = (UINT8*)malloc(w * h * sizeof(INT32));
 
-		if (nBurnBpp == 2) {
+		if (nBurnBpp == 4) {
+			for (INT32 y = 0; y < h; y++) {
+				memcpy(pTemp + y * w * 4, pSShot + y * nBurnPitch, w * 4);
+			}
+		} else if (nBurnBpp == 2) {
 			for (INT32 i = 0; i < h * w; i++) {
-				UINT16 nColour = ((UINT16*)pSShot)[i];
+				UINT16 nColour = ((UINT16*)(pSShot + (i / w) * nBurnPitch))[i % w];
 
 				// Red
 		        *(pTemp + i * 4 + 0) = (UINT8)((nColour & 0x1F) << 3);
@@ -1,7 +1,6 @@
 // Driver Save State module
 #include "burner.h"
-
-FILE *bfp = NULL;
+#include "burn_state.h"
 
 // If bAll=0 save/load all non-volatile ram to .fs
 // If bAll=1 save/load all ram to .fs
@@ -40,11 +39,6 @@ static INT32 StateInfo(INT32* pnLen, INT32* pnMinVer, INT32 bAll)
 	return 0;
 }
 
-static int __cdecl ReadAcb(struct BurnArea* pba)
-{
-	fread(pba->Data, 1, pba->nLen, bfp);
-}
-
 // State load
 INT32 BurnStateLoadEmbed(FILE* fp, INT32 nOffset, INT32 bAll, INT32 (*pLoadGame)())
 {
@@ -153,11 +147,18 @@ INT32 BurnStateLoadEmbed(FILE* fp, INT32 nOffset, INT32 bAll, INT32 (*pLoadGame)
 
 	fseek(fp, 0x0C, SEEK_CUR);							// Move file pointer to the start of the compressed block
 
-	bfp = fp;
-	BurnAcb = ReadAcb;
+	Def = (UINT8*)malloc(nLen);							// read the whole block, then scan it from memory
+	if (Def == NULL) {
+		return -1;
+	}
+	if (fread(Def, 1, nLen, fp) != (size_t)nLen) {		// truncated state, leave the driver untouched
+		free(Def);
+		return -1;
+	}
 
-	if (bAll) BurnAreaScan(ACB_FULLSCAN | ACB_WRITE, NULL);		// scan all ram, write (to driver <- decompress)
-	else      BurnAreaScan(ACB_NVRAM    | ACB_WRITE, NULL);		// scan nvram,   write (to driver <- decompress)
+	if (bAll) BurnStateMemScan(Def, nLen, ACB_FULLSCAN | ACB_WRITE);	// scan all ram, write (to driver <- decompress)
+	else      BurnStateMemScan(Def, nLen, ACB_NVRAM    | ACB_WRITE);	// scan nvram,   write (to driver <- decompress)
+	free(Def);
 
 	fseek(fp, nChunkData + nChunkSize, SEEK_SET);
 
@@ -193,13 +194,6 @@ INT32 BurnStateLoad(TCHAR* szName, INT32 bAll, INT32 (*pLoadGame)())
 	}
 }
 
-static int __cdecl WriteAcb(struct BurnArea *pba)
-{
-	//printf("WRITE ACB - len: %i, name: %s\n", pba->nLen, pba->szName);
-	fwrite(pba->Data, 1, pba->nLen, bfp);
-	nTotalLen += pba->nLen;
-}
-
 // Write a savestate as a chunk of an "FBS " file
 // nOffset is the absolute offset from the beginning of the file
 // -1: Append at current position
@@ -259,13 +253,18 @@ INT32 BurnStateSaveEmbed(FILE* fp, INT32 nOffset, INT32 bAll)
 	fwrite(&nZero, 1, 4, fp);							//
 	fwrite(&nZero, 1, 4, fp);							//
 
-	bfp = fp;
-	nTotalLen = 0;
-	BurnAcb = WriteAcb;
+	Def = (UINT8*)malloc(nLen);							// scan into memory, then write it in one go
+	if (Def == NULL) {
+		return -1;
+	}
 
-	if (bAll) BurnAreaScan(ACB_FULLSCAN | ACB_READ, NULL);		// scan all ram, read (from driver <- decompress)
-	else      BurnAreaScan(ACB_NVRAM    | ACB_READ, NULL);		// scan nvram,   read (from driver <- decompress)
-	nDefLen = nTotalLen;
+	if (bAll) nDefLen = BurnStateMemScan(Def, nLen, ACB_FULLSCAN | ACB_READ);	// scan all ram, read (from driver <- decompress)
+	else      nDefLen = BurnStateMemScan(Def, nLen, ACB_NVRAM    | ACB_READ);	// scan nvram,   read (from driver <- decompress)
+	if (nDefLen > nLen) {								// more data than probed, the tail is lost
+		nDefLen = nLen;
+	}
+	fwrite(Def, 1, nDefLen, fp);
+	free(Def);
 
 	if (nDefLen & 3) {									// Chunk size must be a multiple of 4
 		fwrite(&nZero, 1, 4 - (nDefLen & 3), fp);		// Pad chunk if needed
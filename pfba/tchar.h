@@ -46,6 +46,8 @@ typedef char TCHAR;
 #define	_istspace	isspace
 
 #define _tfopen     fopen
+#define _tremove    remove
+#define _trename    rename
 
 #define _stricmp strcmp
 #define _strnicmp strncmp
@@ -16,6 +16,10 @@ static unsigned int myHighCol16(int r, int g, int b, int /* i */) {
     return t;
 }
 
+static unsigned int myHighCol32(int r, int g, int b, int /* i */) {
+    return (unsigned int) ((r << 16) | (g << 8) | b); // xxxx xxxx rrrr rrrr gggg gggg bbbb bbbb
+}
+
 Video::Video(Renderer *renderer) {
 
     this->renderer = renderer;
@@ -30,12 +34,22 @@ Video::Video(Renderer *renderer) {
         printf("game orientation: flipped\n");
     }
 
+    // 32 bits is only used if the renderer supports it, the drivers
+    // pick their 16/32 bits draw functions from nBurnBpp on the next frame
+    int format = gui->GetConfig()->GetRomValue(Option::Index::ROM_COLOR_DEPTH) > 0 ?
+                 TEXTURE_FORMAT_XRGB8888 : TEXTURE_FORMAT_RGB565;
     if (screen == NULL) {
-        screen = renderer->CreateTexture(VideoBufferWidth, VideoBufferHeight);
+        screen = renderer->CreateTexture(VideoBufferWidth, VideoBufferHeight, format);
     }
 
-    nBurnBpp = 2;
-    BurnHighCol = myHighCol16;
+    if (screen != NULL && screen->format == TEXTURE_FORMAT_XRGB8888) {
+        nBurnBpp = 4;
+        BurnHighCol = myHighCol32;
+    } else {
+        nBurnBpp = 2;
+        BurnHighCol = myHighCol16;
+    }
+    printf("game color depth: %i bits\n", nBurnBpp * 8);
     BurnRecalcPal();
     renderer->LockTexture(screen, Rect(), (void **) &pBurnDraw, &nBurnPitch);
     renderer->UnlockTexture(screen);
@@ -155,6 +169,8 @@ void Video::Clear() {
 }
 
 void Video::Lock() {
+    // the drivers draw (BurnTransferCopy's palette pass for the generic tile
+    // ones) straight in the locked texture buffer, there's no frame copy after
     renderer->LockTexture(screen, Rect(), (void **) &pBurnDraw, &nBurnPitch);
 }
 
@@ -163,7 +179,8 @@ void Video::Unlock() {
 }
 
 void Video::Render() {
-    if (pBurnDraw != NULL) {
+    // in threaded mode the screen texture always holds the last uploaded frame
+    if (pBurnDraw != NULL || frames[0] != NULL) {
         renderer->DrawTexture(screen, scale.x, scale.y, scale.w, scale.h, rotation);
     }
 }
@@ -172,8 +189,55 @@ void Video::Flip() {
     renderer->Flip();
 }
 
+void Video::CreateFrames() {
+
+    DestroyFrames();
+
+    frame_pitch = VideoBufferWidth * nBurnBpp;
+    for (int i = 0; i < 3; i++) {
+        frames[i] = (unsigned char *) malloc((size_t) (frame_pitch * VideoBufferHeight));
+        memset(frames[i], 0, (size_t) (frame_pitch * VideoBufferHeight));
+    }
+    mailbox.Reset();
+}
+
+void Video::DestroyFrames() {
+    for (int i = 0; i < 3; i++) {
+        if (frames[i] != NULL) {
+            free(frames[i]);
+            frames[i] = NULL;
+        }
+    }
+}
+
+unsigned char *Video::GetBackFrame() {
+    nBurnPitch = frame_pitch;
+    return frames[mailbox.GetBack()];
+}
+
+void Video::PublishFrame() {
+    mailbox.Publish();
+}
+
+bool Video::UploadFrame() {
+
+    if (!mailbox.Acquire()) {
+        return false;
+    }
+
+    // sdl2 and sfml upload straight from the frame, no copy in the lock buffer
+    renderer->UpdateTexture(screen, frames[mailbox.GetFront()], frame_pitch);
+
+    return true;
+}
+
 Video::~Video() {
+    DestroyFrames();
     if (screen != NULL) {
+        if (screen->uploads > 0) {
+            printf("Video: %u uploads, %lu us average, %lu us worst\n",
+                   screen->uploads, screen->upload_time / screen->uploads, screen->upload_max);
+        }
         delete (screen);
         screen = NULL;
     }
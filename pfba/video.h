@@ -7,6 +7,7 @@
 
 #include <cstring>
 #include <skeleton/renderer.h>
+#include "mailbox.h"
 
 class Video {
 
@@ -22,12 +23,24 @@ public:
     virtual void Scale();
     virtual void Filter(int filter);
 
+    // threaded mode: the emulation thread draws into "frames",
+    // the render thread uploads the newest one to the screen texture
+    void CreateFrames();
+    void DestroyFrames();
+    unsigned char *GetBackFrame();
+    void PublishFrame();
+    bool UploadFrame();
+
     Renderer *renderer = NULL;
     Texture *screen = NULL;
     Rect scale;
     int VideoBufferWidth = 0;
     int VideoBufferHeight = 0;
     int rotation = 0;
+
+    unsigned char *frames[3] = {NULL, NULL, NULL};
+    int frame_pitch = 0;
+    Mailbox mailbox;
 };
 
 #endif //_VIDEO_H_
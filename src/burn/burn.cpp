@@ -3,6 +3,10 @@
 #include "version.h"
 #include "burnint.h"
 #include "burn_sound.h"
+#include "burn_state.h"
+#include "tilemap_generic.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
 #include "driverlist.h"
 
 #ifndef __LIBRETRO__
@@ -47,8 +51,9 @@ INT32 nBurnSoundRate = 0;				// sample rate of sound or zero for no sound
 INT32 nBurnSoundLen = 0;				// length in samples per frame
 INT16* pBurnSoundOut = NULL;		// pointer to output buffer
 
-INT32 nInterpolation = 1;				// Desired interpolation level for ADPCM/PCM sound
+INT32 nInterpolation = 1;				// Unused by the sound cores, kept for the frontends
 INT32 nFMInterpolation = 0;			// Desired interpolation level for FM sound
+INT32 nResampleQuality = 1;			// Band-limited resampler filter length
 
 UINT8 nBurnLayer = 0xFF;	// Can be used externally to select which layers to show
 UINT8 nSpriteEnable = 0xFF;	// Can be used externally to select which layers to show
@@ -79,6 +84,8 @@ extern "C" INT32 BurnLibInit()
 
 	cmc_4p_Precalc();
 	bBurnUseMMX = BurnCheckMMXSupport();
+	BurnSoundKernelInit(-1);
+	BurnMachineInit();
 
 	return 0;
 }
@@ -87,6 +94,8 @@ extern "C" INT32 BurnLibExit()
 {
 	nBurnDrvCount = 0;
 
+	BurnMachineExit();
+
 	return 0;
 }
 
@@ -536,6 +545,40 @@ extern "C" INT32 BurnDrvGetHardwareCode()
 	return pDriver[nBurnDrvActive]->Hardware;
 }
 
+// Get a short name for the hardware family ("cps2", "neogeo", ...)
+extern "C" const char* BurnDrvGetHardwareName()
+{
+	static const struct { UINT32 nPrefix; const char* szName; } Families[] = {
+		{ HARDWARE_PREFIX_SNK,					"neogeo"	},
+		{ HARDWARE_PREFIX_CAPCOM,				"cps1"		},
+		{ HARDWARE_PREFIX_CPS2,					"cps2"		},
+		{ HARDWARE_PREFIX_CPS3,					"cps3"		},
+		{ HARDWARE_PREFIX_IGS_PGM,				"pgm"		},
+		{ HARDWARE_PREFIX_PSIKYO,				"psikyo"	},
+		{ HARDWARE_PREFIX_CAVE,					"cave"		},
+		{ HARDWARE_PREFIX_SEGA,					"sega"		},
+		{ HARDWARE_PREFIX_CAPCOM_MISC,			"capcom"	},
+		{ HARDWARE_PREFIX_DATAEAST,				"dataeast"	},
+		{ HARDWARE_PREFIX_IREM,					"irem"		},
+		{ HARDWARE_PREFIX_KANEKO,				"kaneko"	},
+		{ HARDWARE_PREFIX_KONAMI,				"konami"	},
+		{ HARDWARE_PREFIX_TAITO,				"taito"		},
+		{ HARDWARE_PREFIX_TOAPLAN,				"toaplan"	},
+		{ HARDWARE_PREFIX_SEGA_MEGADRIVE,		"megadrive"	},
+		{ HARDWARE_PREFIX_PCENGINE,				"pce"		},
+	};
+
+	UINT32 nPrefix = BurnDrvGetHardwareCode() & 0x7f000000;
+
+	for (UINT32 i = 0; i < sizeof(Families) / sizeof(Families[0]); i++) {
+		if (Families[i].nPrefix == nPrefix) {
+			return Families[i].szName;
+		}
+	}
+
+	return "misc";
+}
+
 // Get flags, including BDF_GAME_WORKING flag
 extern "C" INT32 BurnDrvGetFlags()
 {
@@ -623,6 +666,9 @@ extern "C" INT32 BurnDrvInit()
 	BurnStateInit();	
 	BurnInitMemoryManager();
 
+	nBurnIdleMask = ~0;									// the driver may turn some off
+	BurnIdleReset();
+
 	nReturnValue = pDriver[nBurnDrvActive]->Init();	// Forward to drivers function
 
 	nMaxPlayers = pDriver[nBurnDrvActive]->Players;
@@ -715,7 +761,14 @@ extern "C" INT32 BurnDrvFrame()
 {
 	CheatApply();									// Apply cheats (if any)
 	HiscoreApply();
+#ifdef BURN_PROF
+	BurnProfFrameBegin();
+	INT32 nRet = pDriver[nBurnDrvActive]->Frame();
+	BurnProfFrameEnd();
+	return nRet;
+#else
 	return pDriver[nBurnDrvActive]->Frame();		// Forward to drivers function
+#endif
 }
 
 // Force redraw of the screen
@@ -823,6 +876,9 @@ INT32 BurnByteswap(UINT8* pMem, INT32 nLen)
 // Application-defined rom loading function:
 INT32 (__cdecl *BurnExtLoadRom)(UINT8 *Dest, INT32 *pnWrote, INT32 i) = NULL;
 
+// Application-defined crc of the rom files:
+INT32 (__cdecl *BurnExtRomCrc)(UINT32* pnCrc, UINT32* pnLen, INT32 i) = NULL;
+
 // Application-defined colour conversion function
 static UINT32 __cdecl BurnHighColFiller(INT32, INT32, INT32, INT32) { return (UINT32)(~0); }
 UINT32 (__cdecl *BurnHighCol) (INT32 r, INT32 g, INT32 b, INT32 i) = BurnHighColFiller;
@@ -849,6 +905,11 @@ INT32 BurnAreaScan(INT32 nAction, INT32* pnMin)
 		nRet |= pDriver[nBurnDrvActive]->AreaScan(nAction, pnMin);
 	}
 
+	// video ram may have been restored, re-render the cached tilemaps
+	if (nAction & ACB_WRITE) {
+		GenericTilemapAllTilesDirty(TMAP_GLOBAL);
+	}
+
 	return nRet;
 }
 
@@ -929,6 +990,8 @@ void BurnStateExit()
 	for (INT32 i = 0; i < 8; i++) {
 		BurnPostload[i] = NULL;
 	}
+
+	BurnStateMemReset();
 }
 
 INT32 BurnStateInit()
@@ -20,6 +20,7 @@
 extern TCHAR szAppHiscorePath[MAX_PATH];
 extern TCHAR szAppSamplesPath[MAX_PATH];
 extern TCHAR szAppBlendPath[MAX_PATH];
+extern TCHAR szAppCachePath[MAX_PATH];							// decoded graphics cache, empty to disable it
 
 // Alignment macro, to keep savestates compatible between 32/64bit platforms.
 #ifdef _MSC_VER
@@ -96,6 +97,9 @@ enum BurnCartrigeCommand { CART_INIT_START, CART_INIT_END, CART_EXIT };
 // Application-defined rom loading function
 extern INT32 (__cdecl *BurnExtLoadRom)(UINT8* Dest, INT32* pnWrote, INT32 i);
 
+// Application-defined function returning the crc and length of the file rom i is loaded from (NULL if unknown)
+extern INT32 (__cdecl *BurnExtRomCrc)(UINT32* pnCrc, UINT32* pnLen, INT32 i);
+
 // Application-defined progress indicator functions
 extern INT32 (__cdecl *BurnExtProgressRangeCallback)(double dProgressRange);
 extern INT32 (__cdecl *BurnExtProgressUpdateCallback)(double dProgress, const TCHAR* pszText, bool bAbs);
@@ -242,8 +246,9 @@ extern INT32 nBurnSoundRate;					// Samplerate of sound
 extern INT32 nBurnSoundLen;					// Length in samples per frame
 extern INT16* pBurnSoundOut;				// Pointer to output buffer
 
-extern INT32 nInterpolation;					// Desired interpolation level for ADPCM/PCM sound
-extern INT32 nFMInterpolation;				// Desired interpolation level for FM sound
+extern INT32 nInterpolation;					// Unused, the ADPCM/PCM chips always go through the resampler
+extern INT32 nFMInterpolation;				// Desired interpolation level for FM sound (3+: band-limited)
+extern INT32 nResampleQuality;				// Band-limited resampler: 0 = 8, 1 = 16, 2 = 32 taps
 
 extern UINT32 *pBurnDrvPalette;
 
@@ -305,6 +310,7 @@ INT32 BurnDrvGetVisibleOffs(INT32* pnLeft, INT32* pnTop);
 INT32 BurnDrvGetFullSize(INT32* pnWidth, INT32* pnHeight);
 INT32 BurnDrvGetAspect(INT32* pnXAspect, INT32* pnYAspect);
 INT32 BurnDrvGetHardwareCode();
+const char* BurnDrvGetHardwareName();
 INT32 BurnDrvGetFlags();
 bool BurnDrvIsWorking();
 INT32 BurnDrvGetMaxPlayers();
@@ -0,0 +1,445 @@
+// Palette lookup line blitters used by BurnTransferCopy
+//
+// Every kernel produces exactly the same output as the c one: 16 and 32-bit
+// pixels are the low bits of the palette entry, 24-bit pixels are stored
+// packed as b, g, r (c & 0xff, (c >> 8) & 0xff, (c >> 16) & 0xff).
+
+#include "burnint.h"
+#include "burn_blit.h"
+#include <time.h>
+
+#if defined __GNUC__ && (defined __i386__ || defined __x86_64__) \
+	&& (defined __clang__ || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+ #define BURN_BLIT_X86
+ #include <immintrin.h>
+#endif
+
+#if defined __ARM_NEON__ || defined __ARM_NEON
+ #define BURN_BLIT_ARM
+ #include <arm_neon.h>
+#endif
+
+static BurnBlitLineFn BlitLine[BURN_BLIT_MAX][5];
+static INT32 nBlitKernel = BURN_BLIT_C;
+static INT32 bBlitInitted = 0;
+
+// ----------------------------------------------------------------------------
+// c
+
+static void BlitLine16_C(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	UINT16* pPixel = (UINT16*)pDest;
+	INT32 x = 0;
+
+	for (; x < nWidth - 3; x += 4) {
+		pPixel[x + 0] = pPalette[pSrc[x + 0]];
+		pPixel[x + 1] = pPalette[pSrc[x + 1]];
+		pPixel[x + 2] = pPalette[pSrc[x + 2]];
+		pPixel[x + 3] = pPalette[pSrc[x + 3]];
+	}
+	for (; x < nWidth; x++) {
+		pPixel[x] = pPalette[pSrc[x]];
+	}
+}
+
+static void BlitLine24_C(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+#ifdef LSB_FIRST
+	// 4 pixels are exactly 3 words, pack them instead of doing 12 byte stores
+	if (((uintptr_t)pDest & 3) == 0) {
+		UINT32* pWord = (UINT32*)pDest;
+		for (; x < nWidth - 3; x += 4, pWord += 3) {
+			UINT32 c0 = pPalette[pSrc[x + 0]] & 0xFFFFFF;
+			UINT32 c1 = pPalette[pSrc[x + 1]] & 0xFFFFFF;
+			UINT32 c2 = pPalette[pSrc[x + 2]] & 0xFFFFFF;
+			UINT32 c3 = pPalette[pSrc[x + 3]] & 0xFFFFFF;
+			pWord[0] = c0 | (c1 << 24);
+			pWord[1] = (c1 >> 8) | (c2 << 16);
+			pWord[2] = (c2 >> 16) | (c3 << 8);
+		}
+	}
+#endif
+
+	for (; x < nWidth; x++) {
+		UINT32 c = pPalette[pSrc[x]];
+		pDest[(x * 3) + 0] = c & 0xFF;
+		pDest[(x * 3) + 1] = (c >> 8) & 0xFF;
+		pDest[(x * 3) + 2] = (c >> 16) & 0xFF;
+	}
+}
+
+static void BlitLine32_C(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	UINT32* pPixel = (UINT32*)pDest;
+	INT32 x = 0;
+
+	for (; x < nWidth - 3; x += 4) {
+		pPixel[x + 0] = pPalette[pSrc[x + 0]];
+		pPixel[x + 1] = pPalette[pSrc[x + 1]];
+		pPixel[x + 2] = pPalette[pSrc[x + 2]];
+		pPixel[x + 3] = pPalette[pSrc[x + 3]];
+	}
+	for (; x < nWidth; x++) {
+		pPixel[x] = pPalette[pSrc[x]];
+	}
+}
+
+// ----------------------------------------------------------------------------
+// x86 (sse2 / avx2), selected at runtime
+
+#ifdef BURN_BLIT_X86
+
+#define SSE2_GATHER4(p, s)	_mm_set_epi32(p[s[3]], p[s[2]], p[s[1]], p[s[0]])
+
+__attribute__((target("sse2")))
+static void BlitLine16_SSE2(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+	for (; x < nWidth - 7; x += 8) {
+		__m128i lo = SSE2_GATHER4(pPalette, (pSrc + x));
+		__m128i hi = SSE2_GATHER4(pPalette, (pSrc + x + 4));
+		// sign extend the low 16 bits so the saturating pack keeps them as is
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i*)(pDest + (x * 2)), _mm_packs_epi32(lo, hi));
+	}
+
+	BlitLine16_C(pDest + (x * 2), pSrc + x, pPalette, nWidth - x);
+}
+
+__attribute__((target("sse2")))
+static void BlitLine32_SSE2(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+	for (; x < nWidth - 7; x += 8) {
+		_mm_storeu_si128((__m128i*)(pDest + (x * 4)), SSE2_GATHER4(pPalette, (pSrc + x)));
+		_mm_storeu_si128((__m128i*)(pDest + (x * 4) + 16), SSE2_GATHER4(pPalette, (pSrc + x + 4)));
+	}
+
+	BlitLine32_C(pDest + (x * 4), pSrc + x, pPalette, nWidth - x);
+}
+
+#undef SSE2_GATHER4
+
+__attribute__((target("avx2")))
+static inline __m256i AVX2Gather8(const UINT32* pPalette, const UINT16* pSrc)
+{
+	__m256i idx = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)pSrc));
+	return _mm256_i32gather_epi32((const int*)pPalette, idx, 4);
+}
+
+__attribute__((target("avx2")))
+static void BlitLine16_AVX2(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	const __m256i mask = _mm256_set1_epi32(0xFFFF);
+	INT32 x = 0;
+
+	for (; x < nWidth - 15; x += 16) {
+		__m256i a = _mm256_and_si256(AVX2Gather8(pPalette, pSrc + x), mask);
+		__m256i b = _mm256_and_si256(AVX2Gather8(pPalette, pSrc + x + 8), mask);
+		// the pack works per 128-bit lane: a0-3 b0-3 a4-7 b4-7, put the quads back in order
+		__m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+		_mm256_storeu_si256((__m256i*)(pDest + (x * 2)), p);
+	}
+
+	BlitLine16_C(pDest + (x * 2), pSrc + x, pPalette, nWidth - x);
+}
+
+__attribute__((target("avx2")))
+static void BlitLine24_AVX2(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	// drop the 4th byte of each pixel, 12 packed bytes at the bottom of each lane
+	const __m256i shuffle = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	INT32 x = 0;
+
+	// each 16-byte store spills 4 bytes past its 12, which the next store or the
+	// tail overwrites: stop while there are still 2 pixels left after the block
+	for (; x < nWidth - 9; x += 8) {
+		__m256i p = _mm256_shuffle_epi8(AVX2Gather8(pPalette, pSrc + x), shuffle);
+		_mm_storeu_si128((__m128i*)(pDest + (x * 3)), _mm256_castsi256_si128(p));
+		_mm_storeu_si128((__m128i*)(pDest + (x * 3) + 12), _mm256_extracti128_si256(p, 1));
+	}
+
+	BlitLine24_C(pDest + (x * 3), pSrc + x, pPalette, nWidth - x);
+}
+
+__attribute__((target("avx2")))
+static void BlitLine32_AVX2(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+	for (; x < nWidth - 7; x += 8) {
+		_mm256_storeu_si256((__m256i*)(pDest + (x * 4)), AVX2Gather8(pPalette, pSrc + x));
+	}
+
+	BlitLine32_C(pDest + (x * 4), pSrc + x, pPalette, nWidth - x);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// arm (neon), always available when built in
+
+#ifdef BURN_BLIT_ARM
+
+static inline uint32x4_t NEONGather4(const UINT32* pPalette, const UINT16* pSrc)
+{
+	uint32x4_t c = vdupq_n_u32(pPalette[pSrc[0]]);
+	c = vsetq_lane_u32(pPalette[pSrc[1]], c, 1);
+	c = vsetq_lane_u32(pPalette[pSrc[2]], c, 2);
+	c = vsetq_lane_u32(pPalette[pSrc[3]], c, 3);
+	return c;
+}
+
+static void BlitLine16_NEON(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+	for (; x < nWidth - 7; x += 8) {
+		uint16x4_t lo = vmovn_u32(NEONGather4(pPalette, pSrc + x));
+		uint16x4_t hi = vmovn_u32(NEONGather4(pPalette, pSrc + x + 4));
+		vst1q_u16((uint16_t*)(pDest + (x * 2)), vcombine_u16(lo, hi));
+	}
+
+	BlitLine16_C(pDest + (x * 2), pSrc + x, pPalette, nWidth - x);
+}
+
+static void BlitLine24_NEON(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+	for (; x < nWidth - 7; x += 8) {
+		uint32x4_t lo = NEONGather4(pPalette, pSrc + x);
+		uint32x4_t hi = NEONGather4(pPalette, pSrc + x + 4);
+		uint8x8x3_t bgr;
+		bgr.val[0] = vmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+		bgr.val[1] = vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 8), vshrn_n_u32(hi, 8)));
+		bgr.val[2] = vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)));
+		// interleaving store, no need for the packing shuffle
+		vst3_u8(pDest + (x * 3), bgr);
+	}
+
+	BlitLine24_C(pDest + (x * 3), pSrc + x, pPalette, nWidth - x);
+}
+
+static void BlitLine32_NEON(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth)
+{
+	INT32 x = 0;
+
+	for (; x < nWidth - 7; x += 8) {
+		vst1q_u32((uint32_t*)(pDest + (x * 4)), NEONGather4(pPalette, pSrc + x));
+		vst1q_u32((uint32_t*)(pDest + (x * 4) + 16), NEONGather4(pPalette, pSrc + x + 4));
+	}
+
+	BlitLine32_C(pDest + (x * 4), pSrc + x, pPalette, nWidth - x);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// dispatch
+
+INT32 BurnBlitKernelSupported(INT32 nKernel)
+{
+	switch (nKernel) {
+		case BURN_BLIT_C:
+			return 1;
+#ifdef BURN_BLIT_X86
+		case BURN_BLIT_SSE2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse2") ? 1 : 0;
+		case BURN_BLIT_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+#ifdef BURN_BLIT_ARM
+		case BURN_BLIT_NEON:
+			return 1;
+#endif
+	}
+
+	return 0;
+}
+
+static void BurnBlitSetupTables()
+{
+	memset(BlitLine, 0, sizeof(BlitLine));
+
+	for (INT32 i = 0; i < BURN_BLIT_MAX; i++) {
+		BlitLine[i][2] = BlitLine16_C;
+		BlitLine[i][3] = BlitLine24_C;
+		BlitLine[i][4] = BlitLine32_C;
+	}
+
+#ifdef BURN_BLIT_X86
+	BlitLine[BURN_BLIT_SSE2][2] = BlitLine16_SSE2;
+	BlitLine[BURN_BLIT_SSE2][4] = BlitLine32_SSE2;
+
+	BlitLine[BURN_BLIT_AVX2][2] = BlitLine16_AVX2;
+	BlitLine[BURN_BLIT_AVX2][3] = BlitLine24_AVX2;
+	BlitLine[BURN_BLIT_AVX2][4] = BlitLine32_AVX2;
+#endif
+
+#ifdef BURN_BLIT_ARM
+	BlitLine[BURN_BLIT_NEON][2] = BlitLine16_NEON;
+	BlitLine[BURN_BLIT_NEON][3] = BlitLine24_NEON;
+	BlitLine[BURN_BLIT_NEON][4] = BlitLine32_NEON;
+#endif
+}
+
+INT32 BurnBlitInit()
+{
+	if (!bBlitInitted) {
+		BurnBlitSetupTables();
+		bBlitInitted = 1;
+
+		nBlitKernel = BURN_BLIT_C;
+		for (INT32 i = BURN_BLIT_MAX - 1; i > BURN_BLIT_C; i--) {
+			if (BurnBlitKernelSupported(i)) {
+				nBlitKernel = i;
+				break;
+			}
+		}
+	}
+
+	return nBlitKernel;
+}
+
+INT32 BurnBlitSetKernel(INT32 nKernel)
+{
+	BurnBlitInit();
+
+	if (nKernel < 0 || nKernel >= BURN_BLIT_MAX || !BurnBlitKernelSupported(nKernel)) {
+		return 1;
+	}
+
+	nBlitKernel = nKernel;
+
+	return 0;
+}
+
+INT32 BurnBlitGetKernel()
+{
+	return BurnBlitInit();
+}
+
+const char* BurnBlitGetKernelName(INT32 nKernel)
+{
+	static const char* pszNames[BURN_BLIT_MAX] = { "c", "sse2", "avx2", "neon" };
+
+	if (nKernel < 0 || nKernel >= BURN_BLIT_MAX) {
+		return "unknown";
+	}
+
+	return pszNames[nKernel];
+}
+
+BurnBlitLineFn BurnBlitGetLine(INT32 nBpp)
+{
+	BurnBlitInit();
+
+	if (nBpp < 2 || nBpp > 4) {
+		return NULL;
+	}
+
+	return BlitLine[nBlitKernel][nBpp];
+}
+
+// ----------------------------------------------------------------------------
+// benchmark
+
+INT32 BurnBlitBench(INT32 nFrames)
+{
+	static const INT32 nSizes[][2] = { { 256, 224 }, { 320, 224 }, { 384, 224 }, { 640, 480 } };
+	const INT32 nSizeCount = sizeof(nSizes) / sizeof(nSizes[0]);
+	const INT32 nMaxPixels = 640 * 480;
+	const INT32 nPaletteSize = 0x10000;
+	INT32 nMismatch = 0;
+
+	if (nFrames <= 0) {
+		nFrames = 100;
+	}
+
+	BurnBlitInit();
+	INT32 nOldKernel = nBlitKernel;
+
+	UINT16* pSrc = (UINT16*)malloc(nMaxPixels * sizeof(UINT16));
+	UINT32* pPalette = (UINT32*)malloc(nPaletteSize * sizeof(UINT32));
+	UINT8* pDest = (UINT8*)malloc(nMaxPixels * 4);
+	UINT8* pRef = (UINT8*)malloc(nMaxPixels * 4);
+	if (pSrc == NULL || pPalette == NULL || pDest == NULL || pRef == NULL) {
+		free(pSrc);
+		free(pPalette);
+		free(pDest);
+		free(pRef);
+		return 1;
+	}
+
+	// noisy image and palette so nothing stays in a single cache line
+	UINT32 nSeed = 0x12345678;
+	for (INT32 i = 0; i < nPaletteSize; i++) {
+		nSeed = nSeed * 1103515245 + 12345;
+		pPalette[i] = nSeed;
+	}
+	for (INT32 i = 0; i < nMaxPixels; i++) {
+		nSeed = nSeed * 1103515245 + 12345;
+		pSrc[i] = (nSeed >> 16) & (nPaletteSize - 1);
+	}
+
+	bprintf(PRINT_NORMAL, _T("BurnBlit: best kernel is %s\n"), BurnBlitGetKernelName(BurnBlitGetKernel()));
+
+	for (INT32 k = 0; k < BURN_BLIT_MAX; k++) {
+		if (!BurnBlitKernelSupported(k)) {
+			continue;
+		}
+		for (INT32 nBpp = 2; nBpp <= 4; nBpp++) {
+			BurnBlitLineFn pBlit = BlitLine[k][nBpp];
+			BurnBlitLineFn pBlitRef = BlitLine[BURN_BLIT_C][nBpp];
+
+			for (INT32 s = 0; s < nSizeCount; s++) {
+				INT32 nWidth = nSizes[s][0], nHeight = nSizes[s][1];
+				INT32 nPitch = nWidth * nBpp;
+
+				// the odd width lines check the tails of the vector loops
+				memset(pDest, 0, nMaxPixels * 4);
+				memset(pRef, 0, nMaxPixels * 4);
+				for (INT32 y = 0; y < nHeight; y++) {
+					pBlit(pDest + y * nPitch, pSrc + y * nWidth, pPalette, nWidth - (y & 15));
+					pBlitRef(pRef + y * nPitch, pSrc + y * nWidth, pPalette, nWidth - (y & 15));
+				}
+				INT32 bMatch = memcmp(pDest, pRef, nPitch * nHeight) == 0;
+				if (!bMatch) {
+					nMismatch++;
+				}
+
+				clock_t nStart = clock();
+				for (INT32 f = 0; f < nFrames; f++) {
+					for (INT32 y = 0; y < nHeight; y++) {
+						pBlit(pDest + y * nPitch, pSrc + y * nWidth, pPalette, nWidth);
+					}
+				}
+				double fSeconds = (double)(clock() - nStart) / CLOCKS_PER_SEC;
+				double fPixels = (double)nWidth * nHeight * nFrames;
+
+				bprintf(PRINT_NORMAL, _T("BurnBlit: %-4s %ibpp %3ix%3i: %8.2f Mpixels/s%s\n"),
+						BurnBlitGetKernelName(k), nBpp * 8, nWidth, nHeight,
+						fSeconds > 0 ? fPixels / fSeconds / 1000000.0 : 0.0, bMatch ? "" : " (MISMATCH)");
+			}
+		}
+	}
+
+	nBlitKernel = nOldKernel;
+
+	free(pSrc);
+	free(pPalette);
+	free(pDest);
+	free(pRef);
+
+	return nMismatch;
+}
@@ -0,0 +1,23 @@
+// Palette lookup line blitters (pTransDraw -> pBurnDraw)
+
+enum {
+	BURN_BLIT_C = 0,
+	BURN_BLIT_SSE2,
+	BURN_BLIT_AVX2,
+	BURN_BLIT_NEON,
+	BURN_BLIT_MAX
+};
+
+// convert nWidth palette indexes from pSrc to nBpp bytes per pixel pixels at pDest
+typedef void (*BurnBlitLineFn)(UINT8* pDest, const UINT16* pSrc, const UINT32* pPalette, INT32 nWidth);
+
+INT32 BurnBlitInit();									// select the fastest kernels for this cpu, returns BURN_BLIT_*
+INT32 BurnBlitSetKernel(INT32 nKernel);					// returns 1 if the kernel isn't supported by this cpu
+INT32 BurnBlitGetKernel();
+INT32 BurnBlitKernelSupported(INT32 nKernel);
+const char* BurnBlitGetKernelName(INT32 nKernel);
+BurnBlitLineFn BurnBlitGetLine(INT32 nBpp);				// NULL if nBpp isn't 2, 3 or 4
+
+// run every supported kernel over common resolutions and print pixels/sec per bpp,
+// returns the number of kernels whose output didn't match the c kernel
+INT32 BurnBlitBench(INT32 nFrames);
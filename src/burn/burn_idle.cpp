@@ -0,0 +1,653 @@
+// Idle loop skipping
+
+#include "burnint.h"
+#include "burn_idle.h"
+
+#define IDLE_MAX_OPS		12							// instructions in a loop, its slot included
+#define IDLE_MAX_BYTES		64							// how far back the branch may go
+
+// registers, one bit each in the masks:
+//   68000: d0-d7 a0-a7 (reg(): same numbers), Z, N/V/C
+//   Z80:   a, the carry, the other flags, b c d e h l (reg(): 0 bc, 1 de, 2 hl)
+//   SH-2:  r0-r15, gbr (reg(): same numbers), T
+#define M68K_Z				(1 << 16)
+#define M68K_NVC			(1 << 17)
+#define Z80_A				(1 << 0)
+#define Z80_CF				(1 << 1)
+#define Z80_F				(1 << 2)
+#define Z80_BC				((1 << 3) | (1 << 4))
+#define Z80_DE				((1 << 5) | (1 << 6))
+#define Z80_HL				((1 << 7) | (1 << 8))
+#define SH2_GBR				(1 << 16)
+#define SH2_T				(1 << 17)
+
+#define IDLE_BRANCH_IF		1
+#define IDLE_BRANCH			2
+
+bool bBurnIdleSkip = true;
+BURN_THREAD UINT32 nBurnIdleMask = ~0;
+BURN_THREAD UINT64 nBurnIdleCycles[BURN_IDLE_MAX];
+BURN_THREAD UINT32 nBurnIdleSkips[BURN_IDLE_MAX];
+
+const char* szBurnIdleName[BURN_IDLE_MAX] = { "m68k", "z80", "sh2" };
+
+static const INT32 nIdleOpCycles[BURN_IDLE_MAX] = { 34, 23, 1 };	// most an instruction of the loops can take
+
+struct IdleOp {
+	INT32 nLength;
+	UINT32 nRead;										// registers read
+	UINT32 nWrite;										// registers written
+	INT32 nBranch;										// IDLE_BRANCH*
+	UINT32 nTarget;
+	bool bSlot;											// a delayed branch
+
+	INT32 nMemSize;										// a load
+	INT32 nBase, nIndex;								// reg() numbers added to the address, -1 for none
+	UINT32 nBaseMask, nIndexMask;
+	UINT32 nDisp;
+	bool bLiteral;										// from the code (a constant), not the polled location
+
+	INT32 nSet;											// register the load / move sets to a value known from the code, -1 for none
+	INT32 nSetFrom;										// ... copied from this one (-1: nSetValue, or the literal)
+	UINT32 nSetValue;
+};
+
+void BurnIdleDisable(UINT32 nMask)
+{
+	nBurnIdleMask &= ~nMask;
+}
+
+void BurnIdleReset()
+{
+	memset(nBurnIdleCycles, 0, sizeof(nBurnIdleCycles));
+	memset(nBurnIdleSkips, 0, sizeof(nBurnIdleSkips));
+}
+
+void BurnIdleMachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(nBurnIdleMask);
+	BURN_MACHINE_AREA(nBurnIdleCycles);
+	BURN_MACHINE_AREA(nBurnIdleSkips);
+}
+
+static INT32 IdleFetch(const BurnIdleCpu* pCpu, UINT32 a, INT32 nSize, UINT32* pValue)
+{
+	UINT32 v = 0;
+
+	for (INT32 i = 0; i < nSize; i++, a++) {
+		UINT8* pr = pCpu->fetch(a);
+		if (pr == NULL) return 0;
+		v = (v << 8) | pr[(a ^ pCpu->nPageXor) & (pCpu->nPageSize - 1)];
+	}
+
+	*pValue = v;
+	return 1;
+}
+
+static void IdleMem(IdleOp* op, INT32 nSize, INT32 nBase, UINT32 nBaseMask, UINT32 nDisp)
+{
+	op->nMemSize = nSize;
+	op->nBase = nBase;
+	op->nBaseMask = nBaseMask;
+	op->nDisp = nDisp;
+	op->nRead |= nBaseMask;
+}
+
+// ----------------------------------------------------------------------------
+// 68000: tst, cmp, cmpi, btst, move to a data register, moveq, and, andi, nop, bra and bcc
+
+static INT32 IdleEaM68K(const BurnIdleCpu* pCpu, IdleOp* op, UINT32 a, INT32 nMode, INT32 nReg, INT32 nSize, bool bSource)
+{
+	UINT32 w;
+
+	switch (nMode) {
+		case 0:
+			op->nRead |= 1 << nReg;
+			return 1;
+		case 1:
+			if (!bSource || nSize == 1) return 0;
+			op->nRead |= 1 << (8 + nReg);
+			return 1;
+		case 2:
+			IdleMem(op, nSize, 8 + nReg, 1 << (8 + nReg), 0);
+			return 1;
+		case 5:
+			if (!IdleFetch(pCpu, a + op->nLength, 2, &w)) return 0;
+			op->nLength += 2;
+			IdleMem(op, nSize, 8 + nReg, 1 << (8 + nReg), (INT16)w);
+			return 1;
+		case 7:
+			switch (nReg) {
+				case 0:
+					if (!IdleFetch(pCpu, a + op->nLength, 2, &w)) return 0;
+					op->nLength += 2;
+					IdleMem(op, nSize, -1, 0, (INT16)w);
+					return 1;
+				case 1:
+					if (!IdleFetch(pCpu, a + op->nLength, 4, &w)) return 0;
+					op->nLength += 4;
+					IdleMem(op, nSize, -1, 0, w);
+					return 1;
+				case 2:
+					if (!IdleFetch(pCpu, a + op->nLength, 2, &w)) return 0;
+					IdleMem(op, nSize, -1, 0, a + op->nLength + (INT16)w);
+					op->nLength += 2;
+					op->bLiteral = true;
+					return 1;
+				case 4:
+					if (!bSource) return 0;
+					op->nLength += (nSize == 4) ? 4 : 2;
+					return 1;
+			}
+			break;
+	}
+
+	return 0;
+}
+
+static INT32 IdleDecodeM68K(const BurnIdleCpu* pCpu, UINT32 a, IdleOp* op)
+{
+	static const INT32 nSizes[4] = { 1, 2, 4, 0 };
+	UINT32 w;
+
+	if (!IdleFetch(pCpu, a, 2, &w)) return 0;
+	op->nLength = 2;
+
+	INT32 nMode = (w >> 3) & 7;
+	INT32 nReg = w & 7;
+	INT32 nDn = (w >> 9) & 7;
+	INT32 nSize = nSizes[(w >> 6) & 3];
+
+	if (w == 0x4e71) {											// nop
+		return 1;
+	}
+
+	if ((w & 0xf000) == 0x6000) {								// bra, bcc
+		INT32 nCond = (w >> 8) & 15;
+		INT32 nDisp = (INT8)w;
+		if (nCond == 1 || nDisp == -1) return 0;				// bsr, 68020 displacement
+		if (nDisp == 0) {
+			if (!IdleFetch(pCpu, a + 2, 2, &w)) return 0;
+			nDisp = (INT16)w;
+			op->nLength = 4;
+		}
+		op->nTarget = (a + 2 + nDisp) & 0xffffff;
+		if (nCond == 0) {
+			op->nBranch = IDLE_BRANCH;
+		} else {
+			op->nBranch = IDLE_BRANCH_IF;
+			if (nCond == 2 || nCond == 3 || nCond == 6 || nCond == 7 || nCond >= 14) op->nRead |= M68K_Z;
+			if (nCond != 6 && nCond != 7) op->nRead |= M68K_NVC;
+		}
+		return 1;
+	}
+
+	if ((w & 0xff00) == 0x4a00 && nSize) {						// tst
+		op->nWrite = M68K_Z | M68K_NVC;
+		return IdleEaM68K(pCpu, op, a, nMode, nReg, nSize, false);
+	}
+
+	if ((w & 0xff00) == 0x0c00 && nSize) {						// cmpi
+		op->nLength += (nSize == 4) ? 4 : 2;
+		op->nWrite = M68K_Z | M68K_NVC;
+		return IdleEaM68K(pCpu, op, a, nMode, nReg, nSize, false);
+	}
+
+	if ((w & 0xff00) == 0x0200 && nSize && nMode == 0) {		// andi to dn
+		op->nLength += (nSize == 4) ? 4 : 2;
+		op->nRead = 1 << nReg;
+		op->nWrite = (1 << nReg) | M68K_Z | M68K_NVC;
+		return 1;
+	}
+
+	if ((w & 0xffc0) == 0x0800 || (w & 0xf1c0) == 0x0100) {		// btst #n, btst dn
+		if (nMode == 1) return 0;
+		if (w & 0x0100) {
+			op->nRead = 1 << nDn;
+		} else {
+			op->nLength += 2;
+		}
+		op->nWrite = M68K_Z;
+		return IdleEaM68K(pCpu, op, a, nMode, nReg, (nMode == 0) ? 4 : 1, false);
+	}
+
+	if ((w & 0xc000) == 0 && (w & 0x3000) && (w & 0x01c0) == 0) {	// move to dn
+		static const INT32 nMoveSizes[4] = { 0, 1, 4, 2 };
+		op->nWrite = (1 << nDn) | M68K_Z | M68K_NVC;
+		return IdleEaM68K(pCpu, op, a, nMode, nReg, nMoveSizes[(w >> 12) & 3], true);
+	}
+
+	if ((w & 0xf100) == 0x7000) {								// moveq
+		op->nWrite = (1 << nDn) | M68K_Z | M68K_NVC;
+		op->nSet = nDn;
+		op->nSetValue = (INT8)w;
+		return 1;
+	}
+
+	if (((w & 0xf000) == 0xb000 || (w & 0xf000) == 0xc000) && nSize && (w & 0x0100) == 0) {	// cmp, and to dn
+		op->nRead = 1 << nDn;
+		op->nWrite = M68K_Z | M68K_NVC;
+		if (w & 0x4000) op->nWrite |= 1 << nDn;
+		return IdleEaM68K(pCpu, op, a, nMode, nReg, nSize, (w & 0x4000) == 0);
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Z80: loads to registers, the 8-bit alu ops, bit, nop, jr and jp
+
+static const UINT32 nZ80Regs[8] = { 1 << 3, 1 << 4, 1 << 5, 1 << 6, 1 << 7, 1 << 8, 0, Z80_A };	// b c d e h l (hl) a
+
+static void IdleSrcZ80(IdleOp* op, INT32 nReg)
+{
+	if (nReg == 6) {
+		IdleMem(op, 1, 2, Z80_HL, 0);
+	} else {
+		op->nRead |= nZ80Regs[nReg];
+	}
+}
+
+static INT32 IdleDecodeZ80(const BurnIdleCpu* pCpu, UINT32 a, IdleOp* op)
+{
+	static const UINT32 nConds[8] = { Z80_F, Z80_F, Z80_CF, Z80_CF, Z80_F, Z80_F, Z80_F, Z80_F };
+	UINT32 w, n;
+
+	if (!IdleFetch(pCpu, a, 1, &w)) return 0;
+	op->nLength = 1;
+
+	switch (w) {
+		case 0x00:												// nop
+			return 1;
+
+		case 0x18:												// jr e
+		case 0x20: case 0x28: case 0x30: case 0x38:				// jr cc,e
+			if (!IdleFetch(pCpu, a + 1, 1, &n)) return 0;
+			op->nLength = 2;
+			op->nTarget = (a + 2 + (INT8)n) & 0xffff;
+			op->nBranch = (w == 0x18) ? IDLE_BRANCH : IDLE_BRANCH_IF;
+			if (w != 0x18) op->nRead = nConds[(w >> 3) & 3];
+			return 1;
+
+		case 0x0a:												// ld a,(bc)
+		case 0x1a:												// ld a,(de)
+			op->nWrite = Z80_A;
+			IdleMem(op, 1, w >> 4, (w & 0x10) ? Z80_DE : Z80_BC, 0);
+			return 1;
+
+		case 0x3a:												// ld a,(nn)
+			if (!IdleFetch(pCpu, a + 1, 2, &n)) return 0;
+			op->nLength = 3;
+			op->nWrite = Z80_A;
+			IdleMem(op, 1, -1, 0, ((n & 0xff) << 8) | (n >> 8));
+			return 1;
+
+		case 0xcb:												// bit b,r
+			if (!IdleFetch(pCpu, a + 1, 1, &n) || (n & 0xc0) != 0x40) return 0;
+			op->nLength = 2;
+			op->nWrite = Z80_F;
+			IdleSrcZ80(op, n & 7);
+			return 1;
+	}
+
+	if (w == 0xc3 || (w & 0xc7) == 0xc2) {						// jp nn, jp cc,nn
+		if (!IdleFetch(pCpu, a + 1, 2, &n)) return 0;
+		op->nLength = 3;
+		op->nTarget = ((n & 0xff) << 8) | (n >> 8);
+		op->nBranch = (w == 0xc3) ? IDLE_BRANCH : IDLE_BRANCH_IF;
+		if (op->nBranch == IDLE_BRANCH_IF) op->nRead = nConds[(w >> 3) & 7];
+		return 1;
+	}
+
+	if ((w & 0xc0) == 0x40 && w != 0x76 && (w & 0x38) != 0x30) {	// ld r,r'  ld r,(hl)
+		op->nWrite = nZ80Regs[(w >> 3) & 7];
+		IdleSrcZ80(op, w & 7);
+		return 1;
+	}
+
+	if ((w & 0xc0) == 0x80 || (w & 0xc7) == 0xc6) {			// add adc sub sbc and xor or cp  a,r / a,n
+		INT32 nOp = (w >> 3) & 7;
+		op->nRead = Z80_A;
+		op->nWrite = Z80_CF | Z80_F;
+		if (nOp == 1 || nOp == 3) op->nRead |= Z80_CF;
+		if (nOp != 7) op->nWrite |= Z80_A;
+		if (w & 0x40) {
+			op->nLength = 2;
+		} else {
+			IdleSrcZ80(op, w & 7);
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// SH-2: loads to registers, mov, tst, cmp, and, or, xor, ext, nop, bt, bf and bra
+
+static INT32 IdleDecodeSH2(const BurnIdleCpu* pCpu, UINT32 a, IdleOp* op)
+{
+	UINT32 w;
+
+	if (!IdleFetch(pCpu, a, 2, &w)) return 0;
+	op->nLength = 2;
+
+	INT32 n = (w >> 8) & 15;
+	INT32 m = (w >> 4) & 15;
+
+	if (w == 0x0009) {											// nop
+		return 1;
+	}
+
+	switch (w >> 12) {
+		case 0x2:
+			switch (w & 15) {
+				case 0x8:										// tst rm,rn
+					op->nRead = (1 << n) | (1 << m);
+					op->nWrite = SH2_T;
+					return 1;
+				case 0x9: case 0xa: case 0xb:					// and, xor, or rm,rn
+					op->nRead = (1 << n) | (1 << m);
+					op->nWrite = 1 << n;
+					return 1;
+			}
+			break;
+
+		case 0x3:
+			switch (w & 15) {
+				case 0x0: case 0x2: case 0x3: case 0x6: case 0x7:	// cmp/eq, hs, ge, hi, gt
+					op->nRead = (1 << n) | (1 << m);
+					op->nWrite = SH2_T;
+					return 1;
+			}
+			break;
+
+		case 0x4:
+			if ((w & 0xff) == 0x11 || (w & 0xff) == 0x15) {	// cmp/pz, cmp/pl
+				op->nRead = 1 << n;
+				op->nWrite = SH2_T;
+				return 1;
+			}
+			break;
+
+		case 0x5:												// mov.l @(disp,rm),rn
+			op->nWrite = 1 << n;
+			IdleMem(op, 4, m, 1 << m, (w & 15) * 4);
+			return 1;
+
+		case 0x6:
+			switch (w & 15) {
+				case 0x0: case 0x1: case 0x2:					// mov.b/w/l @rm,rn
+					op->nWrite = 1 << n;
+					IdleMem(op, 1 << (w & 3), m, 1 << m, 0);
+					return 1;
+				case 0x3:										// mov rm,rn
+					op->nRead = 1 << m;
+					op->nWrite = 1 << n;
+					op->nSet = n;
+					op->nSetFrom = m;
+					return 1;
+				case 0xc: case 0xd: case 0xe: case 0xf:			// extu, exts
+					op->nRead = 1 << m;
+					op->nWrite = 1 << n;
+					return 1;
+			}
+			break;
+
+		case 0x8:
+			switch (n) {
+				case 0x4: case 0x5:								// mov.b/w @(disp,rm),r0
+					op->nWrite = 1 << 0;
+					IdleMem(op, 1 << (n & 1), m, 1 << m, (w & 15) << (n & 1));
+					return 1;
+				case 0x8:										// cmp/eq #imm,r0
+					op->nRead = 1 << 0;
+					op->nWrite = SH2_T;
+					return 1;
+				case 0x9: case 0xb: case 0xd: case 0xf:			// bt, bf, bt/s, bf/s
+					op->nRead = SH2_T;
+					op->nBranch = IDLE_BRANCH_IF;
+					op->nTarget = a + 4 + (INT8)w * 2;
+					op->bSlot = (n & 4) != 0;
+					return 1;
+			}
+			break;
+
+		case 0x9:												// mov.w @(disp,pc),rn
+			op->nWrite = 1 << n;
+			op->nSet = n;
+			IdleMem(op, 2, -1, 0, a + 4 + (w & 0xff) * 2);
+			op->bLiteral = true;
+			return 1;
+
+		case 0xa:												// bra
+			op->nBranch = IDLE_BRANCH;
+			op->nTarget = a + 4 + (((INT32)(w << 20)) >> 19);
+			op->bSlot = true;
+			return 1;
+
+		case 0xc:
+			switch (n) {
+				case 0x4: case 0x5: case 0x6:					// mov.b/w/l @(disp,gbr),r0
+					op->nWrite = 1 << 0;
+					IdleMem(op, 1 << (n & 3), 16, SH2_GBR, (w & 0xff) << (n & 3));
+					return 1;
+				case 0x8:										// tst #imm,r0
+					op->nRead = 1 << 0;
+					op->nWrite = SH2_T;
+					return 1;
+				case 0x9:										// and #imm,r0
+					op->nRead = 1 << 0;
+					op->nWrite = 1 << 0;
+					return 1;
+				case 0xc:										// tst.b #imm,@(r0,gbr)
+					op->nWrite = SH2_T;
+					IdleMem(op, 1, 16, SH2_GBR, 0);
+					op->nIndex = 0;
+					op->nIndexMask = 1 << 0;
+					op->nRead |= 1 << 0;
+					return 1;
+			}
+			break;
+
+		case 0xd:												// mov.l @(disp,pc),rn
+			op->nWrite = 1 << n;
+			op->nSet = n;
+			IdleMem(op, 4, -1, 0, (a & ~3) + 4 + (w & 0xff) * 4);
+			op->bLiteral = true;
+			return 1;
+
+		case 0xe:												// mov #imm,rn
+			op->nWrite = 1 << n;
+			op->nSet = n;
+			op->nSetValue = (INT8)w;
+			return 1;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+static INT32 IdleDecode(const BurnIdleCpu* pCpu, UINT32 a, IdleOp* op)
+{
+	memset(op, 0, sizeof(IdleOp));
+	op->nBase = op->nIndex = op->nSet = op->nSetFrom = -1;
+
+	switch (pCpu->nCpu) {
+		case BURN_IDLE_M68K:	return IdleDecodeM68K(pCpu, a, op);
+		case BURN_IDLE_Z80:		return IdleDecodeZ80(pCpu, a, op);
+		case BURN_IDLE_SH2:		return IdleDecodeSH2(pCpu, a, op);
+	}
+
+	return 0;
+}
+
+// the value of a register at this point of the pass, 0 if it isn't known
+static INT32 IdleReg(const BurnIdleCpu* pCpu, INT32 nReg, UINT32 nMask, UINT32 nWritten, UINT32 nKnown, const UINT32* pValues, UINT32* pValue)
+{
+	if (nReg < 0) {
+		*pValue = 0;
+		return 1;
+	}
+
+	if (nMask & nWritten) {
+		// set earlier in the pass, from the code
+		if ((nMask & nKnown) != nMask || (nMask & (nMask - 1))) return 0;
+		*pValue = pValues[nReg];
+		return 1;
+	}
+
+	*pValue = pCpu->reg(nReg);
+	return 1;
+}
+
+INT32 BurnIdleFind(const BurnIdleCpu* pCpu, UINT32 nPc, BurnIdleLoop* pLoop)
+{
+	IdleOp ops[IDLE_MAX_OPS];
+	UINT32 nAddress[IDLE_MAX_OPS];
+	UINT32 a = nPc, nStart = 0, nEnd = 0;
+	INT32 nOps;
+
+	// forward from pc to a branch back over it, past the conditional ones out
+	for (nOps = 0; nOps < IDLE_MAX_OPS && nEnd == 0; nOps++) {
+		if (!IdleDecode(pCpu, a, &ops[0])) return 0;
+		a += ops[0].nLength;
+
+		if (ops[0].bSlot) {
+			IdleOp slot;
+			if (!IdleDecode(pCpu, a, &slot) || slot.nBranch) return 0;
+			a += slot.nLength;
+			nOps++;
+		}
+
+		if (ops[0].nBranch) {
+			if (ops[0].nTarget <= nPc && nPc - ops[0].nTarget < IDLE_MAX_BYTES) {
+				nStart = ops[0].nTarget;
+				nEnd = a;
+			} else if (ops[0].nBranch == IDLE_BRANCH) {
+				return 0;
+			}
+		}
+	}
+
+	if (nEnd == 0) return 0;
+
+	// the whole loop, what it writes
+	UINT32 nLoopWritten = 0;
+	bool bPc = false;
+
+	a = nStart;
+	for (nOps = 0; a < nEnd; nOps++) {
+		if (nOps == IDLE_MAX_OPS || !IdleDecode(pCpu, a, &ops[nOps])) return 0;
+		if (a == nPc) bPc = true;
+		nAddress[nOps] = a;
+		nLoopWritten |= ops[nOps].nWrite;
+		a += ops[nOps].nLength;
+	}
+
+	if (a != nEnd || !bPc) return 0;
+
+	// a pass, it mustn't depend on anything the pass before left but the polled value
+	UINT32 nWritten = 0, nKnown = 0;
+	UINT32 nValues[32];
+
+	pLoop->nStart = nStart;
+	pLoop->nEnd = nEnd;
+	pLoop->nPoll = 0;
+	pLoop->nPollSize = 0;
+	pLoop->nCycles = nOps * nIdleOpCycles[pCpu->nCpu];
+
+	for (INT32 i = 0; i < nOps; i++) {
+		IdleOp* op = &ops[i];
+
+		if (op->nRead & nLoopWritten & ~nWritten) return 0;
+
+		if (op->nBranch) {
+			UINT32 nAfter = nAddress[i] + op->nLength + (op->bSlot ? ops[i + 1].nLength : 0);
+			if (nAfter == nEnd) {
+				if (op->nTarget != nStart) return 0;
+			} else if (op->nBranch != IDLE_BRANCH_IF || (op->nTarget >= nStart && op->nTarget < nEnd)) {
+				return 0;
+			}
+		}
+
+		UINT32 nLoaded = 0;
+
+		if (op->nMemSize) {
+			UINT32 nBase, nIndex;
+			if (!IdleReg(pCpu, op->nBase, op->nBaseMask, nWritten, nKnown, nValues, &nBase)) return 0;
+			if (!IdleReg(pCpu, op->nIndex, op->nIndexMask, nWritten, nKnown, nValues, &nIndex)) return 0;
+
+			UINT32 nAddr = op->nDisp + nBase + nIndex;
+			if (pCpu->nCpu == BURN_IDLE_M68K) nAddr &= 0xffffff;
+			if (pCpu->nCpu == BURN_IDLE_Z80) nAddr &= 0xffff;
+
+			if (op->bLiteral) {
+				if (!IdleFetch(pCpu, nAddr, op->nMemSize, &nLoaded)) return 0;
+				if (op->nMemSize == 2) nLoaded = (INT16)nLoaded;
+			} else {
+				if (pCpu->read(nAddr) == NULL || pCpu->read(nAddr + op->nMemSize - 1) == NULL) return 0;
+				if (pLoop->nPollSize && (pLoop->nPoll != nAddr || pLoop->nPollSize != op->nMemSize)) return 0;
+				pLoop->nPoll = nAddr;
+				pLoop->nPollSize = op->nMemSize;
+			}
+		}
+
+		nWritten |= op->nWrite;
+		nKnown &= ~op->nWrite;
+
+		if (op->nSet >= 0) {
+			if (op->nSetFrom >= 0) {
+				if (!IdleReg(pCpu, op->nSetFrom, 1 << op->nSetFrom, nWritten & ~(1 << op->nSet), nKnown, nValues, &nValues[op->nSet])) continue;
+			} else {
+				nValues[op->nSet] = op->nMemSize ? nLoaded : op->nSetValue;
+			}
+			nKnown |= 1 << op->nSet;
+		}
+	}
+
+	return 1;
+}
+
+UINT32 BurnIdleValue(const BurnIdleCpu* pCpu, const BurnIdleLoop* pLoop)
+{
+	UINT32 v = 0, a = pLoop->nPoll;
+
+	for (INT32 i = 0; i < pLoop->nPollSize; i++, a++) {
+		UINT8* pr = pCpu->read(a);
+		if (pr) v = (v << 8) | pr[(a ^ pCpu->nPageXor) & (pCpu->nPageSize - 1)];
+	}
+
+	return v;
+}
+
+INT32 BurnIdleRun(const BurnIdleCpu* pCpu, INT32 (*pRun)(INT32), INT32 nCycles)
+{
+	BurnIdleLoop loop;
+
+	if (!BurnIdleEnabled(pCpu->nCpu) || !BurnIdleFind(pCpu, pCpu->pc(), &loop)) {
+		return pRun(nCycles);
+	}
+
+	// a couple of passes first, the loop can only be left from a pass that saw something new
+	INT32 nProbe = loop.nCycles * 2;
+	if (nCycles <= nProbe * 2) {
+		return pRun(nCycles);
+	}
+
+	UINT32 nValue = BurnIdleValue(pCpu, &loop);
+	INT32 nDone = pRun(nProbe);
+	if (nDone < nProbe) {
+		return nDone;											// the timeslice was ended
+	}
+
+	UINT32 nPc = pCpu->pc();
+	if (nPc >= loop.nStart && nPc < loop.nEnd && BurnIdleValue(pCpu, &loop) == nValue) {
+		BurnIdleSkipped(pCpu->nCpu, nCycles - nDone);
+		pCpu->idle(nCycles - nDone);
+		return nCycles;
+	}
+
+	return nDone + pRun(nCycles - nDone);
+}
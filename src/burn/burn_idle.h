@@ -0,0 +1,76 @@
+// Idle loop skipping
+//
+// A cpu that spins in a loop polling one directly mapped memory location
+// can't get out of it before something else writes that location, and nothing
+// else runs while its timeslice does. The cpu interfaces look at the code the
+// cpu is in when a timeslice starts; if it is such a loop (a short backward
+// branch, a body that only reads one location and computes the branch from
+// it), the cpu runs a couple of passes of it, and if it is still in the loop
+// with the location unchanged, the rest of the timeslice is skipped (it goes to
+// the cpu's cycle count as SekIdle() / ZetIdle() would). The SH-2 block cores
+// do the same between passes, up to the next internal timer event.
+//
+// Only loads from directly mapped pages qualify, loops polling through read
+// handlers (i/o, status ports) are left to the driver speedhacks. A driver the
+// skipping breaks turns it off with BurnIdleDisable() from its init.
+
+#include "burn_machine.h"
+
+enum BurnIdleCpuId {
+	BURN_IDLE_M68K = 0,
+	BURN_IDLE_Z80,
+	BURN_IDLE_SH2,
+	BURN_IDLE_MAX
+};
+
+// what a cpu interface tells the detector
+struct BurnIdleCpu {
+	INT32 nCpu;											// BURN_IDLE_*
+	UINT8 *(*fetch)(UINT32);							// page the code at an address is in, NULL if not directly mapped
+	UINT8 *(*read)(UINT32);								// page reads of an address go to, NULL if handled
+	UINT32 nPageSize;
+	UINT32 nPageXor;									// address ^ nPageXor is the offset of a byte in its page
+	UINT32 (*reg)(INT32);								// register values (see burn_idle.cpp for the numbering)
+	UINT32 (*pc)();
+	INT32 (*idle)(INT32);								// adds cycles to the cpu's count without running it
+};
+
+// a loop found by BurnIdleFind()
+struct BurnIdleLoop {
+	UINT32 nStart;										// the first instruction
+	UINT32 nEnd;										// the byte after the branch back (and its slot)
+	UINT32 nPoll;										// the location polled
+	INT32 nPollSize;									// bytes, 0 if the loop reads no memory (it waits for an irq)
+	INT32 nCycles;										// most cycles a pass can take (68000, Z80)
+};
+
+extern const char* szBurnIdleName[BURN_IDLE_MAX];
+extern bool bBurnIdleSkip;								// frontend: skip idle loops (default on)
+extern BURN_THREAD UINT32 nBurnIdleMask;				// bit per BURN_IDLE_*, set by BurnDrvInit()
+extern BURN_THREAD UINT64 nBurnIdleCycles[BURN_IDLE_MAX];	// cycles skipped since BurnIdleReset()
+extern BURN_THREAD UINT32 nBurnIdleSkips[BURN_IDLE_MAX];	// times some were
+
+// driver opt-out, call from the driver init (nMask: bits of BURN_IDLE_*)
+void BurnIdleDisable(UINT32 nMask);
+void BurnIdleReset();
+
+inline static bool BurnIdleEnabled(INT32 nCpu)
+{
+	return bBurnIdleSkip && (nBurnIdleMask & (1 << nCpu));
+}
+
+// 1 if the code at nPc is a poll loop, registers are read to work out the location
+INT32 BurnIdleFind(const BurnIdleCpu* pCpu, UINT32 nPc, BurnIdleLoop* pLoop);
+
+// the polled location, byte order doesn't matter, it is only compared
+UINT32 BurnIdleValue(const BurnIdleCpu* pCpu, const BurnIdleLoop* pLoop);
+
+// count skipped cycles
+inline static void BurnIdleSkipped(INT32 nCpu, INT32 nCycles)
+{
+	nBurnIdleCycles[nCpu] += nCycles;
+	nBurnIdleSkips[nCpu]++;
+}
+
+// run the open cpu for nCycles with pRun, skipping the timeslice if it is seen idle at the start
+INT32 BurnIdleRun(const BurnIdleCpu* pCpu, INT32 (*pRun)(INT32), INT32 nCycles);
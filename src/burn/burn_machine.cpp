@@ -0,0 +1,124 @@
+// Machines
+
+#include "burnint.h"
+#include "burn_machine.h"
+#include "m68000_intf.h"
+#include "z80_intf.h"
+
+#define MACHINE_SIZE	0
+#define MACHINE_SAVE	1
+#define MACHINE_SWAP	2
+
+struct BurnMachine {
+	UINT8* pState;										// the module globals, in BurnMachineAreas() order
+};
+
+static INT32 nMachineSize = 0;
+static UINT8* pMachineBoot = NULL;						// the globals before anything ran, new machines start from them
+
+static BURN_THREAD INT32 nMachineAction;
+static BURN_THREAD UINT8* pMachineState;
+static BURN_THREAD INT32 nMachinePos;
+
+static void BurnMachineArea(void* pData, INT32 nLen)
+{
+	UINT8* pd = (UINT8*)pData;
+	UINT8* ps = pMachineState + nMachinePos;
+
+	switch (nMachineAction) {
+		case MACHINE_SAVE:
+			memcpy(ps, pd, nLen);
+			break;
+		case MACHINE_SWAP:
+			for (INT32 i = 0; i < nLen; i++) {
+				UINT8 t = pd[i];
+				pd[i] = ps[i];
+				ps[i] = t;
+			}
+			break;
+	}
+
+	nMachinePos += nLen;
+}
+
+static void BurnMachineAreas(INT32 nAction, UINT8* pState)
+{
+	nMachineAction = nAction;
+	pMachineState = pState;
+	nMachinePos = 0;
+
+	SekMachineAreas(BurnMachineArea);
+	ZetMachineAreas(BurnMachineArea);
+	Sh2MachineAreas(BurnMachineArea);
+	BurnTimerMachineAreas(BurnMachineArea);
+	GenericTilesMachineAreas(BurnMachineArea);
+	BurnMemoryMachineAreas(BurnMachineArea);
+	BurnIdleMachineAreas(BurnMachineArea);
+}
+
+INT32 BurnMachineInit()
+{
+	if (pMachineBoot) {
+		return 0;
+	}
+
+	BurnMachineAreas(MACHINE_SIZE, NULL);
+	nMachineSize = nMachinePos;
+
+	pMachineBoot = (UINT8*)malloc(nMachineSize);
+	if (pMachineBoot == NULL) {
+		return 1;
+	}
+
+	BurnMachineAreas(MACHINE_SAVE, pMachineBoot);
+
+	return 0;
+}
+
+void BurnMachineExit()
+{
+	if (pMachineBoot) {
+		free(pMachineBoot);
+		pMachineBoot = NULL;
+	}
+}
+
+BurnMachine* BurnMachineCreate()
+{
+	if (pMachineBoot == NULL) {
+		return NULL;
+	}
+
+	BurnMachine* pMachine = (BurnMachine*)malloc(sizeof(BurnMachine));
+	if (pMachine == NULL) {
+		return NULL;
+	}
+
+	pMachine->pState = (UINT8*)malloc(nMachineSize);
+	if (pMachine->pState == NULL) {
+		free(pMachine);
+		return NULL;
+	}
+
+	memcpy(pMachine->pState, pMachineBoot, nMachineSize);
+
+	return pMachine;
+}
+
+void BurnMachineDestroy(BurnMachine* pMachine)
+{
+	if (pMachine) {
+		free(pMachine->pState);
+		free(pMachine);
+	}
+}
+
+void BurnMachineSwap(BurnMachine* pMachine)
+{
+#if defined FBA_DEBUG
+	if (nSekActive != -1) bprintf(PRINT_ERROR, _T("BurnMachineSwap called with a 68000 open\n"));
+	if (DebugCPU_ZetInitted && ZetGetActive() != -1) bprintf(PRINT_ERROR, _T("BurnMachineSwap called with a Z80 open\n"));
+#endif
+
+	BurnMachineAreas(MACHINE_SWAP, pMachine->pState);
+}
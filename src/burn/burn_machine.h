@@ -0,0 +1,68 @@
+// Machines
+//
+// The cpu interfaces (Sek, Zet, Sh2), the timers, the generic tile renderer, the
+// memory manager and the idle skip keep their state in globals, the state of the
+// machine a thread runs. In BURN_MACHINES builds those are thread local, so every
+// thread runs a machine of its own, and a BurnMachine holds a machine no thread runs:
+// BurnMachineSwap() exchanges it with the one of the calling thread, which lets
+// a thread switch between several machines (pfba-bench --switch runs its boards
+// both ways and compares them).
+//
+// Only these modules are per machine so far, so two games can't run at once,
+// only bare cpus can (pfba-bench --switch). Still shared by all machines:
+// - burn.cpp: nBurnDrvActive, nCurrentFrame, pBurnDraw, nBurnPitch, nBurnBpp,
+//   pBurnSoundOut, nBurnSoundLen, nBurnSoundRate, nBurnCPUSpeedAdjust,
+//   pBurnDrvPalette, BurnAcb
+// - the drivers' globals and statics
+// - the sound cores and their resamplers, the devices (eeprom, tc0140syt, ...),
+//   the palette, cheats, hiscore, gun and led code
+// - the opcode table Musashi builds on the first SekInit() (set up a machine
+//   before starting the other threads)
+// BURN_MACHINES builds don't use the 68000 and SH-2 recompilers.
+
+#ifndef BURN_MACHINE_H
+#define BURN_MACHINE_H
+
+// per machine globals are declared with BURN_THREAD (C and C++)
+#if defined BURN_MACHINES
+ #if defined _MSC_VER
+  #define BURN_THREAD __declspec(thread)
+ #else
+  #define BURN_THREAD __thread
+ #endif
+#else
+ #define BURN_THREAD
+#endif
+
+#ifdef __cplusplus
+
+struct BurnMachine;
+
+// the modules list their per machine globals with this
+typedef void (*BurnMachineAreaCallback)(void* pData, INT32 nLen);
+#define BURN_MACHINE_AREA(x) pArea(&(x), sizeof(x))
+
+void SekMachineAreas(BurnMachineAreaCallback pArea);
+void ZetMachineAreas(BurnMachineAreaCallback pArea);
+void Sh2MachineAreas(BurnMachineAreaCallback pArea);
+void BurnTimerMachineAreas(BurnMachineAreaCallback pArea);
+void GenericTilesMachineAreas(BurnMachineAreaCallback pArea);
+void BurnMemoryMachineAreas(BurnMachineAreaCallback pArea);
+void BurnIdleMachineAreas(BurnMachineAreaCallback pArea);
+
+// BurnLibInit() / BurnLibExit()
+INT32 BurnMachineInit();
+void BurnMachineExit();
+
+// a machine with nothing set up, NULL before BurnLibInit()
+BurnMachine* BurnMachineCreate();
+
+// the cpus and the rest must have been exited while it ran
+void BurnMachineDestroy(BurnMachine* pMachine);
+
+// exchange the calling thread's machine with pMachine, with no cpu open
+void BurnMachineSwap(BurnMachine* pMachine);
+
+#endif
+
+#endif // BURN_MACHINE_H
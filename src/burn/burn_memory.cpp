@@ -8,7 +8,7 @@
 
 #define MAX_MEM_PTR	0x400 // more than 1024 malloc calls should be insane...
 
-static UINT8 *memptr[MAX_MEM_PTR]; // pointer to allocated memory
+static BURN_THREAD UINT8 *memptr[MAX_MEM_PTR]; // pointer to allocated memory
 
 // this should be called early on... BurnDrvInit?
 
@@ -75,3 +75,9 @@ void BurnExitMemoryManager()
 		}
 	}
 }
+
+// what a machine has allocated (burn_machine.h)
+void BurnMemoryMachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(memptr);
+}
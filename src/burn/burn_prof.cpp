@@ -0,0 +1,259 @@
+// Hot path profiler
+
+#include "burnint.h"
+#include "burn_prof.h"
+#include <atomic>
+
+#define PROF_MAX_DEPTH	8
+#define PROF_FRAME_ID	-1								// trace events of the whole frame
+
+INT64 (*BurnProfClock)() = NULL;
+INT64 nBurnProfClockRate = 1000000;
+INT64 nBurnProfTime[BURN_PROF_MAX];
+
+const char* szBurnProfName[BURN_PROF_MAX] = {
+	"m68k", "z80", "sh2", "arm7", "nec",
+	"cps_draw", "neo_sprites", "pgm_draw", "tilemap", "transfer",
+	"ym2610", "qsound", "msm6295",
+	"user0", "user1", "user2", "user3"
+};
+
+static const char* szProfCategory[BURN_PROF_MAX] = {
+	"cpu", "cpu", "cpu", "cpu", "cpu",
+	"draw", "draw", "draw", "draw", "draw",
+	"sound", "sound", "sound",
+	"frontend", "frontend", "frontend", "frontend"
+};
+
+static INT32 nProfStack[PROF_MAX_DEPTH];
+static INT64 nProfBegin[PROF_MAX_DEPTH];				// start of each open scope, for the trace
+static INT32 nProfDepth = 0;
+static INT64 nProfStart = 0;							// start of the innermost scope, or of its last resume
+
+static INT64 nProfFrameTime[BURN_PROF_MAX];				// current frame
+static INT64 nProfFrameStart = 0;
+
+// single writer (emulation thread), any number of readers: a slot is reused
+// BURN_PROF_FRAMES frames after it was published, readers detect that with the
+// published count and drop the frames that may have been overwritten meanwhile
+static struct BurnProfFrame ProfFrames[BURN_PROF_FRAMES];
+static std::atomic<UINT32> nProfFramesPublished(0);
+
+struct ProfEvent {
+	INT64 nStart;
+	INT64 nEnd;
+	INT32 nId;
+	INT32 nDepth;
+};
+
+static struct ProfEvent* pProfEvents = NULL;
+static INT32 nProfEventsMax = 0;
+static UINT32 nProfEventsCount = 0;					// events recorded, the ring keeps the newest
+
+static inline void ProfTrace(INT32 nId, INT32 nDepth, INT64 nStart, INT64 nEnd)
+{
+	struct ProfEvent* e = &pProfEvents[nProfEventsCount % nProfEventsMax];
+
+	e->nStart = nStart;
+	e->nEnd = nEnd;
+	e->nId = nId;
+	e->nDepth = nDepth;
+	nProfEventsCount++;
+}
+
+void BurnProfInit(INT64 (*pClock)(), INT64 nClockRate)
+{
+	BurnProfReset();
+	nProfFramesPublished = 0;
+
+	nBurnProfClockRate = nClockRate > 0 ? nClockRate : 1000000;
+	BurnProfClock = pClock;
+}
+
+void BurnProfExit()
+{
+	BurnProfClock = NULL;
+	nProfDepth = 0;
+
+	if (pProfEvents) {
+		free(pProfEvents);
+		pProfEvents = NULL;
+	}
+	nProfEventsMax = 0;
+	nProfEventsCount = 0;
+}
+
+void BurnProfReset()
+{
+	memset(nBurnProfTime, 0, sizeof(nBurnProfTime));
+	memset(nProfFrameTime, 0, sizeof(nProfFrameTime));
+	nProfDepth = 0;
+}
+
+void BurnProfBegin(INT32 nId)
+{
+	INT64 nNow = BurnProfClock();
+
+	// pause the enclosing scope
+	if (nProfDepth > 0 && nProfDepth <= PROF_MAX_DEPTH) {
+		INT64 nTime = nNow - nProfStart;
+		nBurnProfTime[nProfStack[nProfDepth - 1]] += nTime;
+		nProfFrameTime[nProfStack[nProfDepth - 1]] += nTime;
+	}
+	if (nProfDepth < PROF_MAX_DEPTH) {
+		nProfStack[nProfDepth] = nId;
+		nProfBegin[nProfDepth] = nNow;
+	}
+	nProfDepth++;
+	nProfStart = nNow;
+}
+
+void BurnProfEnd()
+{
+	if (nProfDepth <= 0 || BurnProfClock == NULL) {
+		return;
+	}
+
+	INT64 nNow = BurnProfClock();
+
+	nProfDepth--;
+	if (nProfDepth < PROF_MAX_DEPTH) {
+		INT64 nTime = nNow - nProfStart;
+		nBurnProfTime[nProfStack[nProfDepth]] += nTime;
+		nProfFrameTime[nProfStack[nProfDepth]] += nTime;
+		if (pProfEvents) {
+			ProfTrace(nProfStack[nProfDepth], nProfDepth + 1, nProfBegin[nProfDepth], nNow);
+		}
+	}
+	nProfStart = nNow;									// resume the enclosing scope
+}
+
+void BurnProfFrameBegin()
+{
+	if (BurnProfClock == NULL) {
+		return;
+	}
+
+	nProfFrameStart = BurnProfClock();
+}
+
+void BurnProfFrameEnd()
+{
+	if (BurnProfClock == NULL) {
+		return;
+	}
+
+	INT64 nNow = BurnProfClock();
+
+	UINT32 nPublished = nProfFramesPublished.load(std::memory_order_relaxed);
+	struct BurnProfFrame* f = &ProfFrames[nPublished % BURN_PROF_FRAMES];
+	f->nFrame = nCurrentFrame;
+	f->nTotal = nNow - nProfFrameStart;
+	memcpy(f->nTime, nProfFrameTime, sizeof(f->nTime));
+	nProfFramesPublished.store(nPublished + 1, std::memory_order_release);
+
+	memset(nProfFrameTime, 0, sizeof(nProfFrameTime));
+
+	if (pProfEvents) {
+		ProfTrace(PROF_FRAME_ID, 0, nProfFrameStart, nNow);
+	}
+}
+
+INT32 BurnProfGetFrames(struct BurnProfFrame* pFrames, INT32 nCount)
+{
+	// keep clear of the slot the writer may be filling
+	if (nCount > BURN_PROF_FRAMES - 1) {
+		nCount = BURN_PROF_FRAMES - 1;
+	}
+
+	UINT32 nPublished = nProfFramesPublished.load(std::memory_order_acquire);
+	if ((UINT32)nCount > nPublished) {
+		nCount = (INT32)nPublished;
+	}
+
+	UINT32 nFirst = nPublished - nCount;
+	for (INT32 i = 0; i < nCount; i++) {
+		pFrames[i] = ProfFrames[(nFirst + i) % BURN_PROF_FRAMES];
+	}
+
+	// the writer went on while we were copying: drop the oldest frames, they may be torn
+	std::atomic_thread_fence(std::memory_order_acquire);
+	UINT32 nNow = nProfFramesPublished.load(std::memory_order_relaxed);
+	UINT32 nTorn = nNow - nPublished;
+	if (nTorn == 0) {
+		return nCount;
+	}
+	if (nTorn >= (UINT32)nCount) {
+		return 0;
+	}
+	memmove(pFrames, pFrames + nTorn, (nCount - nTorn) * sizeof(struct BurnProfFrame));
+
+	return nCount - nTorn;
+}
+
+INT32 BurnProfTraceStart(INT32 nMaxEvents)
+{
+	if (pProfEvents) {
+		free(pProfEvents);
+	}
+	nProfEventsCount = 0;
+	nProfEventsMax = 0;
+
+	if (nMaxEvents <= 0) {
+		return 1;
+	}
+
+	pProfEvents = (struct ProfEvent*)malloc(nMaxEvents * sizeof(struct ProfEvent));
+	if (pProfEvents == NULL) {
+		return 1;
+	}
+	nProfEventsMax = nMaxEvents;
+
+	return 0;
+}
+
+INT32 BurnProfTraceStop(const char* szFilename)
+{
+	if (pProfEvents == NULL) {
+		return 1;
+	}
+
+	INT32 nRet = 1;
+	FILE* fp = fopen(szFilename, "w");
+
+	if (fp) {
+		UINT32 nCount = nProfEventsCount < (UINT32)nProfEventsMax ? nProfEventsCount : (UINT32)nProfEventsMax;
+		UINT32 nFirst = nProfEventsCount - nCount;
+		double dScale = 1000000.0 / nBurnProfClockRate;			// trace timestamps are in us
+		INT64 nBase = 0;
+
+		for (UINT32 i = 0; i < nCount; i++) {
+			struct ProfEvent* e = &pProfEvents[(nFirst + i) % nProfEventsMax];
+			if (i == 0 || e->nStart < nBase) {
+				nBase = e->nStart;
+			}
+		}
+
+		fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"driver\": \"%s\"}, \"traceEvents\": [\n", BurnDrvGetTextA(DRV_NAME));
+		for (UINT32 i = 0; i < nCount; i++) {
+			struct ProfEvent* e = &pProfEvents[(nFirst + i) % nProfEventsMax];
+			const char* szName = e->nId == PROF_FRAME_ID ? "frame" : szBurnProfName[e->nId];
+			const char* szCat = e->nId == PROF_FRAME_ID ? "frame" : szProfCategory[e->nId];
+			fprintf(fp, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f}",
+				i ? ",\n" : "", szName, szCat, (e->nStart - nBase) * dScale, (e->nEnd - e->nStart) * dScale);
+		}
+		fprintf(fp, "\n]}\n");
+
+		nRet = ferror(fp) ? 1 : 0;
+		fclose(fp);
+
+		bprintf(0, _T("BurnProf: %d trace events written to %s\n"), nCount, szFilename);
+	}
+
+	free(pProfEvents);
+	pProfEvents = NULL;
+	nProfEventsMax = 0;
+	nProfEventsCount = 0;
+
+	return nRet;
+}
@@ -0,0 +1,74 @@
+// Hot path profiler
+//
+// Scopes around the cpu cores, the heavy draw functions, the sound renders and
+// the final transfer charge the time spent in them, minus the scopes nested
+// inside (a sound cpu run from a main cpu write handler is charged to the sound
+// cpu only), to their id. The totals of every BurnDrvFrame go to a lock-free
+// ring the frontend can read from any thread, and the scopes can be recorded
+// and written out as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+//
+// The scopes are compiled in with BURN_PROF and do nothing until BurnProfInit()
+// gives the profiler a clock. Everything but BurnProfGetFrames() must be called
+// from the emulation thread (or while it is stopped).
+
+enum BurnProfId {
+	BURN_PROF_M68K = 0,
+	BURN_PROF_Z80,
+	BURN_PROF_SH2,
+	BURN_PROF_ARM7,
+	BURN_PROF_VEZ,
+	BURN_PROF_CPS_DRAW,
+	BURN_PROF_NEO_SPRITES,
+	BURN_PROF_PGM_DRAW,
+	BURN_PROF_TILEMAP,
+	BURN_PROF_TRANSFER,
+	BURN_PROF_YM2610,
+	BURN_PROF_QSOUND,
+	BURN_PROF_MSM6295,
+	BURN_PROF_USER0,									// free for the frontend
+	BURN_PROF_USER1,
+	BURN_PROF_USER2,
+	BURN_PROF_USER3,
+	BURN_PROF_MAX
+};
+
+#define BURN_PROF_FRAMES	256							// frames kept in the ring
+
+struct BurnProfFrame {
+	UINT32 nFrame;										// nCurrentFrame
+	INT64 nTotal;										// whole BurnDrvFrame
+	INT64 nTime[BURN_PROF_MAX];
+};
+
+extern const char* szBurnProfName[BURN_PROF_MAX];
+extern INT64 (*BurnProfClock)();						// NULL when the profiler is off
+extern INT64 nBurnProfClockRate;						// clock ticks per second
+extern INT64 nBurnProfTime[BURN_PROF_MAX];				// totals since BurnProfReset()
+
+// start (pClock: any monotonic clock, nClockRate: its ticks per second) or stop the profiler
+void BurnProfInit(INT64 (*pClock)(), INT64 nClockRate);
+void BurnProfExit();
+void BurnProfReset();
+
+// copy the newest (up to) nCount frames, oldest first, return how many were copied; any thread
+INT32 BurnProfGetFrames(struct BurnProfFrame* pFrames, INT32 nCount);
+
+// record the newest nMaxEvents scopes, then write them to szFilename as a Chrome trace (0 on success)
+INT32 BurnProfTraceStart(INT32 nMaxEvents);
+INT32 BurnProfTraceStop(const char* szFilename);
+
+void BurnProfBegin(INT32 nId);
+void BurnProfEnd();
+void BurnProfFrameBegin();
+void BurnProfFrameEnd();
+
+#ifdef BURN_PROF
+struct BurnProfScope {
+	bool bOn;
+	BurnProfScope(INT32 nId) : bOn(BurnProfClock != NULL) { if (bOn) BurnProfBegin(nId); }
+	~BurnProfScope() { if (bOn) BurnProfEnd(); }
+};
+#define BURN_PROF_SCOPE(id)			BurnProfScope BurnProfScopeVar(id)
+#else
+#define BURN_PROF_SCOPE(id)
+#endif
@@ -0,0 +1,228 @@
+// Band-limited resampling and mixing of the sound chips
+
+#include "burnint.h"
+#include "burn_resample.h"
+#include "burn_sound.h"
+#include <math.h>
+
+#define RESAMPLE_BLOCK		256
+
+static const INT32 nResampleTaps[3] = { 8, 16, 32 };
+
+// way past the 16 bits output, only keeps the 24.8 samples from wrapping
+static inline INT32 ResampleClip32(INT64 nSample)
+{
+	return nSample < -0x7fffff00LL ? -0x7fffff00 : nSample > 0x7fffff00LL ? 0x7fffff00 : (INT32)nSample;
+}
+
+// windowed (blackman) sinc, a set of nTaps coefficients for each fraction of
+// an input sample, low-passed below the lowest of the two nyquist frequencies
+static void ResampleMakeFilter(struct BurnResampler* pRes, INT32 nInRate, INT32 nOutRate)
+{
+	const double PI = 3.14159265358979323846;
+	INT32 nTaps = pRes->nTaps;
+	double dCutoff = 0.46 * (nOutRate < nInRate ? (double)nOutRate / nInRate : 1.0);
+
+	for (INT32 p = 0; p < BURN_RESAMPLE_PHASES; p++) {
+		INT16* pCoefs = pRes->pCoefs + p * nTaps;
+		double dCoefs[64];
+		double dSum = 0.0;
+
+		for (INT32 k = 0; k < nTaps; k++) {
+			double t = k - (nTaps / 2 - 1) - (double)p / BURN_RESAMPLE_PHASES;
+			double x = 2.0 * dCutoff * t;
+			double dSinc = (x == 0.0) ? 1.0 : sin(PI * x) / (PI * x);
+			double dWindow = 0.42 + 0.5 * cos(2.0 * PI * t / nTaps) + 0.08 * cos(4.0 * PI * t / nTaps);
+
+			dCoefs[k] = dSinc * dWindow;
+			dSum += dCoefs[k];
+		}
+
+		// unity gain for every phase, the rounding error goes to the center tap
+		INT32 nSum = 0;
+		for (INT32 k = 0; k < nTaps; k++) {
+			pCoefs[k] = (INT16)floor(dCoefs[k] * 16384.0 / dSum + 0.5);
+			nSum += pCoefs[k];
+		}
+		pCoefs[nTaps / 2 - 1] += 16384 - nSum;
+	}
+}
+
+INT32 BurnResampleInit(struct BurnResampler* pRes, INT32 nInRate, INT32 nOutRate)
+{
+	memset(pRes, 0, sizeof(struct BurnResampler));
+
+	if (nInRate <= 0 || nOutRate <= 0) {
+		return 1;
+	}
+
+	INT32 nQuality = nResampleQuality;
+	if (nQuality < 0) nQuality = 0;
+	if (nQuality > 2) nQuality = 2;
+
+	pRes->nTaps = nResampleTaps[nQuality];
+	pRes->pCoefs = (INT16*)malloc(BURN_RESAMPLE_PHASES * pRes->nTaps * sizeof(INT16));
+	pRes->nInputMax = 4096;
+	pRes->pInput = (INT32*)malloc(pRes->nInputMax * 2 * sizeof(INT32));
+
+	if (pRes->pCoefs == NULL || pRes->pInput == NULL) {
+		BurnResampleExit(pRes);
+		return 1;
+	}
+
+	ResampleMakeFilter(pRes, nInRate, nOutRate);
+
+	pRes->nStep = ((UINT64)nInRate << 32) / nOutRate;
+
+	BurnResampleReset(pRes);
+
+	return 0;
+}
+
+void BurnResampleExit(struct BurnResampler* pRes)
+{
+	if (pRes->pCoefs) {
+		free(pRes->pCoefs);
+	}
+	if (pRes->pInput) {
+		free(pRes->pInput);
+	}
+
+	memset(pRes, 0, sizeof(struct BurnResampler));
+}
+
+void BurnResampleReset(struct BurnResampler* pRes)
+{
+	if (pRes->pInput == NULL) {
+		return;
+	}
+
+	// silent history for the first output samples
+	pRes->nInput = pRes->nTaps / 2 - 1;
+	pRes->nPos = (UINT64)pRes->nInput << 32;
+	memset(pRes->pInput, 0, pRes->nInput * 2 * sizeof(INT32));
+}
+
+INT32 BurnResampleNeeded(struct BurnResampler* pRes, INT32 nLen)
+{
+	if (nLen <= 0 || pRes->pInput == NULL) {
+		return 0;
+	}
+
+	INT32 nLast = (INT32)((pRes->nPos + pRes->nStep * (nLen - 1)) >> 32);
+	INT32 nNeeded = nLast + pRes->nTaps / 2 + 1 - pRes->nInput;
+
+	return nNeeded > 0 ? nNeeded : 0;
+}
+
+INT32* BurnResampleInput(struct BurnResampler* pRes, INT32 nLen)
+{
+	if (nLen < 0 || pRes->pInput == NULL) {
+		nLen = 0;
+	}
+
+	if (pRes->nInput + nLen > pRes->nInputMax) {
+		INT32 nMax = (pRes->nInput + nLen) * 2;
+		INT32* pInput = (INT32*)realloc(pRes->pInput, nMax * 2 * sizeof(INT32));
+		if (pInput == NULL) {
+			return NULL;
+		}
+		pRes->pInput = pInput;
+		pRes->nInputMax = nMax;
+	}
+
+	INT32* pDest = pRes->pInput + pRes->nInput * 2;
+	memset(pDest, 0, nLen * 2 * sizeof(INT32));
+	pRes->nInput += nLen;
+
+	return pDest;
+}
+
+void BurnResampleRender(struct BurnResampler* pRes, INT16* pSoundBuf, INT32 nLen, INT32 bAdd)
+{
+	if (pRes->pInput == NULL) {
+		return;
+	}
+
+	// never read past the input, the chip may not have been able to render all of it
+	INT32 nAvailable = 0;
+	INT32 nLast = pRes->nInput - pRes->nTaps / 2 - 1;
+	if (nLast >= 0 && (pRes->nPos >> 32) <= (UINT64)nLast) {
+		UINT64 nAvailableMax = ((((UINT64)nLast << 32) | 0xFFFFFFFF) - pRes->nPos) / pRes->nStep + 1;
+		nAvailable = nAvailableMax < (UINT64)nLen ? (INT32)nAvailableMax : nLen;
+	}
+
+	INT32 nTaps = pRes->nTaps;
+	UINT64 nPos = pRes->nPos;
+
+	// filter a block to 24.8 fixed point, then clamp it to the sound buffer with the simd copy
+	INT32 nBlock[RESAMPLE_BLOCK * 2];
+
+	for (INT32 nDone = 0; nDone < nAvailable; ) {
+		INT32 nBlockLen = nAvailable - nDone < RESAMPLE_BLOCK ? nAvailable - nDone : RESAMPLE_BLOCK;
+
+		for (INT32 i = 0; i < nBlockLen; i++, nPos += pRes->nStep) {
+			const INT32* pSrc = pRes->pInput + (((INT32)(nPos >> 32) - (nTaps / 2 - 1)) << 1);
+			const INT16* pCoefs = pRes->pCoefs + ((INT32)(nPos >> 22) & (BURN_RESAMPLE_PHASES - 1)) * nTaps;
+			INT64 nLeft = 0, nRight = 0;
+
+			for (INT32 k = 0; k < nTaps; k++) {
+				nLeft  += (INT64)pSrc[(k << 1) + 0] * pCoefs[k];
+				nRight += (INT64)pSrc[(k << 1) + 1] * pCoefs[k];
+			}
+
+			nBlock[(i << 1) + 0] = ResampleClip32(nLeft >> 6);
+			nBlock[(i << 1) + 1] = ResampleClip32(nRight >> 6);
+		}
+
+		if (bAdd) {
+			BurnSoundCopyClamp_Add(nBlock, pSoundBuf + (nDone << 1), nBlockLen);
+		} else {
+			BurnSoundCopyClamp(nBlock, pSoundBuf + (nDone << 1), nBlockLen);
+		}
+		nDone += nBlockLen;
+	}
+
+	for (INT32 i = nAvailable; i < nLen && !bAdd; i++) {
+		pSoundBuf[(i << 1) + 0] = 0;
+		pSoundBuf[(i << 1) + 1] = 0;
+	}
+
+	// drop the input nothing will read again
+	INT32 nDrop = (INT32)(nPos >> 32) - (nTaps / 2 - 1);
+	if (nDrop > 0) {
+		pRes->nInput -= nDrop;
+		memmove(pRes->pInput, pRes->pInput + nDrop * 2, pRes->nInput * 2 * sizeof(INT32));
+		nPos -= (UINT64)nDrop << 32;
+	}
+	pRes->nPos = nPos;
+}
+
+INT32 BurnResamplePending(struct BurnResampler* pRes)
+{
+	INT32 nPending = pRes->nInput - (INT32)(pRes->nPos >> 32);
+
+	return nPending > 0 ? nPending : 0;
+}
+
+void BurnResampleMixPan(INT32* pDest, INT16* pSrc, INT32 nLen, double nLeftVolume, double nRightVolume)
+{
+	INT32 nLeft = (INT32)(nLeftVolume * 4096.0);
+	INT32 nRight = (INT32)(nRightVolume * 4096.0);
+
+	if (pDest == NULL || (nLeft == 0 && nRight == 0)) {
+		return;
+	}
+
+	for (INT32 i = 0; i < nLen; i++) {
+		pDest[(i << 1) + 0] += (pSrc[i] * nLeft) >> 12;
+		pDest[(i << 1) + 1] += (pSrc[i] * nRight) >> 12;
+	}
+}
+
+void BurnResampleMixRoute(INT32* pDest, INT16* pSrc, INT32 nLen, double nVolume, INT32 nRouteDir)
+{
+	BurnResampleMixPan(pDest, pSrc, nLen,
+		(nRouteDir & BURN_SND_ROUTE_LEFT) ? nVolume : 0.0,
+		(nRouteDir & BURN_SND_ROUTE_RIGHT) ? nVolume : 0.0);
+}
@@ -0,0 +1,46 @@
+// Band-limited resampling and mixing of the sound chips
+//
+// A chip renders at its native rate, its outputs are routed (the *SetRoute
+// volumes) into the stereo INT32 input of a resampler, and the resampler
+// converts the mix to nBurnSoundRate with a windowed sinc polyphase filter,
+// clamping it into the sound buffer in the same pass. nResampleQuality sets
+// the filter length (cost per output sample).
+//
+// - the FM wrappers (YM2151, YM2203, YM2413, YM2608, YM2610, YM2612, YM3526,
+//   YM3812, Y8950) use it with nFMInterpolation 3 and up, below that the
+//   chip runs at the output rate as before
+// - the MSM6295, QSound and YMZ280B always step their voices at the chip
+//   rate and go through it
+// The resampler state is not saved, a chip reset clears it.
+
+#define BURN_RESAMPLE_PHASES		1024
+
+struct BurnResampler {
+	INT32 nTaps;
+	INT16* pCoefs;					// BURN_RESAMPLE_PHASES x nTaps, 2.14 fixed point
+	UINT64 nStep;					// input samples per output sample, 32.32 fixed point
+	UINT64 nPos;					// position of the next output sample in pInput, 32.32 fixed point
+	INT32* pInput;					// stereo, interleaved
+	INT32 nInput;					// samples in pInput
+	INT32 nInputMax;
+};
+
+INT32 BurnResampleInit(struct BurnResampler* pRes, INT32 nInRate, INT32 nOutRate);
+void BurnResampleExit(struct BurnResampler* pRes);
+void BurnResampleReset(struct BurnResampler* pRes);
+
+// input samples still to add before nLen samples can be rendered
+INT32 BurnResampleNeeded(struct BurnResampler* pRes, INT32 nLen);
+
+// add nLen (silent) input samples and return them, to mix the chip outputs into
+INT32* BurnResampleInput(struct BurnResampler* pRes, INT32 nLen);
+
+// render nLen stereo samples to pSoundBuf (added to it with bAdd)
+void BurnResampleRender(struct BurnResampler* pRes, INT16* pSoundBuf, INT32 nLen, INT32 bAdd);
+
+// input samples added ahead of the next output sample
+INT32 BurnResamplePending(struct BurnResampler* pRes);
+
+// mix a mono chip output into a stereo input, with a volume per side or a route
+void BurnResampleMixPan(INT32* pDest, INT16* pSrc, INT32 nLen, double nLeftVolume, double nRightVolume);
+void BurnResampleMixRoute(INT32* pDest, INT16* pSrc, INT32 nLen, double nVolume, INT32 nRouteDir);
@@ -0,0 +1,43 @@
+// Interleaved cpu runs
+
+#include "burnint.h"
+#include "burn_sched.h"
+#include "timer.h"
+
+void BurnSchedRun(BurnSchedCpu* pCpus, INT32 nCount, INT32 nSlices, void (*pSlice)(INT32 nSlice))
+{
+#if defined FBA_DEBUG
+	if (nSlices < 1) bprintf(PRINT_ERROR, _T("BurnSchedRun called with %d slices\n"), nSlices);
+#endif
+
+	if (nSlices < 1) {
+		nSlices = 1;
+	}
+
+	for (INT32 i = 0; i < nSlices; i++) {
+		for (INT32 j = 0; j < nCount; j++) {
+			BurnSchedCpu* pCpu = &pCpus[j];
+			INT32 nNext = (INT32)((INT64)pCpu->nCyclesFrame * (i + 1) / nSlices);
+
+			pCpu->open(pCpu->nCpu);
+			if (pCpu->run == NULL) {
+				BurnTimerUpdate(nNext);
+				pCpu->nCyclesDone = nNext;
+			} else if (nNext > pCpu->nCyclesDone) {
+				pCpu->nCyclesDone += pCpu->run(nNext - pCpu->nCyclesDone);
+			}
+			if (pCpu->slice) {
+				pCpu->slice(i);
+			}
+			pCpu->close();
+		}
+
+		if (pSlice) {
+			pSlice(i);
+		}
+	}
+
+	for (INT32 j = 0; j < nCount; j++) {
+		pCpus[j].nCyclesDone -= pCpus[j].nCyclesFrame;
+	}
+}
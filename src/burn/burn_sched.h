@@ -0,0 +1,38 @@
+// Interleaved cpu runs
+//
+// A board with several cpus runs them in turn in slices of the frame, so that
+// they see each other's writes and irqs close to when they happen:
+//
+//	for (INT32 i = 0; i < nInterleave; i++) {
+//		SekOpen(0); nCyclesDone[0] += SekRun(nCyclesTotal[0] * (i + 1) / nInterleave - nCyclesDone[0]); SekClose();
+//		ZetOpen(0); nCyclesDone[1] += ZetRun(nCyclesTotal[1] * (i + 1) / nInterleave - nCyclesDone[1]); ZetClose();
+//	}
+//
+// BurnSchedRun() runs such a loop for a list of cpus in one call, with the
+// same slice lengths. The 68000 and Z80 interfaces only point their core at the
+// cpu's registers on open, so a slice costs little more than the run itself. The
+// exception is the A68K assembler core (EMU_A68K), which works on one fixed
+// register block: SekOpen()/SekClose() still copy its registers in and out.
+//
+// A cpu the sound timers run (BurnTimerAttach*) has no run function, its slice
+// is BurnTimerUpdate() to the slice end; the driver still ends its frame with
+// BurnTimerEndFrame(). Irqs raised at a slice go in the cpu's slice callback.
+
+struct BurnSchedCpu {
+	void (*open)(INT32);
+	void (*close)();
+	INT32 (*run)(INT32);								// NULL for a cpu the timers run
+	INT32 nCpu;											// passed to open()
+	INT32 nCyclesFrame;									// cycles to run in the frame
+	INT32 nCyclesDone;									// run so far, the overrun into the next frame once it returns
+	void (*slice)(INT32 nSlice);						// called after each slice with the cpu still open, NULL for none
+};
+
+#define BURN_SCHED_SEK(n, nCycles)		{ SekOpen, SekClose, SekRun, n, nCycles, 0, NULL }
+#define BURN_SCHED_ZET(n, nCycles)		{ ZetOpen, ZetClose, ZetRun, n, nCycles, 0, NULL }
+#define BURN_SCHED_SEK_TIMER(n, nCycles)	{ SekOpen, SekClose, NULL, n, nCycles, 0, NULL }
+#define BURN_SCHED_ZET_TIMER(n, nCycles)	{ ZetOpen, ZetClose, NULL, n, nCycles, 0, NULL }
+
+// run the frame in nSlices slices, the cpus in pCpus order in each; pSlice (NULL for none) is called
+// after each slice with no cpu open
+void BurnSchedRun(BurnSchedCpu* pCpus, INT32 nCount, INT32 nSlices, void (*pSlice)(INT32 nSlice));
@@ -21,3 +21,83 @@ INT32 cmc_4p_Precalc()
 
 	return 0;
 }
+
+const char* szBurnSoundKernelName[BURN_SOUND_KERNEL_MAX] = { "c", "sse2", "neon" };
+
+void (*BurnSoundCopyClamp)(INT32* Src, INT16* Dest, INT32 Len) = BurnSoundCopyClamp_C;
+void (*BurnSoundCopyClamp_Add)(INT32* Src, INT16* Dest, INT32 Len) = BurnSoundCopyClamp_Add_C;
+void (*BurnSoundCopyClamp_Mono)(INT32* Src, INT16* Dest, INT32 Len) = BurnSoundCopyClamp_Mono_C;
+void (*BurnSoundCopyClamp_Mono_Add)(INT32* Src, INT16* Dest, INT32 Len) = BurnSoundCopyClamp_Mono_Add_C;
+void (*BurnSoundCopy_FM)(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR) = BurnSoundCopy_FM_C;
+void (*BurnSoundCopy_FM_Add)(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR) = BurnSoundCopy_FM_Add_C;
+void (*BurnSoundCopy_FM_OPN)(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR) = BurnSoundCopy_FM_OPN_C;
+void (*BurnSoundCopy_FM_OPN_Add)(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR) = BurnSoundCopy_FM_OPN_Add_C;
+
+// the simd versions are only built in when the compiler targets a cpu that has them
+// (sse2: x86-64 or -msse2, neon: aarch64 or -mfpu=neon), the whole binary needs it then
+bool BurnSoundKernelAvailable(INT32 nKernel)
+{
+	switch (nKernel) {
+		case BURN_SOUND_KERNEL_C:
+			return true;
+#if defined BURN_SOUND_SSE2
+		case BURN_SOUND_KERNEL_SSE2:
+			return true;
+#endif
+#if defined BURN_SOUND_NEON
+		case BURN_SOUND_KERNEL_NEON:
+			return true;
+#endif
+	}
+
+	return false;
+}
+
+INT32 BurnSoundKernelInit(INT32 nKernel)
+{
+	if (nKernel < 0) {
+		for (nKernel = BURN_SOUND_KERNEL_MAX - 1; nKernel > BURN_SOUND_KERNEL_C; nKernel--) {
+			if (BurnSoundKernelAvailable(nKernel)) break;
+		}
+	}
+	if (!BurnSoundKernelAvailable(nKernel)) {
+		nKernel = BURN_SOUND_KERNEL_C;
+	}
+
+	BurnSoundCopyClamp = BurnSoundCopyClamp_C;
+	BurnSoundCopyClamp_Add = BurnSoundCopyClamp_Add_C;
+	BurnSoundCopyClamp_Mono = BurnSoundCopyClamp_Mono_C;
+	BurnSoundCopyClamp_Mono_Add = BurnSoundCopyClamp_Mono_Add_C;
+	BurnSoundCopy_FM = BurnSoundCopy_FM_C;
+	BurnSoundCopy_FM_Add = BurnSoundCopy_FM_Add_C;
+	BurnSoundCopy_FM_OPN = BurnSoundCopy_FM_OPN_C;
+	BurnSoundCopy_FM_OPN_Add = BurnSoundCopy_FM_OPN_Add_C;
+
+#if defined BURN_SOUND_SSE2
+	if (nKernel == BURN_SOUND_KERNEL_SSE2) {
+		BurnSoundCopyClamp = BurnSoundCopyClamp_SSE2;
+		BurnSoundCopyClamp_Add = BurnSoundCopyClamp_Add_SSE2;
+		BurnSoundCopyClamp_Mono = BurnSoundCopyClamp_Mono_SSE2;
+		BurnSoundCopyClamp_Mono_Add = BurnSoundCopyClamp_Mono_Add_SSE2;
+		BurnSoundCopy_FM = BurnSoundCopy_FM_SSE2;
+		BurnSoundCopy_FM_Add = BurnSoundCopy_FM_Add_SSE2;
+		BurnSoundCopy_FM_OPN = BurnSoundCopy_FM_OPN_SSE2;
+		BurnSoundCopy_FM_OPN_Add = BurnSoundCopy_FM_OPN_Add_SSE2;
+	}
+#endif
+
+#if defined BURN_SOUND_NEON
+	if (nKernel == BURN_SOUND_KERNEL_NEON) {
+		BurnSoundCopyClamp = BurnSoundCopyClamp_NEON;
+		BurnSoundCopyClamp_Add = BurnSoundCopyClamp_Add_NEON;
+		BurnSoundCopyClamp_Mono = BurnSoundCopyClamp_Mono_NEON;
+		BurnSoundCopyClamp_Mono_Add = BurnSoundCopyClamp_Mono_Add_NEON;
+		BurnSoundCopy_FM = BurnSoundCopy_FM_NEON;
+		BurnSoundCopy_FM_Add = BurnSoundCopy_FM_Add_NEON;
+		BurnSoundCopy_FM_OPN = BurnSoundCopy_FM_OPN_NEON;
+		BurnSoundCopy_FM_OPN_Add = BurnSoundCopy_FM_OPN_Add_NEON;
+	}
+#endif
+
+	return nKernel;
+}
@@ -30,6 +30,52 @@ void BurnSoundCopyClamp_C(INT32* Src, INT16* Dest, INT32 Len);
 void BurnSoundCopyClamp_Add_C(INT32* Src, INT16* Dest, INT32 Len);
 void BurnSoundCopyClamp_Mono_C(INT32* Src, INT16* Dest, INT32 Len);
 void BurnSoundCopyClamp_Mono_Add_C(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopy_FM_C(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+void BurnSoundCopy_FM_Add_C(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+void BurnSoundCopy_FM_OPN_C(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+void BurnSoundCopy_FM_OPN_Add_C(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+ #define BURN_SOUND_SSE2
+void BurnSoundCopyClamp_SSE2(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopyClamp_Add_SSE2(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopyClamp_Mono_SSE2(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopyClamp_Mono_Add_SSE2(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopy_FM_SSE2(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+void BurnSoundCopy_FM_Add_SSE2(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+void BurnSoundCopy_FM_OPN_SSE2(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+void BurnSoundCopy_FM_OPN_Add_SSE2(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+#endif
+
+#if defined __ARM_NEON || defined __ARM_NEON__ || defined __aarch64__
+ #define BURN_SOUND_NEON
+void BurnSoundCopyClamp_NEON(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopyClamp_Add_NEON(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopyClamp_Mono_NEON(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopyClamp_Mono_Add_NEON(INT32* Src, INT16* Dest, INT32 Len);
+void BurnSoundCopy_FM_NEON(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+void BurnSoundCopy_FM_Add_NEON(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+void BurnSoundCopy_FM_OPN_NEON(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+void BurnSoundCopy_FM_OPN_Add_NEON(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+#endif
+
+// The fastest versions the cpu runs, picked by BurnSoundKernelInit() (BurnLibInit)
+enum BurnSoundKernel { BURN_SOUND_KERNEL_C = 0, BURN_SOUND_KERNEL_SSE2, BURN_SOUND_KERNEL_NEON, BURN_SOUND_KERNEL_MAX };
+
+extern const char* szBurnSoundKernelName[BURN_SOUND_KERNEL_MAX];
+
+extern void (*BurnSoundCopyClamp)(INT32* Src, INT16* Dest, INT32 Len);
+extern void (*BurnSoundCopyClamp_Add)(INT32* Src, INT16* Dest, INT32 Len);
+extern void (*BurnSoundCopyClamp_Mono)(INT32* Src, INT16* Dest, INT32 Len);
+extern void (*BurnSoundCopyClamp_Mono_Add)(INT32* Src, INT16* Dest, INT32 Len);
+extern void (*BurnSoundCopy_FM)(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+extern void (*BurnSoundCopy_FM_Add)(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR);
+extern void (*BurnSoundCopy_FM_OPN)(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+extern void (*BurnSoundCopy_FM_OPN_Add)(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR);
+
+bool BurnSoundKernelAvailable(INT32 nKernel);
+// nKernel -1 picks the fastest one, returns the kernel set in use
+INT32 BurnSoundKernelInit(INT32 nKernel);
 
 extern INT32 cmc_4p_Precalc();
 
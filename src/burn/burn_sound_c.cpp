@@ -43,4 +43,67 @@ void BurnSoundCopyClamp_Mono_Add_C(INT32 *Src, INT16 *Dest, INT32 Len)
 	}
 }
 
+// the FM copies match the MMX versions: volumes are saturated to 16 bits, and
+// the samples are multiplied by them keeping the high 16 bits of the product
+
+void BurnSoundCopy_FM_C(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR)
+{
+	VolL = CLIP(VolL);
+	VolR = CLIP(VolR);
+
+	while (Len--) {
+		Dest[0] = (*SrcL * VolL) >> 16;
+		Dest[1] = (*SrcR * VolR) >> 16;
+		SrcL++;
+		SrcR++;
+		Dest += 2;
+	}
+}
+
+void BurnSoundCopy_FM_Add_C(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR)
+{
+	VolL = CLIP(VolL);
+	VolR = CLIP(VolR);
+
+	while (Len--) {
+		Dest[0] = CLIP(((*SrcL * VolL) >> 16) + Dest[0]);
+		Dest[1] = CLIP(((*SrcR * VolR) >> 16) + Dest[1]);
+		SrcL++;
+		SrcR++;
+		Dest += 2;
+	}
+}
+
+void BurnSoundCopy_FM_OPN_C(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR)
+{
+	VolPSGL = CLIP(VolPSGL);
+	VolPSGR = CLIP(VolPSGR);
+
+	while (Len--) {
+		INT32 nPSG = CLIP(*SrcPSG);
+		Dest[0] = CLIP(((nPSG * VolPSGL) >> 16) + SrcOPN[0]);
+		Dest[1] = CLIP(((nPSG * VolPSGR) >> 16) + SrcOPN[4096]);
+		SrcOPN++;
+		SrcPSG++;
+		Dest += 2;
+	}
+}
+
+void BurnSoundCopy_FM_OPN_Add_C(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR)
+{
+	VolPSGL = CLIP(VolPSGL);
+	VolPSGR = CLIP(VolPSGR);
+
+	while (Len--) {
+		INT32 nPSG = CLIP(*SrcPSG);
+		INT32 nLeftSample = CLIP(((nPSG * VolPSGL) >> 16) + SrcOPN[0]);
+		INT32 nRightSample = CLIP(((nPSG * VolPSGR) >> 16) + SrcOPN[4096]);
+		Dest[0] = CLIP(nLeftSample + Dest[0]);
+		Dest[1] = CLIP(nRightSample + Dest[1]);
+		SrcOPN++;
+		SrcPSG++;
+		Dest += 2;
+	}
+}
+
 #undef CLIP
@@ -0,0 +1,280 @@
+// SSE2 and NEON versions of the BurnSoundCopy* functions, bit-exact with the C ones
+// (burn_sound_c.cpp), see BurnSoundKernelInit() in burn_sound.cpp for the selection
+
+#include "burnint.h"
+#include "burn_sound.h"
+
+#if defined BURN_SOUND_SSE2
+#include <emmintrin.h>
+
+#define CLIP(A) ((A) < -0x8000 ? -0x8000 : (A) > 0x7fff ? 0x7fff : (A))
+
+// 8 INT16 of Dest as two vectors of 4 INT32
+#define SSE2_WIDEN_LO(v)	_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)
+#define SSE2_WIDEN_HI(v)	_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)
+
+void BurnSoundCopyClamp_SSE2(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	Len *= 2;
+	for (; Len >= 8; Len -= 8, Src += 8, Dest += 8) {
+		__m128i a = _mm_srai_epi32(_mm_loadu_si128((__m128i*)(Src + 0)), 8);
+		__m128i b = _mm_srai_epi32(_mm_loadu_si128((__m128i*)(Src + 4)), 8);
+		_mm_storeu_si128((__m128i*)Dest, _mm_packs_epi32(a, b));
+	}
+	while (Len--) {
+		*Dest++ = CLIP((*Src >> 8));
+		Src++;
+	}
+}
+
+void BurnSoundCopyClamp_Add_SSE2(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	Len *= 2;
+	for (; Len >= 8; Len -= 8, Src += 8, Dest += 8) {
+		__m128i d = _mm_loadu_si128((__m128i*)Dest);
+		__m128i a = _mm_srai_epi32(_mm_loadu_si128((__m128i*)(Src + 0)), 8);
+		__m128i b = _mm_srai_epi32(_mm_loadu_si128((__m128i*)(Src + 4)), 8);
+		a = _mm_add_epi32(a, SSE2_WIDEN_LO(d));
+		b = _mm_add_epi32(b, SSE2_WIDEN_HI(d));
+		_mm_storeu_si128((__m128i*)Dest, _mm_packs_epi32(a, b));
+	}
+	while (Len--) {
+		*Dest = CLIP((*Src >> 8) + *Dest);
+		Src++;
+		Dest++;
+	}
+}
+
+void BurnSoundCopyClamp_Mono_SSE2(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	for (; Len >= 4; Len -= 4, Src += 4, Dest += 8) {
+		__m128i a = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((__m128i*)Src), 8), _mm_setzero_si128());
+		_mm_storeu_si128((__m128i*)Dest, _mm_unpacklo_epi16(a, a));
+	}
+	while (Len--) {
+		Dest[0] = CLIP((*Src >> 8));
+		Dest[1] = CLIP((*Src >> 8));
+		Src++;
+		Dest += 2;
+	}
+}
+
+void BurnSoundCopyClamp_Mono_Add_SSE2(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	for (; Len >= 4; Len -= 4, Src += 4, Dest += 8) {
+		__m128i d = _mm_loadu_si128((__m128i*)Dest);
+		__m128i s = _mm_srai_epi32(_mm_loadu_si128((__m128i*)Src), 8);
+		__m128i a = _mm_add_epi32(_mm_unpacklo_epi32(s, s), SSE2_WIDEN_LO(d));
+		__m128i b = _mm_add_epi32(_mm_unpackhi_epi32(s, s), SSE2_WIDEN_HI(d));
+		_mm_storeu_si128((__m128i*)Dest, _mm_packs_epi32(a, b));
+	}
+	while (Len--) {
+		Dest[0] = CLIP((*Src >> 8) + Dest[0]);
+		Dest[1] = CLIP((*Src >> 8) + Dest[1]);
+		Src++;
+		Dest += 2;
+	}
+}
+
+// VolL, VolR, VolL, ... as INT16
+static inline __m128i SSE2Volumes(INT32 VolL, INT32 VolR)
+{
+	return _mm_set1_epi32((INT32)(((UINT32)(UINT16)CLIP(VolR) << 16) | (UINT16)CLIP(VolL)));
+}
+
+void BurnSoundCopy_FM_SSE2(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR)
+{
+	__m128i v = SSE2Volumes(VolL, VolR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		__m128i s = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i*)(SrcL + n)), _mm_loadl_epi64((__m128i*)(SrcR + n)));
+		_mm_storeu_si128((__m128i*)(Dest + (n << 1)), _mm_mulhi_epi16(s, v));
+	}
+	BurnSoundCopy_FM_C(SrcL + n, SrcR + n, Dest + (n << 1), Len - n, VolL, VolR);
+}
+
+void BurnSoundCopy_FM_Add_SSE2(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR)
+{
+	__m128i v = SSE2Volumes(VolL, VolR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		__m128i s = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i*)(SrcL + n)), _mm_loadl_epi64((__m128i*)(SrcR + n)));
+		__m128i d = _mm_loadu_si128((__m128i*)(Dest + (n << 1)));
+		_mm_storeu_si128((__m128i*)(Dest + (n << 1)), _mm_adds_epi16(_mm_mulhi_epi16(s, v), d));
+	}
+	BurnSoundCopy_FM_Add_C(SrcL + n, SrcR + n, Dest + (n << 1), Len - n, VolL, VolR);
+}
+
+void BurnSoundCopy_FM_OPN_SSE2(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR)
+{
+	__m128i v = SSE2Volumes(VolPSGL, VolPSGR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		__m128i p = _mm_packs_epi32(_mm_loadu_si128((__m128i*)(SrcPSG + n)), _mm_setzero_si128());
+		__m128i o = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i*)(SrcOPN + n)), _mm_loadl_epi64((__m128i*)(SrcOPN + 4096 + n)));
+		p = _mm_mulhi_epi16(_mm_unpacklo_epi16(p, p), v);
+		_mm_storeu_si128((__m128i*)(Dest + (n << 1)), _mm_adds_epi16(p, o));
+	}
+	BurnSoundCopy_FM_OPN_C(SrcOPN + n, SrcPSG + n, Dest + (n << 1), Len - n, VolPSGL, VolPSGR);
+}
+
+void BurnSoundCopy_FM_OPN_Add_SSE2(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR)
+{
+	__m128i v = SSE2Volumes(VolPSGL, VolPSGR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		__m128i p = _mm_packs_epi32(_mm_loadu_si128((__m128i*)(SrcPSG + n)), _mm_setzero_si128());
+		__m128i o = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i*)(SrcOPN + n)), _mm_loadl_epi64((__m128i*)(SrcOPN + 4096 + n)));
+		__m128i d = _mm_loadu_si128((__m128i*)(Dest + (n << 1)));
+		p = _mm_mulhi_epi16(_mm_unpacklo_epi16(p, p), v);
+		_mm_storeu_si128((__m128i*)(Dest + (n << 1)), _mm_adds_epi16(_mm_adds_epi16(p, o), d));
+	}
+	BurnSoundCopy_FM_OPN_Add_C(SrcOPN + n, SrcPSG + n, Dest + (n << 1), Len - n, VolPSGL, VolPSGR);
+}
+
+#undef SSE2_WIDEN_LO
+#undef SSE2_WIDEN_HI
+#undef CLIP
+
+#endif
+
+#if defined BURN_SOUND_NEON
+#include <arm_neon.h>
+
+#define CLIP(A) ((A) < -0x8000 ? -0x8000 : (A) > 0x7fff ? 0x7fff : (A))
+
+void BurnSoundCopyClamp_NEON(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	Len *= 2;
+	for (; Len >= 8; Len -= 8, Src += 8, Dest += 8) {
+		int16x4_t a = vqshrn_n_s32(vld1q_s32(Src + 0), 8);
+		int16x4_t b = vqshrn_n_s32(vld1q_s32(Src + 4), 8);
+		vst1q_s16(Dest, vcombine_s16(a, b));
+	}
+	while (Len--) {
+		*Dest++ = CLIP((*Src >> 8));
+		Src++;
+	}
+}
+
+void BurnSoundCopyClamp_Add_NEON(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	Len *= 2;
+	for (; Len >= 8; Len -= 8, Src += 8, Dest += 8) {
+		int16x8_t d = vld1q_s16(Dest);
+		int32x4_t a = vaddq_s32(vshrq_n_s32(vld1q_s32(Src + 0), 8), vmovl_s16(vget_low_s16(d)));
+		int32x4_t b = vaddq_s32(vshrq_n_s32(vld1q_s32(Src + 4), 8), vmovl_s16(vget_high_s16(d)));
+		vst1q_s16(Dest, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+	}
+	while (Len--) {
+		*Dest = CLIP((*Src >> 8) + *Dest);
+		Src++;
+		Dest++;
+	}
+}
+
+void BurnSoundCopyClamp_Mono_NEON(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	for (; Len >= 4; Len -= 4, Src += 4, Dest += 8) {
+		int16x4_t a = vqshrn_n_s32(vld1q_s32(Src), 8);
+		int16x4x2_t z = vzip_s16(a, a);
+		vst1q_s16(Dest, vcombine_s16(z.val[0], z.val[1]));
+	}
+	while (Len--) {
+		Dest[0] = CLIP((*Src >> 8));
+		Dest[1] = CLIP((*Src >> 8));
+		Src++;
+		Dest += 2;
+	}
+}
+
+void BurnSoundCopyClamp_Mono_Add_NEON(INT32 *Src, INT16 *Dest, INT32 Len)
+{
+	for (; Len >= 4; Len -= 4, Src += 4, Dest += 8) {
+		int16x8_t d = vld1q_s16(Dest);
+		int32x4_t s = vshrq_n_s32(vld1q_s32(Src), 8);
+		int32x4x2_t z = vzipq_s32(s, s);
+		int32x4_t a = vaddq_s32(z.val[0], vmovl_s16(vget_low_s16(d)));
+		int32x4_t b = vaddq_s32(z.val[1], vmovl_s16(vget_high_s16(d)));
+		vst1q_s16(Dest, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+	}
+	while (Len--) {
+		Dest[0] = CLIP((*Src >> 8) + Dest[0]);
+		Dest[1] = CLIP((*Src >> 8) + Dest[1]);
+		Src++;
+		Dest += 2;
+	}
+}
+
+// VolL, VolR, VolL, VolR as INT16
+static inline int16x4_t NEONVolumes(INT32 VolL, INT32 VolR)
+{
+	INT16 v[4] = { (INT16)CLIP(VolL), (INT16)CLIP(VolR), (INT16)CLIP(VolL), (INT16)CLIP(VolR) };
+
+	return vld1_s16(v);
+}
+
+// (s * v) >> 16 on 8 INT16, like pmulhw (vqdmulh doubles and would round differently)
+static inline int16x8_t NEONMulHi(int16x4x2_t s, int16x4_t v)
+{
+	return vcombine_s16(vshrn_n_s32(vmull_s16(s.val[0], v), 16), vshrn_n_s32(vmull_s16(s.val[1], v), 16));
+}
+
+void BurnSoundCopy_FM_NEON(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR)
+{
+	int16x4_t v = NEONVolumes(VolL, VolR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		vst1q_s16(Dest + (n << 1), NEONMulHi(vzip_s16(vld1_s16(SrcL + n), vld1_s16(SrcR + n)), v));
+	}
+	BurnSoundCopy_FM_C(SrcL + n, SrcR + n, Dest + (n << 1), Len - n, VolL, VolR);
+}
+
+void BurnSoundCopy_FM_Add_NEON(INT16* SrcL, INT16* SrcR, INT16* Dest, INT32 Len, INT32 VolL, INT32 VolR)
+{
+	int16x4_t v = NEONVolumes(VolL, VolR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		int16x8_t s = NEONMulHi(vzip_s16(vld1_s16(SrcL + n), vld1_s16(SrcR + n)), v);
+		vst1q_s16(Dest + (n << 1), vqaddq_s16(s, vld1q_s16(Dest + (n << 1))));
+	}
+	BurnSoundCopy_FM_Add_C(SrcL + n, SrcR + n, Dest + (n << 1), Len - n, VolL, VolR);
+}
+
+void BurnSoundCopy_FM_OPN_NEON(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR)
+{
+	int16x4_t v = NEONVolumes(VolPSGL, VolPSGR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		int16x4_t p = vqmovn_s32(vld1q_s32(SrcPSG + n));
+		int16x4x2_t o = vzip_s16(vld1_s16(SrcOPN + n), vld1_s16(SrcOPN + 4096 + n));
+		int16x8_t s = NEONMulHi(vzip_s16(p, p), v);
+		vst1q_s16(Dest + (n << 1), vqaddq_s16(s, vcombine_s16(o.val[0], o.val[1])));
+	}
+	BurnSoundCopy_FM_OPN_C(SrcOPN + n, SrcPSG + n, Dest + (n << 1), Len - n, VolPSGL, VolPSGR);
+}
+
+void BurnSoundCopy_FM_OPN_Add_NEON(INT16* SrcOPN, INT32* SrcPSG, INT16* Dest, INT32 Len, INT32 VolPSGL, INT32 VolPSGR)
+{
+	int16x4_t v = NEONVolumes(VolPSGL, VolPSGR);
+	INT32 n = 0;
+
+	for (; n + 4 <= Len; n += 4) {
+		int16x4_t p = vqmovn_s32(vld1q_s32(SrcPSG + n));
+		int16x4x2_t o = vzip_s16(vld1_s16(SrcOPN + n), vld1_s16(SrcOPN + 4096 + n));
+		int16x8_t s = vqaddq_s16(NEONMulHi(vzip_s16(p, p), v), vcombine_s16(o.val[0], o.val[1]));
+		vst1q_s16(Dest + (n << 1), vqaddq_s16(s, vld1q_s16(Dest + (n << 1))));
+	}
+	BurnSoundCopy_FM_OPN_Add_C(SrcOPN + n, SrcPSG + n, Dest + (n << 1), Len - n, VolPSGL, VolPSGR);
+}
+
+#undef CLIP
+
+#endif
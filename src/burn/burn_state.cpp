@@ -0,0 +1,178 @@
+// Memory savestates
+//
+// The state is sized once with a length-only BurnAreaScan, after that every
+// save/load is a single scan memcpy'ing each area to/from a buffer owned by
+// the caller: no file i/o and no allocation per call. This is what rewind,
+// run-ahead and the quick save slots are built on.
+
+#include "burnint.h"
+#include "burn_state.h"
+#include <time.h>
+
+static INT32 nStateMemSize = -1;						// full state size, -1 until probed
+
+static UINT8* pStateMemPos = NULL;
+static UINT8* pStateMemEnd = NULL;
+static INT32 nStateMemLen = 0;							// bytes scanned, including the ones that didn't fit
+
+static INT32 __cdecl StateMemLenAcb(struct BurnArea* pba)
+{
+	nStateMemLen += pba->nLen;
+
+	return 0;
+}
+
+// driver -> buffer
+static INT32 __cdecl StateMemSaveAcb(struct BurnArea* pba)
+{
+	nStateMemLen += pba->nLen;
+
+	if (pba->nLen > (UINT32)(pStateMemEnd - pStateMemPos)) {
+		pStateMemEnd = pStateMemPos;					// out of space, keep counting only
+		return 1;
+	}
+	memcpy(pStateMemPos, pba->Data, pba->nLen);
+	pStateMemPos += pba->nLen;
+
+	return 0;
+}
+
+// buffer -> driver
+static INT32 __cdecl StateMemLoadAcb(struct BurnArea* pba)
+{
+	nStateMemLen += pba->nLen;
+
+	if (pba->nLen > (UINT32)(pStateMemEnd - pStateMemPos)) {
+		pStateMemEnd = pStateMemPos;
+		return 1;
+	}
+	memcpy(pba->Data, pStateMemPos, pba->nLen);
+	pStateMemPos += pba->nLen;
+
+	return 0;
+}
+
+INT32 BurnStateMemScan(UINT8* pBuffer, INT32 nSize, INT32 nAction)
+{
+	if (nBurnDrvActive >= nBurnDrvCount) {
+		return 0;
+	}
+
+	pStateMemPos = pBuffer;
+	pStateMemEnd = pBuffer + (pBuffer ? nSize : 0);
+	nStateMemLen = 0;
+	BurnAcb = (nAction & ACB_WRITE) ? StateMemLoadAcb : StateMemSaveAcb;
+
+	BurnAreaScan(nAction, NULL);
+
+	return nStateMemLen;
+}
+
+INT32 BurnStateMemGetSize()
+{
+	if (nStateMemSize < 0) {
+		if (nBurnDrvActive >= nBurnDrvCount) {
+			return 0;
+		}
+
+		INT32 nMin = 0;
+		nStateMemLen = 0;
+		BurnAcb = StateMemLenAcb;
+		BurnAreaScan(ACB_FULLSCAN, &nMin);
+
+		nStateMemSize = sizeof(UINT32) + nStateMemLen;
+	}
+
+	return nStateMemSize;
+}
+
+void BurnStateMemReset()
+{
+	nStateMemSize = -1;
+}
+
+INT32 BurnStateMemSave(UINT8* pDest, INT32 nSize)
+{
+	INT32 nStateSize = BurnStateMemGetSize();
+	if (pDest == NULL || nStateSize <= 0 || nSize < nStateSize) {
+		return 1;
+	}
+
+	memcpy(pDest, &nCurrentFrame, sizeof(UINT32));
+	INT32 nAreaSize = nStateSize - sizeof(UINT32);
+
+	if (BurnStateMemScan(pDest + sizeof(UINT32), nAreaSize, ACB_FULLSCAN | ACB_READ) != nAreaSize) {
+		// the driver doesn't scan a fixed amount of data, probe it again next time
+		nStateMemSize = -1;
+		return 1;
+	}
+
+	return 0;
+}
+
+INT32 BurnStateMemLoad(const UINT8* pSrc, INT32 nSize)
+{
+	INT32 nStateSize = BurnStateMemGetSize();
+	if (pSrc == NULL || nStateSize <= 0 || nSize != nStateSize) {
+		return 1;
+	}
+
+	memcpy(&nCurrentFrame, pSrc, sizeof(UINT32));
+	INT32 nAreaSize = nStateSize - sizeof(UINT32);
+
+	if (BurnStateMemScan((UINT8*)pSrc + sizeof(UINT32), nAreaSize, ACB_FULLSCAN | ACB_WRITE) != nAreaSize) {
+		nStateMemSize = -1;
+		return 1;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// benchmark
+
+INT32 BurnStateMemBench(INT32 nIterations)
+{
+	if (nIterations <= 0) {
+		nIterations = 200;
+	}
+
+	INT32 nSize = BurnStateMemGetSize();
+	if (nSize <= 0) {
+		return 0;
+	}
+
+	UINT8* pState = (UINT8*)malloc(nSize);
+	UINT8* pCheck = (UINT8*)malloc(nSize);
+	if (pState == NULL || pCheck == NULL) {
+		free(pState);
+		free(pCheck);
+		return 0;
+	}
+
+	BurnStateMemSave(pState, nSize);
+
+	clock_t nStart = clock();
+	for (INT32 i = 0; i < nIterations; i++) {
+		BurnStateMemSave(pCheck, nSize);
+	}
+	double fSave = (double)(clock() - nStart) * 1000000.0 / CLOCKS_PER_SEC / nIterations;
+
+	// loading the state we just saved leaves the driver as it was
+	nStart = clock();
+	for (INT32 i = 0; i < nIterations; i++) {
+		BurnStateMemLoad(pState, nSize);
+	}
+	double fLoad = (double)(clock() - nStart) * 1000000.0 / CLOCKS_PER_SEC / nIterations;
+
+	BurnStateMemSave(pCheck, nSize);
+	INT32 nMismatch = memcmp(pState, pCheck, nSize) ? 1 : 0;
+
+	bprintf(PRINT_NORMAL, _T("BurnState: %-9s %-12s %8i bytes: save %8.1f us, load %8.1f us%s\n"),
+			BurnDrvGetHardwareName(), BurnDrvGetTextA(DRV_NAME), nSize, fSave, fLoad, nMismatch ? " (MISMATCH)" : "");
+
+	free(pState);
+	free(pCheck);
+
+	return nMismatch;
+}
@@ -0,0 +1,18 @@
+// Memory savestates (BurnAreaScan <-> contiguous buffer)
+
+// size of a full (ACB_FULLSCAN) memory state, probed once per driver init
+INT32 BurnStateMemGetSize();
+void BurnStateMemReset();								// forget the probed size (called by BurnStateExit)
+
+// save/load a full state (frame counter + every area) to/from a caller owned buffer
+// of BurnStateMemGetSize() bytes, return 0 on success
+INT32 BurnStateMemSave(UINT8* pDest, INT32 nSize);
+INT32 BurnStateMemLoad(const UINT8* pSrc, INT32 nSize);
+
+// raw scan of the areas selected by nAction (ACB_READ: driver -> buffer, ACB_WRITE: buffer -> driver),
+// areas that don't fit are skipped, returns the total length scanned
+INT32 BurnStateMemScan(UINT8* pBuffer, INT32 nSize, INT32 nAction);
+
+// time save/load of the running driver state and print us per call along with its hardware family,
+// returns 1 if a load followed by a save didn't give the same state back
+INT32 BurnStateMemBench(INT32 nIterations);
@@ -18,6 +18,7 @@
 #endif
 
 #include "burn.h"
+#include "burn_machine.h"
 
 #ifdef LSB_FIRST
 typedef union
@@ -143,6 +144,10 @@ struct cpu_core_config {
 
 	UINT64 nMemorySize;		// how large is our memory range?
 	UINT32 nAddressXor;		// fix endianness for some cpus
+
+	UINT8 *(*page)(UINT32);		// directly mapped page holding an address, NULL if handled (optional)
+	UINT32 nPageSize;		// size of the pages returned by page()
+	UINT32 nPageXor;		// byte order in the pages: address ^ nPageXor is the offset
 };
 
 void CpuCheatRegister(INT32 type, cpu_core_config *config);
@@ -166,12 +171,12 @@ void BurnExitMemoryManager();
 // ---------------------------------------------------------------------------
 // Debug Tracker
 
-extern UINT8 Debug_BurnTransferInitted;
+extern BURN_THREAD UINT8 Debug_BurnTransferInitted;
 extern UINT8 Debug_BurnGunInitted;
 extern UINT8 Debug_BurnLedInitted;
 extern UINT8 Debug_BurnShiftInitted;
 extern UINT8 Debug_HiscoreInitted;
-extern UINT8 Debug_GenericTilesInitted;
+extern BURN_THREAD UINT8 Debug_GenericTilesInitted;
 
 extern UINT8 DebugDev_8255PPIInitted;
 extern UINT8 DebugDev_8257DMAInitted;
@@ -234,11 +239,11 @@ extern UINT8 DebugCPU_M6800Initted;
 extern UINT8 DebugCPU_M6805Initted;
 extern UINT8 DebugCPU_M6809Initted;
 extern UINT8 DebugCPU_S2650Initted;
-extern UINT8 DebugCPU_SekInitted;
+extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 extern UINT8 DebugCPU_VezInitted;
-extern UINT8 DebugCPU_ZetInitted;
+extern BURN_THREAD UINT8 DebugCPU_ZetInitted;
 extern UINT8 DebugCPU_PIC16C5XInitted;
 extern UINT8 DebugCPU_I8039Initted;
-extern UINT8 DebugCPU_SH2Initted;
+extern BURN_THREAD UINT8 DebugCPU_SH2Initted;
 
 void DebugTrackerExit();
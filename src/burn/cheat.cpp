@@ -322,13 +322,30 @@ void CheatExit()
 
 // Cheat search
 
+// The search takes a snapshot of the whole address range, pages the cpu maps
+// directly are copied in one go, only the handled ones are read byte per byte.
+// The snapshot keeps the byte order of the pages (address ^ nSearchXor), the
+// addresses still in the results are a bitmap indexed the same way.
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHEAT_SEARCH_SSE2
+#endif
+
 static UINT8 *MemoryValues = NULL;
-static UINT8 *MemoryStatus = NULL;
+static UINT32 *MemoryStatus = NULL;
 static UINT32 nMemorySize = 0;
+static UINT32 nSearchXor = 0;
 CheatSearchInitCallback CheatSearchInitCallbackFunction = NULL;
 
-#define NOT_IN_RESULTS	0
-#define IN_RESULTS	1
+#define SEARCH_PAGE_SIZE	0x1000		// used when the cpu doesn't give its pages
+
+#define SEARCH_NOCHANGE		0
+#define SEARCH_CHANGE		1
+#define SEARCH_DECREASED	2
+#define SEARCH_INCREASED	3
+
+#define IN_RESULTS(a)		(MemoryStatus[(a) >> 5] & (1U << ((a) & 31)))
 
 UINT32 CheatSearchShowResultAddresses[CHEATSEARCH_SHOWRESULTS];
 UINT32 CheatSearchShowResultValues[CHEATSEARCH_SHOWRESULTS];
@@ -350,15 +367,99 @@ void CheatSearchExit()
 	}
 	
 	nMemorySize = 0;
+	nSearchXor = 0;
 	
 	memset(CheatSearchShowResultAddresses, 0, CHEATSEARCH_SHOWRESULTS);
 	memset(CheatSearchShowResultValues, 0, CHEATSEARCH_SHOWRESULTS);
 }
 
+static UINT32 CheatSearchPageSize()
+{
+	if (cheat_subptr->page && cheat_subptr->nPageSize) {
+		return cheat_subptr->nPageSize < nMemorySize ? cheat_subptr->nPageSize : nMemorySize;
+	}
+
+	return SEARCH_PAGE_SIZE < nMemorySize ? SEARCH_PAGE_SIZE : nMemorySize;
+}
+
+static bool CheatSearchPageEmpty(UINT32 nAddress, UINT32 nLen)
+{
+	for (UINT32 i = nAddress >> 5; i < (nAddress + nLen + 31) >> 5; i++) {
+		if (MemoryStatus[i]) return false;
+	}
+
+	return true;
+}
+
+// the current values of a page, in snapshot order: directly from the cpu memory map
+// if it can, or read in pBuffer (only the addresses still in the results)
+static const UINT8 *CheatSearchReadPage(UINT32 nAddress, UINT32 nLen, UINT8 *pBuffer)
+{
+	if (cheat_subptr->page) {
+		UINT8 *pr = cheat_subptr->page(nAddress);
+		if (pr) return pr;
+	}
+
+	memset(pBuffer, 0, nLen);
+	for (UINT32 i = 0; i < nLen; i++) {
+		if (IN_RESULTS(nAddress + i)) {
+			pBuffer[i] = cheat_subptr->read((nAddress + i) ^ nSearchXor);
+		}
+	}
+
+	return pBuffer;
+}
+
+static UINT32 CheatSearchCount(UINT32 nBits)
+{
+	nBits = nBits - ((nBits >> 1) & 0x55555555);
+	nBits = (nBits & 0x33333333) + ((nBits >> 2) & 0x33333333);
+	return (((nBits + (nBits >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+// one bit per byte of pNew that compares to pOld, 32 bytes
+static UINT32 CheatSearchMatch(const UINT8 *pNew, const UINT8 *pOld, INT32 nMode)
+{
+#if defined CHEAT_SEARCH_SSE2
+	UINT32 nMatch = 0;
+
+	for (INT32 i = 0; i < 32; i += 16) {
+		__m128i n = _mm_loadu_si128((const __m128i*)(pNew + i));
+		__m128i o = _mm_loadu_si128((const __m128i*)(pOld + i));
+		__m128i m;
+
+		switch (nMode) {
+			case SEARCH_NOCHANGE:	m = _mm_cmpeq_epi8(n, o); break;
+			case SEARCH_CHANGE:	m = _mm_xor_si128(_mm_cmpeq_epi8(n, o), _mm_set1_epi8(-1)); break;
+			default: {
+				// unsigned compare, values are biased to the signed range
+				__m128i bias = _mm_set1_epi8((char)0x80);
+				n = _mm_xor_si128(n, bias);
+				o = _mm_xor_si128(o, bias);
+				m = (nMode == SEARCH_DECREASED) ? _mm_cmplt_epi8(n, o) : _mm_cmpgt_epi8(n, o);
+			}
+		}
+
+		nMatch |= (UINT32)_mm_movemask_epi8(m) << i;
+	}
+
+	return nMatch;
+#else
+	UINT32 nMatch = 0;
+
+	switch (nMode) {
+		case SEARCH_NOCHANGE:	for (INT32 i = 0; i < 32; i++) nMatch |= (UINT32)(pNew[i] == pOld[i]) << i; break;
+		case SEARCH_CHANGE:	for (INT32 i = 0; i < 32; i++) nMatch |= (UINT32)(pNew[i] != pOld[i]) << i; break;
+		case SEARCH_DECREASED:	for (INT32 i = 0; i < 32; i++) nMatch |= (UINT32)(pNew[i] < pOld[i]) << i; break;
+		default:		for (INT32 i = 0; i < 32; i++) nMatch |= (UINT32)(pNew[i] > pOld[i]) << i; break;
+	}
+
+	return nMatch;
+#endif
+}
+
 void CheatSearchStart()
 {
-	UINT32 nAddress;
-	
 	INT32 nActiveCPU = 0;
 	cheat_ptr = &cpus[nActiveCPU];
 	cheat_subptr = cheat_ptr->cpuconfig;
@@ -368,18 +469,27 @@ void CheatSearchStart()
 	if (nActiveCPU >= 0) cheat_subptr->close();
 	cheat_subptr->open(cheat_ptr->nCPU);
 	nMemorySize = cheat_subptr->nMemorySize;
+	nSearchXor = cheat_subptr->page ? cheat_subptr->nPageXor : 0;
 
-	MemoryValues = (UINT8*)malloc(nMemorySize);
-	MemoryStatus = (UINT8*)malloc(nMemorySize);
+	// whole 32 bytes blocks, the tail is never in the results
+	UINT32 nStatusSize = ((nMemorySize + 31) >> 5) * sizeof(UINT32);
+	MemoryValues = (UINT8*)malloc(nMemorySize + 32);
+	MemoryStatus = (UINT32*)malloc(nStatusSize);
 	
-	memset(MemoryStatus, IN_RESULTS, nMemorySize);
+	memset(MemoryStatus, 0xff, nStatusSize);
+	if (nMemorySize & 31) MemoryStatus[nMemorySize >> 5] = (1U << (nMemorySize & 31)) - 1;
 	
 	if (CheatSearchInitCallbackFunction) CheatSearchInitCallbackFunction();
 
-	for (nAddress = 0; nAddress < nMemorySize; nAddress++) {
-		if (MemoryStatus[nAddress] == NOT_IN_RESULTS) continue;
-		MemoryValues[nAddress] = cheat_subptr->read(nAddress);
+	UINT32 nPageSize = CheatSearchPageSize();
+	UINT8 *pBuffer = (UINT8*)malloc(nPageSize);
+
+	for (UINT32 nAddress = 0; nAddress < nMemorySize; nAddress += nPageSize) {
+		UINT32 nLen = (nMemorySize - nAddress < nPageSize) ? nMemorySize - nAddress : nPageSize;
+		memcpy(MemoryValues + nAddress, CheatSearchReadPage(nAddress, nLen, pBuffer), nLen);
 	}
+
+	free(pBuffer);
 	
 	cheat_subptr->close();
 	if (nActiveCPU >= 0) cheat_subptr->open(nActiveCPU);
@@ -387,42 +497,61 @@ void CheatSearchStart()
 
 static void CheatSearchGetResults()
 {
-	UINT32 nAddress;
 	UINT32 nResultsPos = 0;
 	
 	memset(CheatSearchShowResultAddresses, 0, CHEATSEARCH_SHOWRESULTS);
 	memset(CheatSearchShowResultValues, 0, CHEATSEARCH_SHOWRESULTS);
 	
-	for (nAddress = 0; nAddress < nMemorySize; nAddress++) {		
-		if (MemoryStatus[nAddress] == IN_RESULTS) {
-			CheatSearchShowResultAddresses[nResultsPos] = nAddress;
+	for (UINT32 nAddress = 0; nAddress < nMemorySize && nResultsPos < CHEATSEARCH_SHOWRESULTS; nAddress++) {
+		if (MemoryStatus[nAddress >> 5] == 0) {
+			nAddress |= 31;
+			continue;
+		}
+		if (IN_RESULTS(nAddress)) {
+			CheatSearchShowResultAddresses[nResultsPos] = nAddress ^ nSearchXor;
 			CheatSearchShowResultValues[nResultsPos] = MemoryValues[nAddress];
 			nResultsPos++;
 		}
 	}
 }
 
-UINT32 CheatSearchValueNoChange()
+static UINT32 CheatSearchCompare(INT32 nMode)
 {
 	UINT32 nMatchedAddresses = 0;
-	UINT32 nAddress;
 	
 	INT32 nActiveCPU = 0;
 	
 	nActiveCPU = cheat_subptr->active();
 	if (nActiveCPU >= 0) cheat_subptr->close();
 	cheat_subptr->open(0);
-	
-	for (nAddress = 0; nAddress < nMemorySize; nAddress++) {
-		if (MemoryStatus[nAddress] == NOT_IN_RESULTS) continue;
-		if (cheat_subptr->read(nAddress) == MemoryValues[nAddress]) {
-			MemoryValues[nAddress] = cheat_subptr->read(nAddress);
-			nMatchedAddresses++;
-		} else {
-			MemoryStatus[nAddress] = NOT_IN_RESULTS;
+
+	UINT32 nPageSize = CheatSearchPageSize();
+	UINT8 *pBuffer = (UINT8*)malloc(nPageSize + 32);
+
+	for (UINT32 nAddress = 0; nAddress < nMemorySize; nAddress += nPageSize) {
+		UINT32 nLen = (nMemorySize - nAddress < nPageSize) ? nMemorySize - nAddress : nPageSize;
+		if (CheatSearchPageEmpty(nAddress, nLen)) continue;
+
+		const UINT8 *pNew = CheatSearchReadPage(nAddress, nLen, pBuffer);
+		if (nLen & 31) {
+			// the last block runs past the memory range, compare a padded copy
+			if (pNew != pBuffer) memcpy(pBuffer, pNew, nLen);
+			pNew = pBuffer;
 		}
+
+		for (UINT32 i = 0; i < nLen; i += 32) {
+			UINT32 *pStatus = &MemoryStatus[(nAddress + i) >> 5];
+			if (*pStatus == 0) continue;
+			*pStatus &= CheatSearchMatch(pNew + i, MemoryValues + nAddress + i, nMode);
+			nMatchedAddresses += CheatSearchCount(*pStatus);
+		}
+
+		// only the values of the addresses left in the results matter
+		memcpy(MemoryValues + nAddress, pNew, nLen);
 	}
 
+	free(pBuffer);
+
 	cheat_subptr->close();
 	if (nActiveCPU >= 0) cheat_subptr->open(nActiveCPU);
 	
@@ -431,104 +560,36 @@ UINT32 CheatSearchValueNoChange()
 	return nMatchedAddresses;
 }
 
+UINT32 CheatSearchValueNoChange()
+{
+	return CheatSearchCompare(SEARCH_NOCHANGE);
+}
+
 UINT32 CheatSearchValueChange()
 {
-	UINT32 nMatchedAddresses = 0;
-	UINT32 nAddress;
-	
-	INT32 nActiveCPU = 0;
-	
-	nActiveCPU = cheat_subptr->active();
-	if (nActiveCPU >= 0) cheat_subptr->close();
-	cheat_subptr->open(0);
-	
-	for (nAddress = 0; nAddress < nMemorySize; nAddress++) {
-		if (MemoryStatus[nAddress] == NOT_IN_RESULTS) continue;
-		if (cheat_subptr->read(nAddress) != MemoryValues[nAddress]) {
-			MemoryValues[nAddress] = cheat_subptr->read(nAddress);
-			nMatchedAddresses++;
-		} else {
-			MemoryStatus[nAddress] = NOT_IN_RESULTS;
-		}
-	}
-	
-	cheat_subptr->close();
-	if (nActiveCPU >= 0) cheat_subptr->open(nActiveCPU);
-	
-	if (nMatchedAddresses <= CHEATSEARCH_SHOWRESULTS) CheatSearchGetResults();
-	
-	return nMatchedAddresses;
+	return CheatSearchCompare(SEARCH_CHANGE);
 }
 
 UINT32 CheatSearchValueDecreased()
 {
-	UINT32 nMatchedAddresses = 0;
-	UINT32 nAddress;
-	
-	INT32 nActiveCPU = 0;
-	
-	nActiveCPU = cheat_subptr->active();
-	if (nActiveCPU >= 0) cheat_subptr->close();
-	cheat_subptr->open(0);
-
-	for (nAddress = 0; nAddress < nMemorySize; nAddress++) {
-		if (MemoryStatus[nAddress] == NOT_IN_RESULTS) continue;
-		if (cheat_subptr->read(nAddress) < MemoryValues[nAddress]) {
-			MemoryValues[nAddress] = cheat_subptr->read(nAddress);
-			nMatchedAddresses++;
-		} else {
-			MemoryStatus[nAddress] = NOT_IN_RESULTS;
-		}
-	}
-
-	cheat_subptr->close();
-	if (nActiveCPU >= 0) cheat_subptr->open(nActiveCPU);
-	
-	if (nMatchedAddresses <= CHEATSEARCH_SHOWRESULTS) CheatSearchGetResults();
-	
-	return nMatchedAddresses;
+	return CheatSearchCompare(SEARCH_DECREASED);
 }
 
 UINT32 CheatSearchValueIncreased()
 {
-	UINT32 nMatchedAddresses = 0;
-	UINT32 nAddress;
-	
-	INT32 nActiveCPU = 0;
-	
-	nActiveCPU = cheat_subptr->active();
-	if (nActiveCPU >= 0) cheat_subptr->close();
-	cheat_subptr->open(0);
-
-	for (nAddress = 0; nAddress < nMemorySize; nAddress++) {
-		if (MemoryStatus[nAddress] == NOT_IN_RESULTS) continue;
-		if (cheat_subptr->read(nAddress) > MemoryValues[nAddress]) {
-			MemoryValues[nAddress] = cheat_subptr->read(nAddress);
-			nMatchedAddresses++;
-		} else {
-			MemoryStatus[nAddress] = NOT_IN_RESULTS;
-		}
-	}
-	
-	cheat_subptr->close();
-	if (nActiveCPU >= 0) cheat_subptr->open(nActiveCPU);
-	
-	if (nMatchedAddresses <= CHEATSEARCH_SHOWRESULTS) CheatSearchGetResults();
-	
-	return nMatchedAddresses;
+	return CheatSearchCompare(SEARCH_INCREASED);
 }
 
 void CheatSearchDumptoFile()
 {
 	FILE *fp = fopen("cheatsearchdump.txt", "wt");
-	UINT32 nAddress;
 	
 	if (fp) {
 		char Temp[256];
 		
-		for (nAddress = 0; nAddress < nMemorySize; nAddress++) {
-			if (MemoryStatus[nAddress] == IN_RESULTS) {
-				sprintf(Temp, "Address %08X Value %02X\n", nAddress, MemoryValues[nAddress]);
+		for (UINT32 nAddress = 0; nAddress < nMemorySize; nAddress++) {
+			if (IN_RESULTS(nAddress ^ nSearchXor)) {
+				sprintf(Temp, "Address %08X Value %02X\n", nAddress, MemoryValues[nAddress ^ nSearchXor]);
 				fwrite(Temp, 1, strlen(Temp), fp);
 			}
 		}
@@ -539,10 +600,14 @@ void CheatSearchDumptoFile()
 
 void CheatSearchExcludeAddressRange(UINT32 nStart, UINT32 nEnd)
 {
-	for (UINT32 nAddress = nStart; nAddress <= nEnd; nAddress++) {
-		MemoryStatus[nAddress] = NOT_IN_RESULTS;
+	for (UINT32 nAddress = nStart; nAddress <= nEnd && nAddress < nMemorySize; nAddress++) {
+		MemoryStatus[(nAddress ^ nSearchXor) >> 5] &= ~(1U << ((nAddress ^ nSearchXor) & 31));
 	}
 }
 
-#undef NOT_IN_RESULTS
 #undef IN_RESULTS
+#undef SEARCH_INCREASED
+#undef SEARCH_DECREASED
+#undef SEARCH_CHANGE
+#undef SEARCH_NOCHANGE
+#undef SEARCH_PAGE_SIZE
@@ -2,12 +2,12 @@
 
 #include "burnint.h"
 
-UINT8 Debug_BurnTransferInitted;
+BURN_THREAD UINT8 Debug_BurnTransferInitted;
 UINT8 Debug_BurnGunInitted;
 UINT8 Debug_BurnLedInitted;
 UINT8 Debug_BurnShiftInitted;
 UINT8 Debug_HiscoreInitted;
-UINT8 Debug_GenericTilesInitted;
+BURN_THREAD UINT8 Debug_GenericTilesInitted;
 
 UINT8 DebugDev_8255PPIInitted;
 UINT8 DebugDev_8257DMAInitted;
@@ -70,12 +70,12 @@ UINT8 DebugCPU_M6800Initted;
 UINT8 DebugCPU_M6805Initted;
 UINT8 DebugCPU_M6809Initted;
 UINT8 DebugCPU_S2650Initted;
-UINT8 DebugCPU_SekInitted;
+BURN_THREAD UINT8 DebugCPU_SekInitted;
 UINT8 DebugCPU_VezInitted;
-UINT8 DebugCPU_ZetInitted;
+BURN_THREAD UINT8 DebugCPU_ZetInitted;
 UINT8 DebugCPU_PIC16C5XInitted;
 UINT8 DebugCPU_I8039Initted;
-UINT8 DebugCPU_SH2Initted;
+BURN_THREAD UINT8 DebugCPU_SH2Initted;
 
 void DebugTrackerExit()
 {
@@ -819,7 +819,7 @@ void SlapsticInit(INT32 chip)
 	SlapsticReset();
 
 	/* see if we're 68k or 6502/6809 based */
-	extern INT32 nSekCount;
+	extern BURN_THREAD INT32 nSekCount;
 	access_68k = (nSekCount != -1); // Ok?
 }
 
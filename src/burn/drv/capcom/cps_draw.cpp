@@ -1,4 +1,5 @@
 #include "cps.h"
+#include "burn_prof.h"
 // CPS - Draw
 
 UINT8 CpsRecalcPal = 0;			// Flag - If it is 1, recalc the whole palette
@@ -500,6 +501,8 @@ static void DoDraw(INT32 Recalc)
 
 INT32 CpsDraw()
 {
+	BURN_PROF_SCOPE(BURN_PROF_CPS_DRAW);
+
 	DoDraw(CpsRecalcPal);
 
 	CpsRecalcPal = 0;
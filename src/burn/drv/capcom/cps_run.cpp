@@ -1,5 +1,6 @@
 // CPS - Run
 #include "cps.h"
+#include "burn_sched.h"
 
 // Inputs:
 UINT8 CpsReset = 0;
@@ -13,6 +14,9 @@ static const INT32 nFirstLine = 0x10;							// The first scanline of the display
 
 static INT32 nCpsCyclesExtra;
 
+static INT32 nCps1DisplayEnd;
+static BurnSchedCpu Cps1SchedCpu[1] = { BURN_SCHED_SEK(0, 0) };
+
 INT32 CpsDrawSpritesInReverse = 0;
 
 INT32 nIrqLine50, nIrqLine52;
@@ -286,10 +290,29 @@ static void DoIRQ()
 	return;
 }
 
-INT32 Cps1Frame()
+// after each quarter of the frame, with the 68K open
+static void Cps1FrameQuarter(INT32 nQuarter)
 {
-	INT32 nDisplayEnd, nNext, i;
+	INT32 nNext = ((nQuarter + 2) * nCpsCycles) >> 2;			// where the next quarter runs to
+
+	if (nQuarter == 1 && CpsRunFrameMiddleCallbackFunction) {
+		CpsRunFrameMiddleCallbackFunction();
+	}
+
+	if (nQuarter < 3 && SekTotalCycles() < nCps1DisplayEnd && nNext > nCps1DisplayEnd) {
+
+		SekRun(nNext - nCps1DisplayEnd);						// run 68K
+
+		memcpy(CpsSaveReg[0], CpsReg, 0x100);				// Registers correct now
+
+		SekSetIRQLine(Cps1VBlankIRQLine, CPU_IRQSTATUS_AUTO);				// Trigger VBlank interrupt
+	}
+
+	Cps1SchedCpu[0].nCyclesDone = SekTotalCycles();			// the quarters run to the 68K's own count
+}
 
+INT32 Cps1Frame()
+{
 	if (CpsReset) {
 		DrvReset();
 	}
@@ -312,7 +335,7 @@ INT32 Cps1Frame()
 
 	CpsRwGetInp();												// Update the input port values
 
-	nDisplayEnd = (nCpsCycles * (nFirstLine + 224)) / nCpsNumScanlines;	// Account for VBlank
+	nCps1DisplayEnd = (nCpsCycles * (nFirstLine + 224)) / nCpsNumScanlines;	// Account for VBlank
 
 	SekOpen(0);
 
@@ -320,24 +343,15 @@ INT32 Cps1Frame()
 
 	CpsObjGet();											// Get objects
 
-	for (i = 0; i < 4; i++) {
-		nNext = ((i + 1) * nCpsCycles) >> 2;					// find out next cycle count to run to
-		
-		if (i == 2 && CpsRunFrameMiddleCallbackFunction) {
-			CpsRunFrameMiddleCallbackFunction();
-		}
-
-		if (SekTotalCycles() < nDisplayEnd && nNext > nDisplayEnd) {
+	Cps1SchedCpu[0].nCyclesFrame = nCpsCycles;
+	Cps1SchedCpu[0].nCyclesDone = SekTotalCycles();
+	Cps1SchedCpu[0].slice = Cps1FrameQuarter;
 
-			SekRun(nNext - nDisplayEnd);						// run 68K
-
-			memcpy(CpsSaveReg[0], CpsReg, 0x100);				// Registers correct now
+	SekClose();
 
-			SekSetIRQLine(Cps1VBlankIRQLine, CPU_IRQSTATUS_AUTO);				// Trigger VBlank interrupt
-		}
+	BurnSchedRun(Cps1SchedCpu, 1, 4, NULL);					// run 68K to the end of the frame in quarters
 
-		SekRun(nNext - SekTotalCycles());						// run 68K
-	}
+	SekOpen(0);
 
 	if (pBurnDraw) {
 		CpsDraw();										// Draw frame
@@ -3,11 +3,14 @@
 #include <math.h>
 #include "cps.h"
 #include "burn_sound.h"
+#include "burn_resample.h"
+#include "burn_prof.h"
 
 static const INT32 nQscClock = 4000000;
 static const INT32 nQscClockDivider = 166;
 
-static INT32 nQscRate = 0;
+static INT32 nQscRate = 0;						// the chip samplerate, the resampler brings it to nBurnSoundRate
+static struct BurnResampler QscResampler;
 INT32 Mmatrix; // global
 
 static INT32 Tams = -1;
@@ -32,8 +35,6 @@ struct QChan {
 		INT32 nVolume[2];					// Left & right side volumes (panning)
 
 		INT32 nPitch;						// Playback frequency
-
-		INT8 nEndBuffer[8];				// Buffer to enable correct cubic interpolation
 };
 
 static struct QChan QChan[16];
@@ -57,31 +58,6 @@ static void MapBank(struct QChan* pc)
 	pc->PlayBank = (INT8*)CpsQSam + nBank;
 }
 
-static void UpdateEndBuffer(struct QChan* pc)
-{
-	if (pc->bKey) {
-		// prepare a buffer to correctly interpolate the last 4 samples
-		if (nInterpolation >= 3) {
-			for (INT32 i = 0; i < 4; i++) {
-				pc->nEndBuffer[i] = pc->PlayBank[(pc->nEnd >> 12) - 4 + i];
-			}
-
-			if (pc->nLoop) {
-				for (INT32 i = 0, j = 0; i < 4; i++, j++) {
-					if (j >= (pc->nLoop >> 12)) {
-						j = 0;
-					}
-					pc->nEndBuffer[i + 4] = pc->PlayBank[((pc->nEnd - pc->nLoop) >> 12) + j];
-				}
-			} else {
-				for (INT32 i = 0; i < 4; i++) {
-					pc->nEndBuffer[i + 4] = pc->nEndBuffer[3];
-				}
-			}
-		}
-	}
-}
-
 static void CalcAdvance(struct QChan* pc)
 {
 	if (nQscRate) {
@@ -97,19 +73,26 @@ void QscReset()
 	for (INT32 i = 0; i < 16; i++) {
 		QChan[i].PlayBank = (INT8*)CpsQSam;
 	}
+
+	BurnResampleReset(&QscResampler);
 }
 
 void QscExit()
 {
 	nQscRate = 0;
 
+	BurnResampleExit(&QscResampler);
+
 	BurnFree(Qs_s);
 	Tams = -1;
 }
 
 INT32 QscInit(INT32 nRate)
 {
-	nQscRate = nRate;
+	nQscRate = nQscClock / nQscClockDivider;
+
+	// (left without a buffer when there is no sound)
+	BurnResampleInit(&QscResampler, nQscRate, nRate);
 
 	for (INT32 i = 0; i < 33; i++) {
 		PanningVolumes[i] = (INT32)((256.0 / sqrt(32.0)) * sqrt((double)i));
@@ -205,7 +188,6 @@ void QscWrite(INT32 a, INT32 d)
 			pc = QChan + ((nChanNum + 1) & 15);
 			pc->nBank = d;
 			MapBank(pc);
-			UpdateEndBuffer(pc);
 			break;
 		}
 		case 1: {										// Set sample start offset
@@ -229,12 +211,10 @@ void QscWrite(INT32 a, INT32 d)
 #endif
 		case 4: {										// Set sample loop offset
 			pc->nLoop = d << 12;
-			UpdateEndBuffer(pc);
 			break;
 		}
 		case 5: {										// Set sample end offset
 			pc->nEnd = d << 12;
-			UpdateEndBuffer(pc);
 			break;
 		}
 		case 6: {										// Set volume
@@ -248,8 +228,7 @@ void QscWrite(INT32 a, INT32 d)
 
 					pc->nPos = 0;
 					pc->bKey = 3;
-					UpdateEndBuffer(pc);
-				}
+						}
 			}
 			break;
 		}
@@ -262,8 +241,45 @@ void QscWrite(INT32 a, INT32 d)
 	}
 }
 
+// Qs_s to the resampler input through the routes
+static void QscMix(INT32* pDest, INT32 nLen)
+{
+	INT32 *pSrc = Qs_s;
+
+	if (pDest == NULL) {
+		return;
+	}
+
+	if (QsndOutputDir[BURN_SND_QSND_OUTPUT_1] == BURN_SND_ROUTE_LEFT && QsndGain[BURN_SND_QSND_OUTPUT_1] == 1.00
+	 && QsndOutputDir[BURN_SND_QSND_OUTPUT_2] == BURN_SND_ROUTE_RIGHT && QsndGain[BURN_SND_QSND_OUTPUT_2] == 1.00) {
+		// the default routes are a plain copy
+		for (INT32 i = 0; i < nLen * 2; i++) {
+			pDest[i] = pSrc[i] >> 8;
+		}
+		return;
+	}
+
+	for (INT32 i = 0; i < nLen; i++) {
+		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
+			pDest[(i << 1) + 0] += (INT32)((pSrc[(i << 1) + 0] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_1]);
+		}
+		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
+			pDest[(i << 1) + 1] += (INT32)((pSrc[(i << 1) + 0] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_1]);
+		}
+
+		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
+			pDest[(i << 1) + 0] += (INT32)((pSrc[(i << 1) + 1] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_2]);
+		}
+		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
+			pDest[(i << 1) + 1] += (INT32)((pSrc[(i << 1) + 1] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_2]);
+		}
+	}
+}
+
 INT32 QscUpdate(INT32 nEnd)
 {
+	BURN_PROF_SCOPE(BURN_PROF_QSOUND);
+
 	INT32 nLen;
 
 	if (nEnd > nBurnSoundLen) {
@@ -276,15 +292,17 @@ INT32 QscUpdate(INT32 nEnd)
 		return 0;
 	}
 
-	if (Tams < nLen) {
-		BurnFree(Qs_s);
-		Tams = nLen;
-		Qs_s = (INT32*)BurnMalloc(sizeof(INT32) * 2 * Tams);
-	}
+	// the channels step through the samples at the chip samplerate
+	INT32 nSamplesNeeded = BurnResampleNeeded(&QscResampler, nLen);
 
-	memset(Qs_s, 0, nLen * 2 * sizeof(INT32));
+	if (nSamplesNeeded > 0) {
+		if (Tams < nSamplesNeeded) {
+			BurnFree(Qs_s);
+			Tams = nSamplesNeeded;
+			Qs_s = (INT32*)BurnMalloc(sizeof(INT32) * 2 * Tams);
+		}
 
-	if (nInterpolation < 3) {
+		memset(Qs_s, 0, nSamplesNeeded * 2 * sizeof(INT32));
 
 		// Go through all channels
 		for (INT32 c = 0; c < 16; c++) {
@@ -294,8 +312,8 @@ INT32 QscUpdate(INT32 nEnd)
 				INT32 VolL = (QChan[c].nMasterVolume * QChan[c].nVolume[0]) >> 8;
 				INT32 VolR = (QChan[c].nMasterVolume * QChan[c].nVolume[1]) >> 8;
 				INT32* pTemp = Qs_s;
-				INT32 i = nLen;
-				INT32 s, p;
+				INT32 i = nSamplesNeeded;
+				INT32 s, p, n;
 
 				if (QChan[c].bKey & 2) {
 					QChan[c].bKey &= ~2;
@@ -310,25 +328,26 @@ INT32 QscUpdate(INT32 nEnd)
 					if (QChan[c].nPos >= (QChan[c].nEnd - 0x01000)) {
 						if (QChan[c].nLoop) {						// Loop sample
 							if (QChan[c].nPos < QChan[c].nEnd) {
-								QChan[c].nEndBuffer[0] = QChan[c].PlayBank[(QChan[c].nEnd - QChan[c].nLoop) >> 12];
+								n = QChan[c].PlayBank[(QChan[c].nEnd - QChan[c].nLoop) >> 12];
 							} else {
 								QChan[c].nPos = QChan[c].nEnd - QChan[c].nLoop + (QChan[c].nPos & 0x0FFF);
 								p = (QChan[c].nPos >> 12) & 0xFFFF;
+								n = QChan[c].PlayBank[p + 1];
 							}
 						} else {
 							if (QChan[c].nPos < QChan[c].nEnd) {
-								QChan[c].nEndBuffer[0] = QChan[c].PlayBank[p];
+								n = QChan[c].PlayBank[p];
 							} else {
 								QChan[c].bKey = 0;					// Quit playing
 								break;
 							}
 						}
 					} else {
-						QChan[c].nEndBuffer[0] = QChan[c].PlayBank[p + 1];
+						n = QChan[c].PlayBank[p + 1];
 					}
 
 					// Interpolate sample
-					s = QChan[c].PlayBank[p] * (1 << 6) + ((QChan[c].nPos) & ((1 << 12) - 1)) * (QChan[c].nEndBuffer[0] - QChan[c].PlayBank[p]) / (1 << 6);
+					s = QChan[c].PlayBank[p] * (1 << 6) + ((QChan[c].nPos) & ((1 << 12) - 1)) * (n - QChan[c].PlayBank[p]) / (1 << 6);
 
 					// Add to the sound currently in the buffer
 					pTemp[0] += (s * VolL) >> 3;
@@ -341,140 +360,11 @@ INT32 QscUpdate(INT32 nEnd)
 			}
 		}
 
-		INT16 *pDest = pBurnSoundOut + (nPos << 1);
-		INT32 *pSrc = Qs_s;
-		for (INT32 i = 0; i < nLen; i++) {
-			INT32 nLeftSample = 0, nRightSample = 0;
-			
-			if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample += (INT32)((pSrc[(i << 1) + 0] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_1]);
-			}
-			if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample += (INT32)((pSrc[(i << 1) + 0] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_1]);
-			}
-			
-			if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample += (INT32)((pSrc[(i << 1) + 1] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_2]);
-			}
-			if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample += (INT32)((pSrc[(i << 1) + 1] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_2]);
-			}
-			
-			pDest[(i << 1) + 0] = BURN_SND_CLIP(nLeftSample);
-			pDest[(i << 1) + 1] = BURN_SND_CLIP(nRightSample);
-		}
-		nPos = nEnd;
-
-		return 0;
+		QscMix(BurnResampleInput(&QscResampler, nSamplesNeeded), nSamplesNeeded);
 	}
 
-	// Go through all channels
-	for (INT32 c = 0; c < 16; c++) {
-
-		// If the channel is playing, add the samples to the buffer
-		if (QChan[c].bKey) {
-			INT32 VolL = (QChan[c].nMasterVolume * QChan[c].nVolume[0]) >> 11;
-			INT32 VolR = (QChan[c].nMasterVolume * QChan[c].nVolume[1]) >> 11;
-			INT32* pTemp = Qs_s;
-			INT32 i = nLen;
-
-			// handle 1st sample
-			if (QChan[c].bKey & 2) {
-				while (QChan[c].nPos < 0x1000 && i) {
-					INT32 p = QChan[c].nPlayStart >> 12;
-					INT32 s = INTERPOLATE4PS_CUSTOM(QChan[c].nPos,
-												  0,
-												  QChan[c].PlayBank[p + 0],
-												  QChan[c].PlayBank[p + 1],
-												  QChan[c].PlayBank[p + 2],
-												  256);
-
-					pTemp[0] += s * VolL;
-					pTemp[1] += s * VolR;
-
-					QChan[c].nPos += QChan[c].nAdvance;				// increment sample position based on pitch
-
-					pTemp += 2;
-					i--;
-				}
-				if (i > 0) {
-					QChan[c].bKey &= ~2;
-					QChan[c].nPos = (QChan[c].nPos & 0x0FFF) + QChan[c].nPlayStart;
-				}
-			}
-
-			while (i > 0) {
-				INT32 s, p;
-
-				// Check for end of sample
-				if (QChan[c].nPos >= (QChan[c].nEnd - 0x3000)) {
-					if (QChan[c].nPos < QChan[c].nEnd) {
-						INT32 nIndex = 4 - ((QChan[c].nEnd - QChan[c].nPos) >> 12);
-						s = INTERPOLATE4PS_CUSTOM((QChan[c].nPos) & ((1 << 12) - 1),
-												  QChan[c].nEndBuffer[nIndex + 0],
-												  QChan[c].nEndBuffer[nIndex + 1],
-												  QChan[c].nEndBuffer[nIndex + 2],
-												  QChan[c].nEndBuffer[nIndex + 3],
-												  256);
-					} else {
-						if (QChan[c].nLoop) {					// Loop sample
-							if (QChan[c].nLoop <= 0x1000) {		// Don't play, but leave bKey on
-								QChan[c].nPos = QChan[c].nEnd - 0x1000;
-								break;
-							}
-							QChan[c].nPos -= QChan[c].nLoop;
-							continue;
-						} else {
-							QChan[c].bKey = 0;					// Stop playing
-							break;
-						}
-					}
-				} else {
-					p = (QChan[c].nPos >> 12) & 0xFFFF;
-					s = INTERPOLATE4PS_CUSTOM((QChan[c].nPos) & ((1 << 12) - 1),
-											  QChan[c].PlayBank[p + 0],
-											  QChan[c].PlayBank[p + 1],
-											  QChan[c].PlayBank[p + 2],
-											  QChan[c].PlayBank[p + 3],
-											  256);
-				}
-
-				// Add to the sound currently in the buffer
-				pTemp[0] += s * VolL;
-				pTemp[1] += s * VolR;
-
-				pTemp += 2;
-
-				QChan[c].nPos += QChan[c].nAdvance;				// increment sample position based on pitch
-
-				i--;
-			}
-		}
-	}
-	
-	INT16 *pDest = pBurnSoundOut + (nPos << 1);
-	INT32 *pSrc = Qs_s;
-	for (INT32 i = 0; i < nLen; i++) {
-		INT32 nLeftSample = 0, nRightSample = 0;
-			
-		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample += (INT32)((pSrc[(i << 1) + 0] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_1]);
-		}
-		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample += (INT32)((pSrc[(i << 1) + 0] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_1]);
-		}
-			
-		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample += (INT32)((pSrc[(i << 1) + 1] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_2]);
-		}
-		if ((QsndOutputDir[BURN_SND_QSND_OUTPUT_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample += (INT32)((pSrc[(i << 1) + 1] >> 8) * QsndGain[BURN_SND_QSND_OUTPUT_2]);
-		}
-			
-		pDest[(i << 1) + 0] = BURN_SND_CLIP(nLeftSample);
-		pDest[(i << 1) + 1] = BURN_SND_CLIP(nRightSample);
-	}
-	nPos = nEnd;	
+	BurnResampleRender(&QscResampler, pBurnSoundOut + (nPos << 1), nLen, 0);
+	nPos = nEnd;
 
 	return 0;
 }
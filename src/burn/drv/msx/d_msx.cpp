@@ -432,7 +432,7 @@ static void CASPatchBIOS(UINT8 *bios)
 	}
 }
 
-extern void (*z80edfe_callback)(Z80_Regs *Regs);
+extern BURN_THREAD void (*z80edfe_callback)(Z80_Regs *Regs);
 
 static void Z80EDFECallback(Z80_Regs *Regs)
 {
@@ -105,6 +105,12 @@ struct NeoMediaInfo {
 #include "bitswap.h"
 #include "neocdlist.h"
 
+// If defined, map the decoded graphics cache instead of reading it
+#if (defined __unix__ || defined __APPLE__) && !defined __PSP2__ && !defined __3DS__
+ #define NEO_CACHE_MMAP
+ #include <sys/mman.h>
+#endif
+
 // #undef USE_SPEEDHACKS
 
 // #define LOG_IRQ
@@ -495,6 +501,216 @@ static INT32 FindROMs(UINT32 nType, INT32* pOffset, INT32* pNum)
 	return 0;
 }
 
+// ----------------------------------------------------------------------------
+// Decoded graphics cache
+//
+// Decrypting and decoding the C/S ROMs takes seconds on slow machines, so the
+// final sprite/text data is saved to szAppCachePath and reused as long as the
+// CRCs of the ROM files loaded match (the application has to give them, see
+// BurnExtRomCrc). Some drivers modify the graphics in pInitialise: the first
+// load finds that out and saves a header only cache, those drivers always load
+// the ROMs so pInitialise sees the graphics it expects.
+
+#define NEO_CACHE_MAGIC		(0x4347454E)						// "NEGC"
+#define NEO_CACHE_VERSION	(3)									// 2: keyed on the files' CRCs, not the driver's, 3: no graphics with NEO_CACHE_INIT_GFX
+#define NEO_CACHE_DATA		(0x10000)							// sprite data offset, page aligned (up to 64KB pages) so it can be mapped
+
+#define NEO_CACHE_INIT_GFX	(1)									// pInitialise modifies the graphics, nothing cached
+
+struct NeoCacheHeader {
+	UINT32 nMagic;
+	UINT32 nVersion;
+	UINT32 nRomCrc;
+	UINT32 nFlags;
+	UINT32 nSpriteSize;											// allocated sprite ROM size
+	UINT32 nTextSize;
+};
+
+static UINT8* NeoSpriteMap[MAX_SLOT] = { NULL, };				// NeoSpriteROM when it's mapped from the cache
+static UINT32 nNeoSpriteMapSize[MAX_SLOT] = { 0, };
+
+static bool NeoCacheEnabled()
+{
+	return szAppCachePath[0] != 0 && BurnExtRomCrc != NULL;
+}
+
+static INT32 NeoCacheGetName(TCHAR* szName)
+{
+	if (!NeoCacheEnabled()) {
+		return 1;
+	}
+
+	_stprintf(szName, _T("%s%s.ngc"), szAppCachePath, BurnDrvGetText(DRV_NAME));
+
+	return 0;
+}
+
+static UINT32 NeoCacheHash(UINT32 nHash, const UINT8* pData, UINT32 nLen)
+{
+	for (UINT32 i = 0; i < nLen; i++) {
+		nHash = (nHash ^ pData[i]) * 16777619;
+	}
+
+	return nHash;
+}
+
+// all the ROM files loaded, a different BIOS or P ROM can come with different graphics. The
+// CRCs are the files' ones, not the driver's: a bad dump replaced by a good one makes a new cache
+static UINT32 NeoCacheRomCrc()
+{
+	UINT32 nHash = 2166136261U;
+
+	for (INT32 i = 0; BurnDrvGetRomInfo(NULL, i) == 0; i++) {
+		UINT32 nCrc = 0, nLen = 0;
+		BurnExtRomCrc(&nCrc, &nLen, i);							// missing: 0, 0
+		nHash = NeoCacheHash(nHash, (UINT8*)&nCrc, sizeof(nCrc));
+		nHash = NeoCacheHash(nHash, (UINT8*)&nLen, sizeof(nLen));
+	}
+
+	return nHash;
+}
+
+// it only has to tell if pInitialise changed anything: four independent lanes
+// of 64 bit words, so it goes at memory speed instead of one multiply per word
+static UINT32 NeoCacheGfxHash()
+{
+	UINT64 nLane[4] = { 1, 2, 3, 4 };
+	UINT64* pData = (UINT64*)NeoSpriteROM[nNeoActiveSlot];
+	UINT32 nWords = nSpriteSize[nNeoActiveSlot] / 32 * 4;
+
+	for (UINT32 i = 0; i < nWords; i += 4) {
+		nLane[0] = (nLane[0] ^ pData[i + 0]) * 0x100000001b3ULL;
+		nLane[1] = (nLane[1] ^ pData[i + 1]) * 0x100000001b3ULL;
+		nLane[2] = (nLane[2] ^ pData[i + 2]) * 0x100000001b3ULL;
+		nLane[3] = (nLane[3] ^ pData[i + 3]) * 0x100000001b3ULL;
+	}
+
+	UINT32 nHash = NeoCacheHash(2166136261U, (UINT8*)nLane, sizeof(nLane));
+	nHash = NeoCacheHash(nHash, NeoSpriteROM[nNeoActiveSlot] + nWords * 8, nSpriteSize[nNeoActiveSlot] - nWords * 8);
+	return NeoCacheHash(nHash, NeoTextROM[nNeoActiveSlot], nNeoTextROMSize[nNeoActiveSlot]);
+}
+
+static FILE* NeoCacheOpen(struct NeoCacheHeader* pHeader, UINT32 nSpriteAlloc)
+{
+	TCHAR szName[MAX_PATH];
+	if (NeoCacheGetName(szName)) {
+		return NULL;
+	}
+
+	FILE* fp = _tfopen(szName, _T("rb"));
+	if (fp == NULL) {
+		return NULL;
+	}
+
+	if (fread(pHeader, sizeof(*pHeader), 1, fp) != 1
+	 || pHeader->nMagic != NEO_CACHE_MAGIC
+	 || pHeader->nVersion != NEO_CACHE_VERSION
+	 || pHeader->nRomCrc != NeoCacheRomCrc()
+	 || pHeader->nSpriteSize != nSpriteAlloc
+	 || pHeader->nTextSize != (UINT32)nNeoTextROMSize[nNeoActiveSlot]) {
+		fclose(fp);
+		return NULL;
+	}
+
+	return fp;
+}
+
+// read (or map) the cached sprite data, NeoSpriteROM must be NULL or allocated
+static INT32 NeoCacheLoadSprites(FILE* fp, struct NeoCacheHeader* pHeader)
+{
+#if defined NEO_CACHE_MMAP
+	if (NeoSpriteROM[nNeoActiveSlot] == NULL) {
+		void* pMap = mmap(NULL, pHeader->nSpriteSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fp), NEO_CACHE_DATA);
+		if (pMap != MAP_FAILED) {
+			NeoSpriteMap[nNeoActiveSlot] = NeoSpriteROM[nNeoActiveSlot] = (UINT8*)pMap;
+			nNeoSpriteMapSize[nNeoActiveSlot] = pHeader->nSpriteSize;
+			return 0;
+		}
+	}
+#endif
+
+	if (NeoSpriteROM[nNeoActiveSlot] == NULL) {
+		NeoSpriteROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(pHeader->nSpriteSize);
+		if (NeoSpriteROM[nNeoActiveSlot] == NULL) {
+			return 1;
+		}
+	}
+
+	if (fseek(fp, NEO_CACHE_DATA, SEEK_SET) != 0 || fread(NeoSpriteROM[nNeoActiveSlot], 1, pHeader->nSpriteSize, fp) != pHeader->nSpriteSize) {
+		return 1;
+	}
+
+	return 0;
+}
+
+static INT32 NeoCacheLoadText(FILE* fp, struct NeoCacheHeader* pHeader)
+{
+	if (NeoTextROM[nNeoActiveSlot] == NULL) {
+		NeoTextROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(pHeader->nTextSize);
+		if (NeoTextROM[nNeoActiveSlot] == NULL) {
+			return 1;
+		}
+	}
+
+	if (fseek(fp, NEO_CACHE_DATA + pHeader->nSpriteSize, SEEK_SET) != 0 || fread(NeoTextROM[nNeoActiveSlot], 1, pHeader->nTextSize, fp) != pHeader->nTextSize) {
+		return 1;
+	}
+
+	return 0;
+}
+
+static void NeoCacheSave(UINT32 nSpriteAlloc, UINT32 nFlags)
+{
+	TCHAR szName[MAX_PATH];
+	TCHAR szTemp[MAX_PATH];
+	if (NeoCacheGetName(szName)) {
+		return;
+	}
+
+	// write a temporary file first, a partial cache must never look valid
+	_stprintf(szTemp, _T("%s.tmp"), szName);
+	FILE* fp = _tfopen(szTemp, _T("wb"));
+	if (fp == NULL) {
+		return;
+	}
+
+	struct NeoCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.nMagic = NEO_CACHE_MAGIC;
+	header.nVersion = NEO_CACHE_VERSION;
+	header.nRomCrc = NeoCacheRomCrc();
+	header.nFlags = nFlags;
+	header.nSpriteSize = nSpriteAlloc;
+	header.nTextSize = nNeoTextROMSize[nNeoActiveSlot];
+
+	INT32 nRet = fwrite(&header, sizeof(header), 1, fp) != 1;
+	if ((nFlags & NEO_CACHE_INIT_GFX) == 0) {
+		nRet |= fseek(fp, NEO_CACHE_DATA, SEEK_SET) != 0;
+		nRet |= fwrite(NeoSpriteROM[nNeoActiveSlot], 1, nSpriteAlloc, fp) != nSpriteAlloc;
+		nRet |= fwrite(NeoTextROM[nNeoActiveSlot], 1, header.nTextSize, fp) != header.nTextSize;
+	}
+	nRet |= fclose(fp) != 0;
+
+	if (nRet || _trename(szTemp, szName) != 0) {
+		bprintf(PRINT_ERROR, _T("  - Couldn't write graphics cache %s\n"), szName);
+		_tremove(szTemp);
+	}
+}
+
+static void NeoCacheFreeSprites(INT32 nSlot)
+{
+#if defined NEO_CACHE_MMAP
+	if (NeoSpriteMap[nSlot]) {
+		munmap(NeoSpriteMap[nSlot], nNeoSpriteMapSize[nSlot]);
+		NeoSpriteMap[nSlot] = NeoSpriteROM[nSlot] = NULL;
+		nNeoSpriteMapSize[nSlot] = 0;
+		return;
+	}
+#endif
+
+	BurnFree(NeoSpriteROM[nSlot]);
+}
+
 static INT32 LoadRoms()
 {
 	NeoGameInfo info;
@@ -650,11 +866,37 @@ static INT32 LoadRoms()
 //		nSpriteSize[nNeoActiveSlot] = 0x5000000;
 //	}
 
-	NeoSpriteROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(nSpriteSize[nNeoActiveSlot] < (nNeoTileMask[nNeoActiveSlot] << 7) ? ((nNeoTileMask[nNeoActiveSlot] + 1) << 7) : nSpriteSize[nNeoActiveSlot]);
-	if (NeoSpriteROM[nNeoActiveSlot] == NULL) {
-		return 1;
+	UINT32 nSpriteAlloc = nSpriteSize[nNeoActiveSlot] < (nNeoTileMask[nNeoActiveSlot] << 7) ? ((nNeoTileMask[nNeoActiveSlot] + 1) << 7) : nSpriteSize[nNeoActiveSlot];
+
+	struct NeoCacheHeader cache;
+	FILE* fCache = NeoCacheOpen(&cache, nSpriteAlloc);
+	bool bCacheKnown = fCache != NULL;							// we know if pInitialise touches the graphics
+	if (fCache && (cache.nFlags & NEO_CACHE_INIT_GFX)) {
+		// it does, it has to see the ROMs as loaded: nothing to take from the cache
+		fclose(fCache);
+		fCache = NULL;
+	}
+
+	if (fCache) {
+		// pInitialise doesn't touch the graphics, take the final ones right away
+		BurnUpdateProgress(0.0, _T("Loading cached graphics...")/*, BST_PROCESS_SPR*/, 0);
+		if (NeoCacheLoadSprites(fCache, &cache) || NeoCacheLoadText(fCache, &cache)) {
+			fclose(fCache);
+			return 1;
+		}
+	} else {
+		NeoSpriteROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(nSpriteAlloc);
+		NeoTextROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(nNeoTextROMSize[nNeoActiveSlot]);
+		if (NeoSpriteROM[nNeoActiveSlot] == NULL || NeoTextROM[nNeoActiveSlot] == NULL) {
+			if (fCache) {
+				fclose(fCache);
+			}
+			return 1;
+		}
 	}
 
+	if (fCache == NULL) {
+
 /*	if ((BurnDrvGetHardwareCode() & HARDWARE_PUBLIC_MASK) == HARDWARE_SNK_DEDICATED_PCB) {
 		BurnSetProgressRange(1.0 / ((double)nSpriteSize[nNeoActiveSlot] / 0x800000 / 12));
 	} else if (BurnDrvGetHardwareCode() & (HARDWARE_SNK_CMC42 | HARDWARE_SNK_CMC50)) {
@@ -663,26 +905,20 @@ static INT32 LoadRoms()
 		BurnSetProgressRange(1.0 / ((double)nSpriteSize[nNeoActiveSlot] / 0x800000 /  3));
 	}*/
 	
-	if (BurnDrvGetHardwareCode() & (HARDWARE_SNK_CMC42 | HARDWARE_SNK_CMC50)) {
-		double fRange = (double)pInfo->nSpriteNum / 4.0;
-		if (fRange < 1.5) {
-			fRange = 1.5;
+		if (BurnDrvGetHardwareCode() & (HARDWARE_SNK_CMC42 | HARDWARE_SNK_CMC50)) {
+			double fRange = (double)pInfo->nSpriteNum / 4.0;
+			if (fRange < 1.5) {
+				fRange = 1.5;
+			}
+			BurnSetProgressRange(1.0 / fRange);
+		} else {
+			BurnSetProgressRange(1.0 / pInfo->nSpriteNum);
 		}
-		BurnSetProgressRange(1.0 / fRange);
-	} else {
-		BurnSetProgressRange(1.0 / pInfo->nSpriteNum);
-	}
-
-	// Load sprite data
-	NeoLoadSprites(pInfo->nSpriteOffset, pInfo->nSpriteNum, NeoSpriteROM[nNeoActiveSlot], nSpriteSize[nNeoActiveSlot]);
 
-	NeoTextROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(nNeoTextROMSize[nNeoActiveSlot]);
-	if (NeoTextROM[nNeoActiveSlot] == NULL) {
-		return 1;
-	}
+		// Load sprite data
+		NeoLoadSprites(pInfo->nSpriteOffset, pInfo->nSpriteNum, NeoSpriteROM[nNeoActiveSlot], nSpriteSize[nNeoActiveSlot]);
 
-	// Load Text layer tiledata
-	{
+		// Load Text layer tiledata
 		if (pInfo->nTextOffset != -1) {
 			// Load S ROM data
 			BurnLoadRom(NeoTextROM[nNeoActiveSlot], pInfo->nTextOffset, 1);
@@ -701,6 +937,9 @@ static INT32 LoadRoms()
 
 	Neo68KROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(nCodeSize[nNeoActiveSlot]);	// 68K cartridge ROM
 	if (Neo68KROM[nNeoActiveSlot] == NULL) {
+		if (fCache) {
+			fclose(fCache);
+		}
 		return 1;
 	}
 	Neo68KROMActive = Neo68KROM[nNeoActiveSlot];
@@ -716,6 +955,9 @@ static INT32 LoadRoms()
 
 	NeoZ80ROM[nNeoActiveSlot] = (UINT8*)BurnMalloc(0x080000);	// Z80 cartridge ROM
 	if (NeoZ80ROM[nNeoActiveSlot] == NULL) {
+		if (fCache) {
+			fclose(fCache);
+		}
 		return 1;
 	}
 	NeoZ80ROMActive = NeoZ80ROM[nNeoActiveSlot]; 
@@ -725,16 +967,30 @@ static INT32 LoadRoms()
 		neogeo_cmc50_m1_decrypt();
 	}
 	
+	// first load of the set: to know if pInitialise modifies the graphics
+	bool bCacheSave = !bCacheKnown && NeoCacheEnabled();
+	UINT32 nGfxHash = bCacheSave ? NeoCacheGfxHash() : 0;
+
 	if (NeoCallbackActive && NeoCallbackActive->pInitialise) {
 		NeoCallbackActive->pInitialise();
 	}
 
-	// Decode text data
-	BurnUpdateProgress(0.0, _T("Preprocessing text layer graphics...")/*, BST_PROCESS_TXT*/, 0);
-	NeoDecodeText(0, nNeoTextROMSize[nNeoActiveSlot], NeoTextROM[nNeoActiveSlot], NeoTextROM[nNeoActiveSlot]);
+	if (fCache) {
+		fclose(fCache);
+	} else {
+		UINT32 nFlags = (bCacheSave && NeoCacheGfxHash() != nGfxHash) ? NEO_CACHE_INIT_GFX : 0;
+
+		// Decode text data
+		BurnUpdateProgress(0.0, _T("Preprocessing text layer graphics...")/*, BST_PROCESS_TXT*/, 0);
+		NeoDecodeText(0, nNeoTextROMSize[nNeoActiveSlot], NeoTextROM[nNeoActiveSlot], NeoTextROM[nNeoActiveSlot]);
 
-	// Decode sprite data
-	NeoDecodeSprites(NeoSpriteROM[nNeoActiveSlot], nSpriteSize[nNeoActiveSlot]);
+		// Decode sprite data
+		NeoDecodeSprites(NeoSpriteROM[nNeoActiveSlot], nSpriteSize[nNeoActiveSlot]);
+
+		if (bCacheSave) {
+			NeoCacheSave(nSpriteAlloc, nFlags);
+		}
+	}
 
 	if (pInfo->nADPCMANum) {
 		char* pName;
@@ -4228,7 +4484,7 @@ INT32 NeoExit()
 			BurnFree(NeoTextROM[nNeoActiveSlot]);						// Text ROM
 			nNeoTextROMSize[nNeoActiveSlot] = 0;
 
-			BurnFree(NeoSpriteROM[nNeoActiveSlot]);						// Sprite ROM
+			NeoCacheFreeSprites(nNeoActiveSlot);						// Sprite ROM
 			BurnFree(Neo68KROM[nNeoActiveSlot]);						// 68K ROM
 			BurnFree(NeoVector[nNeoActiveSlot]);						// 68K vectors
 			BurnFree(NeoZ80ROM[nNeoActiveSlot]);						// Z80 ROM
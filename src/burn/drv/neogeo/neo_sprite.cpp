@@ -1,4 +1,5 @@
 #include "neogeo.h"
+#include "burn_prof.h"
 
 UINT8* NeoZoomROM;
 
@@ -47,6 +48,8 @@ static inline UINT32 alpha_blend(UINT32 d, UINT32 s, UINT32 p)
 
 INT32 NeoRenderSprites()
 {
+	BURN_PROF_SCOPE(BURN_PROF_NEO_SPRITES);
+
 	if (nLastBPP != nBurnBpp ) {
 		nLastBPP = nBurnBpp;
 
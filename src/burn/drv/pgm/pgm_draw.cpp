@@ -1,5 +1,6 @@
 #include "pgm.h"
 #include "pgm_sprite.h"
+#include "burn_prof.h"
 
 //#define DUMP_SPRITE_BITMAPS
 //#define DRAW_SPRITE_NUMBER
@@ -1020,6 +1021,8 @@ static void pgmBlendCopy()
 
 INT32 pgmDraw()
 {
+	BURN_PROF_SCOPE(BURN_PROF_PGM_DRAW);
+
 	if (enable_blending) nPgmPalRecalc = 1; // force recalc.
 
 	if (nPgmPalRecalc) {
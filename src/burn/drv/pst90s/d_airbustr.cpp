@@ -227,6 +227,22 @@ void __fastcall airbustr_main_write(UINT16 address, UINT8 data)
 	}
 }
 
+void __fastcall airbustr_sub_write(UINT16 address, UINT8 data)
+{
+	switch (address & 0xf800)
+	{
+		case 0xc000:
+			DrvVidRAM1[address & 0x7ff] = data;
+			GenericTilemapSetTileDirty(1, address & 0x3ff);
+		return;
+
+		case 0xc800:
+			DrvVidRAM0[address & 0x7ff] = data;
+			GenericTilemapSetTileDirty(0, address & 0x3ff);
+		return;
+	}
+}
+
 UINT8 __fastcall airbustr_main_read(UINT16 address)
 {
 	if ((address & 0xf000) == 0xe000) {
@@ -420,6 +436,7 @@ static INT32 DrvDoReset(INT32 full_reset)
 {
 	if (full_reset) {
 		memset (AllRam, 0, RamEnd - AllRam);
+		GenericTilemapAllTilesDirty(TMAP_GLOBAL);
 	}
 
 //	UINT8 *rom[3] = { DrvZ80ROM0, DrvZ80ROM1, DrvZ80ROM2 };
@@ -612,10 +629,10 @@ static INT32 DrvInit()
 	ZetMapArea(0x0000, 0x7fff, 0, DrvZ80ROM1);
 	ZetMapArea(0x0000, 0x7fff, 2, DrvZ80ROM1);
 	ZetMapArea(0xc000, 0xc7ff, 0, DrvVidRAM1);
-	ZetMapArea(0xc000, 0xc7ff, 1, DrvVidRAM1);
+//	ZetMapArea(0xc000, 0xc7ff, 1, DrvVidRAM1); // handler
 	ZetMapArea(0xc000, 0xc7ff, 2, DrvVidRAM1);
 	ZetMapArea(0xc800, 0xcfff, 0, DrvVidRAM0);
-	ZetMapArea(0xc800, 0xcfff, 1, DrvVidRAM0);
+//	ZetMapArea(0xc800, 0xcfff, 1, DrvVidRAM0); // handler
 	ZetMapArea(0xc800, 0xcfff, 2, DrvVidRAM0);
 	ZetMapArea(0xd000, 0xdfff, 0, DrvPalRAM);
 	ZetMapArea(0xd000, 0xdfff, 1, DrvPalRAM);
@@ -626,6 +643,7 @@ static INT32 DrvInit()
 	ZetMapArea(0xf000, 0xffff, 0, DrvShareRAM);
 	ZetMapArea(0xf000, 0xffff, 1, DrvShareRAM);
 	ZetMapArea(0xf000, 0xffff, 2, DrvShareRAM);
+	ZetSetWriteHandler(airbustr_sub_write);
 	ZetSetOutHandler(airbustr_sub_out);
 	ZetSetInHandler(airbustr_sub_in);
 	ZetClose();
@@ -660,6 +678,8 @@ static INT32 DrvInit()
 	GenericTilemapInit(1, scan_rows_map_scan, airbustr1_map_callback, 16, 16, 32, 32);
 	GenericTilemapSetTransparent(1, 0);
 	GenericTilemapSetGfx(0, DrvGfxROM0, 4, 16, 16, 0x100000, 0, 0x1f);
+	GenericTilemapUseDirtyTiles(0);
+	GenericTilemapUseDirtyTiles(1);
 
 	DrvDoReset(1);
 
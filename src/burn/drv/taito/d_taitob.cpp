@@ -15,6 +15,7 @@
 #include "burn_ym2203.h"
 #include "burn_gun.h"
 #include "eeprom.h"
+#include "burn_sched.h"
 
 static UINT8  *DrvPxlRAM	= NULL;
 static UINT16 *DrvPxlScroll	= NULL;
@@ -2009,6 +2010,13 @@ static INT32 DrvDraw()
 	return 0;
 }
 
+// after each slice, with the 68000 open
+static void DrvFrameSlice(INT32 nSlice)
+{
+	if (nSlice == 4)   SekSetIRQLine(irq_config[0], CPU_IRQSTATUS_AUTO); // Start of frame + 5000 cycles
+	if (nSlice == 199) SekSetIRQLine(irq_config[1], CPU_IRQSTATUS_AUTO); // End of frame
+}
+
 static INT32 DrvFrame()
 {
 	if (TaitoReset) {
@@ -2026,26 +2034,22 @@ static INT32 DrvFrame()
 
 	TaitoMakeInputsFunction();
 
-	SekOpen(0);
-	ZetOpen(0);
-
 	INT32 SekSpeed = (INT32)((INT64)cpu_speed[0] * nBurnCPUSpeedAdjust / 0x100);
 	INT32 ZetSpeed = (INT32)((INT64)cpu_speed[1] * nBurnCPUSpeedAdjust / 0x100);
 
 	INT32 nInterleave = 200;	// high so that ym2203 sounds are good, 200 is perfect for irq #0
 	INT32 nCyclesTotal[2] = { SekSpeed / 60, ZetSpeed / 60 };
-	INT32 nCyclesDone[2] = { 0, 0 };
-	INT32 nNext[2] = { 0, 0 };
-
-	for (INT32 i = 0; i < nInterleave; i++) {
-		nNext[0] += nCyclesTotal[0] / nInterleave;
-		nCyclesDone[0] += SekRun(nNext[0] - nCyclesDone[0]);
-		if (i == 4)                     SekSetIRQLine(irq_config[0], CPU_IRQSTATUS_AUTO); // Start of frame + 5000 cycles
-		if (i == (nInterleave / 1) - 1) SekSetIRQLine(irq_config[1], CPU_IRQSTATUS_AUTO); // End of frame
-		nNext[1] += nCyclesTotal[1] / nInterleave;
-		BurnTimerUpdate(nNext[1]);
-		nCyclesDone[1] += nNext[1];
-	}
+
+	// the slices are whole cycles, the z80's remainder runs in BurnTimerEndFrame()
+	BurnSchedCpu Cpus[2] = {
+		BURN_SCHED_SEK(0, nCyclesTotal[0] / nInterleave * nInterleave),
+		BURN_SCHED_ZET_TIMER(0, nCyclesTotal[1] / nInterleave * nInterleave)
+	};
+	Cpus[0].slice = DrvFrameSlice;
+
+	BurnSchedRun(Cpus, 2, nInterleave, NULL);
+
+	ZetOpen(0);
 
 	BurnTimerEndFrame(nCyclesTotal[1]);
 
@@ -2059,7 +2063,6 @@ static INT32 DrvFrame()
 	}
 
 	ZetClose();
-	SekClose();
 	
 	if (pBurnDraw) {
 		DrvDraw();
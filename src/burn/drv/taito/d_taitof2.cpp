@@ -8,6 +8,7 @@
 #include "burn_ym2610.h"
 #include "burn_ym2203.h"
 #include "msm6295.h"
+#include "burn_sched.h"
 
 static INT32 Footchmp;
 static INT32 YesnoDip;
@@ -10723,34 +10724,23 @@ static INT32 TaitoF2Frame()
 		}
 	}
 	
-	nTaitoCyclesDone[0] = nTaitoCyclesDone[1] = 0;
+	// the 68000 stops 500 cycles short of the frame end for the two vblank irqs
+	BurnSchedCpu Cpus[2] = {
+		BURN_SCHED_SEK(0, nTaitoCyclesTotal[0] - 500),
+		BURN_SCHED_ZET_TIMER(0, nTaitoCyclesTotal[1] / nInterleave * nInterleave)
+	};
 
 	SekNewFrame();
 	ZetNewFrame();
-		
-	for (INT32 i = 0; i < nInterleave; i++) {
-		INT32 nCurrentCPU, nNext;
-
-		// Run 68000 #1
-		nCurrentCPU = 0;
-		SekOpen(0);
-		nNext = (i + 1) * nTaitoCyclesTotal[nCurrentCPU] / nInterleave;
-		nTaitoCyclesSegment = nNext - nTaitoCyclesDone[nCurrentCPU];
-		if (i == (nInterleave - 1)) nTaitoCyclesSegment -= 500;
-		nTaitoCyclesDone[nCurrentCPU] += SekRun(nTaitoCyclesSegment);
-		if (i == (nInterleave - 1)) {
-			SekSetIRQLine(5, CPU_IRQSTATUS_AUTO);
-			nTaitoCyclesDone[nCurrentCPU] += SekRun(500);
-			SekSetIRQLine(6, CPU_IRQSTATUS_AUTO);
-		} 
-		SekClose();
-		
-		nCurrentCPU = 1;
-		ZetOpen(0);
-		BurnTimerUpdate((i + 1) * (nTaitoCyclesTotal[1] / nInterleave));
-		ZetClose();
-	}
-	
+
+	BurnSchedRun(Cpus, 2, nInterleave, NULL);
+
+	SekOpen(0);
+	SekSetIRQLine(5, CPU_IRQSTATUS_AUTO);
+	SekRun(500);
+	SekSetIRQLine(6, CPU_IRQSTATUS_AUTO);
+	SekClose();
+
 	ZetOpen(0);
 	BurnTimerEndFrame(nTaitoCyclesTotal[1]);
 	if (pBurnSoundOut) {
@@ -10785,37 +10775,22 @@ static INT32 DriveoutFrame()
 		}
 	}
 	
-	nTaitoCyclesDone[0] = nTaitoCyclesDone[1] = 0;
+	// the 68000 stops 500 cycles short of the frame end for the two vblank irqs
+	BurnSchedCpu Cpus[2] = {
+		BURN_SCHED_SEK(0, nTaitoCyclesTotal[0] - 500),
+		BURN_SCHED_ZET(0, nTaitoCyclesTotal[1])
+	};
 
 	SekNewFrame();
 	ZetNewFrame();
-		
-	for (INT32 i = 0; i < nInterleave; i++) {
-		INT32 nCurrentCPU, nNext;
-
-		// Run 68000 #1
-		nCurrentCPU = 0;
-		SekOpen(0);
-		nNext = (i + 1) * nTaitoCyclesTotal[nCurrentCPU] / nInterleave;
-		nTaitoCyclesSegment = nNext - nTaitoCyclesDone[nCurrentCPU];
-		if (i == 9) nTaitoCyclesSegment -= 500;
-		nTaitoCyclesDone[nCurrentCPU] += SekRun(nTaitoCyclesSegment);
-		if (i == 9) {
-			SekSetIRQLine(5, CPU_IRQSTATUS_AUTO);
-			nTaitoCyclesDone[nCurrentCPU] += SekRun(500);
-			SekSetIRQLine(6, CPU_IRQSTATUS_AUTO);
-		} 
-		SekClose();
-		
-		// Run Z80
-		nCurrentCPU = 1;
-		ZetOpen(0);
-		nNext = (i + 1) * nTaitoCyclesTotal[nCurrentCPU] / nInterleave;
-		nTaitoCyclesSegment = nNext - nTaitoCyclesDone[nCurrentCPU];
-		nTaitoCyclesSegment = ZetRun(nTaitoCyclesSegment);
-		nTaitoCyclesDone[nCurrentCPU] += nTaitoCyclesSegment;
-		ZetClose();
-	}
+
+	BurnSchedRun(Cpus, 2, nInterleave, NULL);
+
+	SekOpen(0);
+	SekSetIRQLine(5, CPU_IRQSTATUS_AUTO);
+	SekRun(500);
+	SekSetIRQLine(6, CPU_IRQSTATUS_AUTO);
+	SekClose();
 	
 	// Make sure the buffer is entirely filled.
 	if (pBurnSoundOut) {
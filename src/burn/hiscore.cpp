@@ -36,7 +36,7 @@ static INT32 HiscoresInUse;
 static INT32 WriteCheck1;
 
 static INT32 nCpuType;
-extern INT32 nSekCount;
+extern BURN_THREAD INT32 nSekCount;
 
 static void set_cpu_type()
 {
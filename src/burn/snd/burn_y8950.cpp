@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_y8950.h"
+#include "burn_resample.h"
 #include "m68000_intf.h"
 #include "z80_intf.h"
 #include "m6809_intf.h"
@@ -293,7 +294,6 @@ static INT16* pY8950Buffer[MAX_Y8950];
 
 static INT32 nY8950Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 nNumChips = 0;
@@ -303,6 +303,9 @@ static INT32 bY8950AddSignal;
 static double Y8950Volumes[1 * MAX_Y8950];
 static INT32 Y8950RouteDirs[1 * MAX_Y8950];
 
+static struct BurnResampler Y8950Resampler;
+static INT32 nY8950MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -343,95 +346,62 @@ static void Y8950Render(INT32 nSegmentLength)
 // ----------------------------------------------------------------------------
 // Update the sound buffer
 
-static void Y8950UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+// route the samples the chips rendered since the last update to the resampler
+static void Y8950MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nY8950MixPosition;
+
+	if (nLength <= 0) {
+		return;
+	}
+
+	INT32* pMix = BurnResampleInput(&Y8950Resampler, nLength);
+
+	for (INT32 i = 0; i < nNumChips; i++) {
+		BurnResampleMixRoute(pMix, pBuffer + i * 4096 + 4 + nY8950MixPosition, nLength, Y8950Volumes[i + BURN_SND_Y8950_ROUTE], Y8950RouteDirs[i + BURN_SND_Y8950_ROUTE]);
+	}
+
+	nY8950MixPosition = nSamplesEnd;
+}
+
+static void Y8950UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_Y8950Initted) bprintf(PRINT_ERROR, _T("Y8950UpdateResample called without init\n"));
+	if (!DebugSnd_Y8950Initted) bprintf(PRINT_ERROR, _T("Y8950UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnY8950SoundRate / nBurnSoundRate + 1;
 
+	if (nSegmentLength > nBurnSoundLen) {
+		nSegmentLength = nBurnSoundLen;
+	}
+	nSegmentLength -= nFractionalPosition;
+
+	INT32 nSamplesNeeded = nY8950MixPosition + BurnResampleNeeded(&Y8950Resampler, nSegmentLength);
 
 	if (nSamplesNeeded < nY8950Position) {
 		nSamplesNeeded = nY8950Position;
 	}
-
-	if (nSegmentLength > nBurnSoundLen) {
-		nSegmentLength = nBurnSoundLen;
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
-	nSegmentLength <<= 1;
 
 	Y8950Render(nSamplesNeeded);
-	
-	pY8950Buffer[0] = pBuffer + 0 * 4096 + 4;
-	
-	if (nNumChips > 1) {
-		pY8950Buffer[1] = pBuffer + 1 * 4096 + 4;
-	}
-	
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if ((Y8950RouteDirs[BURN_SND_Y8950_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 3] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-			nLeftSample[1] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 2] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-			nLeftSample[2] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 1] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-			nLeftSample[3] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 0] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-		}
-		if ((Y8950RouteDirs[BURN_SND_Y8950_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 3] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-			nRightSample[1] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 2] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-			nRightSample[2] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 1] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-			nRightSample[3] += (INT32)(pY8950Buffer[0][(nFractionalPosition >> 16) - 0] * Y8950Volumes[BURN_SND_Y8950_ROUTE]);
-		}
-		
-		if (nNumChips > 1) {
-			if ((Y8950RouteDirs[1 + BURN_SND_Y8950_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample[0] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 3] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-				nLeftSample[1] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 2] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-				nLeftSample[2] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 1] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-				nLeftSample[3] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 0] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-			}
-			if ((Y8950RouteDirs[1 + BURN_SND_Y8950_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample[0] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 3] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-				nRightSample[1] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 2] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-				nRightSample[2] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 1] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-				nRightSample[3] += (INT32)(pY8950Buffer[1][(nFractionalPosition >> 16) - 0] * Y8950Volumes[1 + BURN_SND_Y8950_ROUTE]);
-			}
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3]);
-		nTotalRightSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3]);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bY8950AddSignal) {
-			pSoundBuf[i + 0] += nTotalLeftSample;
-			pSoundBuf[i + 1] += nTotalRightSample;
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
+	Y8950MixPolyphase(nSamplesNeeded);
+
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&Y8950Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bY8950AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
 
 	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&Y8950Resampler);
 
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pY8950Buffer[0][i] = pY8950Buffer[0][(nFractionalPosition >> 16) + i];
-			
-			if (nNumChips > 1) {
-				pY8950Buffer[1][i] = pY8950Buffer[1][(nFractionalPosition >> 16) + i];
-			}
-		}
-
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
 		nY8950Position = nExtraSamples;
+		nY8950MixPosition = nExtraSamples;
 	}
 }
 
@@ -532,6 +502,8 @@ void BurnY8950Reset()
 	for (INT32 i = 0; i < nNumChips; i++) {
 		Y8950ResetChip(i);
 	}
+
+	BurnResampleReset(&Y8950Resampler);
 }
 
 void BurnY8950Exit()
@@ -545,6 +517,8 @@ void BurnY8950Exit()
 
 	Y8950Shutdown();
 
+	BurnResampleExit(&Y8950Resampler);
+
 	BurnTimerExitY8950();
 
 	BurnFree(pBuffer);
@@ -570,18 +544,15 @@ INT32 BurnY8950Init(INT32 num, INT32 nClockFrequency, UINT8* Y8950ADPCM0ROM, INT
 
 	BurnY8950StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set Y8950 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the Y8950 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnY8950SoundRate = nClockFrequency / 72;
-		// Bring Y8950 core samplerate within usable range
 		while (nBurnY8950SoundRate > nBurnSoundRate * 3) {
 			nBurnY8950SoundRate >>= 1;
 		}
 
-		BurnY8950Update = Y8950UpdateResample;
-
-		nSampleSize = (UINT32)nBurnY8950SoundRate * (1 << 16) / nBurnSoundRate;
-		nFractionalPosition = 0;
+		BurnResampleInit(&Y8950Resampler, nBurnY8950SoundRate, nBurnSoundRate);
+		BurnY8950Update = Y8950UpdatePolyphase;
 	} else {
 		nBurnY8950SoundRate = nBurnSoundRate;
 
@@ -604,6 +575,7 @@ INT32 BurnY8950Init(INT32 num, INT32 nClockFrequency, UINT8* Y8950ADPCM0ROM, INT
 	memset(pBuffer, 0, 4096 * num * sizeof(INT16));
 
 	nY8950Position = 0;
+	nY8950MixPosition = 0;
 
 	nFractionalPosition = 0;
 	
@@ -653,6 +625,11 @@ void BurnY8950Scan(INT32 nAction, INT32* pnMin)
 	
 	if (nAction & ACB_DRIVER_DATA) {
 		SCAN_VAR(nY8950Position);
+
+		if ((nAction & ACB_WRITE) && BurnY8950Update == Y8950UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nY8950Position = nY8950MixPosition;
+		}
 	}
 }
 
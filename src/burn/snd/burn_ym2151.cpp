@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym2151.h"
+#include "burn_resample.h"
 
 void (*BurnYM2151Render)(INT16* pSoundBuf, INT32 nSegmentLength);
 
@@ -13,94 +14,37 @@ static INT16* pBuffer;
 static INT16* pYM2151Buffer[2];
 
 static INT32 nBurnPosition;
-static UINT32 nSampleSize;
-static UINT32 nFractionalPosition;
-static UINT32 nSamplesRendered;
 
 static double YM2151Volumes[2];
 static INT32 YM2151RouteDirs[2];
 
-static void YM2151RenderResample(INT16* pSoundBuf, INT32 nSegmentLength)
+static struct BurnResampler YM2151Resampler;
+
+static void YM2151RenderPolyphase(INT16* pSoundBuf, INT32 nSegmentLength)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM2151Initted) bprintf(PRINT_ERROR, _T("YM2151RenderResample called without init\n"));
+	if (!DebugSnd_YM2151Initted) bprintf(PRINT_ERROR, _T("YM2151RenderPolyphase called without init\n"));
 #endif
-	
-	nBurnPosition += nSegmentLength;
-
-	if (nBurnPosition >= nBurnSoundRate) {
-		nBurnPosition = nSegmentLength;
-
-		pYM2151Buffer[0][1] = pYM2151Buffer[0][(nFractionalPosition >> 16) - 3];
-		pYM2151Buffer[0][2] = pYM2151Buffer[0][(nFractionalPosition >> 16) - 2];
-		pYM2151Buffer[0][3] = pYM2151Buffer[0][(nFractionalPosition >> 16) - 1];
-
-		pYM2151Buffer[1][1] = pYM2151Buffer[1][(nFractionalPosition >> 16) - 3];
-		pYM2151Buffer[1][2] = pYM2151Buffer[1][(nFractionalPosition >> 16) - 2];
-		pYM2151Buffer[1][3] = pYM2151Buffer[1][(nFractionalPosition >> 16) - 1];
-
-		nSamplesRendered -= (nFractionalPosition >> 16) - 4;
 
-		for (UINT32 i = 0; i <= nSamplesRendered; i++) {
-			pYM2151Buffer[0][4 + i] = pYM2151Buffer[0][(nFractionalPosition >> 16) + i];
-			pYM2151Buffer[1][4 + i] = pYM2151Buffer[1][(nFractionalPosition >> 16) + i];
-		}
+	nBurnPosition += nSegmentLength;
 
-		nFractionalPosition &= 0x0000FFFF;
-		nFractionalPosition |= 4 << 16;
+	INT32 nSamplesNeeded = BurnResampleNeeded(&YM2151Resampler, nSegmentLength);
+	if (nSamplesNeeded > 65536) {
+		nSamplesNeeded = 65536;
 	}
 
-	pYM2151Buffer[0] = pBuffer + 4 + nSamplesRendered;
-	pYM2151Buffer[1] = pBuffer + 4 + nSamplesRendered + 65536;
+	if (nSamplesNeeded > 0) {
+		pYM2151Buffer[0] = pBuffer;
+		pYM2151Buffer[1] = pBuffer + 65536;
 
-	YM2151UpdateOne(0, pYM2151Buffer, (UINT32)(nBurnPosition + 1) * nBurnYM2151SoundRate / nBurnSoundRate - nSamplesRendered);
-	nSamplesRendered += (UINT32)(nBurnPosition + 1) * nBurnYM2151SoundRate / nBurnSoundRate - nSamplesRendered;
-
-	pYM2151Buffer[0] = pBuffer;
-	pYM2151Buffer[1] = pBuffer + 65536;
+		YM2151UpdateOne(0, pYM2151Buffer, nSamplesNeeded);
 
-	nSegmentLength <<= 1;
-	
-	for (INT32 i = 0; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if ((YM2151RouteDirs[BURN_SND_YM2151_YM2151_ROUTE_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 3] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-			nLeftSample[1] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 2] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-			nLeftSample[2] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 1] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-			nLeftSample[3] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 0] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-		}
-		if ((YM2151RouteDirs[BURN_SND_YM2151_YM2151_ROUTE_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 3] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-			nRightSample[1] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 2] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-			nRightSample[2] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 1] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-			nRightSample[3] += (INT32)(pYM2151Buffer[0][(nFractionalPosition >> 16) - 0] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1]);
-		}
-		
-		if ((YM2151RouteDirs[BURN_SND_YM2151_YM2151_ROUTE_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 3] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-			nLeftSample[1] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 2] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-			nLeftSample[2] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 1] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-			nLeftSample[3] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 0] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-		}
-		if ((YM2151RouteDirs[BURN_SND_YM2151_YM2151_ROUTE_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 3] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-			nRightSample[1] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 2] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-			nRightSample[2] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 1] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-			nRightSample[3] += (INT32)(pYM2151Buffer[1][(nFractionalPosition >> 16) - 0] * YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2]);
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_CUSTOM((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3], 16384.0);
-		nTotalRightSample = INTERPOLATE4PS_CUSTOM((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3], 16384.0);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		pSoundBuf[i + 0] = nTotalLeftSample;
-		pSoundBuf[i + 1] = nTotalRightSample;
+		INT32* pMix = BurnResampleInput(&YM2151Resampler, nSamplesNeeded);
+		BurnResampleMixRoute(pMix, pYM2151Buffer[0], nSamplesNeeded, YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_1], YM2151RouteDirs[BURN_SND_YM2151_YM2151_ROUTE_1]);
+		BurnResampleMixRoute(pMix, pYM2151Buffer[1], nSamplesNeeded, YM2151Volumes[BURN_SND_YM2151_YM2151_ROUTE_2], YM2151RouteDirs[BURN_SND_YM2151_YM2151_ROUTE_2]);
 	}
+
+	BurnResampleRender(&YM2151Resampler, pSoundBuf, nSegmentLength, 0);
 }
 
 static void YM2151RenderNormal(INT16* pSoundBuf, INT32 nSegmentLength)
@@ -149,6 +93,8 @@ void BurnYM2151Reset()
 
 	memset(&BurnYM2151Registers, 0, sizeof(BurnYM2151Registers));
 	YM2151ResetChip(0);
+
+	BurnResampleReset(&YM2151Resampler);
 }
 
 void BurnYM2151Exit()
@@ -164,6 +110,8 @@ void BurnYM2151Exit()
 
 	YM2151Shutdown();
 
+	BurnResampleExit(&YM2151Resampler);
+
 	if (pBuffer) {
 		free(pBuffer);
 		pBuffer = NULL;
@@ -181,15 +129,15 @@ INT32 BurnYM2151Init(INT32 nClockFrequency)
 		return 0;
 	}
 
-	if (nFMInterpolation == 3) {
-		// Set YM2151 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM2151 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM2151SoundRate = nClockFrequency >> 6;
-		// Bring YM2151 core samplerate within usable range
 		while (nBurnYM2151SoundRate > nBurnSoundRate * 3) {
 			nBurnYM2151SoundRate >>= 1;
 		}
 
-		BurnYM2151Render = YM2151RenderResample;
+		BurnResampleInit(&YM2151Resampler, nBurnYM2151SoundRate, nBurnSoundRate);
+		BurnYM2151Render = YM2151RenderPolyphase;
 	} else {
 		nBurnYM2151SoundRate = nBurnSoundRate;
 		BurnYM2151Render = YM2151RenderNormal;
@@ -200,9 +148,6 @@ INT32 BurnYM2151Init(INT32 nClockFrequency)
 	pBuffer = (INT16*)malloc(65536 * 2 * sizeof(INT16));
 	memset(pBuffer, 0, 65536 * 2 * sizeof(INT16));
 
-	nSampleSize = (UINT32)nBurnYM2151SoundRate * (1 << 16) / nBurnSoundRate;
-	nFractionalPosition = 4 << 16;
-	nSamplesRendered = 0;
 	nBurnPosition = 0;
 	memset(&BurnYM2151Registers, 0, sizeof(BurnYM2151Registers));
 	
@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym2203.h"
+#include "burn_resample.h"
 
 #define MAX_YM2203	3
 
@@ -16,7 +17,6 @@ static INT16* pYM2203Buffer[4 * MAX_YM2203];
 static INT32 nYM2203Position;
 static INT32 nAY8910Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 nNumChips = 0;
@@ -31,6 +31,9 @@ static double YM2203RightVolumes[4 * MAX_YM2203];
 
 INT32 bYM2203UseSeperateVolumes; // support custom Taito panning hardware
 
+static struct BurnResampler YM2203Resampler;
+static INT32 nYM2203MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -118,42 +121,45 @@ static void YM2203Render(INT32 nSegmentLength)
 // ----------------------------------------------------------------------------
 // Update the sound buffer
 
-#define INTERPOLATE_ADD_SOUND_LEFT(route, buffer)																	\
-	if ((YM2203RouteDirs[route] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {									\
-		nLeftSample[0] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 3] * YM2203Volumes[route]);	\
-		nLeftSample[1] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 2] * YM2203Volumes[route]);	\
-		nLeftSample[2] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 1] * YM2203Volumes[route]);	\
-		nLeftSample[3] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 0] * YM2203Volumes[route]);	\
+// route the samples the chips rendered since the last update to the resampler
+static void YM2203MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nYM2203MixPosition;
+
+	if (nLength <= 0) {
+		return;
 	}
 
-#define INTERPOLATE_ADD_SOUND_RIGHT(route, buffer)																	\
-	if ((YM2203RouteDirs[route] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {									\
-		nRightSample[0] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 3] * YM2203Volumes[route]);	\
-		nRightSample[1] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 2] * YM2203Volumes[route]);	\
-		nRightSample[2] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 1] * YM2203Volumes[route]);	\
-		nRightSample[3] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 0] * YM2203Volumes[route]);	\
+	INT32* pMix = BurnResampleInput(&YM2203Resampler, nLength);
+
+	// buffer n of a chip holds its route n, the YM2203 then the three AY8910 channels
+	for (INT32 i = 0; i < nNumChips * 4; i++) {
+		INT16* pSrc = pBuffer + i * 4096 + 4 + nYM2203MixPosition;
+
+		if (bYM2203UseSeperateVolumes) {
+			BurnResampleMixPan(pMix, pSrc, nLength, YM2203LeftVolumes[i], YM2203RightVolumes[i]);
+		} else {
+			BurnResampleMixRoute(pMix, pSrc, nLength, YM2203Volumes[i], YM2203RouteDirs[i]);
+		}
 	}
-	
-#define SPLIT_INTERPOLATE_ADD_SOUND_LEFT(route, buffer)																\
-	nLeftSample[0] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 3] * YM2203LeftVolumes[route]);	\
-	nLeftSample[1] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 2] * YM2203LeftVolumes[route]);	\
-	nLeftSample[2] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 1] * YM2203LeftVolumes[route]);	\
-	nLeftSample[3] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 0] * YM2203LeftVolumes[route]);
-	
-#define SPLIT_INTERPOLATE_ADD_SOUND_RIGHT(route, buffer)																\
-	nRightSample[0] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 3] * YM2203RightVolumes[route]);	\
-	nRightSample[1] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 2] * YM2203RightVolumes[route]);	\
-	nRightSample[2] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 1] * YM2203RightVolumes[route]);	\
-	nRightSample[3] += (INT32)(pYM2203Buffer[buffer][(nFractionalPosition >> 16) - 0] * YM2203RightVolumes[route]);
 
-static void YM2203UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+	nYM2203MixPosition = nSamplesEnd;
+}
+
+static void YM2203UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM2203Initted) bprintf(PRINT_ERROR, _T("YM2203UpdateResample called without init\n"));
+	if (!DebugSnd_YM2203Initted) bprintf(PRINT_ERROR, _T("YM2203UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnYM2203SoundRate / nBurnSoundRate + 1;
+
+	if (nSegmentLength > nBurnSoundLen) {
+		nSegmentLength = nBurnSoundLen;
+	}
+	nSegmentLength -= nFractionalPosition;
+
+	INT32 nSamplesNeeded = nYM2203MixPosition + BurnResampleNeeded(&YM2203Resampler, nSegmentLength);
 
 	if (nSamplesNeeded < nAY8910Position) {
 		nSamplesNeeded = nAY8910Position;
@@ -161,152 +167,28 @@ static void YM2203UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
 	if (nSamplesNeeded < nYM2203Position) {
 		nSamplesNeeded = nYM2203Position;
 	}
-
-	if (nSegmentLength > nBurnSoundLen) {
-		nSegmentLength = nBurnSoundLen;
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
-	nSegmentLength <<= 1;
 
 	YM2203Render(nSamplesNeeded);
 	AY8910Render(nSamplesNeeded);
+	YM2203MixPolyphase(nSamplesNeeded);
 
-	pYM2203Buffer[0] = pBuffer + 0 * 4096 + 4;
-	pYM2203Buffer[1] = pBuffer + 1 * 4096 + 4;
-	pYM2203Buffer[2] = pBuffer + 2 * 4096 + 4;
-	pYM2203Buffer[3] = pBuffer + 3 * 4096 + 4;
-	
-	if (nNumChips > 1) {
-		pYM2203Buffer[4] = pBuffer + 4 * 4096 + 4;
-		pYM2203Buffer[5] = pBuffer + 5 * 4096 + 4;
-		pYM2203Buffer[6] = pBuffer + 6 * 4096 + 4;
-		pYM2203Buffer[7] = pBuffer + 7 * 4096 + 4;
-	}
-	
-	if (nNumChips > 2) {
-		pYM2203Buffer[8] = pBuffer + 8 * 4096 + 4;
-		pYM2203Buffer[9] = pBuffer + 9 * 4096 + 4;
-		pYM2203Buffer[10] = pBuffer + 10 * 4096 + 4;
-		pYM2203Buffer[11] = pBuffer + 11 * 4096 + 4;
-	}
-
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if (bYM2203UseSeperateVolumes) {
-			SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_AY8910_ROUTE_1, 1)
-			SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_AY8910_ROUTE_2, 2)
-			SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_AY8910_ROUTE_3, 3)
-			SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_YM2203_ROUTE  , 0)
-			
-			SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_AY8910_ROUTE_1, 1)
-			SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_AY8910_ROUTE_2, 2)
-			SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_AY8910_ROUTE_3, 3)
-			SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_YM2203_ROUTE  , 0)
-			
-			if (nNumChips > 1) {
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_AY8910_ROUTE_1, 5)
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_AY8910_ROUTE_2, 6)
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_AY8910_ROUTE_3, 7)
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_YM2203_ROUTE  , 4)
-			
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_AY8910_ROUTE_1, 5)
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_AY8910_ROUTE_2, 6)
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_AY8910_ROUTE_3, 7)
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_YM2203_ROUTE  , 4)
-			}
-			
-			if (nNumChips > 2) {
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_AY8910_ROUTE_1, 9)
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_AY8910_ROUTE_2, 10)
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_AY8910_ROUTE_3, 11)
-				SPLIT_INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_YM2203_ROUTE  , 8)
-			
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_AY8910_ROUTE_1, 9)
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_AY8910_ROUTE_2, 10)
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_AY8910_ROUTE_3, 11)
-				SPLIT_INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_YM2203_ROUTE  , 8)
-			}
-		} else {		
-			INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_AY8910_ROUTE_1, 1)
-			INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_AY8910_ROUTE_1, 1)
-			INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_AY8910_ROUTE_2, 2)
-			INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_AY8910_ROUTE_2, 2)
-			INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_AY8910_ROUTE_3, 3)
-			INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_AY8910_ROUTE_3, 3)
-			INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2203_YM2203_ROUTE  , 0)
-			INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2203_YM2203_ROUTE  , 0)
-		
-			if (nNumChips > 1) {
-				INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_AY8910_ROUTE_1, 5)
-				INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_AY8910_ROUTE_1, 5)
-				INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_AY8910_ROUTE_2, 6)
-				INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_AY8910_ROUTE_2, 6)
-				INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_AY8910_ROUTE_3, 7)
-				INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_AY8910_ROUTE_3, 7)
-				INTERPOLATE_ADD_SOUND_LEFT  (4 + BURN_SND_YM2203_YM2203_ROUTE  , 4)
-				INTERPOLATE_ADD_SOUND_RIGHT (4 + BURN_SND_YM2203_YM2203_ROUTE  , 4)
-			}
-			
-			if (nNumChips > 2) {
-				INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_AY8910_ROUTE_1, 9)
-				INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_AY8910_ROUTE_1, 9)
-				INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_AY8910_ROUTE_2, 10)
-				INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_AY8910_ROUTE_2, 10)
-				INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_AY8910_ROUTE_3, 11)
-				INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_AY8910_ROUTE_3, 11)
-				INTERPOLATE_ADD_SOUND_LEFT  (8 + BURN_SND_YM2203_YM2203_ROUTE  , 8)
-				INTERPOLATE_ADD_SOUND_RIGHT (8 + BURN_SND_YM2203_YM2203_ROUTE  , 8)
-			}
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_CUSTOM((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3], 16384.0);
-		nTotalRightSample = INTERPOLATE4PS_CUSTOM((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3], 16384.0);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bYM2203AddSignal) {
-			//pSoundBuf[i + 0] += nTotalLeftSample;
-			//pSoundBuf[i + 1] += nTotalRightSample;
-			pSoundBuf[i + 0] = BURN_SND_CLIP(pSoundBuf[i + 0] + nTotalLeftSample);
-			pSoundBuf[i + 1] = BURN_SND_CLIP(pSoundBuf[i + 1] + nTotalRightSample);
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
-		
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&YM2203Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bYM2203AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
 
 	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
-
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pYM2203Buffer[0][i] = pYM2203Buffer[0][(nFractionalPosition >> 16) + i];
-			pYM2203Buffer[1][i] = pYM2203Buffer[1][(nFractionalPosition >> 16) + i];
-			pYM2203Buffer[2][i] = pYM2203Buffer[2][(nFractionalPosition >> 16) + i];
-			pYM2203Buffer[3][i] = pYM2203Buffer[3][(nFractionalPosition >> 16) + i];
-			
-			if (nNumChips > 1) {
-				pYM2203Buffer[4][i] = pYM2203Buffer[4][(nFractionalPosition >> 16) + i];
-				pYM2203Buffer[5][i] = pYM2203Buffer[5][(nFractionalPosition >> 16) + i];
-				pYM2203Buffer[6][i] = pYM2203Buffer[6][(nFractionalPosition >> 16) + i];
-				pYM2203Buffer[7][i] = pYM2203Buffer[7][(nFractionalPosition >> 16) + i];
-			}
-			
-			if (nNumChips > 2) {
-				pYM2203Buffer[8][i] = pYM2203Buffer[8][(nFractionalPosition >> 16) + i];
-				pYM2203Buffer[9][i] = pYM2203Buffer[9][(nFractionalPosition >> 16) + i];
-				pYM2203Buffer[10][i] = pYM2203Buffer[10][(nFractionalPosition >> 16) + i];
-				pYM2203Buffer[11][i] = pYM2203Buffer[11][(nFractionalPosition >> 16) + i];
-			}
-		}
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&YM2203Resampler);
 
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
 		nYM2203Position = nExtraSamples;
 		nAY8910Position = nExtraSamples;
+		nYM2203MixPosition = nExtraSamples;
 
 		dTime += 100.0 / nBurnFPS;
 	}
@@ -562,6 +444,8 @@ void BurnYM2203Reset()
 		YM2203ResetChip(i);
 		AY8910Reset(i);
 	}
+
+	BurnResampleReset(&YM2203Resampler);
 }
 
 void BurnYM2203Exit()
@@ -578,6 +462,8 @@ void BurnYM2203Exit()
 		AY8910Exit(i);
 	}
 
+	BurnResampleExit(&YM2203Resampler);
+
 	BurnTimerExit();
 
 	if (pBuffer) {
@@ -613,10 +499,9 @@ INT32 BurnYM2203Init(INT32 num, INT32 nClockFrequency, FM_IRQHANDLER IRQCallback
 
 	BurnYM2203StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set YM2203 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM2203 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM2203SoundRate = nClockFrequency >> 6;
-		// Bring YM2203 core samplerate within usable range
 		while (nBurnYM2203SoundRate > nBurnSoundRate * 3) {
 			nBurnYM2203SoundRate >>= 1;
 		}
@@ -624,10 +509,9 @@ INT32 BurnYM2203Init(INT32 num, INT32 nClockFrequency, FM_IRQHANDLER IRQCallback
 		if (nBurnYM2203SoundRate < nBurnSoundRate)
 			nBurnYM2203SoundRate = nBurnSoundRate;
 
-		BurnYM2203Update = YM2203UpdateResample;
-		nSampleSize = (UINT32)nBurnYM2203SoundRate * (1 << 16) / nBurnSoundRate;
-
-    } else {
+		BurnResampleInit(&YM2203Resampler, nBurnYM2203SoundRate, nBurnSoundRate);
+		BurnYM2203Update = YM2203UpdatePolyphase;
+	} else {
 		nBurnYM2203SoundRate = nBurnSoundRate;
 		BurnYM2203Update = YM2203UpdateNormal;
 	}
@@ -643,6 +527,7 @@ INT32 BurnYM2203Init(INT32 num, INT32 nClockFrequency, FM_IRQHANDLER IRQCallback
 
 	nYM2203Position = 0;
 	nAY8910Position = 0;
+	nYM2203MixPosition = 0;
 	nFractionalPosition = 0;
 	
 	nNumChips = num;
@@ -773,6 +658,12 @@ void BurnYM2203Scan(INT32 nAction, INT32* pnMin)
 	if (nAction & ACB_DRIVER_DATA) {
 		SCAN_VAR(nYM2203Position);
 		SCAN_VAR(nAY8910Position);
+
+		if ((nAction & ACB_WRITE) && BurnYM2203Update == YM2203UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nYM2203Position = nYM2203MixPosition;
+			nAY8910Position = nYM2203MixPosition;
+		}
 	}
 }
 
@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym2413.h"
+#include "burn_resample.h"
 
 void (*BurnYM2413Render)(INT16* pSoundBuf, INT32 nSegmentLength);
 
@@ -10,23 +11,38 @@ static INT16* pBuffer;
 static INT16* pYM2413Buffer[2];
 
 static INT32 nBurnPosition;
-static UINT32 nSampleSize;
-static INT32 nFractionalPosition;
-static UINT32 nSamplesRendered;
 
 static double YM2413Volumes[2];
 static INT32 YM2413RouteDirs[2];
 
-#if 0
-static void YM2413RenderResample(INT16* pSoundBuf, INT32 nSegmentLength)
+static struct BurnResampler YM2413Resampler;
+
+static void YM2413RenderPolyphase(INT16* pSoundBuf, INT32 nSegmentLength)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM2413Initted) bprintf(PRINT_ERROR, _T("YM2413RenderResample called without init\n"));
+	if (!DebugSnd_YM2413Initted) bprintf(PRINT_ERROR, _T("YM2413RenderPolyphase called without init\n"));
 #endif
 
-	// not currently supported (old code crashed)
+	nBurnPosition += nSegmentLength;
+
+	INT32 nSamplesNeeded = BurnResampleNeeded(&YM2413Resampler, nSegmentLength);
+	if (nSamplesNeeded > 65536) {
+		nSamplesNeeded = 65536;
+	}
+
+	if (nSamplesNeeded > 0) {
+		pYM2413Buffer[0] = pBuffer;
+		pYM2413Buffer[1] = pBuffer + 65536;
+
+		YM2413UpdateOne(0, pYM2413Buffer, nSamplesNeeded);
+
+		INT32* pMix = BurnResampleInput(&YM2413Resampler, nSamplesNeeded);
+		BurnResampleMixRoute(pMix, pYM2413Buffer[0], nSamplesNeeded, YM2413Volumes[BURN_SND_YM2413_YM2413_ROUTE_1], YM2413RouteDirs[BURN_SND_YM2413_YM2413_ROUTE_1]);
+		BurnResampleMixRoute(pMix, pYM2413Buffer[1], nSamplesNeeded, YM2413Volumes[BURN_SND_YM2413_YM2413_ROUTE_2], YM2413RouteDirs[BURN_SND_YM2413_YM2413_ROUTE_2]);
+	}
+
+	BurnResampleRender(&YM2413Resampler, pSoundBuf, nSegmentLength, 0);
 }
-#endif
 
 static void YM2413RenderNormal(INT16* pSoundBuf, INT32 nSegmentLength)
 {
@@ -73,6 +89,8 @@ void BurnYM2413Reset()
 #endif
 
 	YM2413ResetChip(0);
+
+	BurnResampleReset(&YM2413Resampler);
 }
 
 void BurnYM2413Exit()
@@ -85,6 +103,8 @@ void BurnYM2413Exit()
 
 	YM2413Shutdown();
 
+	BurnResampleExit(&YM2413Resampler);
+
 	if (pBuffer) {
 		free(pBuffer);
 		pBuffer = NULL;
@@ -102,33 +122,25 @@ INT32 BurnYM2413Init(INT32 nClockFrequency)
 		return 0;
 	}
 
-#if 0
-	if (nFMInterpolation == 3) {
-		// Set YM2413 core samplerate to match the hardware
-		nBurnYM2413SoundRate = nClockFrequency >> 6;
-		// Bring YM2413 core samplerate within usable range
+	if (nFMInterpolation >= 3) {
+		// Run the YM2413 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
+		nBurnYM2413SoundRate = nClockFrequency / 72;
 		while (nBurnYM2413SoundRate > nBurnSoundRate * 3) {
 			nBurnYM2413SoundRate >>= 1;
 		}
 
-		BurnYM2413Render = YM2413RenderResample;
+		BurnResampleInit(&YM2413Resampler, nBurnYM2413SoundRate, nBurnSoundRate);
+		BurnYM2413Render = YM2413RenderPolyphase;
 	} else {
 		nBurnYM2413SoundRate = nBurnSoundRate;
 		BurnYM2413Render = YM2413RenderNormal;
 	}
-#else
-	nBurnYM2413SoundRate = nBurnSoundRate;
-	BurnYM2413Render = YM2413RenderNormal;
-#endif
 
 	YM2413Init(1, nClockFrequency, nBurnYM2413SoundRate);
 
 	pBuffer = (INT16*)malloc(65536 * 2 * sizeof(INT16));
 	memset(pBuffer, 0, 65536 * 2 * sizeof(INT16));
 
-	nSampleSize = (UINT32)nBurnYM2413SoundRate * (1 << 16) / nBurnSoundRate;
-	nFractionalPosition = 4 << 16;
-	nSamplesRendered = 0;
 	nBurnPosition = 0;
 	
 	// default routes
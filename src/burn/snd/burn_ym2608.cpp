@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym2608.h"
+#include "burn_resample.h"
 
 void (*BurnYM2608Update)(INT16* pSoundBuf, INT32 nSegmentEnd);
 
@@ -16,7 +17,6 @@ static INT32* pAYBuffer;
 static INT32 nYM2608Position;
 static INT32 nAY8910Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 bYM2608AddSignal;
@@ -24,6 +24,9 @@ static INT32 bYM2608AddSignal;
 static double YM2608Volumes[3];
 static INT32 YM2608RouteDirs[3];
 
+static struct BurnResampler YM2608Resampler;
+static INT32 nYM2608MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -84,14 +87,46 @@ static void YM2608Render(INT32 nSegmentLength)
 // ----------------------------------------------------------------------------
 // Update the sound buffer
 
-static void YM2608UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+// route the samples the chips rendered since the last update to the resampler
+static void YM2608MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nYM2608MixPosition;
+
+	if (nLength <= 0) {
+		return;
+	}
+
+	INT16* pYMLeft = pBuffer + 0 * 4096 + 4 + nYM2608MixPosition;
+	INT16* pYMRight = pBuffer + 1 * 4096 + 4 + nYM2608MixPosition;
+	INT16* pAYSum = pBuffer + 5 * 4096 + 4 + nYM2608MixPosition;
+	for (INT32 i = 0; i < nLength; i++) {
+		INT32 j = nYM2608MixPosition + 4 + i;
+		pAYSum[i] = BURN_SND_CLIP(pBuffer[2 * 4096 + j] + pBuffer[3 * 4096 + j] + pBuffer[4 * 4096 + j]);
+	}
+
+	INT32* pMix = BurnResampleInput(&YM2608Resampler, nLength);
+
+	BurnResampleMixRoute(pMix, pAYSum, nLength, YM2608Volumes[BURN_SND_YM2608_AY8910_ROUTE], YM2608RouteDirs[BURN_SND_YM2608_AY8910_ROUTE]);
+	BurnResampleMixRoute(pMix, pYMLeft, nLength, YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1], YM2608RouteDirs[BURN_SND_YM2608_YM2608_ROUTE_1]);
+	BurnResampleMixRoute(pMix, pYMRight, nLength, YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2], YM2608RouteDirs[BURN_SND_YM2608_YM2608_ROUTE_2]);
+
+	nYM2608MixPosition = nSamplesEnd;
+}
+
+static void YM2608UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM2608Initted) bprintf(PRINT_ERROR, _T("YM2608UpdateResample called without init\n"));
+	if (!DebugSnd_YM2608Initted) bprintf(PRINT_ERROR, _T("YM2608UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnYM2608SoundRate / nBurnSoundRate + 1;
+
+	if (nSegmentLength > nBurnSoundLen) {
+		nSegmentLength = nBurnSoundLen;
+	}
+	nSegmentLength -= nFractionalPosition;
+
+	INT32 nSamplesNeeded = nYM2608MixPosition + BurnResampleNeeded(&YM2608Resampler, nSegmentLength);
 
 	if (nSamplesNeeded < nAY8910Position) {
 		nSamplesNeeded = nAY8910Position;
@@ -99,100 +134,28 @@ static void YM2608UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
 	if (nSamplesNeeded < nYM2608Position) {
 		nSamplesNeeded = nYM2608Position;
 	}
-
-	if (nSegmentLength > nBurnSoundLen) {
-		nSegmentLength = nBurnSoundLen;
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
-	nSegmentLength <<= 1;
 
 	YM2608Render(nSamplesNeeded);
 	AY8910Render(nSamplesNeeded);
+	YM2608MixPolyphase(nSamplesNeeded);
 
-	pYM2608Buffer[0] = pBuffer + 0 * 4096 + 4;
-	pYM2608Buffer[1] = pBuffer + 1 * 4096 + 4;
-	pYM2608Buffer[2] = pBuffer + 2 * 4096 + 4;
-	pYM2608Buffer[3] = pBuffer + 3 * 4096 + 4;
-	pYM2608Buffer[4] = pBuffer + 4 * 4096 + 4;
-	pYM2608Buffer[5] = pBuffer + 5 * 4096 + 4;
-
-	for (INT32 i = (nFractionalPosition >> 16) - 4; i < nSamplesNeeded; i++) {
-		pYM2608Buffer[5][i] = (INT32)((pYM2608Buffer[2][i] + pYM2608Buffer[3][i] + pYM2608Buffer[4][i]) * YM2608Volumes[BURN_SND_YM2608_AY8910_ROUTE]);
-	}
-
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if ((YM2608RouteDirs[BURN_SND_YM2608_AY8910_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 3];
-			nLeftSample[1] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 2];
-			nLeftSample[2] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 1];
-			nLeftSample[3] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 0];
-		}
-		if ((YM2608RouteDirs[BURN_SND_YM2608_AY8910_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 3];
-			nRightSample[1] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 2];
-			nRightSample[2] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 1];
-			nRightSample[3] += pYM2608Buffer[5][(nFractionalPosition >> 16) - 0];
-		}
-		
-		if ((YM2608RouteDirs[BURN_SND_YM2608_YM2608_ROUTE_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 3] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-			nLeftSample[1] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 2] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-			nLeftSample[2] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 1] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-			nLeftSample[3] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 0] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-		}
-		if ((YM2608RouteDirs[BURN_SND_YM2608_YM2608_ROUTE_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 3] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-			nRightSample[1] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 2] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-			nRightSample[2] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 1] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-			nRightSample[3] += (INT32)(pYM2608Buffer[0][(nFractionalPosition >> 16) - 0] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_1]);
-		}
-		
-		if ((YM2608RouteDirs[BURN_SND_YM2608_YM2608_ROUTE_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 3] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-			nLeftSample[1] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 2] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-			nLeftSample[2] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 1] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-			nLeftSample[3] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 0] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-		}
-		if ((YM2608RouteDirs[BURN_SND_YM2608_YM2608_ROUTE_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 3] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-			nRightSample[1] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 2] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-			nRightSample[2] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 1] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-			nRightSample[3] += (INT32)(pYM2608Buffer[1][(nFractionalPosition >> 16) - 0] * YM2608Volumes[BURN_SND_YM2608_YM2608_ROUTE_2]);
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3]);
-		nTotalRightSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3]);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bYM2608AddSignal) {
-			pSoundBuf[i + 0] += nTotalLeftSample;
-			pSoundBuf[i + 1] += nTotalRightSample;
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&YM2608Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bYM2608AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
 
 	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
-
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pYM2608Buffer[0][i] = pYM2608Buffer[0][(nFractionalPosition >> 16) + i];
-			pYM2608Buffer[1][i] = pYM2608Buffer[1][(nFractionalPosition >> 16) + i];
-			pYM2608Buffer[2][i] = pYM2608Buffer[2][(nFractionalPosition >> 16) + i];
-			pYM2608Buffer[3][i] = pYM2608Buffer[3][(nFractionalPosition >> 16) + i];
-			pYM2608Buffer[4][i] = pYM2608Buffer[4][(nFractionalPosition >> 16) + i];
-		}
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&YM2608Resampler);
 
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
-		nYM2608Position = nExtraSamples;
 		nAY8910Position = nExtraSamples;
+		nYM2608Position = nExtraSamples;
+		nYM2608MixPosition = nExtraSamples;
 
 		dTime += 100.0 / nBurnFPS;
 	}
@@ -321,6 +284,8 @@ void BurnYM2608Reset()
 	BurnTimerReset();
 
 	YM2608ResetChip(0);
+
+	BurnResampleReset(&YM2608Resampler);
 }
 
 void BurnYM2608Exit()
@@ -334,6 +299,8 @@ void BurnYM2608Exit()
 	YM2608Shutdown();
 	AY8910Exit(0);
 
+	BurnResampleExit(&YM2608Resampler);
+
 	BurnTimerExit();
 
 	if (pBuffer) {
@@ -368,18 +335,15 @@ INT32 BurnYM2608Init(INT32 nClockFrequency, UINT8* YM2608ADPCMROM, INT32* nYM260
 
 	BurnYM2608StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set YM2608 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM2608 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM2608SoundRate = nClockFrequency / 144;
-		// Bring YM2608 core samplerate within usable range
 		while (nBurnYM2608SoundRate > nBurnSoundRate * 3) {
 			nBurnYM2608SoundRate >>= 1;
 		}
 
-		BurnYM2608Update = YM2608UpdateResample;
-
-		nSampleSize = (UINT32)nBurnYM2608SoundRate * (1 << 16) / nBurnSoundRate;
-		nFractionalPosition = 0;
+		BurnResampleInit(&YM2608Resampler, nBurnYM2608SoundRate, nBurnSoundRate);
+		BurnYM2608Update = YM2608UpdatePolyphase;
 	} else {
 		nBurnYM2608SoundRate = nBurnSoundRate;
 
@@ -397,7 +361,9 @@ INT32 BurnYM2608Init(INT32 nClockFrequency, UINT8* YM2608ADPCMROM, INT32* nYM260
 
 	nYM2608Position = 0;
 	nAY8910Position = 0;
-	
+	nYM2608MixPosition = 0;
+
+	nFractionalPosition = 0;
 	bYM2608AddSignal = bAddSignal;
 	
 	// default routes
@@ -434,5 +400,11 @@ void BurnYM2608Scan(INT32 nAction, INT32* pnMin)
 	if (nAction & ACB_DRIVER_DATA) {
 		SCAN_VAR(nYM2608Position);
 		SCAN_VAR(nAY8910Position);
+
+		if ((nAction & ACB_WRITE) && BurnYM2608Update == YM2608UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nYM2608Position = nYM2608MixPosition;
+			nAY8910Position = nYM2608MixPosition;
+		}
 	}
 }
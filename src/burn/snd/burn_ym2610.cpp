@@ -1,6 +1,8 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym2610.h"
+#include "burn_resample.h"
+#include "burn_prof.h"
 
 void (*BurnYM2610Update)(INT16* pSoundBuf, INT32 nSegmentEnd);
 
@@ -16,7 +18,6 @@ static INT32* pAYBuffer;
 static INT32 nYM2610Position;
 static INT32 nAY8910Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 bYM2610AddSignal;
@@ -29,6 +30,9 @@ static double YM2610RightVolumes[3];
 
 INT32 bYM2610UseSeperateVolumes; // support custom Taito panning hardware
 
+static struct BurnResampler YM2610Resampler;
+static INT32 nYM2610MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -89,14 +93,54 @@ static void YM2610Render(INT32 nSegmentLength)
 // ----------------------------------------------------------------------------
 // Update the sound buffer
 
-static void YM2610UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+// route the samples the chips rendered since the last update to the resampler
+static void YM2610MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nYM2610MixPosition;
+
+	if (nLength <= 0) {
+		return;
+	}
+
+	INT16* pYMLeft = pBuffer + 0 * 4096 + 4 + nYM2610MixPosition;
+	INT16* pYMRight = pBuffer + 1 * 4096 + 4 + nYM2610MixPosition;
+	INT16* pAYSum = pBuffer + 5 * 4096 + 4 + nYM2610MixPosition;
+	for (INT32 i = 0; i < nLength; i++) {
+		INT32 j = nYM2610MixPosition + 4 + i;
+		pAYSum[i] = BURN_SND_CLIP(pBuffer[2 * 4096 + j] + pBuffer[3 * 4096 + j] + pBuffer[4 * 4096 + j]);
+	}
+
+	INT32* pMix = BurnResampleInput(&YM2610Resampler, nLength);
+
+	if (bYM2610UseSeperateVolumes) {
+		BurnResampleMixPan(pMix, pAYSum, nLength, YM2610LeftVolumes[BURN_SND_YM2610_AY8910_ROUTE], YM2610RightVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
+		BurnResampleMixPan(pMix, pYMLeft, nLength, YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_1], YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
+		BurnResampleMixPan(pMix, pYMRight, nLength, YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_2], YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
+	} else {
+		BurnResampleMixRoute(pMix, pAYSum, nLength, YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE], YM2610RouteDirs[BURN_SND_YM2610_AY8910_ROUTE]);
+		BurnResampleMixRoute(pMix, pYMLeft, nLength, YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1], YM2610RouteDirs[BURN_SND_YM2610_YM2610_ROUTE_1]);
+		BurnResampleMixRoute(pMix, pYMRight, nLength, YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2], YM2610RouteDirs[BURN_SND_YM2610_YM2610_ROUTE_2]);
+	}
+
+	nYM2610MixPosition = nSamplesEnd;
+}
+
+static void YM2610UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
+	BURN_PROF_SCOPE(BURN_PROF_YM2610);
+
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM2610Initted) bprintf(PRINT_ERROR, _T("YM2610UpdateResample called without init\n"));
+	if (!DebugSnd_YM2610Initted) bprintf(PRINT_ERROR, _T("YM2610UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnYM2610SoundRate / nBurnSoundRate + 1;
+
+	if (nSegmentLength > nBurnSoundLen) {
+		nSegmentLength = nBurnSoundLen;
+	}
+	nSegmentLength -= nFractionalPosition;
+
+	INT32 nSamplesNeeded = nYM2610MixPosition + BurnResampleNeeded(&YM2610Resampler, nSegmentLength);
 
 	if (nSamplesNeeded < nAY8910Position) {
 		nSamplesNeeded = nAY8910Position;
@@ -104,134 +148,28 @@ static void YM2610UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
 	if (nSamplesNeeded < nYM2610Position) {
 		nSamplesNeeded = nYM2610Position;
 	}
-
-	if (nSegmentLength > nBurnSoundLen) {
-		nSegmentLength = nBurnSoundLen;
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
-	nSegmentLength <<= 1;
 
 	YM2610Render(nSamplesNeeded);
 	AY8910Render(nSamplesNeeded);
+	YM2610MixPolyphase(nSamplesNeeded);
 
-	pYM2610Buffer[0] = pBuffer + 0 * 4096 + 4;
-	pYM2610Buffer[1] = pBuffer + 1 * 4096 + 4;
-	pYM2610Buffer[2] = pBuffer + 2 * 4096 + 4;
-	pYM2610Buffer[3] = pBuffer + 3 * 4096 + 4;
-	pYM2610Buffer[4] = pBuffer + 4 * 4096 + 4;
-	pYM2610Buffer[5] = pBuffer + 5 * 4096 + 4;
-
-	for (INT32 i = (nFractionalPosition >> 16) - 4; i < nSamplesNeeded; i++) {
-		pYM2610Buffer[5][i] = BURN_SND_CLIP(pYM2610Buffer[2][i] + pYM2610Buffer[3][i] + pYM2610Buffer[4][i]);
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&YM2610Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bYM2610AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
 
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if (bYM2610UseSeperateVolumes) {
-			nLeftSample[0] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 3] * YM2610LeftVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			nLeftSample[1] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 2] * YM2610LeftVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			nLeftSample[2] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 1] * YM2610LeftVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			nLeftSample[3] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 0] * YM2610LeftVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			
-			nLeftSample[0] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 3] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			nLeftSample[1] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 2] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			nLeftSample[2] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 1] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			nLeftSample[3] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 0] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			
-			nLeftSample[0] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 3] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			nLeftSample[1] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 2] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			nLeftSample[2] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 1] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			nLeftSample[3] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 0] * YM2610LeftVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				
-			nRightSample[0] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 3] * YM2610RightVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			nRightSample[1] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 2] * YM2610RightVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			nRightSample[2] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 1] * YM2610RightVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			nRightSample[3] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 0] * YM2610RightVolumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			
-			nRightSample[0] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 3] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			nRightSample[1] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 2] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			nRightSample[2] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 1] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			nRightSample[3] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 0] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			
-			nRightSample[0] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 3] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			nRightSample[1] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 2] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			nRightSample[2] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 1] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			nRightSample[3] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 0] * YM2610RightVolumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-		} else {
-			if ((YM2610RouteDirs[BURN_SND_YM2610_AY8910_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample[0] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 3] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-				nLeftSample[1] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 2] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-				nLeftSample[2] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 1] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-				nLeftSample[3] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 0] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			}
-			if ((YM2610RouteDirs[BURN_SND_YM2610_AY8910_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample[0] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 3] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-				nRightSample[1] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 2] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-				nRightSample[2] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 1] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-				nRightSample[3] += (INT32)(pYM2610Buffer[5][(nFractionalPosition >> 16) - 0] * YM2610Volumes[BURN_SND_YM2610_AY8910_ROUTE]);
-			}
-		
-			if ((YM2610RouteDirs[BURN_SND_YM2610_YM2610_ROUTE_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample[0] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 3] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-				nLeftSample[1] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 2] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-				nLeftSample[2] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 1] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-				nLeftSample[3] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 0] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			}
-			if ((YM2610RouteDirs[BURN_SND_YM2610_YM2610_ROUTE_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample[0] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 3] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-				nRightSample[1] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 2] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-				nRightSample[2] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 1] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-				nRightSample[3] += (INT32)(pYM2610Buffer[0][(nFractionalPosition >> 16) - 0] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_1]);
-			}
-		
-			if ((YM2610RouteDirs[BURN_SND_YM2610_YM2610_ROUTE_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample[0] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 3] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				nLeftSample[1] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 2] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				nLeftSample[2] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 1] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				nLeftSample[3] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 0] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			}
-			if ((YM2610RouteDirs[BURN_SND_YM2610_YM2610_ROUTE_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample[0] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 3] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				nRightSample[1] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 2] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				nRightSample[2] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 1] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-				nRightSample[3] += (INT32)(pYM2610Buffer[1][(nFractionalPosition >> 16) - 0] * YM2610Volumes[BURN_SND_YM2610_YM2610_ROUTE_2]);
-			}
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3]);
-		nTotalRightSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3]);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bYM2610AddSignal) {
-//			pSoundBuf[i + 0] += nTotalLeftSample;
-//			pSoundBuf[i + 1] += nTotalRightSample;
-			pSoundBuf[i + 0] = BURN_SND_CLIP(pSoundBuf[i + 0] + nTotalLeftSample);
-			pSoundBuf[i + 1] = BURN_SND_CLIP(pSoundBuf[i + 1] + nTotalRightSample);
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
-	}
-	
 	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
-
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pYM2610Buffer[0][i] = pYM2610Buffer[0][(nFractionalPosition >> 16) + i];
-			pYM2610Buffer[1][i] = pYM2610Buffer[1][(nFractionalPosition >> 16) + i];
-			pYM2610Buffer[2][i] = pYM2610Buffer[2][(nFractionalPosition >> 16) + i];
-			pYM2610Buffer[3][i] = pYM2610Buffer[3][(nFractionalPosition >> 16) + i];
-			pYM2610Buffer[4][i] = pYM2610Buffer[4][(nFractionalPosition >> 16) + i];
-		}
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&YM2610Resampler);
 
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
 		nYM2610Position = nExtraSamples;
 		nAY8910Position = nExtraSamples;
+		nYM2610MixPosition = nExtraSamples;
 
 		dTime += 100.0 / nBurnFPS;
 	}
@@ -239,6 +177,8 @@ static void YM2610UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
 
 static void YM2610UpdateNormal(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
+	BURN_PROF_SCOPE(BURN_PROF_YM2610);
+
 #if defined FBA_DEBUG
 	if (!DebugSnd_YM2610Initted) bprintf(PRINT_ERROR, _T("YM2610UpdateNormal called without init\n"));
 #endif
@@ -372,6 +312,8 @@ void BurnYM2610Reset()
 	BurnTimerReset();
 
 	YM2610ResetChip(0);
+
+	BurnResampleReset(&YM2610Resampler);
 }
 
 void BurnYM2610Exit()
@@ -385,6 +327,8 @@ void BurnYM2610Exit()
 	YM2610Shutdown();
 	AY8910Exit(0);
 
+	BurnResampleExit(&YM2610Resampler);
+
 	BurnTimerExit();
 	
 	if (pBuffer) {
@@ -429,17 +373,15 @@ INT32 BurnYM2610Init(INT32 nClockFrequency, UINT8* YM2610ADPCMAROM, INT32* nYM26
 
 	BurnYM2610StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set YM2610 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM2610 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM2610SoundRate = nClockFrequency / 144;
-		// Bring YM2610 core samplerate within usable range
 		while (nBurnYM2610SoundRate > nBurnSoundRate * 3) {
 			nBurnYM2610SoundRate >>= 1;
 		}
 
-		BurnYM2610Update = YM2610UpdateResample;
-
-		nSampleSize = (UINT32)nBurnYM2610SoundRate * (1 << 16) / nBurnSoundRate;
+		BurnResampleInit(&YM2610Resampler, nBurnYM2610SoundRate, nBurnSoundRate);
+		BurnYM2610Update = YM2610UpdatePolyphase;
 	} else {
 		nBurnYM2610SoundRate = nBurnSoundRate;
 
@@ -457,6 +399,7 @@ INT32 BurnYM2610Init(INT32 nClockFrequency, UINT8* YM2610ADPCMAROM, INT32* nYM26
 	
 	nYM2610Position = 0;
 	nAY8910Position = 0;
+	nYM2610MixPosition = 0;
 
 	nFractionalPosition = 0;
 	bYM2610AddSignal = bAddSignal;
@@ -523,5 +466,11 @@ void BurnYM2610Scan(INT32 nAction, INT32* pnMin)
 	if (nAction & ACB_DRIVER_DATA) {
 		SCAN_VAR(nYM2610Position);
 		SCAN_VAR(nAY8910Position);
+
+		if ((nAction & ACB_WRITE) && BurnYM2610Update == YM2610UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nYM2610Position = nYM2610MixPosition;
+			nAY8910Position = nYM2610MixPosition;
+		}
 	}
 }
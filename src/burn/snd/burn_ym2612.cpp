@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym2612.h"
+#include "burn_resample.h"
 
 #define MAX_YM2612	2
 
@@ -15,7 +16,6 @@ static INT16* pYM2612Buffer[2 * MAX_YM2612];
 
 static INT32 nYM2612Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 nNumChips = 0;
@@ -24,6 +24,9 @@ static INT32 bYM2612AddSignal;
 static double YM2612Volumes[2 * MAX_YM2612];
 static INT32 YM2612RouteDirs[2 * MAX_YM2612];
 
+static struct BurnResampler YM2612Resampler;
+static INT32 nYM2612MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -71,96 +74,63 @@ static void YM2612Render(INT32 nSegmentLength)
 
 // Update the sound buffer
 
-#define INTERPOLATE_ADD_SOUND_LEFT(route, buffer)																	\
-	if ((YM2612RouteDirs[route] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {									\
-		nLeftSample[0] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 3] * YM2612Volumes[route]);	\
-		nLeftSample[1] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 2] * YM2612Volumes[route]);	\
-		nLeftSample[2] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 1] * YM2612Volumes[route]);	\
-		nLeftSample[3] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 0] * YM2612Volumes[route]);	\
+// route the samples the chips rendered since the last update to the resampler
+static void YM2612MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nYM2612MixPosition;
+
+	if (nLength <= 0) {
+		return;
 	}
 
-#define INTERPOLATE_ADD_SOUND_RIGHT(route, buffer)																	\
-	if ((YM2612RouteDirs[route] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {									\
-		nRightSample[0] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 3] * YM2612Volumes[route]);	\
-		nRightSample[1] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 2] * YM2612Volumes[route]);	\
-		nRightSample[2] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 1] * YM2612Volumes[route]);	\
-		nRightSample[3] += (INT32)(pYM2612Buffer[buffer][(nFractionalPosition >> 16) - 0] * YM2612Volumes[route]);	\
+	INT32* pMix = BurnResampleInput(&YM2612Resampler, nLength);
+
+	// buffer n holds route n, the left then the right output of each chip
+	for (INT32 i = 0; i < nNumChips * 2; i++) {
+		BurnResampleMixRoute(pMix, pBuffer + i * 4096 + 4 + nYM2612MixPosition, nLength, YM2612Volumes[i], YM2612RouteDirs[i]);
 	}
 
-static void YM2612UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+	nYM2612MixPosition = nSamplesEnd;
+}
+
+static void YM2612UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM2612Initted) bprintf(PRINT_ERROR, _T("YM2612UpdateResample called without init\n"));
+	if (!DebugSnd_YM2612Initted) bprintf(PRINT_ERROR, _T("YM2612UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnYM2612SoundRate / nBurnSoundRate + 1;
-
-	if (nSamplesNeeded < nYM2612Position) {
-		nSamplesNeeded = nYM2612Position;
-	}
 
 	if (nSegmentLength > nBurnSoundLen) {
 		nSegmentLength = nBurnSoundLen;
 	}
-	nSegmentLength <<= 1;
+	nSegmentLength -= nFractionalPosition;
 
-	YM2612Render(nSamplesNeeded);
+	INT32 nSamplesNeeded = nYM2612MixPosition + BurnResampleNeeded(&YM2612Resampler, nSegmentLength);
 
-	pYM2612Buffer[0] = pBuffer + 0 * 4096 + 4;
-	pYM2612Buffer[1] = pBuffer + 1 * 4096 + 4;
-	if (nNumChips > 1) {
-		pYM2612Buffer[2] = pBuffer + 2 * 4096 + 4;
-		pYM2612Buffer[3] = pBuffer + 3 * 4096 + 4;
+	if (nSamplesNeeded < nYM2612Position) {
+		nSamplesNeeded = nYM2612Position;
+	}
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
 
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
+	YM2612Render(nSamplesNeeded);
+	YM2612MixPolyphase(nSamplesNeeded);
 
-		INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2612_YM2612_ROUTE_1, 0)
-		INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2612_YM2612_ROUTE_1, 0)
-		INTERPOLATE_ADD_SOUND_LEFT  (BURN_SND_YM2612_YM2612_ROUTE_2, 1)
-		INTERPOLATE_ADD_SOUND_RIGHT (BURN_SND_YM2612_YM2612_ROUTE_2, 1)
-		
-		if (nNumChips > 1) {
-			INTERPOLATE_ADD_SOUND_LEFT  (2 + BURN_SND_YM2612_YM2612_ROUTE_1, 2)
-			INTERPOLATE_ADD_SOUND_RIGHT (2 + BURN_SND_YM2612_YM2612_ROUTE_1, 2)
-			INTERPOLATE_ADD_SOUND_LEFT  (2 + BURN_SND_YM2612_YM2612_ROUTE_2, 3)
-			INTERPOLATE_ADD_SOUND_RIGHT (2 + BURN_SND_YM2612_YM2612_ROUTE_2, 3)
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3]);
-		nTotalRightSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3]);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bYM2612AddSignal) {
-			pSoundBuf[i + 0] = BURN_SND_CLIP(pSoundBuf[i + 0] + nTotalLeftSample);
-			pSoundBuf[i + 1] = BURN_SND_CLIP(pSoundBuf[i + 1] + nTotalRightSample);
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&YM2612Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bYM2612AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
-	
-	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
 
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pYM2612Buffer[0][i] = pYM2612Buffer[0][(nFractionalPosition >> 16) + i];
-			pYM2612Buffer[1][i] = pYM2612Buffer[1][(nFractionalPosition >> 16) + i];
-			if (nNumChips > 1) {
-				pYM2612Buffer[2][i] = pYM2612Buffer[2][(nFractionalPosition >> 16) + i];
-				pYM2612Buffer[3][i] = pYM2612Buffer[3][(nFractionalPosition >> 16) + i];
-			}
-		}
+	if (nSegmentEnd >= nBurnSoundLen) {
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&YM2612Resampler);
 
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
 		nYM2612Position = nExtraSamples;
+		nYM2612MixPosition = nExtraSamples;
 
 		dTime += 100.0 / nBurnFPS;
 	}
@@ -285,6 +255,8 @@ void BurnYM2612Reset()
 	for (INT32 i = 0; i < nNumChips; i++) {
 		YM2612ResetChip(i);
 	}
+
+	BurnResampleReset(&YM2612Resampler);
 }
 
 void BurnYM2612Exit()
@@ -297,6 +269,8 @@ void BurnYM2612Exit()
 
 	YM2612Shutdown();
 
+	BurnResampleExit(&YM2612Resampler);
+
 	BurnTimerExit();
 
 	if (pBuffer) {
@@ -333,17 +307,15 @@ INT32 BurnYM2612Init(INT32 num, INT32 nClockFrequency, FM_IRQHANDLER IRQCallback
 
 	BurnYM2612StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set YM2612 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM2612 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM2612SoundRate = nClockFrequency / 144;
-		// Bring YM2612 core samplerate within usable range
 		while (nBurnYM2612SoundRate > nBurnSoundRate * 3) {
 			nBurnYM2612SoundRate >>= 1;
 		}
 
-		BurnYM2612Update = YM2612UpdateResample;
-
-		nSampleSize = (UINT32)nBurnYM2612SoundRate * (1 << 16) / nBurnSoundRate;
+		BurnResampleInit(&YM2612Resampler, nBurnYM2612SoundRate, nBurnSoundRate);
+		BurnYM2612Update = YM2612UpdatePolyphase;
 	} else {
 		nBurnYM2612SoundRate = nBurnSoundRate;
 
@@ -356,6 +328,7 @@ INT32 BurnYM2612Init(INT32 num, INT32 nClockFrequency, FM_IRQHANDLER IRQCallback
 	memset(pBuffer, 0, 4096 * 2 * num * sizeof(INT16));
 	
 	nYM2612Position = 0;
+	nYM2612MixPosition = 0;
 	nFractionalPosition = 0;
 	
 	nNumChips = num;
@@ -405,6 +378,11 @@ void BurnYM2612Scan(INT32 nAction, INT32* pnMin)
 	if (nAction & ACB_DRIVER_DATA) {
 		BurnTimerScan(nAction, pnMin);
 		SCAN_VAR(nYM2612Position);
+
+		if ((nAction & ACB_WRITE) && BurnYM2612Update == YM2612UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nYM2612Position = nYM2612MixPosition;
+		}
 	}
 }
 
@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym3526.h"
+#include "burn_resample.h"
 #include "m68000_intf.h"
 #include "z80_intf.h"
 #include "m6809_intf.h"
@@ -291,7 +292,6 @@ static INT16* pYM3526Buffer;
 
 static INT32 nYM3526Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 bYM3526AddSignal;
@@ -299,6 +299,9 @@ static INT32 bYM3526AddSignal;
 static double YM3526Volumes[1];
 static INT32 YM3526RouteDirs[1];
 
+static struct BurnResampler YM3526Resampler;
+static INT32 nYM3526MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -335,71 +338,60 @@ static void YM3526Render(INT32 nSegmentLength)
 // ----------------------------------------------------------------------------
 // Update the sound buffer
 
-static void YM3526UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+// route the samples the chip rendered since the last update to the resampler
+static void YM3526MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nYM3526MixPosition;
+
+	if (nLength <= 0) {
+		return;
+	}
+
+	INT32* pMix = BurnResampleInput(&YM3526Resampler, nLength);
+
+	BurnResampleMixRoute(pMix, pBuffer + 4 + nYM3526MixPosition, nLength, YM3526Volumes[BURN_SND_YM3526_ROUTE], YM3526RouteDirs[BURN_SND_YM3526_ROUTE]);
+
+	nYM3526MixPosition = nSamplesEnd;
+}
+
+static void YM3526UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM3526Initted) bprintf(PRINT_ERROR, _T("YM3526UpdateResample called without init\n"));
+	if (!DebugSnd_YM3526Initted) bprintf(PRINT_ERROR, _T("YM3526UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnYM3526SoundRate / nBurnSoundRate + 1;
+
+	if (nSegmentLength > nBurnSoundLen) {
+		nSegmentLength = nBurnSoundLen;
+	}
+	nSegmentLength -= nFractionalPosition;
+
+	INT32 nSamplesNeeded = nYM3526MixPosition + BurnResampleNeeded(&YM3526Resampler, nSegmentLength);
 
 	if (nSamplesNeeded < nYM3526Position) {
 		nSamplesNeeded = nYM3526Position;
 	}
-
-	if (nSegmentLength > nBurnSoundLen) {
-		nSegmentLength = nBurnSoundLen;
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
-	nSegmentLength <<= 1;
 
 	YM3526Render(nSamplesNeeded);
+	YM3526MixPolyphase(nSamplesNeeded);
 
-	pYM3526Buffer = pBuffer + 0 * 4096 + 4;
-
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if ((YM3526RouteDirs[BURN_SND_YM3526_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 3] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-			nLeftSample[1] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 2] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-			nLeftSample[2] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 1] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-			nLeftSample[3] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 0] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-		}
-		if ((YM3526RouteDirs[BURN_SND_YM3526_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 3] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-			nRightSample[1] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 2] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-			nRightSample[2] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 1] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-			nRightSample[3] += (INT32)(pYM3526Buffer[(nFractionalPosition >> 16) - 0] * YM3526Volumes[BURN_SND_YM3526_ROUTE]);
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3]);
-		nTotalRightSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3]);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bYM3526AddSignal) {
-			pSoundBuf[i + 0] += nTotalLeftSample;
-			pSoundBuf[i + 1] += nTotalRightSample;
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&YM3526Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bYM3526AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
 
 	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&YM3526Resampler);
 
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pYM3526Buffer[i] = pYM3526Buffer[(nFractionalPosition >> 16) + i];
-		}
-
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
 		nYM3526Position = nExtraSamples;
+		nYM3526MixPosition = nExtraSamples;
 	}
 }
 
@@ -485,6 +477,8 @@ void BurnYM3526Reset()
 	BurnTimerResetYM3526();
 
 	YM3526ResetChip(0);
+
+	BurnResampleReset(&YM3526Resampler);
 }
 
 void BurnYM3526Exit()
@@ -497,6 +491,8 @@ void BurnYM3526Exit()
 
 	YM3526Shutdown();
 
+	BurnResampleExit(&YM3526Resampler);
+
 	BurnTimerExitYM3526();
 
 	if (pBuffer) {
@@ -526,18 +522,15 @@ INT32 BurnYM3526Init(INT32 nClockFrequency, OPL_IRQHANDLER IRQCallback, INT32 (*
 
 	BurnYM3526StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set YM3526 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM3526 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM3526SoundRate = nClockFrequency / 72;
-		// Bring YM3526 core samplerate within usable range
 		while (nBurnYM3526SoundRate > nBurnSoundRate * 3) {
 			nBurnYM3526SoundRate >>= 1;
 		}
 
-		BurnYM3526Update = YM3526UpdateResample;
-
-		nSampleSize = (UINT32)nBurnYM3526SoundRate * (1 << 16) / nBurnSoundRate;
-		nFractionalPosition = 0;
+		BurnResampleInit(&YM3526Resampler, nBurnYM3526SoundRate, nBurnSoundRate);
+		BurnYM3526Update = YM3526UpdatePolyphase;
 	} else {
 		nBurnYM3526SoundRate = nBurnSoundRate;
 
@@ -553,6 +546,7 @@ INT32 BurnYM3526Init(INT32 nClockFrequency, OPL_IRQHANDLER IRQCallback, INT32 (*
 	memset(pBuffer, 0, 4096 * sizeof(INT16));
 
 	nYM3526Position = 0;
+	nYM3526MixPosition = 0;
 
 	nFractionalPosition = 0;
 	
@@ -587,5 +581,10 @@ void BurnYM3526Scan(INT32 nAction, INT32* pnMin)
 	
 	if (nAction & ACB_DRIVER_DATA) {
 		SCAN_VAR(nYM3526Position);
+
+		if ((nAction & ACB_WRITE) && BurnYM3526Update == YM3526UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nYM3526Position = nYM3526MixPosition;
+		}
 	}
 }
@@ -1,6 +1,7 @@
 #include "burnint.h"
 #include "burn_sound.h"
 #include "burn_ym3812.h"
+#include "burn_resample.h"
 #include "m68000_intf.h"
 #include "z80_intf.h"
 #include "m6809_intf.h"
@@ -306,7 +307,6 @@ static INT16* pYM3812Buffer[2 * MAX_YM3812];
 
 static INT32 nYM3812Position;
 
-static UINT32 nSampleSize;
 static INT32 nFractionalPosition;
 
 static INT32 nNumChips = 0;
@@ -315,6 +315,9 @@ static INT32 bYM3812AddSignal;
 static double YM3812Volumes[1 * MAX_YM3812];
 static INT32 YM3812RouteDirs[1 * MAX_YM3812];
 
+static struct BurnResampler YM3812Resampler;
+static INT32 nYM3812MixPosition;
+
 // ----------------------------------------------------------------------------
 // Dummy functions
 
@@ -355,92 +358,62 @@ static void YM3812Render(INT32 nSegmentLength)
 // ----------------------------------------------------------------------------
 // Update the sound buffer
 
-static void YM3812UpdateResample(INT16* pSoundBuf, INT32 nSegmentEnd)
+// route the samples the chips rendered since the last update to the resampler
+static void YM3812MixPolyphase(INT32 nSamplesEnd)
+{
+	INT32 nLength = nSamplesEnd - nYM3812MixPosition;
+
+	if (nLength <= 0) {
+		return;
+	}
+
+	INT32* pMix = BurnResampleInput(&YM3812Resampler, nLength);
+
+	for (INT32 i = 0; i < nNumChips; i++) {
+		BurnResampleMixRoute(pMix, pBuffer + i * 4096 + 4 + nYM3812MixPosition, nLength, YM3812Volumes[i + BURN_SND_YM3812_ROUTE], YM3812RouteDirs[i + BURN_SND_YM3812_ROUTE]);
+	}
+
+	nYM3812MixPosition = nSamplesEnd;
+}
+
+static void YM3812UpdatePolyphase(INT16* pSoundBuf, INT32 nSegmentEnd)
 {
 #if defined FBA_DEBUG
-	if (!DebugSnd_YM3812Initted) bprintf(PRINT_ERROR, _T("YM3812UpdateResample called without init\n"));
+	if (!DebugSnd_YM3812Initted) bprintf(PRINT_ERROR, _T("YM3812UpdatePolyphase called without init\n"));
 #endif
 
 	INT32 nSegmentLength = nSegmentEnd;
-	INT32 nSamplesNeeded = nSegmentEnd * nBurnYM3812SoundRate / nBurnSoundRate + 1;
-
-	if (nSamplesNeeded < nYM3812Position) {
-		nSamplesNeeded = nYM3812Position;
-	}
 
 	if (nSegmentLength > nBurnSoundLen) {
 		nSegmentLength = nBurnSoundLen;
 	}
-	nSegmentLength <<= 1;
+	nSegmentLength -= nFractionalPosition;
 
-	YM3812Render(nSamplesNeeded);
+	INT32 nSamplesNeeded = nYM3812MixPosition + BurnResampleNeeded(&YM3812Resampler, nSegmentLength);
 
-	pYM3812Buffer[0] = pBuffer + 0 * 4096 + 4;
-	if (nNumChips > 1) {
-		pYM3812Buffer[1] = pBuffer + 1 * 4096 + 4;
+	if (nSamplesNeeded < nYM3812Position) {
+		nSamplesNeeded = nYM3812Position;
+	}
+	if (nSamplesNeeded > 4096 - 4) {
+		nSamplesNeeded = 4096 - 4;
 	}
 
-	for (INT32 i = (nFractionalPosition & 0xFFFF0000) >> 15; i < nSegmentLength; i += 2, nFractionalPosition += nSampleSize) {
-		INT32 nLeftSample[4] = {0, 0, 0, 0};
-		INT32 nRightSample[4] = {0, 0, 0, 0};
-		INT32 nTotalLeftSample, nTotalRightSample;
-		
-		if ((YM3812RouteDirs[0 + BURN_SND_YM3812_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample[0] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 3] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-			nLeftSample[1] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 2] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-			nLeftSample[2] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 1] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-			nLeftSample[3] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 0] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-		}
-		if ((YM3812RouteDirs[0 + BURN_SND_YM3812_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample[0] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 3] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-			nRightSample[1] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 2] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-			nRightSample[2] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 1] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-			nRightSample[3] += (INT32)(pYM3812Buffer[0][(nFractionalPosition >> 16) - 0] * YM3812Volumes[0 + BURN_SND_YM3812_ROUTE]);
-		}
-		
-		if (nNumChips > 1) {
-			if ((YM3812RouteDirs[1 + BURN_SND_YM3812_ROUTE] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-				nLeftSample[0] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 3] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-				nLeftSample[1] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 2] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-				nLeftSample[2] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 1] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-				nLeftSample[3] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 0] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-			}
-			if ((YM3812RouteDirs[1 + BURN_SND_YM3812_ROUTE] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-				nRightSample[0] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 3] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-				nRightSample[1] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 2] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-				nRightSample[2] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 1] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-				nRightSample[3] += (INT32)(pYM3812Buffer[1][(nFractionalPosition >> 16) - 0] * YM3812Volumes[1 + BURN_SND_YM3812_ROUTE]);
-			}
-		}
-		
-		nTotalLeftSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nLeftSample[0], nLeftSample[1], nLeftSample[2], nLeftSample[3]);
-		nTotalRightSample = INTERPOLATE4PS_16BIT((nFractionalPosition >> 4) & 0x0fff, nRightSample[0], nRightSample[1], nRightSample[2], nRightSample[3]);
-		
-		nTotalLeftSample = BURN_SND_CLIP(nTotalLeftSample);
-		nTotalRightSample = BURN_SND_CLIP(nTotalRightSample);
-			
-		if (bYM3812AddSignal) {
-			pSoundBuf[i + 0] = BURN_SND_CLIP(pSoundBuf[i + 0] + nTotalLeftSample);
-			pSoundBuf[i + 1] = BURN_SND_CLIP(pSoundBuf[i + 1] + nTotalRightSample);
-		} else {
-			pSoundBuf[i + 0] = nTotalLeftSample;
-			pSoundBuf[i + 1] = nTotalRightSample;
-		}
+	YM3812Render(nSamplesNeeded);
+	YM3812MixPolyphase(nSamplesNeeded);
+
+	if (nSegmentLength > 0) {
+		BurnResampleRender(&YM3812Resampler, pSoundBuf + (nFractionalPosition << 1), nSegmentLength, bYM3812AddSignal);
+		nFractionalPosition += nSegmentLength;
 	}
 
 	if (nSegmentEnd >= nBurnSoundLen) {
-		INT32 nExtraSamples = nSamplesNeeded - (nFractionalPosition >> 16);
+		// what was rendered ahead of the output waits in the resampler, the chips go on from there
+		INT32 nExtraSamples = BurnResamplePending(&YM3812Resampler);
 
-		for (INT32 i = -4; i < nExtraSamples; i++) {
-			pYM3812Buffer[0][i] = pYM3812Buffer[0][(nFractionalPosition >> 16) + i];
-			if (nNumChips > 1) {
-				pYM3812Buffer[1][i] = pYM3812Buffer[1][(nFractionalPosition >> 16) + i];
-			}
-		}
-
-		nFractionalPosition &= 0xFFFF;
+		nFractionalPosition = 0;
 
 		nYM3812Position = nExtraSamples;
+		nYM3812MixPosition = nExtraSamples;
 	}
 }
 
@@ -541,6 +514,8 @@ void BurnYM3812Reset()
 	for (INT32 i = 0; i < nNumChips; i++) {
 		YM3812ResetChip(i);
 	}
+
+	BurnResampleReset(&YM3812Resampler);
 }
 
 void BurnYM3812Exit()
@@ -553,6 +528,8 @@ void BurnYM3812Exit()
 
 	YM3812Shutdown();
 
+	BurnResampleExit(&YM3812Resampler);
+
 	BurnTimerExitYM3812();
 
 	if (pBuffer) {
@@ -585,18 +562,15 @@ INT32 BurnYM3812Init(INT32 num, INT32 nClockFrequency, OPL_IRQHANDLER IRQCallbac
 
 	BurnYM3812StreamCallback = StreamCallback;
 
-	if (nFMInterpolation == 3) {
-		// Set YM3812 core samplerate to match the hardware
+	if (nFMInterpolation >= 3) {
+		// Run the YM3812 core at the hardware samplerate (halved while above 3x the output, as it gets costly)
 		nBurnYM3812SoundRate = nClockFrequency / 72;
-		// Bring YM3812 core samplerate within usable range
 		while (nBurnYM3812SoundRate > nBurnSoundRate * 3) {
 			nBurnYM3812SoundRate >>= 1;
 		}
 
-		BurnYM3812Update = YM3812UpdateResample;
-
-		nSampleSize = (UINT32)nBurnYM3812SoundRate * (1 << 16) / nBurnSoundRate;
-		nFractionalPosition = 0;
+		BurnResampleInit(&YM3812Resampler, nBurnYM3812SoundRate, nBurnSoundRate);
+		BurnYM3812Update = YM3812UpdatePolyphase;
 	} else {
 		nBurnYM3812SoundRate = nBurnSoundRate;
 
@@ -612,6 +586,7 @@ INT32 BurnYM3812Init(INT32 num, INT32 nClockFrequency, OPL_IRQHANDLER IRQCallbac
 	memset(pBuffer, 0, 4096 * num * sizeof(INT16));
 
 	nYM3812Position = 0;
+	nYM3812MixPosition = 0;
 
 	nFractionalPosition = 0;
 	
@@ -660,5 +635,10 @@ void BurnYM3812Scan(INT32 nAction, INT32* pnMin)
 	
 	if (nAction & ACB_DRIVER_DATA) {
 		SCAN_VAR(nYM3812Position);
+
+		if ((nAction & ACB_WRITE) && BurnYM3812Update == YM3812UpdatePolyphase) {
+			// the resampler is not saved, the chips go on from what it holds
+			nYM3812Position = nYM3812MixPosition;
+		}
 	}
 }
@@ -5,6 +5,8 @@
 #include "burnint.h"
 #include "msm6295.h"
 #include "burn_sound.h"
+#include "burn_resample.h"
+#include "burn_prof.h"
 
 UINT8* MSM6295ROM;
 
@@ -19,15 +21,12 @@ struct MSM6295ChannelInfo {
 	INT32 nStep;
 	INT32 nDelta;
 
-	INT32 nBufPos;
 	INT32 nPlaying;
 };
 
 static struct {
 	INT32 nVolume;
 	INT32 nSampleRate;
-	INT32 nSampleSize;
-	INT32 nFractionalPosition;
 
 	// All current settings for each channel
 	MSM6295ChannelInfo ChannelInfo[4];
@@ -83,10 +82,8 @@ static UINT32 MSM6295VolumeTable[16];
 static INT32 MSM6295DeltaTable[49 * 16];
 static INT32 MSM6295StepShift[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
 
-static INT32* MSM6295ChannelData[MAX_MSM6295][4];
-
-static INT32* pLeftBuffer = NULL;
-static INT32* pRightBuffer = NULL;
+// each chip runs at its own samplerate, the resampler brings it to nBurnSoundRate
+static struct BurnResampler MSM6295Resampler[MAX_MSM6295];
 
 static bool bAdd;
 
@@ -100,14 +97,12 @@ void MSM6295Reset(INT32 nChip)
 	nMSM6295Status[nChip] = 0;
 	MSM6295[nChip].bIsCommand = false;
 
-	MSM6295[nChip].nFractionalPosition = 0;
-
 	for (INT32 nChannel = 0; nChannel < 4; nChannel++) {
 		MSM6295[nChip].ChannelInfo[nChannel].nPlaying = 0;
-		memset(MSM6295ChannelData[nChip][nChannel], 0, 0x1000 * sizeof(INT32));
-		MSM6295[nChip].ChannelInfo[nChannel].nBufPos = 4;
 	}
 
+	BurnResampleReset(&MSM6295Resampler[nChip]);
+
 	// set bank data only if DataPointer has not already been set
 	if (pBankPointer[nChip][0] == NULL) {
 		MSM6295SetBank(nChip, MSM6295ROM + (nChip * 0x0100000), 0, 0x3ffff); // set initial bank (compatibility)
@@ -121,9 +116,7 @@ INT32 MSM6295Scan(INT32 nChip, INT32 )
 	if (nChip > nLastMSM6295Chip) bprintf(PRINT_ERROR, _T("MSM6295Scan called with invalid chip number %x\n"), nChip);
 #endif
 
-	INT32 nSampleSize = MSM6295[nChip].nSampleSize;
 	SCAN_VAR(MSM6295[nChip]);
-	MSM6295[nChip].nSampleSize = nSampleSize;
 
 	SCAN_VAR(nMSM6295Status[nChip]);
 
@@ -134,246 +127,101 @@ INT32 MSM6295Scan(INT32 nChip, INT32 )
 	return 0;
 }
 
-static void MSM6295Render_Linear(INT32 nChip, INT32* pLeftBuf, INT32 *pRightBuf, INT32 nSegmentLength)
-{
-	static INT32 nPreviousSample[MAX_MSM6295], nCurrentSample[MAX_MSM6295];
-	INT32 nVolume = MSM6295[nChip].nVolume;
-	INT32 nFractionalPosition = MSM6295[nChip].nFractionalPosition;
-
-	INT32 nChannel, nDelta, nSample;
-	MSM6295ChannelInfo* pChannelInfo;
-
-	while (nSegmentLength--) {
-		if (nFractionalPosition >= 0x1000) {
-
-			nPreviousSample[nChip] = nCurrentSample[nChip];
-
-			do {
-				nCurrentSample[nChip] = 0;
-
-				for (nChannel = 0; nChannel < 4; nChannel++) {
-					if (nMSM6295Status[nChip] & (1 << nChannel)) {
-						pChannelInfo = &MSM6295[nChip].ChannelInfo[nChannel];
-
-						// Check for end of sample
-						if (pChannelInfo->nSampleCount-- == 0) {
-							nMSM6295Status[nChip] &= ~(1 << nChannel);
-							MSM6295[nChip].ChannelInfo[nChannel].nPlaying = 0;
-							continue;
-						}
-
-						// Get new delta from ROM
-						if (pChannelInfo->nPosition & 1) {
-							nDelta = pChannelInfo->nDelta & 0x0F;
-						} else {
-							pChannelInfo->nDelta = MSM6295ReadData(nChip, (pChannelInfo->nPosition >> 1) & 0x3ffff);
-							nDelta = pChannelInfo->nDelta >> 4;
-						}
-
-						// Compute new sample
-						nSample = pChannelInfo->nSample + MSM6295DeltaTable[(pChannelInfo->nStep << 4) + nDelta];
-						if (nSample > 2047) {
-							nSample = 2047;
-						} else {
-							if (nSample < -2048) {
-								nSample = -2048;
-							}
-						}
-						pChannelInfo->nSample = nSample;
-						pChannelInfo->nOutput = (nSample * pChannelInfo->nVolume);
-
-						// Update step value
-						pChannelInfo->nStep = pChannelInfo->nStep + MSM6295StepShift[nDelta & 7];
-						if (pChannelInfo->nStep > 48) {
-							pChannelInfo->nStep = 48;
-						} else {
-							if (pChannelInfo->nStep < 0) {
-								pChannelInfo->nStep = 0;
-							}
-						}
-
-						nCurrentSample[nChip] += pChannelInfo->nOutput / 16;
-
-						// Advance sample position
-						pChannelInfo->nPosition++;
-					}
-				}
-
-				nFractionalPosition -= 0x1000;
-
-			} while (nFractionalPosition >= 0x1000);
-		}
-
-		// Compute linearly interpolated sample
-		nSample = nPreviousSample[nChip] + (((nCurrentSample[nChip] - nPreviousSample[nChip]) * nFractionalPosition) >> 12);
-
-		// Scale all 4 channels
-		nSample *= nVolume;
-
-		if ((MSM6295[nChip].nOutputDir & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			*pLeftBuf++ += nSample;
-		}
-		if ((MSM6295[nChip].nOutputDir & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			*pRightBuf++ += nSample;
-		}
-
-		nFractionalPosition += MSM6295[nChip].nSampleSize;
-	}
-
-	MSM6295[nChip].nFractionalPosition = nFractionalPosition;
-}
-
-static void MSM6295Render_Cubic(INT32 nChip, INT32* pLeftBuf, INT32 *pRightBuf, INT32 nSegmentLength)
+// one sample of the 4 channels at the chip samplerate for each nSamples
+static void MSM6295RenderNative(INT32 nChip, INT32* pBuf, INT32 nSamples)
 {
 	INT32 nVolume = MSM6295[nChip].nVolume;
-	INT32 nFractionalPosition;
 
 	INT32 nChannel, nDelta, nSample, nOutput;
 	MSM6295ChannelInfo* pChannelInfo;
 
-	while (nSegmentLength--) {
-
+	while (nSamples--) {
 		nOutput = 0;
 
 		for (nChannel = 0; nChannel < 4; nChannel++) {
-			pChannelInfo = &MSM6295[nChip].ChannelInfo[nChannel];
-			nFractionalPosition = MSM6295[nChip].nFractionalPosition;
-
 			if (nMSM6295Status[nChip] & (1 << nChannel)) {
+				pChannelInfo = &MSM6295[nChip].ChannelInfo[nChannel];
 
-				while (nFractionalPosition >= 0x1000) {
-
-					// Check for end of sample
-					if (pChannelInfo->nSampleCount-- <= 0) {
-						if (pChannelInfo->nSampleCount <= -2) {
-							nMSM6295Status[nChip] &= ~(1 << nChannel);
-							MSM6295[nChip].ChannelInfo[nChannel].nPlaying = 0;
-						}
-
-						MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos++] = pChannelInfo->nOutput / 16;
-
-						break;
-
-					} else {
-						// Get new delta from ROM
-						if (pChannelInfo->nPosition & 1) {
-							nDelta = pChannelInfo->nDelta & 0x0F;
-						} else {
-							pChannelInfo->nDelta = MSM6295ReadData(nChip, (pChannelInfo->nPosition >> 1) & 0x3ffff);
-							nDelta = pChannelInfo->nDelta >> 4;
-						}
-
-						// Compute new sample
-						nSample = pChannelInfo->nSample + MSM6295DeltaTable[(pChannelInfo->nStep << 4) + nDelta];
-						if (nSample > 2047) {
-							nSample = 2047;
-						} else {
-							if (nSample < -2048) {
-								nSample = -2048;
-							}
-						}
-						pChannelInfo->nSample = nSample;
-						pChannelInfo->nOutput = nSample * pChannelInfo->nVolume;
-
-						// Update step value
-						pChannelInfo->nStep = pChannelInfo->nStep + MSM6295StepShift[nDelta & 7];
-						if (pChannelInfo->nStep > 48) {
-							pChannelInfo->nStep = 48;
-						} else {
-							if (pChannelInfo->nStep < 0) {
-								pChannelInfo->nStep = 0;
-							}
-						}
-
-						// The interpolator needs a 16-bit sample, pChannelInfo->nOutput is now a 20-bit number
-						MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos++] = pChannelInfo->nOutput / 16;
-
-						// Advance sample position
-						pChannelInfo->nPosition++;
-						nFractionalPosition -= 0x1000;
-					}
+				// Check for end of sample
+				if (pChannelInfo->nSampleCount-- == 0) {
+					nMSM6295Status[nChip] &= ~(1 << nChannel);
+					MSM6295[nChip].ChannelInfo[nChannel].nPlaying = 0;
+					continue;
 				}
 
-				if (pChannelInfo->nBufPos > 0x0FF0) {
-					MSM6295ChannelData[nChip][nChannel][0] = MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 4];
-					MSM6295ChannelData[nChip][nChannel][1] = MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 3];
-					MSM6295ChannelData[nChip][nChannel][2] = MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 2];
-					MSM6295ChannelData[nChip][nChannel][3] = MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 1];
-					pChannelInfo->nBufPos = 4;
+				// Get new delta from ROM
+				if (pChannelInfo->nPosition & 1) {
+					nDelta = pChannelInfo->nDelta & 0x0F;
+				} else {
+					pChannelInfo->nDelta = MSM6295ReadData(nChip, (pChannelInfo->nPosition >> 1) & 0x3ffff);
+					nDelta = pChannelInfo->nDelta >> 4;
 				}
 
-				nOutput += INTERPOLATE4PS_16BIT(nFractionalPosition,
-												MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 4],
-												MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 3],
-												MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 2],
-												MSM6295ChannelData[nChip][nChannel][pChannelInfo->nBufPos - 1]);
-			} else {
-				// Ramp channel output to 0
-				if (pChannelInfo->nOutput != 0) {
-					INT32 nRamp = 2048 * 256 * 256 / nBurnSoundRate;
-					if (pChannelInfo->nOutput > 0) {
-						if (pChannelInfo->nOutput > nRamp) {
-							pChannelInfo->nOutput -= nRamp;
-						} else {
-							pChannelInfo->nOutput = 0;
-						}
-					} else {
-						if (pChannelInfo->nOutput < -nRamp) {
-							pChannelInfo->nOutput += nRamp;
-						} else {
-							pChannelInfo->nOutput = 0;
-						}
+				// Compute new sample
+				nSample = pChannelInfo->nSample + MSM6295DeltaTable[(pChannelInfo->nStep << 4) + nDelta];
+				if (nSample > 2047) {
+					nSample = 2047;
+				} else {
+					if (nSample < -2048) {
+						nSample = -2048;
 					}
-					nOutput += pChannelInfo->nOutput / 16;
 				}
+				pChannelInfo->nSample = nSample;
+				pChannelInfo->nOutput = (nSample * pChannelInfo->nVolume);
+
+				// Update step value
+				pChannelInfo->nStep = pChannelInfo->nStep + MSM6295StepShift[nDelta & 7];
+				if (pChannelInfo->nStep > 48) {
+					pChannelInfo->nStep = 48;
+				} else {
+					if (pChannelInfo->nStep < 0) {
+						pChannelInfo->nStep = 0;
+					}
+				}
+
+				// pChannelInfo->nOutput is a 20-bit number
+				nOutput += pChannelInfo->nOutput / 16;
+
+				// Advance sample position
+				pChannelInfo->nPosition++;
 			}
 		}
 
-		nOutput *= nVolume;
+		// Scale all 4 channels
+		nOutput = (nOutput * nVolume) >> 8;
 
-		//*pLeftBuf++ += nOutput;
 		if ((MSM6295[nChip].nOutputDir & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			*pLeftBuf++ += nOutput;
+			pBuf[0] += nOutput;
 		}
 		if ((MSM6295[nChip].nOutputDir & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			*pRightBuf++ += nOutput;
+			pBuf[1] += nOutput;
 		}
-
-		MSM6295[nChip].nFractionalPosition = (MSM6295[nChip].nFractionalPosition & 0x0FFF) + MSM6295[nChip].nSampleSize;
+		pBuf += 2;
 	}
 }
 
 INT32 MSM6295Render(INT32 nChip, INT16* pSoundBuf, INT32 nSegmentLength)
 {
+	BURN_PROF_SCOPE(BURN_PROF_MSM6295);
+
 #if defined FBA_DEBUG
 	if (!DebugSnd_MSM6295Initted) bprintf(PRINT_ERROR, _T("MSM6295Render called without init\n"));
 	if (nChip > nLastMSM6295Chip) bprintf(PRINT_ERROR, _T("MSM6295Render called with invalid chip number %x\n"), nChip);
 #endif
 
-	if (nChip == 0) {
-		memset(pLeftBuffer, 0, nSegmentLength * sizeof(INT32));
-		memset(pRightBuffer, 0, nSegmentLength * sizeof(INT32));
-	}
-
-	if (nInterpolation >= 3) {
-		MSM6295Render_Cubic(nChip, pLeftBuffer, pRightBuffer, nSegmentLength);
-	} else {
-		MSM6295Render_Linear(nChip, pLeftBuffer, pRightBuffer, nSegmentLength);
-	}
+	struct BurnResampler* pRes = &MSM6295Resampler[nChip];
 
-	if (nChip == nLastMSM6295Chip)	{
-		for (INT32 i = 0; i < nSegmentLength; i++) {
-			if (bAdd) {
-				pSoundBuf[0] = BURN_SND_CLIP(pSoundBuf[0] + (pLeftBuffer[i] >> 8));
-				pSoundBuf[1] = BURN_SND_CLIP(pSoundBuf[1] + (pRightBuffer[i] >> 8));
-			} else {
-				pSoundBuf[0] = BURN_SND_CLIP(pLeftBuffer[i] >> 8);
-				pSoundBuf[1] = BURN_SND_CLIP(pRightBuffer[i] >> 8);
-			}
-			pSoundBuf += 2;
+	INT32 nSamplesNeeded = BurnResampleNeeded(pRes, nSegmentLength);
+	if (nSamplesNeeded > 0) {
+		INT32* pMix = BurnResampleInput(pRes, nSamplesNeeded);
+		if (pMix) {
+			MSM6295RenderNative(nChip, pMix, nSamplesNeeded);
 		}
 	}
 
+	// the first chip fills the sound buffer (or adds to it), the others add to that
+	BurnResampleRender(pRes, pSoundBuf, nSegmentLength, (nChip == 0) ? bAdd : 1);
+
 	return 0;
 }
 
@@ -419,14 +267,6 @@ void MSM6295Command(INT32 nChip, UINT8 nCommand)
 						MSM6295[nChip].ChannelInfo[nChannel].nOutput = 0;
 
 						nMSM6295Status[nChip] |= nCommand;
-
-						if (nInterpolation >= 3) {
-							MSM6295ChannelData[nChip][nChannel][0] = 0;
-							MSM6295ChannelData[nChip][nChannel][1] = 0;
-							MSM6295ChannelData[nChip][nChannel][2] = 0;
-							MSM6295ChannelData[nChip][nChannel][3] = 0;
-							MSM6295[nChip].ChannelInfo[nChannel].nBufPos = 4;
-						}
 					}
 				}
 			}
@@ -461,54 +301,32 @@ void MSM6295Exit(INT32 nChip)
 
 	if (!DebugSnd_MSM6295Initted) return;
 
-	if (pLeftBuffer) BurnFree(pLeftBuffer);
-	if (pRightBuffer) BurnFree(pRightBuffer);
-	pLeftBuffer = NULL;
-	pRightBuffer = NULL;
+	BurnResampleExit(&MSM6295Resampler[nChip]);
 
-	for (INT32 nChannel = 0; nChannel < 4; nChannel++) {
-		BurnFree(MSM6295ChannelData[nChip][nChannel]);
-	}
-	
 	if (nChip == nLastMSM6295Chip) DebugSnd_MSM6295Initted = 0;
 }
 
 void MSM6295SetSamplerate(INT32 nChip, INT32 nSamplerate)
 {
 	MSM6295[nChip].nSampleRate = nSamplerate;
-	if (nBurnSoundRate > 0) {
-		MSM6295[nChip].nSampleSize = (nSamplerate << 12) / nBurnSoundRate;
-	} else {
-		MSM6295[nChip].nSampleSize = (nSamplerate << 12) / 11025;
-	}
+
+	BurnResampleExit(&MSM6295Resampler[nChip]);
+	BurnResampleInit(&MSM6295Resampler[nChip], nSamplerate, nBurnSoundRate);
 }
 
 INT32 MSM6295Init(INT32 nChip, INT32 nSamplerate, bool bAddSignal)
 {
 	DebugSnd_MSM6295Initted = 1;
 	
-	if (nBurnSoundRate > 0) {
-		if (pLeftBuffer == NULL) {
-			pLeftBuffer = (INT32*)BurnMalloc(nBurnSoundRate * sizeof(INT32));
-		}
-		if (pRightBuffer == NULL) {
-			pRightBuffer = (INT32*)BurnMalloc(nBurnSoundRate * sizeof(INT32));
-		}
-	}
-
 	bAdd = bAddSignal;
 
 	// Convert volume from percentage
 	MSM6295[nChip].nVolume = INT32(100.0 * 256.0 / 100.0 + 0.5);
 
 	MSM6295[nChip].nSampleRate = nSamplerate;
-	if (nBurnSoundRate > 0) {
-		MSM6295[nChip].nSampleSize = (nSamplerate << 12) / nBurnSoundRate;
-	} else {
-		MSM6295[nChip].nSampleSize = (nSamplerate << 12) / 11025;
-	}
 
-	MSM6295[nChip].nFractionalPosition = 0;
+	// (left without a buffer when there is no sound)
+	BurnResampleInit(&MSM6295Resampler[nChip], nSamplerate, nBurnSoundRate);
 
 	nMSM6295Status[nChip] = 0;
 	MSM6295[nChip].bIsCommand = false;
@@ -551,10 +369,6 @@ INT32 MSM6295Init(INT32 nChip, INT32 nSamplerate, bool bAddSignal)
 		MSM6295VolumeTable[i] = (UINT32)(nVolume + 0.5);
 	}
 
-	for (INT32 nChannel = 0; nChannel < 4; nChannel++) {
-		MSM6295ChannelData[nChip][nChannel] = (INT32*)BurnMalloc(0x1000 * sizeof(INT32));
-	}
-	
 	MSM6295[nChip].nOutputDir = BURN_SND_ROUTE_BOTH;
 
 	memset (pBankPointer[nChip], 0, (0x40000/0x100) * sizeof(UINT8*));
@@ -5,8 +5,10 @@
 #include "burnint.h"
 #include "ymz280b.h"
 #include "burn_sound.h"
+#include "burn_resample.h"
 
-static INT32 nYMZ280BSampleRate;
+static INT32 nYMZ280BSampleRate;				// the chip samplerate, the resampler brings it to nBurnSoundRate
+static struct BurnResampler YMZ280BResampler;
 bool bESPRaDeMixerKludge = false;
 
 UINT8* YMZ280BROM;
@@ -59,8 +61,6 @@ struct sYMZ280BChannelInfo {
 
 	INT32 nOutput;
 	INT32 nPreviousOutput;
-
-	INT32 nBufPos;
 };
 
 static INT32 nActiveChannel, nDelta, nSample, nCount, nRamReadAddress;
@@ -69,8 +69,6 @@ static INT32* buf = NULL;
 sYMZ280BChannelInfo YMZ280BChannelInfo[8];
 static sYMZ280BChannelInfo* channelInfo;
 
-static INT32* YMZ280BChannelData[8];
-
 void YMZ280BReset()
 {
 #if defined FBA_DEBUG
@@ -85,10 +83,7 @@ void YMZ280BReset()
 	bYMZ280BEnable = false;
 	nRamReadAddress = 0;
 
-	for (INT32 j = 0; j < 8; j++) {
-		memset(YMZ280BChannelData[j], 0, 0x1000 * sizeof(INT32));
-		YMZ280BChannelInfo[j].nBufPos = 4;
-	}
+	BurnResampleReset(&YMZ280BResampler);
 
 	return;
 }
@@ -131,11 +126,10 @@ INT32 YMZ280BInit(INT32 nClock, void (*IRQCallback)(INT32))
 	
 	nYMZ280BFrequency = nClock;
 
-	if (nBurnSoundRate > 0) {
-		nYMZ280BSampleRate = nBurnSoundRate;
-	} else {
-		nYMZ280BSampleRate = 11025;
-	}
+	nYMZ280BSampleRate = nClock / 384;
+
+	// (left without a buffer when there is no sound)
+	BurnResampleInit(&YMZ280BResampler, nYMZ280BSampleRate, nBurnSoundRate);
 
 	// Compute sample deltas
 	for (INT32 n = 0; n < 16; n++) {
@@ -154,10 +148,6 @@ INT32 YMZ280BInit(INT32 nClock, void (*IRQCallback)(INT32))
 	}
 	pBuffer = (INT32*)malloc(nYMZ280BSampleRate *  2 * sizeof(INT32));
 
-	for (INT32 j = 0; j < 8; j++) {
-		YMZ280BChannelData[j] = (INT32*)malloc(0x1000 * sizeof(INT32));
-	}
-
 	// default routes
 	YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_1] = 1.00;
 	YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_2] = 1.00;
@@ -200,11 +190,7 @@ void YMZ280BExit()
 		pBuffer = NULL;
 	}
 
-	for (INT32 j = 0; j < 8; j++) {
-		if (YMZ280BChannelData[j])
-			free(YMZ280BChannelData[j]);
-		YMZ280BChannelData[j] = NULL;
-	}
+	BurnResampleExit(&YMZ280BResampler);
 
 	YMZ280BIRQCallback = NULL;
 	pYMZ280BRAMWrite = NULL;
@@ -347,26 +333,6 @@ inline static void ComputeOutput_Linear()
 	*buf++ += nSample * channelInfo->nVolumeRight;
 }
 
-inline static void ComputeOutput_Cubic()
-{
-	if (channelInfo->nBufPos > 0x0FF0) {
-		YMZ280BChannelData[nActiveChannel][0] = YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 4];
-		YMZ280BChannelData[nActiveChannel][1] = YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 3];
-		YMZ280BChannelData[nActiveChannel][2] = YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 2];
-		YMZ280BChannelData[nActiveChannel][3] = YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 1];
-		channelInfo->nBufPos = 4;
-	}
-
-	nSample = INTERPOLATE4PS_16BIT(channelInfo->nFractionalPosition >> 12,
-								   YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 4],
-								   YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 3],
-								   YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 2],
-								   YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos - 1]);
-
-	*buf++ += nSample * channelInfo->nVolumeLeft;
-	*buf++ += nSample * channelInfo->nVolumeRight;
-}
-
 inline static void RenderADPCM_Linear()
 {
 	while (nCount--) {
@@ -440,70 +406,6 @@ inline static void RenderADPCMLoop_Linear()
 		channelInfo->nFractionalPosition += channelInfo->nSampleSize;
 	}
 }
-inline static void RenderADPCM_Cubic()
-{
-	while (nCount--) {
-		while (channelInfo->nFractionalPosition >= 0x01000000) {
-
-			// Check for end of sample
-			if (channelInfo->nPosition >= channelInfo->nSampleStop) {
-				channelInfo->bPlaying = false;
-
-				RampChannel();
-
-				nYMZ280BStatus |= 1 << nActiveChannel;
-				UpdateIRQStatus();
-
-				return;
-			} else {
-
-				decode_table[YMZ280BChannelInfo[nActiveChannel].nMode](); // decode one sample
-
-				// Advance sample position
-				channelInfo->nFractionalPosition -= 0x01000000;
-
-				YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos++] = channelInfo->nSample;
-			}
-		}
-
-		ComputeOutput_Cubic();
-
-		channelInfo->nFractionalPosition += channelInfo->nSampleSize;
-	}
-}
-
-inline static void RenderADPCMLoop_Cubic()
-{
-	while (nCount--) {
-
-		while (channelInfo->nFractionalPosition >= 0x01000000) {
-			// Check for end of sample
-			if (channelInfo->nPosition >= channelInfo->nLoopStop) {
-
-				channelInfo->nStep = channelInfo->nLoopStep;
-				channelInfo->nSample = channelInfo->nLoopSample;
-				channelInfo->nPosition = channelInfo->nLoopStart;
-			} else {
-				// Store the state of the channel at the point where the loop starts
-				if (channelInfo->nPosition == channelInfo->nLoopStart) {
-					channelInfo->nLoopStep = channelInfo->nStep;
-					channelInfo->nLoopSample = channelInfo->nSample;
-				}
-			}
-
-			decode_table[YMZ280BChannelInfo[nActiveChannel].nMode](); // decode one sample
-
-			// Advance sample position
-			channelInfo->nFractionalPosition -= 0x01000000;
-
-			YMZ280BChannelData[nActiveChannel][channelInfo->nBufPos++] = channelInfo->nSample;
-		}
-
-		ComputeOutput_Cubic();
-
-		channelInfo->nFractionalPosition += channelInfo->nSampleSize;
-	}
-}
 
 INT32 YMZ280BRender(INT16* pSoundBuf, INT32 nSegmentLength)
 {
@@ -511,53 +413,52 @@ INT32 YMZ280BRender(INT16* pSoundBuf, INT32 nSegmentLength)
 	if (!DebugSnd_YMZ280BInitted) bprintf(PRINT_ERROR, _T("YMZ280BRender called without init\n"));
 #endif
 
-	memset(pBuffer, 0, nSegmentLength * 2 * sizeof(INT32));
+	// the voices step through the samples at the chip samplerate
+	INT32 nSamplesNeeded = BurnResampleNeeded(&YMZ280BResampler, nSegmentLength);
+	if (nSamplesNeeded > nYMZ280BSampleRate) {
+		nSamplesNeeded = nYMZ280BSampleRate;
+	}
+
+	if (nSamplesNeeded > 0) {
+		memset(pBuffer, 0, nSamplesNeeded * 2 * sizeof(INT32));
 
-	for (nActiveChannel = 0; nActiveChannel < 8; nActiveChannel++) {
-		nCount = nSegmentLength;
-		buf = pBuffer;
-		channelInfo = &YMZ280BChannelInfo[nActiveChannel];
+		for (nActiveChannel = 0; nActiveChannel < 8; nActiveChannel++) {
+			nCount = nSamplesNeeded;
+			buf = pBuffer;
+			channelInfo = &YMZ280BChannelInfo[nActiveChannel];
 
-		if (channelInfo->bPlaying) {
-			if (nInterpolation < 3) {
+			if (channelInfo->bPlaying) {
 				if (channelInfo->bEnabled && channelInfo->bLoop) {
 					RenderADPCMLoop_Linear();
 				} else {
 					RenderADPCM_Linear();
 				}
 			} else {
-				if (channelInfo->bEnabled && channelInfo->bLoop) {
-					RenderADPCMLoop_Cubic();
-				} else {
-					RenderADPCM_Cubic();
-				}
+				RampChannel();
 			}
-		} else {
-			RampChannel();
 		}
-	}
 
-	for (INT32 i = 0; i < nSegmentLength; i++) {
-		INT32 nLeftSample = 0, nRightSample = 0;
-			
-		if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample += (INT32)((pBuffer[(i << 1) + 0] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_1]);
-		}
-		if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample += (INT32)((pBuffer[(i << 1) + 0] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_1]);
-		}
-			
-		if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
-			nLeftSample += (INT32)((pBuffer[(i << 1) + 1] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_2]);
-		}
-		if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
-			nRightSample += (INT32)((pBuffer[(i << 1) + 1] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_2]);
+		INT32* pMix = BurnResampleInput(&YMZ280BResampler, nSamplesNeeded);
+
+		for (INT32 i = 0; i < nSamplesNeeded && pMix; i++) {
+			if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_1] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
+				pMix[(i << 1) + 0] += (INT32)((pBuffer[(i << 1) + 0] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_1]);
+			}
+			if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_1] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
+				pMix[(i << 1) + 1] += (INT32)((pBuffer[(i << 1) + 0] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_1]);
+			}
+
+			if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_2] & BURN_SND_ROUTE_LEFT) == BURN_SND_ROUTE_LEFT) {
+				pMix[(i << 1) + 0] += (INT32)((pBuffer[(i << 1) + 1] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_2]);
+			}
+			if ((YMZ280BRouteDirs[BURN_SND_YMZ280B_YMZ280B_ROUTE_2] & BURN_SND_ROUTE_RIGHT) == BURN_SND_ROUTE_RIGHT) {
+				pMix[(i << 1) + 1] += (INT32)((pBuffer[(i << 1) + 1] >> 8) * YMZ280BVolumes[BURN_SND_YMZ280B_YMZ280B_ROUTE_2]);
+			}
 		}
-			
-		pSoundBuf[(i << 1) + 0] = BURN_SND_CLIP(nLeftSample);
-		pSoundBuf[(i << 1) + 1] = BURN_SND_CLIP(nRightSample);
 	}
 
+	BurnResampleRender(&YMZ280BResampler, pSoundBuf, nSegmentLength, 0);
+
 	return 0;
 }
 
@@ -604,29 +505,11 @@ void YMZ280BWriteRegister(UINT8 nValue)
 #endif
 						}
 
-#if 0
-						if (nInterpolation < 3) {
-							YMZ280BChannelInfo[nWriteChannel].nFractionalPosition = 0;
-							YMZ280BChannelInfo[nWriteChannel].nPreviousOutput = YMZ280BChannelInfo[nWriteChannel].nSample;
-							YMZ280BChannelInfo[nWriteChannel].nOutput = YMZ280BChannelInfo[nWriteChannel].nSample;
-						} else {
-							YMZ280BChannelInfo[nWriteChannel].nFractionalPosition = 0x03000000;
-							YMZ280BChannelData[nWriteChannel][0] = YMZ280BChannelInfo[nWriteChannel].nSample;
-							YMZ280BChannelInfo[nWriteChannel].nBufPos = 1;
-						}
-#else
 						YMZ280BChannelInfo[nWriteChannel].nSample = 0;
 
-						if (nInterpolation < 3) {
-							YMZ280BChannelInfo[nWriteChannel].nFractionalPosition = 0;
-							YMZ280BChannelInfo[nWriteChannel].nPreviousOutput = 0;
-							YMZ280BChannelInfo[nWriteChannel].nOutput = 0;
-						} else {
-							YMZ280BChannelInfo[nWriteChannel].nFractionalPosition = 0x03000000;
-							YMZ280BChannelData[nWriteChannel][3] = 0;
-							YMZ280BChannelInfo[nWriteChannel].nBufPos = 1;
-						}
-#endif
+						YMZ280BChannelInfo[nWriteChannel].nFractionalPosition = 0;
+						YMZ280BChannelInfo[nWriteChannel].nPreviousOutput = 0;
+						YMZ280BChannelInfo[nWriteChannel].nOutput = 0;
 					}
 				}
 
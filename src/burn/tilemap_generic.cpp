@@ -1,4 +1,5 @@
 #include "tiles_generic.h"
+#include "burn_prof.h"
 
 #define MAX_TILEMAPS	32	// number of tile maps allowed
 #define MAX_GFX		32	// number of graphics data regions allowed
@@ -24,8 +25,24 @@ struct GenericTilemap {
 	UINT32 flags;
 	UINT8 transparent[256]; // 0 draw, 1 skip
 	INT32 transcolor;
+
+	// dirty tile cache (see GenericTilemapUseDirtyTiles)
+	UINT8 use_cache;
+	UINT8 all_dirty;
+	UINT32 dirty_count;
+	UINT32 dirty_size;
+	UINT8 *dirty;		// one byte per tile, indexed by the pScan offset
+	UINT32 *scan_table;	// pScan(col, row) for every tile, row major
+	UINT16 *cache_pixmap;	// the whole map, (color << depth) + color_offset + pixel
+	UINT16 *cache_flagmap;	// CACHE_* flags per pixel, tile group in the upper byte
+	INT32 *cache_colscroll;	// scratch for the column scroll blit, one entry per map column
 };
 
+// cache_flagmap flags
+#define CACHE_VALID		(1 << 0)	// the tile wasn't skipped
+#define CACHE_OPAQUE		(1 << 1)	// the pixel isn't transparent
+#define CACHE_GROUP		(1 << 2)	// the tile has a group (upper byte)
+
 struct GenericTilemapGfx {
 	UINT8 *gfxbase;		// pointer to graphics data
 	INT32 depth;		// bits per pixel
@@ -41,6 +58,17 @@ static GenericTilemap maps[MAX_TILEMAPS];
 static GenericTilemapGfx gfxdata[MAX_TILEMAPS];
 static GenericTilemap *cur_map;
 
+static void GenericTilemapFreeCache(GenericTilemap *map)
+{
+	BurnFree(map->dirty);
+	BurnFree(map->scan_table);
+	BurnFree(map->cache_pixmap);
+	BurnFree(map->cache_flagmap);
+	BurnFree(map->cache_colscroll);
+
+	map->use_cache = 0;
+}
+
 void GenericTilemapInit(INT32 which, INT32 (*pScan)(INT32 col, INT32 row), void (*pTile)(INT32 offs, INT32 *tile_gfx, INT32 *tile_code, INT32 *tile_color, UINT32 *tile_flags), UINT32 tile_width, UINT32 tile_height, UINT32 map_width, UINT32 map_height)
 {
 	if (Debug_GenericTilesInitted == 0) {
@@ -50,6 +78,8 @@ void GenericTilemapInit(INT32 which, INT32 (*pScan)(INT32 col, INT32 row), void
 
 	cur_map = &maps[which];
 
+	GenericTilemapFreeCache(cur_map);
+
 	memset (cur_map, 0, sizeof(GenericTilemap));
 
 	cur_map->initialized = 1;
@@ -123,6 +153,13 @@ void GenericTilemapSetGfx(INT32 num, UINT8 *gfxbase, INT32 depth, INT32 tile_wid
 
 	GenericTilemapGfx *ptr = &gfxdata[num];
 
+	// cached tiles may come from this gfx region
+	if (ptr->gfxbase != gfxbase || ptr->depth != depth || ptr->color_offset != color_offset || ptr->color_mask != color_mask) {
+		for (INT32 i = 0; i < MAX_TILEMAPS; i++) {
+			maps[i].all_dirty = 1;
+		}
+	}
+
 	ptr->gfxbase = gfxbase;
 	ptr->depth = depth;
 	ptr->width = tile_width;
@@ -155,6 +192,7 @@ void GenericTilemapExit()
 		cur_map = &maps[i];
 		if (cur_map->scrolly_table) BurnFree(cur_map->scrolly_table);
 		if (cur_map->scrollx_table) BurnFree(cur_map->scrollx_table);
+		GenericTilemapFreeCache(cur_map);
 	}
 
 	// wipe everything else out
@@ -217,6 +255,10 @@ void GenericTilemapSetTransparent(INT32 which, UINT32 transparent)
 		return;
 	}
 
+	if (cur_map->transcolor != (INT32)transparent || (cur_map->flags & TMAP_TRANSPARENT) == 0) {
+		cur_map->all_dirty = 1;
+	}
+
 	memset (cur_map->transparent, 0, 256);	// set all to opaque
 
 	cur_map->transparent[transparent] = 1;	// one color opaque
@@ -239,14 +281,22 @@ void GenericTilemapSetTransMask(INT32 which, UINT16 transmask)
 		return;
 	}
 
-	memset (cur_map->transparent, 1, 256);
+	UINT8 transparent[256];
+
+	memset (transparent, 1, 256);
 
 	for (INT32 i = 0; i < 16; i++) {
 		if ((transmask & (1 << i)) == 0) {
-			cur_map->transparent[i] = 0;
+			transparent[i] = 0;
 		}
 	}
 
+	if (memcmp(cur_map->transparent, transparent, 256) != 0 || (cur_map->flags & TMAP_TRANSMASK) == 0) {
+		cur_map->all_dirty = 1;
+	}
+
+	memcpy (cur_map->transparent, transparent, 256);
+
 	cur_map->flags |= TMAP_TRANSMASK;
 }
 
@@ -269,6 +319,10 @@ void GenericTilemapSetTransTable(INT32 which, INT32 color, INT32 transparent)
 		return;
 	}
 
+	if (cur_map->transparent[color] != ((transparent) ? 1 : 0) || (cur_map->flags & TMAP_TRANSMASK) == 0) {
+		cur_map->all_dirty = 1;
+	}
+
 	cur_map->transparent[color] = (transparent) ? 1 : 0;
 	cur_map->flags |= TMAP_TRANSMASK;
 }	
@@ -515,8 +569,332 @@ void GenericTilemapSetEnable(INT32 which, INT32 enable)
 	cur_map->enable = enable ? 1 : 0;
 }
 
+void GenericTilemapUseDirtyTiles(INT32 which)
+{
+	if (which < 0 || which >= MAX_TILEMAPS) {
+		bprintf (0, _T("GenericTilemapUseDirtyTiles(%d); called with impossible tilemap!\n"), which);
+		return;
+	}
+
+	cur_map = &maps[which];
+
+	if (cur_map->initialized == 0) {
+		bprintf (0, _T("GenericTilemapUseDirtyTiles(%d); called without initialized tilemap!\n"), which);
+		return;
+	}
+
+	if (cur_map->use_cache) {
+		return;
+	}
+
+	UINT32 tiles = cur_map->mwidth * cur_map->mheight;
+	UINT32 pixels = (cur_map->mwidth * cur_map->twidth) * (cur_map->mheight * cur_map->theight);
+
+	cur_map->scan_table = (UINT32*)BurnMalloc(tiles * sizeof(UINT32));
+	if (cur_map->scan_table == NULL) {
+		GenericTilemapFreeCache(cur_map);
+		return;
+	}
+
+	// the scan is a pure function of col/row, do it once
+	cur_map->dirty_size = 0;
+	for (UINT32 row = 0; row < cur_map->mheight; row++) {
+		for (UINT32 col = 0; col < cur_map->mwidth; col++) {
+			UINT32 offs = cur_map->pScan(col, row);
+			cur_map->scan_table[(row * cur_map->mwidth) + col] = offs;
+			if (offs >= cur_map->dirty_size) cur_map->dirty_size = offs + 1;
+		}
+	}
+
+	cur_map->dirty = BurnMalloc(cur_map->dirty_size);
+	cur_map->cache_pixmap = (UINT16*)BurnMalloc(pixels * sizeof(UINT16));
+	cur_map->cache_flagmap = (UINT16*)BurnMalloc(pixels * sizeof(UINT16));
+	cur_map->cache_colscroll = (INT32*)BurnMalloc(cur_map->mwidth * sizeof(INT32));
+
+	if (cur_map->dirty == NULL || cur_map->cache_pixmap == NULL || cur_map->cache_flagmap == NULL || cur_map->cache_colscroll == NULL) {
+		bprintf (0, _T("GenericTilemapUseDirtyTiles(%d); couldn't allocate the cache, drawing uncached!\n"), which);
+		GenericTilemapFreeCache(cur_map);
+		return;
+	}
+
+	cur_map->use_cache = 1;
+	cur_map->all_dirty = 1;
+	cur_map->dirty_count = 0;
+}
+
+void GenericTilemapSetTileDirty(INT32 which, UINT32 offset)
+{
+	if (which < 0 || which >= MAX_TILEMAPS) {
+		bprintf (0, _T("GenericTilemapSetTileDirty(%d, 0x%x); called with impossible tilemap!\n"), which, offset);
+		return;
+	}
+
+	GenericTilemap *map = &maps[which];
+
+	// called from the vram write handlers, stay quiet if the cache isn't used
+	if (map->use_cache == 0 || offset >= map->dirty_size) {
+		return;
+	}
+
+	if (map->dirty[offset] == 0) {
+		map->dirty[offset] = 1;
+		map->dirty_count++;
+	}
+}
+
+void GenericTilemapAllTilesDirty(INT32 which)
+{
+	if (which >= MAX_TILEMAPS) {
+		bprintf (0, _T("GenericTilemapAllTilesDirty(%d); called with impossible tilemap!\n"), which);
+		return;
+	}
+
+	if (which == TMAP_GLOBAL) {
+		for (INT32 i = 0; i < MAX_TILEMAPS; i++) {
+			maps[i].all_dirty = 1;
+		}
+		return;
+	}
+
+	maps[which].all_dirty = 1;
+}
+
+// render one tile in the map cache, map pixels are laid out exactly like the uncached
+// path draws them with the tilemap flip and all the scrolling set to 0
+static void GenericTilemapCacheTile(GenericTilemap *map, UINT32 col, UINT32 row)
+{
+	INT32 code = 0, color = 0, gfxnum = 0;
+	UINT32 flags = 0;
+
+	UINT32 width = map->mwidth * map->twidth;
+	UINT16 *pix = map->cache_pixmap + (row * map->theight * width) + (col * map->twidth);
+	UINT16 *flg = map->cache_flagmap + (row * map->theight * width) + (col * map->twidth);
+
+	map->pTile(map->scan_table[(row * map->mwidth) + col], &gfxnum, &code, &color, &flags);
+
+	GenericTilemapGfx *gfx = &gfxdata[gfxnum];
+
+	if ((flags & TILE_SKIP) || gfx->gfxbase == NULL) {
+		for (UINT32 y = 0; y < map->theight; y++, flg += width) {
+			memset (flg, 0, map->twidth * sizeof(UINT16));
+		}
+		return;
+	}
+
+	UINT32 palette = ((color & gfx->color_mask) << gfx->depth) + gfx->color_offset;
+	code %= gfx->code_mask;
+
+	UINT16 tile_flags = CACHE_VALID;
+	if (flags & TILE_GROUP_ENABLE) {
+		tile_flags |= CACHE_GROUP | (((flags >> 16) & 0xff) << 8);
+	}
+
+	// same transparency rules as the uncached path
+	INT32 transcolor = -1;
+	UINT8 *transtab = NULL;
+	if ((flags & TILE_OPAQUE) == 0) {
+		if (map->flags & TMAP_TRANSPARENT) {
+			transcolor = map->transcolor;
+		} else if (map->flags & TMAP_TRANSMASK) {
+			transtab = map->transparent;
+		}
+	}
+
+	UINT8 *gfxsrc = gfx->gfxbase + (code * map->twidth * map->theight);
+	INT32 flip_wide = (flags & TILE_FLIPX) ? (map->twidth - 1) : 0;
+	INT32 step = (flags & TILE_FLIPX) ? -1 : 1;
+
+	for (UINT32 y = 0; y < map->theight; y++, pix += width, flg += width)
+	{
+		UINT8 *src = gfxsrc + (((flags & TILE_FLIPY) ? (map->theight - 1) - y : y) * map->twidth) + flip_wide;
+
+		for (UINT32 x = 0; x < map->twidth; x++, src += step)
+		{
+			pix[x] = palette + *src;
+			flg[x] = tile_flags;
+
+			if (*src != transcolor && (transtab == NULL || transtab[*src] == 0)) {
+				flg[x] |= CACHE_OPAQUE;
+			}
+		}
+	}
+}
+
+static void GenericTilemapUpdateCache(GenericTilemap *map)
+{
+	if (map->all_dirty)
+	{
+		for (UINT32 row = 0; row < map->mheight; row++) {
+			for (UINT32 col = 0; col < map->mwidth; col++) {
+				GenericTilemapCacheTile(map, col, row);
+			}
+		}
+	}
+	else if (map->dirty_count)
+	{
+		// several col/row can share an offset (mirrored maps), clear after the pass
+		for (UINT32 row = 0; row < map->mheight; row++) {
+			for (UINT32 col = 0; col < map->mwidth; col++) {
+				if (map->dirty[map->scan_table[(row * map->mwidth) + col]]) {
+					GenericTilemapCacheTile(map, col, row);
+				}
+			}
+		}
+	}
+	else
+	{
+		return;
+	}
+
+	memset (map->dirty, 0, map->dirty_size);
+	map->dirty_count = 0;
+	map->all_dirty = 0;
+}
+
+static inline INT32 GenericTilemapWrap(INT32 v, INT32 size)
+{
+	v %= size;
+
+	return (v < 0) ? (v + size) : v;
+}
+
+// pixels are drawn if valid (and opaque unless forced), tiles with a group only
+// if it's the group being drawn. Branchless so the compiler can vectorize it.
+#define CACHE_DRAW(f)	((((f) & (mask | CACHE_GROUP)) == mask) | (((f) & (mask | CACHE_GROUP | 0xff00)) == group))
+
+static void GenericTilemapCacheBlitRun(UINT16 *dest, UINT8 *prio, INT32 len, UINT16 *pix, UINT16 *flg, UINT16 mask, UINT16 group, UINT8 priority)
+{
+	for (INT32 x = 0; x < len; x++) {
+		INT32 draw = CACHE_DRAW(flg[x]);
+		dest[x] = draw ? pix[x] : dest[x];
+		prio[x] = draw ? priority : prio[x];
+	}
+}
+
+static void GenericTilemapCacheBlitRunFlipX(UINT16 *dest, UINT8 *prio, INT32 len, UINT16 *pix, UINT16 *flg, UINT16 mask, UINT16 group, UINT8 priority)
+{
+	for (INT32 x = 0; x < len; x++) {
+		INT32 draw = CACHE_DRAW(flg[-x]);
+		dest[x] = draw ? pix[-x] : dest[x];
+		prio[x] = draw ? priority : prio[x];
+	}
+}
+
+// copy len pixels of a map line starting at mx, wrapping around the map width
+static void GenericTilemapCacheBlitLine(UINT16 *dest, UINT8 *prio, INT32 len, UINT16 *pix, UINT16 *flg, INT32 mx, INT32 width, INT32 dir, UINT16 mask, UINT16 group, UINT8 priority)
+{
+	while (len > 0)
+	{
+		INT32 run;
+
+		if (dir > 0) {
+			run = (width - mx < len) ? (width - mx) : len;
+			GenericTilemapCacheBlitRun(dest, prio, run, pix + mx, flg + mx, mask, group, priority);
+			mx = 0;
+		} else {
+			run = (mx + 1 < len) ? (mx + 1) : len;
+			GenericTilemapCacheBlitRunFlipX(dest, prio, run, pix + mx, flg + mx, mask, group, priority);
+			mx = width - 1;
+		}
+
+		dest += run;
+		prio += run;
+		len -= run;
+	}
+}
+
+// draw the tilemap from its cache, uses the same scroll conventions as the uncached
+// paths, returns 1 if this combination of scrolling isn't handled (row and column)
+static INT32 GenericTilemapDrawCached(UINT16 *Bitmap, INT32 priority, INT32 opaque, INT32 tgroup, INT32 minx, INT32 maxx, INT32 miny, INT32 maxy)
+{
+	GenericTilemap *map = cur_map;
+
+	INT32 rowscroll = (map->scrollx_table != NULL) && (map->scroll_rows > 1);
+	INT32 colscroll = (map->scrolly_table != NULL) && (map->scroll_cols > 1);
+
+	if (rowscroll && colscroll) {
+		return 1;
+	}
+
+	GenericTilemapUpdateCache(map);
+
+	INT32 width = map->mwidth * map->twidth;
+	INT32 height = map->mheight * map->theight;
+	INT32 len = maxx - minx;
+
+	UINT16 mask = opaque ? CACHE_VALID : (CACHE_VALID | CACHE_OPAQUE);
+	UINT16 group = mask | CACHE_GROUP | (tgroup << 8);
+
+	// screen flip mirrors the whole screen, walk the map backwards
+	INT32 dir = (map->flags & TMAP_FLIPX) ? -1 : 1;
+	INT32 srcx = (map->flags & TMAP_FLIPX) ? ((nScreenWidth - 1) - minx) : minx;
+
+	if (colscroll) {
+		for (UINT32 col = 0; col < map->mwidth; col++) {
+			INT32 c = (col * map->scroll_cols) / map->mwidth;
+			map->cache_colscroll[col] = ((map->scrolly + map->scrolly_table[c]) % height) - map->yoffset;
+		}
+	}
+
+	for (INT32 y = miny; y < maxy; y++)
+	{
+		INT32 sy = (map->flags & TMAP_FLIPY) ? ((nScreenHeight - 1) - y) : y;
+
+		UINT16 *dest = Bitmap + (y * nScreenWidth) + minx;
+		UINT8 *prio = pPrioDraw + (y * nScreenWidth) + minx;
+
+		if (colscroll)
+		{
+			INT32 mx = GenericTilemapWrap(srcx + map->scrollx - map->xoffset, width);
+
+			for (INT32 x = 0; x < len; x++)
+			{
+				INT32 offs = (GenericTilemapWrap(sy + map->cache_colscroll[mx / map->twidth], height) * width) + mx;
+				UINT16 f = map->cache_flagmap[offs];
+
+				if (CACHE_DRAW(f)) {
+					dest[x] = map->cache_pixmap[offs];
+					prio[x] = priority;
+				}
+
+				mx += dir;
+				if (mx >= width) mx = 0;
+				else if (mx < 0) mx = width - 1;
+			}
+
+			continue;
+		}
+
+		INT32 my, scrollx;
+
+		if (rowscroll && map->scroll_rows > map->mheight)
+		{
+			// line scroll
+			my = GenericTilemapWrap(map->scrolly + sy + map->yoffset, height);
+			scrollx = map->scrollx_table[(my * map->scroll_rows) / height] - map->xoffset;
+		}
+		else
+		{
+			my = GenericTilemapWrap(sy + map->scrolly - map->yoffset, height);
+			scrollx = map->scrollx - map->xoffset;
+
+			if (rowscroll) {
+				scrollx += map->scrollx_table[((my / map->theight) * map->scroll_rows) / map->mheight];
+			}
+		}
+
+		GenericTilemapCacheBlitLine(dest, prio, len, map->cache_pixmap + (my * width), map->cache_flagmap + (my * width), GenericTilemapWrap(srcx + scrollx, width), width, dir, mask, group, priority);
+	}
+
+	return 0;
+}
+
+#undef CACHE_DRAW
+
 void GenericTilemapDraw(INT32 which, UINT16 *Bitmap, INT32 priority)
 {
+	BURN_PROF_SCOPE(BURN_PROF_TILEMAP);
+
 	if (Bitmap == NULL) {
 		bprintf (0, _T("GenericTilemapDraw(%d, Bitmap, %d); called without initialized Bitmap!\n"), which, priority);
 		return;
@@ -552,6 +930,12 @@ void GenericTilemapDraw(INT32 which, UINT16 *Bitmap, INT32 priority)
 	INT32 tgroup = (priority >> 8) & 0xff;
 	priority &= 0xff;
 
+	if (cur_map->use_cache) {
+		if (GenericTilemapDrawCached(Bitmap, priority, opaque, tgroup, minx, maxx, miny, maxy) == 0) {
+			return;
+		}
+	}
+
 	// line / column scroll
 	if ((cur_map->scrollx_table != NULL) && (cur_map->scroll_rows > cur_map->mheight))
 	{
@@ -139,3 +139,18 @@ void GenericTilemapSetEnable(INT32 which, INT32 enable);
 // Bitmap	- pointer to the bitmap to draw the tilemap
 // priority	- this will be used to set priority data, group is data passed in this variable using TILE_GROUP(x)
 void GenericTilemapDraw(INT32 which, UINT16 *Bitmap, INT32 priority);
+
+
+// Dirty tile cache (opt-in). The whole map is kept pre-rendered and only tiles marked
+// dirty are rendered again, GenericTilemapDraw then copies the visible part from it.
+// The driver must mark tiles dirty when their video ram is written, and all of them
+// when anything else used by the tile callback changes (gfx/palette bank, flags...).
+// Changes to the transparency and gfx settings invalidate the cache by themselves.
+// Row and column scroll together are drawn uncached.
+void GenericTilemapUseDirtyTiles(INT32 which);
+
+// Mark the tile at offset (the offset given to the tile callback) to be rendered again
+void GenericTilemapSetTileDirty(INT32 which, UINT32 offset);
+
+// Mark all tiles to be rendered again (TMAP_GLOBAL for all tilemaps)
+void GenericTilemapAllTilesDirty(INT32 which);
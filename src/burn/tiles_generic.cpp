@@ -14,10 +14,11 @@ Otherwise, use the Transfer code as usual.
 ================================================================================================*/
 
 #include "tiles_generic.h"
+#include "burn_prof.h"
 
-UINT8* pTileData;
-INT32 nScreenWidth, nScreenHeight;
-static INT32 nScreenWidthMax, nScreenHeightMax, nScreenWidthMin, nScreenHeightMin;
+BURN_THREAD UINT8* pTileData;
+BURN_THREAD INT32 nScreenWidth, nScreenHeight;
+static BURN_THREAD INT32 nScreenWidthMax, nScreenHeightMax, nScreenWidthMin, nScreenHeightMin;
 
 INT32 GenericTilesInit()
 {
@@ -124,10 +125,10 @@ void GenericTilesSetScanline(INT32 nScanline)
 // ----------------------------------------------------------------------------
 // Colour-depth independant image transfer
 
-UINT16* pTransDraw = NULL;
-UINT8 *pPrioDraw = NULL;
+BURN_THREAD UINT16* pTransDraw = NULL;
+BURN_THREAD UINT8 *pPrioDraw = NULL;
 
-static INT32 nTransWidth, nTransHeight;
+static BURN_THREAD INT32 nTransWidth, nTransHeight;
 
 void BurnTransferClear()
 {
@@ -142,6 +143,8 @@ void BurnTransferClear()
 
 INT32 BurnTransferCopy(UINT32* pPalette)
 {
+	BURN_PROF_SCOPE(BURN_PROF_TRANSFER);
+
 #if defined FBA_DEBUG
 	if (!Debug_BurnTransferInitted) bprintf(PRINT_ERROR, _T("BurnTransferCopy called without init\n"));
 #endif
@@ -151,35 +154,13 @@ INT32 BurnTransferCopy(UINT32* pPalette)
 	
 	pBurnDrvPalette = pPalette;
 
-	switch (nBurnBpp) {
-		case 2: {
-			for (INT32 y = 0; y < nTransHeight; y++, pSrc += nTransWidth, pDest += nBurnPitch) {
-				for (INT32 x = 0; x < nTransWidth; x ++) {
-					((UINT16*)pDest)[x] = pPalette[pSrc[x]];
-				}
-			}
-			break;
-		}
-		case 3: {
-			for (INT32 y = 0; y < nTransHeight; y++, pSrc += nTransWidth, pDest += nBurnPitch) {
-				for (INT32 x = 0; x < nTransWidth; x++) {
-					UINT32 c = pPalette[pSrc[x]];
-					*(pDest + (x * 3) + 0) = c & 0xFF;
-					*(pDest + (x * 3) + 1) = (c >> 8) & 0xFF;
-					*(pDest + (x * 3) + 2) = c >> 16;
+	BurnBlitLineFn pBlitLine = BurnBlitGetLine(nBurnBpp);
+	if (pBlitLine == NULL) {
+		return 0;
+	}
 
-				}
-			}
-			break;
-		}
-		case 4: {
-			for (INT32 y = 0; y < nTransHeight; y++, pSrc += nTransWidth, pDest += nBurnPitch) {
-				for (INT32 x = 0; x < nTransWidth; x++) {
-					((UINT32*)pDest)[x] = pPalette[pSrc[x]];
-				}
-			}
-			break;
-		}
+	for (INT32 y = 0; y < nTransHeight; y++, pSrc += nTransWidth, pDest += nBurnPitch) {
+		pBlitLine(pDest, pSrc, pPalette, nTransWidth);
 	}
 
 	return 0;
@@ -228,9 +209,29 @@ INT32 BurnTransferInit()
 
 	BurnTransferClear();
 
+	BurnBlitInit();
+
 	return 0;
 }
 
+// the screen and the transfer buffers of a machine (burn_machine.h)
+void GenericTilesMachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(pTileData);
+	BURN_MACHINE_AREA(nScreenWidth);
+	BURN_MACHINE_AREA(nScreenHeight);
+	BURN_MACHINE_AREA(nScreenWidthMax);
+	BURN_MACHINE_AREA(nScreenHeightMax);
+	BURN_MACHINE_AREA(nScreenWidthMin);
+	BURN_MACHINE_AREA(nScreenHeightMin);
+	BURN_MACHINE_AREA(pTransDraw);
+	BURN_MACHINE_AREA(pPrioDraw);
+	BURN_MACHINE_AREA(nTransWidth);
+	BURN_MACHINE_AREA(nTransHeight);
+	BURN_MACHINE_AREA(Debug_GenericTilesInitted);
+	BURN_MACHINE_AREA(Debug_BurnTransferInitted);
+}
+
 /*================================================================================================
 Graphics Decoding
 ================================================================================================*/
@@ -1,8 +1,9 @@
 #include "burnint.h"
 #include "tilemap_generic.h"
+#include "burn_blit.h"
 
-extern UINT8* pTileData;
-extern INT32 nScreenWidth, nScreenHeight;
+extern BURN_THREAD UINT8* pTileData;
+extern BURN_THREAD INT32 nScreenWidth, nScreenHeight;
 
 INT32 GenericTilesInit();
 INT32 GenericTilesExit();
@@ -193,8 +194,8 @@ void RenderCustomTile_Prio_TransMask_FlipXY_Clip(UINT16* pDestDraw, INT32 nWidth
 // ---------------------------------------------------------------------------
 // Colour-depth independant image transfer
 
-extern UINT16* pTransDraw;
-extern UINT8* pPrioDraw;
+extern BURN_THREAD UINT16* pTransDraw;
+extern BURN_THREAD UINT8* pPrioDraw;
 
 void BurnTransferClear();
 INT32 BurnTransferCopy(UINT32* pPalette);
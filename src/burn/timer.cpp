@@ -13,18 +13,18 @@
 
 #define MAX_TIMER_VALUE ((1 << 30) - 65536)
 
-double dTime;									// Time elapsed since the emulated machine was started
+BURN_THREAD double dTime;						// Time elapsed since the emulated machine was started
 
-static INT32 nTimerCount[2], nTimerStart[2];
+static BURN_THREAD INT32 nTimerCount[2], nTimerStart[2];
 
 // Callbacks
-static INT32 (*pTimerOverCallback)(INT32, INT32);
-static double (*pTimerTimeCallback)();
+static BURN_THREAD INT32 (*pTimerOverCallback)(INT32, INT32);
+static BURN_THREAD double (*pTimerTimeCallback)();
 
-static INT32 nCPUClockspeed = 0;
-static INT32 (*pCPUTotalCycles)() = NULL;
-static INT32 (*pCPURun)(INT32) = NULL;
-static void (*pCPURunEnd)() = NULL;
+static BURN_THREAD INT32 nCPUClockspeed = 0;
+static BURN_THREAD INT32 (*pCPUTotalCycles)() = NULL;
+static BURN_THREAD INT32 (*pCPURun)(INT32) = NULL;
+static BURN_THREAD void (*pCPURunEnd)() = NULL;
 
 // ---------------------------------------------------------------------------
 // Running time
@@ -42,7 +42,7 @@ extern "C" double BurnTimerGetTime()
 // ---------------------------------------------------------------------------
 // Update timers
 
-static INT32 nTicksTotal, nTicksDone, nTicksExtra;
+static BURN_THREAD INT32 nTicksTotal, nTicksDone, nTicksExtra;
 
 INT32 BurnTimerUpdate(INT32 nCycles)
 {
@@ -292,7 +292,7 @@ INT32 BurnTimerInit(INT32 (*pOverCallback)(INT32, INT32), double (*pTimeCallback
 }
 
 // Null CPU, for a FM timer that isn't attached to anything.
-static INT32 NullCyclesTotal;
+static BURN_THREAD INT32 NullCyclesTotal;
 
 void NullNewFrame()
 {
@@ -483,3 +483,20 @@ INT32 BurnTimerAttachTlcs90(INT32 nClockspeed)
 	return 0;
 }
 
+// the timer state of a machine (burn_machine.h)
+void BurnTimerMachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(dTime);
+	BURN_MACHINE_AREA(nTimerCount);
+	BURN_MACHINE_AREA(nTimerStart);
+	BURN_MACHINE_AREA(pTimerOverCallback);
+	BURN_MACHINE_AREA(pTimerTimeCallback);
+	BURN_MACHINE_AREA(nCPUClockspeed);
+	BURN_MACHINE_AREA(pCPUTotalCycles);
+	BURN_MACHINE_AREA(pCPURun);
+	BURN_MACHINE_AREA(pCPURunEnd);
+	BURN_MACHINE_AREA(nTicksTotal);
+	BURN_MACHINE_AREA(nTicksDone);
+	BURN_MACHINE_AREA(nTicksExtra);
+	BURN_MACHINE_AREA(NullCyclesTotal);
+}
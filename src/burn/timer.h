@@ -15,7 +15,7 @@ void BurnYMFTimerCallback(INT32 n, INT32 c, double period);				// period in us
 void BurnTimerSetRetrig(INT32 c, double period);						// period in  s
 void BurnTimerSetOneshot(INT32 c, double period);						// period in  s
 
-extern double dTime;
+extern BURN_THREAD double dTime;
 
 void BurnTimerExit();
 void BurnTimerReset();
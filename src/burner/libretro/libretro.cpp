@@ -79,6 +79,7 @@ void IpsApplyPatches(UINT8 *, char *) {}
 
 TCHAR szAppHiscorePath[MAX_PATH];
 TCHAR szAppSamplesPath[MAX_PATH];
+TCHAR szAppCachePath[MAX_PATH];
 TCHAR szAppBurnVer[16];
 
 CDEmuStatusValue CDEmuStatus;
@@ -8,6 +8,7 @@ bool bDoIpsPatch;
 
 TCHAR szAppBurnVer[16];
 TCHAR szAppBlendPath[MAX_PATH];
+TCHAR szAppCachePath[MAX_PATH];
 
 int nAppVirtualFps = 6000;
 
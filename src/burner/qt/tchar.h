@@ -8,6 +8,8 @@
 #define TCHAR char
 #define _T(x) x
 #define _tfopen fopen
+#define _tremove remove
+#define _trename rename
 #define _tcstol strtol
 #define _tcsstr strstr
 #define _istspace(x) isspace(x)
@@ -23,5 +23,6 @@ TCHAR szAppArchivesPath[MAX_PATH]	= _T("support\\archives\\");
 TCHAR szAppHiscorePath[MAX_PATH]	= _T("support\\hiscores\\");
 TCHAR szAppSamplesPath[MAX_PATH]	= _T("support\\samples\\");
 TCHAR szAppBlendPath[MAX_PATH]		= _T("support\\blend\\");
+TCHAR szAppCachePath[MAX_PATH];
 
 TCHAR szCheckIconsPath[MAX_PATH];
@@ -45,6 +45,8 @@ typedef char	_TCHAR;
 #define	_istspace   isspace
 
 #define _tfopen     fopen
+#define _tremove    remove
+#define _trename    rename
 
 #define _stricmp    strcmp
 #define _strnicmp   strncmp
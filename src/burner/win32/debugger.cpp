@@ -31,7 +31,7 @@ static int nMemdumpAttrib;
 static bool bBreakpointHit;
 
 #if defined FBA_DEBUG
-extern UINT8 DebugCPU_SekInitted;
+extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 #endif
 
 struct DbgM68000State {
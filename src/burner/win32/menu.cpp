@@ -1318,7 +1318,7 @@ void MenuEnableItems()
 			}
 
 #if defined (FBA_DEBUG)
-			extern UINT8 DebugCPU_SekInitted;
+			extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 			if (DebugCPU_SekInitted) {
 				EnableMenuItem(hMenu, MENU_DEBUG,		MF_ENABLED | MF_BYCOMMAND);
 			} else {
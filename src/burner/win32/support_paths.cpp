@@ -13,6 +13,7 @@ TCHAR szAppSamplesPath[MAX_PATH]	= _T("support/samples/");
 TCHAR szAppIpsPath[MAX_PATH]		= _T("support/ips/");
 TCHAR szAppIconsPath[MAX_PATH]		= _T("support/icons/");
 TCHAR szAppBlendPath[MAX_PATH]		= _T("support/blend/");
+TCHAR szAppCachePath[MAX_PATH];
 TCHAR szAppSelectPath[MAX_PATH]		= _T("support/select/");
 TCHAR szAppVersusPath[MAX_PATH]		= _T("support/versus/");
 TCHAR szAppHowtoPath[MAX_PATH]		= _T("support/howto/");
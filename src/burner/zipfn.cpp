@@ -3,6 +3,7 @@
 #include "unzip.h"
 
 #ifdef INCLUDE_7Z_SUPPORT
+#include <atomic>
 #include "un7z.h"
 #endif
 
@@ -17,6 +18,21 @@ static INT32 nCurrFile = 0; // The current file we are pointing to
 
 #ifdef INCLUDE_7Z_SUPPORT
 static _7z_file* _7ZipFile = NULL;
+
+// un7z keeps the closed files in a cache of its own, ZipGetListFile() can open
+// and close them from another thread
+static std::atomic_flag _7ZipCacheLock = ATOMIC_FLAG_INIT;
+
+static void _7ZipLock()
+{
+	while (_7ZipCacheLock.test_and_set(std::memory_order_acquire)) {
+	}
+}
+
+static void _7ZipUnlock()
+{
+	_7ZipCacheLock.clear(std::memory_order_release);
+}
 #endif
 
 INT32 ZipOpen(char* szZip)
@@ -39,7 +55,9 @@ INT32 ZipOpen(char* szZip)
 	
 #ifdef INCLUDE_7Z_SUPPORT
 	sprintf(szFileName, "%s.7z", szZip);
+	_7ZipLock();
 	_7z_error _7zerr = 	_7z_file_open(szFileName, &_7ZipFile);
+	_7ZipUnlock();
 	if (_7zerr == _7ZERR_NONE) {
 		nFileType = ZIPFN_FILETYPE_7ZIP;
 		nCurrFile = 0;
@@ -63,7 +81,9 @@ INT32 ZipClose()
 #ifdef INCLUDE_7Z_SUPPORT
 	if (nFileType == ZIPFN_FILETYPE_7ZIP) {
 		if (_7ZipFile != NULL) {
+			_7ZipLock();
 			_7z_file_close(_7ZipFile);
+			_7ZipUnlock();
 			_7ZipFile = NULL;
 		}
 	}
@@ -74,126 +94,182 @@ INT32 ZipClose()
 	return 0;
 }
 
-// Get the contents of a zip file into an array of ZipEntrys
-INT32 ZipGetList(struct ZipEntry** pList, INT32* pnListCount)
+// List the entries of an open zip file
+static INT32 ZipListZip(unzFile hZip, struct ZipEntry** pList, INT32* pnListCount)
 {
-	if (nFileType == ZIPFN_FILETYPE_ZIP && Zip == NULL) return 1;
-	if (pList == NULL) return 1;
+	unz_global_info ZipGlobalInfo;
+	memset(&ZipGlobalInfo, 0, sizeof(ZipGlobalInfo));
 	
-#ifdef INCLUDE_7Z_SUPPORT
-	if (nFileType == ZIPFN_FILETYPE_7ZIP && _7ZipFile == NULL) return 1;	
-#endif
-	
-	if (nFileType == ZIPFN_FILETYPE_ZIP) {
-		unz_global_info ZipGlobalInfo;
-		memset(&ZipGlobalInfo, 0, sizeof(ZipGlobalInfo));
-		
-		unzGetGlobalInfo(Zip, &ZipGlobalInfo);
-		INT32 nListLen = ZipGlobalInfo.number_entry;
+	unzGetGlobalInfo(hZip, &ZipGlobalInfo);
+	INT32 nListLen = ZipGlobalInfo.number_entry;
 
-		// Make an array of File Entries
-		struct ZipEntry* List = (struct ZipEntry *)malloc(nListLen * sizeof(struct ZipEntry));
-		if (List == NULL) { unzClose(Zip); return 1; }
-		memset(List, 0, nListLen * sizeof(struct ZipEntry));
+	// Make an array of File Entries
+	struct ZipEntry* List = (struct ZipEntry *)malloc(nListLen * sizeof(struct ZipEntry));
+	if (List == NULL) return 1;
+	memset(List, 0, nListLen * sizeof(struct ZipEntry));
 
-		INT32 nRet = unzGoToFirstFile(Zip);
-		if (nRet != UNZ_OK) { unzClose(Zip); return 1; }
+	INT32 nRet = unzGoToFirstFile(hZip);
+	if (nRet != UNZ_OK) { free(List); return 1; }
 
-		// Step through all of the files, until we get to the end
-		INT32 nNextRet = 0;
+	// Step through all of the files, until we get to the end
+	INT32 nFile = 0, nNextRet = 0;
 
-		for (nCurrFile = 0, nNextRet = UNZ_OK;
-			nCurrFile < nListLen && nNextRet == UNZ_OK;
-			nCurrFile++, nNextRet = unzGoToNextFile(Zip))
-		{
-			unz_file_info FileInfo;
-			memset(&FileInfo, 0, sizeof(FileInfo));
+	for (nFile = 0, nNextRet = UNZ_OK;
+		nFile < nListLen && nNextRet == UNZ_OK;
+		nFile++, nNextRet = unzGoToNextFile(hZip))
+	{
+		unz_file_info FileInfo;
+		memset(&FileInfo, 0, sizeof(FileInfo));
 
-			nRet = unzGetCurrentFileInfo(Zip, &FileInfo, NULL, 0, NULL, 0, NULL, 0);
-			if (nRet != UNZ_OK) continue;
+		nRet = unzGetCurrentFileInfo(hZip, &FileInfo, NULL, 0, NULL, 0, NULL, 0);
+		if (nRet != UNZ_OK) continue;
+
+		// Allocate space for the filename
+		char* szName = (char *)malloc(FileInfo.size_filename + 1);
+		if (szName == NULL) continue;
+
+		nRet = unzGetCurrentFileInfo(hZip, &FileInfo, szName, FileInfo.size_filename + 1, NULL, 0, NULL, 0);
+		if (nRet != UNZ_OK) continue;
 
-			// Allocate space for the filename
-			char* szName = (char *)malloc(FileInfo.size_filename + 1);
-			if (szName == NULL) continue;
+		List[nFile].szName = szName;
+		List[nFile].nLen = FileInfo.uncompressed_size;
+		List[nFile].nCrc = FileInfo.crc;
+	}
+
+	// return the file list
+	*pList = List;
+	if (pnListCount != NULL) *pnListCount = nListLen;
 
-			nRet = unzGetCurrentFileInfo(Zip, &FileInfo, szName, FileInfo.size_filename + 1, NULL, 0, NULL, 0);
-			if (nRet != UNZ_OK) continue;
+	return 0;
+}
 
-			List[nCurrFile].szName = szName;
-			List[nCurrFile].nLen = FileInfo.uncompressed_size;
-			List[nCurrFile].nCrc = FileInfo.crc;
+#ifdef INCLUDE_7Z_SUPPORT
+// List the entries of an open 7z file
+static INT32 ZipList7z(_7z_file* p7z, struct ZipEntry** pList, INT32* pnListCount)
+{
+	UInt16 *temp = NULL;
+	size_t tempSize = 0;
+	
+	INT32 nListLen = p7z->db.NumFiles, nFile = 0;
+
+	// Make an array of File Entries
+	struct ZipEntry* List = (struct ZipEntry *)malloc(nListLen * sizeof(struct ZipEntry));
+	if (List == NULL) return 1;
+	memset(List, 0, nListLen * sizeof(struct ZipEntry));
+	
+	for (UINT32 i = 0; i < p7z->db.NumFiles; i++) {
+		size_t len = SzArEx_GetFileNameUtf16(&p7z->db, i, NULL);
+
+		// if it's a directory entry we don't care about it..
+		if (SzArEx_IsDir(&p7z->db, i)) continue;
+
+		if (len > tempSize) {
+			SZipFree(NULL, temp);
+			tempSize = len;
+			temp = (UInt16 *)SZipAlloc(NULL, tempSize * sizeof(temp[0]));
+			if (temp == 0) {
+				return 1; // memory error
+			}
 		}
+		
+		UINT64 size = SzArEx_GetFileSize(&p7z->db, i);
+		UINT32 crc = p7z->db.CRCs.Vals[i];
+		
+		SzArEx_GetFileNameUtf16(&p7z->db, i, temp);
+		
+		// convert filename to char
+		char *szFileName = NULL;
+		szFileName = (char*)malloc(len * 2 * sizeof(char*));
+		if (szFileName == NULL) continue;
+		
+		for (UINT32 j = 0; j < len; j++) {
+			szFileName[j + 0] = temp[j] & 0xff;
+			szFileName[j + 1] = temp[j] >> 8;
+		}
+		
+		List[nFile].szName = szFileName;
+		List[nFile].nLen = size;
+		List[nFile].nCrc = crc;
+		
+		nFile++;
+	}
+	
+	// return the file list
+	*pList = List;
+	if (pnListCount != NULL) *pnListCount = nListLen;
+	
+	SZipFree(NULL, temp);
 
-		// return the file list
-		*pList = List;
-		if (pnListCount != NULL) *pnListCount = nListLen;
+	return 0;
+}
+#endif
 
+// Get the contents of a zip file into an array of ZipEntrys
+INT32 ZipGetList(struct ZipEntry** pList, INT32* pnListCount)
+{
+	if (nFileType == ZIPFN_FILETYPE_ZIP && Zip == NULL) return 1;
+	if (pList == NULL) return 1;
+	
+#ifdef INCLUDE_7Z_SUPPORT
+	if (nFileType == ZIPFN_FILETYPE_7ZIP && _7ZipFile == NULL) return 1;	
+#endif
+	
+	if (nFileType == ZIPFN_FILETYPE_ZIP) {
+		if (ZipListZip(Zip, pList, pnListCount)) {
+			ZipClose();
+			return 1;
+		}
 		unzGoToFirstFile(Zip);
 		nCurrFile = 0;
 	}
 	
 #ifdef INCLUDE_7Z_SUPPORT
 	if (nFileType == ZIPFN_FILETYPE_7ZIP) {
-		UInt16 *temp = NULL;
-		size_t tempSize = 0;
-		
-		INT32 nListLen = _7ZipFile->db.NumFiles;
-
-		// Make an array of File Entries
-		struct ZipEntry* List = (struct ZipEntry *)malloc(nListLen * sizeof(struct ZipEntry));
-		if (List == NULL) return 1;
-		memset(List, 0, nListLen * sizeof(struct ZipEntry));
-		
-		for (UINT32 i = 0; i < _7ZipFile->db.NumFiles; i++) {
-			size_t len = SzArEx_GetFileNameUtf16(&_7ZipFile->db, i, NULL);
-
-			// if it's a directory entry we don't care about it..
-			if (SzArEx_IsDir(&_7ZipFile->db, i)) continue;
-
-			if (len > tempSize) {
-				SZipFree(NULL, temp);
-				tempSize = len;
-				temp = (UInt16 *)SZipAlloc(NULL, tempSize * sizeof(temp[0]));
-				if (temp == 0) {
-					return 1; // memory error
-				}
-			}
-			
-			UINT64 size = SzArEx_GetFileSize(&_7ZipFile->db, i);
-			UINT32 crc = _7ZipFile->db.CRCs.Vals[i];
-			
-			SzArEx_GetFileNameUtf16(&_7ZipFile->db, i, temp);
-			
-			// convert filename to char
-			char *szFileName = NULL;
-			szFileName = (char*)malloc(len * 2 * sizeof(char*));
-			if (szFileName == NULL) continue;
-			
-			for (UINT32 j = 0; j < len; j++) {
-				szFileName[j + 0] = temp[j] & 0xff;
-				szFileName[j + 1] = temp[j] >> 8;
-			}
-			
-			List[nCurrFile].szName = szFileName;
-			List[nCurrFile].nLen = size;
-			List[nCurrFile].nCrc = crc;
-			
-			nCurrFile++;
+		if (ZipList7z(_7ZipFile, pList, pnListCount)) {
+			return 1;
 		}
-		
-		// return the file list
-		*pList = List;
-		if (pnListCount != NULL) *pnListCount = nListLen;
-		
 		nCurrFile = 0;
-		
-		SZipFree(NULL, temp);
 	}
 #endif
 		
 	return 0;
 }
 
+// Get the contents of archive szZip (.zip or .7z) with a handle of its own: the
+// file ZipOpen() opened stays as it is, so another thread can use this meanwhile
+INT32 ZipGetListFile(char* szZip, struct ZipEntry** pList, INT32* pnListCount)
+{
+	if (szZip == NULL || pList == NULL) return 1;
+
+	char szFileName[MAX_PATH];
+	INT32 nRet;
+
+	sprintf(szFileName, "%s.zip", szZip);
+	unzFile hZip = unzOpen(szFileName);
+	if (hZip != NULL) {
+		nRet = ZipListZip(hZip, pList, pnListCount);
+		unzClose(hZip);
+		return nRet;
+	}
+
+#ifdef INCLUDE_7Z_SUPPORT
+	_7z_file* p7z = NULL;
+	sprintf(szFileName, "%s.7z", szZip);
+	_7ZipLock();
+	_7z_error _7zerr = _7z_file_open(szFileName, &p7z);
+	_7ZipUnlock();
+	if (_7zerr == _7ZERR_NONE) {
+		nRet = ZipList7z(p7z, pList, pnListCount);
+		_7ZipLock();
+		_7z_file_close(p7z);
+		_7ZipUnlock();
+		return nRet;
+	}
+#endif
+
+	return 1;
+}
+
 INT32 ZipLoadFile(UINT8* Dest, INT32 nLen, INT32* pnWrote, INT32 nEntry)
 {
 	if (nFileType == ZIPFN_FILETYPE_ZIP && Zip == NULL) return 1;
@@ -37,6 +37,7 @@
 #include "burnint.h"
 #include "arm7core.h"
 #include "arm7_intf.h"
+#include "burn_prof.h"
 
 #if defined __GNUC__
 __extension__ typedef unsigned long long	UINT64;
@@ -171,6 +172,8 @@ int Arm7Run(int cycles)
 	if (!DebugCPU_ARM7Initted) bprintf(PRINT_ERROR, _T("Arm7Run called without init\n"));
 #endif
 
+	BURN_PROF_SCOPE(BURN_PROF_ARM7);
+
 /* include the arm7 core execute code */
 #include "arm7exec.c"
 }
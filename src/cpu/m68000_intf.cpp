@@ -2,19 +2,35 @@
 #include "burnint.h"
 #include "m68000_intf.h"
 #include "m68000_debug.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
+
+#if defined M68K_X64_DRC && defined FBA_DEBUG
+#undef M68K_X64_DRC										// breakpoints need the interpreter
+#endif
+#if defined M68K_X64_DRC && defined BURN_MACHINES
+#undef M68K_X64_DRC										// the code is built for one thread's registers
+#endif
+#ifdef M68K_X64_DRC
+#include "m68k_x64.h"
+#endif
 
 #ifdef EMU_M68K
-INT32 nSekM68KContextSize[SEK_MAX];
-INT8* SekM68KContext[SEK_MAX];
+BURN_THREAD INT32 nSekM68KContextSize[SEK_MAX];
+BURN_THREAD INT8* SekM68KContext[SEK_MAX];
 #endif
 
-INT32 nSekCount = -1;							// Number of allocated 68000s
-struct SekExt *SekExt[SEK_MAX] = { NULL, }, *pSekExt = NULL;
+BURN_THREAD INT32 nSekCount = -1;				// Number of allocated 68000s
+BURN_THREAD struct SekExt *SekExt[SEK_MAX] = { NULL, }, *pSekExt = NULL;
 
-INT32 nSekActive = -1;								// The cpu which is currently being emulated
-INT32 nSekCyclesTotal, nSekCyclesScanline, nSekCyclesSegment, nSekCyclesDone, nSekCyclesToDo;
+BURN_THREAD INT32 nSekActive = -1;					// The cpu which is currently being emulated
+BURN_THREAD INT32 nSekCyclesTotal, nSekCyclesScanline, nSekCyclesSegment, nSekCyclesDone, nSekCyclesToDo;
 
-INT32 nSekCPUType[SEK_MAX], nSekCycles[SEK_MAX], nSekIRQPending[SEK_MAX];
+BURN_THREAD INT32 nSekCPUType[SEK_MAX], nSekCycles[SEK_MAX], nSekIRQPending[SEK_MAX];
+
+#ifdef M68K_X64_DRC
+static bool bSekUseRecompiler = false;				// 68000s run translated blocks (SekUseRecompiler)
+#endif
 
 #if defined (FBA_DEBUG)
 
@@ -252,6 +268,9 @@ inline static void WriteByte(UINT32 a, UINT8 d)
 		return;
 	}
 	pSekExt->WriteByte[(uintptr_t)pr](a, d);
+#ifdef M68K_X64_DRC
+	M68KX64HandlerWrote();
+#endif
 }
 
 inline static void WriteByteROM(UINT32 a, UINT8 d)
@@ -264,6 +283,9 @@ inline static void WriteByteROM(UINT32 a, UINT8 d)
 	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
 		a ^= 1;
 		pr[a & SEK_PAGEM] = (UINT8)d;
+#ifdef M68K_X64_DRC
+		M68KX64CodeChanged(a);
+#endif
 		return;
 	}
 	pSekExt->WriteByte[(uintptr_t)pr](a, d);
@@ -339,6 +361,9 @@ inline static void WriteWord(UINT32 a, UINT16 d)
 	}
 
 	pSekExt->WriteWord[(uintptr_t)pr](a, d);
+#ifdef M68K_X64_DRC
+	M68KX64HandlerWrote();
+#endif
 }
 
 inline static void WriteWordROM(UINT32 a, UINT16 d)
@@ -350,6 +375,9 @@ inline static void WriteWordROM(UINT32 a, UINT16 d)
 	pr = FIND_R(a);
 	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
 		*((UINT16*)(pr + (a & SEK_PAGEM))) = (UINT16)d;
+#ifdef M68K_X64_DRC
+		M68KX64CodeChanged(a);
+#endif
 		return;
 	}
 	pSekExt->WriteWord[(uintptr_t)pr](a, d);
@@ -459,6 +487,9 @@ inline static void WriteLong(UINT32 a, UINT32 d)
 		}
 	}
 	pSekExt->WriteLong[(uintptr_t)pr](a, d);
+#ifdef M68K_X64_DRC
+	M68KX64HandlerWrote();
+#endif
 }
 
 inline static void WriteLongROM(UINT32 a, UINT32 d)
@@ -471,6 +502,10 @@ inline static void WriteLongROM(UINT32 a, UINT32 d)
 	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
 		d = (d >> 16) | (d << 16);
 		*((UINT32*)(pr + (a & SEK_PAGEM))) = d;
+#ifdef M68K_X64_DRC
+		M68KX64CodeChanged(a);
+		M68KX64CodeChanged(a + 2);
+#endif
 		return;
 	}
 	pSekExt->WriteLong[(uintptr_t)pr](a, d);
@@ -887,6 +922,17 @@ static INT32 SekInitCPUM68K(INT32 nCount, INT32 nCPUType)
 {
 	nSekCPUType[nCount] = nCPUType;
 
+	// the core runs on the context in place, SekOpen() only points it there
+	nSekM68KContextSize[nCount] = m68k_context_size();
+	SekM68KContext[nCount] = (INT8*)malloc(nSekM68KContextSize[nCount]);
+	if (SekM68KContext[nCount] == NULL) {
+		return 1;
+	}
+	memset(SekM68KContext[nCount], 0, nSekM68KContextSize[nCount]);
+	m68k_set_context_ptr(SekM68KContext[nCount]);
+
+	m68k_init();
+
 	switch (nCPUType) {
 		case 0x68000:
 			m68k_set_cpu_type(M68K_CPU_TYPE_68000);
@@ -901,14 +947,6 @@ static INT32 SekInitCPUM68K(INT32 nCount, INT32 nCPUType)
 			return 1;
 	}
 
-	nSekM68KContextSize[nCount] = m68k_context_size();
-	SekM68KContext[nCount] = (INT8*)malloc(nSekM68KContextSize[nCount]);
-	if (SekM68KContext[nCount] == NULL) {
-		return 1;
-	}
-	memset(SekM68KContext[nCount], 0, nSekM68KContextSize[nCount]);
-	m68k_get_context(SekM68KContext[nCount]);
-
 	return 0;
 }
 #endif
@@ -941,6 +979,50 @@ static UINT8 SekCheatRead(UINT32 a)
 	return SekReadByte(a);
 }
 
+static UINT8 *SekCheatPage(UINT32 a)
+{
+	a &= 0xFFFFFF;
+
+	UINT8* pr = FIND_R(a);
+	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
+		return pr;
+	}
+	return NULL;
+}
+
+static UINT8 *SekIdleFetch(UINT32 a)
+{
+	a &= 0xFFFFFF;
+
+	UINT8* pr = FIND_F(a);
+	if ((uintptr_t)pr >= SEK_MAXHANDLER) {
+		return pr;
+	}
+	return NULL;
+}
+
+static UINT32 SekIdleReg(INT32 n)
+{
+	return SekDbgGetRegister((SekRegister)(SEK_REG_D0 + n));
+}
+
+static UINT32 SekIdlePC()
+{
+	return SekGetPC(-1);
+}
+
+static BurnIdleCpu SekIdleCpu =
+{
+	BURN_IDLE_M68K,
+	SekIdleFetch,
+	SekCheatPage,
+	SEK_PAGE_SIZE,
+	1,		// pages are word swapped
+	SekIdleReg,
+	SekIdlePC,
+	SekIdle
+};
+
 static cpu_core_config SekCheatCpuConfig =
 {
 	SekOpen,
@@ -954,7 +1036,10 @@ static cpu_core_config SekCheatCpuConfig =
 	SekRunEnd,
 	SekReset,
 	(1<<24),	// 0x1000000
-	0
+	0,
+	SekCheatPage,
+	SEK_PAGE_SIZE,
+	1		// pages are word swapped
 };
 
 INT32 SekInit(INT32 nCount, INT32 nCPUType)
@@ -1069,9 +1154,6 @@ INT32 SekInit(INT32 nCount, INT32 nCPUType)
 	}
 #endif
 
-	// Map the normal memory handlers
-	SekDbgDisableBreakpoints();
-
 #ifdef EMU_A68K
 	if (bBurnUseASMCPUEmulation && nCPUType == 0x68000) {
 		if (SekInitCPUA68K(nCount, nCPUType)) {
@@ -1082,17 +1164,26 @@ INT32 SekInit(INT32 nCount, INT32 nCPUType)
 #endif
 
 #ifdef EMU_M68K
-		m68k_init();
 		if (SekInitCPUM68K(nCount, nCPUType)) {
 			SekExit();
 			return 1;
 		}
 #endif
 
+#ifdef M68K_X64_DRC
+		if (nCPUType == 0x68000 && M68KX64Init(nCount)) {
+			SekExit();
+			return 1;
+		}
+#endif
+
 #ifdef EMU_A68K
 	}
 #endif
 
+	// Map the normal memory handlers (after the init, the hook is in the new cpu's context)
+	SekDbgDisableBreakpoints();
+
 	nSekCycles[nCount] = 0;
 	nSekIRQPending[nCount] = 0;
 
@@ -1152,6 +1243,14 @@ INT32 SekExit()
 
 	pSekExt = NULL;
 
+#ifdef EMU_M68K
+	m68k_set_context_ptr(NULL);
+#endif
+
+#ifdef M68K_X64_DRC
+	M68KX64Exit();
+#endif
+
 	nSekActive = -1;
 	nSekCount = -1;
 	
@@ -1160,6 +1259,28 @@ INT32 SekExit()
 	return 0;
 }
 
+// the interface state of a machine (burn_machine.h), SekOpen() points the core at the open cpu
+void SekMachineAreas(BurnMachineAreaCallback pArea)
+{
+#ifdef EMU_M68K
+	BURN_MACHINE_AREA(nSekM68KContextSize);
+	BURN_MACHINE_AREA(SekM68KContext);
+#endif
+	BURN_MACHINE_AREA(nSekCount);
+	BURN_MACHINE_AREA(SekExt);
+	BURN_MACHINE_AREA(pSekExt);
+	BURN_MACHINE_AREA(nSekActive);
+	BURN_MACHINE_AREA(nSekCyclesTotal);
+	BURN_MACHINE_AREA(nSekCyclesScanline);
+	BURN_MACHINE_AREA(nSekCyclesSegment);
+	BURN_MACHINE_AREA(nSekCyclesDone);
+	BURN_MACHINE_AREA(nSekCyclesToDo);
+	BURN_MACHINE_AREA(nSekCPUType);
+	BURN_MACHINE_AREA(nSekCycles);
+	BURN_MACHINE_AREA(nSekIRQPending);
+	BURN_MACHINE_AREA(DebugCPU_SekInitted);
+}
+
 void SekReset()
 {
 #if defined FBA_DEBUG
@@ -1205,6 +1326,8 @@ void SekOpen(const INT32 i)
 		pSekExt = SekExt[nSekActive];						// Point to cpu context
 
 #ifdef EMU_A68K
+		// a68k.asm addresses the one M68000_regs directly, so A68K cpus still copy
+		// their registers in here and out in SekClose(), each way on every switch
 		if (nSekCPUType[nSekActive] == 0) {
 			memcpy(&M68000_regs, SekRegs[nSekActive], sizeof(M68000_regs));
 			A68KChangePC(M68000_regs.pc);
@@ -1212,7 +1335,7 @@ void SekOpen(const INT32 i)
 #endif
 
 #ifdef EMU_M68K
-			m68k_set_context(SekM68KContext[nSekActive]);
+			m68k_set_context_ptr(SekM68KContext[nSekActive]);
 #endif
 
 #ifdef EMU_A68K
@@ -1233,18 +1356,12 @@ void SekClose()
 
 #ifdef EMU_A68K
 	if (nSekCPUType[nSekActive] == 0) {
-		memcpy(SekRegs[nSekActive], &M68000_regs, sizeof(M68000_regs));
-	} else {
-#endif
-
-#ifdef EMU_M68K
-		m68k_get_context(SekM68KContext[nSekActive]);
-#endif
-
-#ifdef EMU_A68K
+		memcpy(SekRegs[nSekActive], &M68000_regs, sizeof(M68000_regs));	// see SekOpen()
 	}
 #endif
 
+	// Musashi ran on SekM68KContext[nSekActive] itself, there's nothing to copy back
+
 	nSekCycles[nSekActive] = nSekCyclesTotal;
 	
 	nSekActive = -1;
@@ -1379,14 +1496,8 @@ void SekRunEnd()
 
 }
 
-// Run the active CPU
-INT32 SekRun(const INT32 nCycles)
+static INT32 SekRunSlice(INT32 nCycles)
 {
-#if defined FBA_DEBUG
-	if (!DebugCPU_SekInitted) bprintf(PRINT_ERROR, _T("SekRun called without init\n"));
-	if (nSekActive == -1) bprintf(PRINT_ERROR, _T("SekRun called when no CPU open\n"));
-#endif
-
 #ifdef EMU_A68K
 	if (nSekCPUType[nSekActive] == 0) {
 		nSekCyclesDone = 0;
@@ -1415,6 +1526,11 @@ INT32 SekRun(const INT32 nCycles)
 #ifdef EMU_M68K
 		nSekCyclesToDo = nCycles;
 
+#ifdef M68K_X64_DRC
+		if (bSekUseRecompiler && nSekCPUType[nSekActive] == 0x68000) {
+			nSekCyclesSegment = M68KX64Run(nCycles);
+		} else
+#endif
 		nSekCyclesSegment = m68k_execute(nCycles);
 
 		nSekCyclesTotal += nSekCyclesSegment;
@@ -1431,13 +1547,28 @@ INT32 SekRun(const INT32 nCycles)
 
 }
 
+// Run the active CPU
+INT32 SekRun(const INT32 nCycles)
+{
+#if defined FBA_DEBUG
+	if (!DebugCPU_SekInitted) bprintf(PRINT_ERROR, _T("SekRun called without init\n"));
+	if (nSekActive == -1) bprintf(PRINT_ERROR, _T("SekRun called when no CPU open\n"));
+#endif
+
+	BURN_PROF_SCOPE(BURN_PROF_M68K);
+
+	return BurnIdleRun(&SekIdleCpu, SekRunSlice, nCycles);
+}
+
 // ----------------------------------------------------------------------------
 // Breakpoint support
 
 void SekDbgDisableBreakpoints()
 {
 #if defined FBA_DEBUG && defined EMU_M68K
-		m68k_set_instr_hook_callback(NULL);
+		if (m68k_get_context_ptr()) {				// NULL before the first Musashi cpu
+			m68k_set_instr_hook_callback(NULL);
+		}
 
 		M68KReadByteDebug = M68KReadByte;
 		M68KReadWordDebug = M68KReadWord;
@@ -1608,6 +1739,10 @@ INT32 SekMapMemory(UINT8* pMemory, UINT32 nStart, UINT32 nEnd, INT32 nType)
 			pMemMap[SEK_WADD * 2] = Ptr + i;
 		}
 
+#ifdef M68K_X64_DRC
+		M68KX64MapChanged(nStart, nEnd, MAP_FETCH);
+#endif
+
 		return 0;
 	}
 
@@ -1624,6 +1759,10 @@ INT32 SekMapMemory(UINT8* pMemory, UINT32 nStart, UINT32 nEnd, INT32 nType)
 		}
 	}
 
+#ifdef M68K_X64_DRC
+	M68KX64MapChanged(nStart, nEnd, nType);
+#endif
+
 	return 0;
 }
 
@@ -1650,9 +1789,37 @@ INT32 SekMapHandler(uintptr_t nHandler, UINT32 nStart, UINT32 nEnd, INT32 nType)
 		}
 	}
 
+#ifdef M68K_X64_DRC
+	M68KX64MapChanged(nStart, nEnd, nType);
+#endif
+
 	return 0;
 }
 
+#ifdef M68K_X64_DRC
+INT32 SekUseRecompiler(bool bUse)
+{
+	bSekUseRecompiler = bUse;
+
+	return 0;
+}
+
+INT32 SekRecompiledBlocks()
+{
+	return nM68KX64Blocks;
+}
+#else
+INT32 SekUseRecompiler(bool)
+{
+	return 0;
+}
+
+INT32 SekRecompiledBlocks()
+{
+	return 0;
+}
+#endif
+
 // Set callbacks
 INT32 SekSetResetCallback(pSekResetCallback pCallback)
 {
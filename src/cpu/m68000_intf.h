@@ -59,9 +59,9 @@
 #endif
 
 #ifdef EMU_M68K
- extern "C" INT32 nSekM68KContextSize[SEK_MAX];
- extern "C" INT8* SekM68KContext[SEK_MAX];
- extern "C" INT32 m68k_ICount;
+ extern "C" BURN_THREAD INT32 nSekM68KContextSize[SEK_MAX];
+ extern "C" BURN_THREAD INT8* SekM68KContext[SEK_MAX];
+ extern "C" BURN_THREAD INT32 m68k_ICount;
 #endif
 
 typedef UINT8 (__fastcall *pSekReadByteHandler)(UINT32 a);
@@ -77,7 +77,7 @@ typedef INT32 (__fastcall *pSekIrqCallback)(INT32 irq);
 typedef INT32 (__fastcall *pSekCmpCallback)(UINT32 val, INT32 reg);
 typedef INT32 (__fastcall *pSekTASCallback)();
 
-extern INT32 nSekCycles[SEK_MAX], nSekCPUType[SEK_MAX];
+extern BURN_THREAD INT32 nSekCycles[SEK_MAX], nSekCPUType[SEK_MAX];
 
 // Mapped memory pointers to Rom and Ram areas (Read then Write)
 // These memory areas must be allocated multiples of the page size
@@ -105,9 +105,9 @@ struct SekExt {
 #define SEK_DEF_READ_LONG(i, a) { UINT32 d; d = pSekExt->ReadWord[i](a) << 16; d |= pSekExt->ReadWord[i]((a) + 2); return d; }
 #define SEK_DEF_WRITE_LONG(i, a, d) { pSekExt->WriteWord[i]((a),(UINT16)((d) >> 16)); pSekExt->WriteWord[i]((a) + 2,(UINT16)((d) & 0xffff)); }
 
-extern struct SekExt *SekExt[SEK_MAX], *pSekExt;
-extern INT32 nSekActive;										// The cpu which is currently being emulated
-extern INT32 nSekCyclesTotal, nSekCyclesScanline, nSekCyclesSegment, nSekCyclesDone, nSekCyclesToDo;
+extern BURN_THREAD struct SekExt *SekExt[SEK_MAX], *pSekExt;
+extern BURN_THREAD INT32 nSekActive;							// The cpu which is currently being emulated
+extern BURN_THREAD INT32 nSekCyclesTotal, nSekCyclesScanline, nSekCyclesSegment, nSekCyclesDone, nSekCyclesToDo;
 
 UINT32 SekReadByte(UINT32 a);
 UINT32 SekReadWord(UINT32 a);
@@ -150,7 +150,7 @@ INT32 SekRun(const INT32 nCycles);
 inline static INT32 SekIdle(INT32 nCycles)
 {
 #if defined FBA_DEBUG
-	extern UINT8 DebugCPU_SekInitted;
+	extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 	if (!DebugCPU_SekInitted) bprintf(PRINT_ERROR, (TCHAR*)_T("SekIdle called without init\n"));
 	if (nSekActive == -1) bprintf(PRINT_ERROR, (TCHAR*)_T("SekIdle called when no CPU open\n"));
 #endif
@@ -163,7 +163,7 @@ inline static INT32 SekIdle(INT32 nCycles)
 inline static INT32 SekSegmentCycles()
 {
 #if defined FBA_DEBUG
-	extern UINT8 DebugCPU_SekInitted;
+	extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 	if (!DebugCPU_SekInitted) bprintf(PRINT_ERROR, (TCHAR*)_T("SekSegmentCycles called without init\n"));
 	if (nSekActive == -1) bprintf(PRINT_ERROR, (TCHAR*)_T("SekSegmentCycles called when no CPU open\n"));
 #endif
@@ -182,7 +182,7 @@ inline static INT32 SekTotalCycles()
 #endif
 {
 #if defined FBA_DEBUG
-	extern UINT8 DebugCPU_SekInitted;
+	extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 	if (!DebugCPU_SekInitted) bprintf(PRINT_ERROR, (TCHAR*)_T("SekTotalCycles called without init\n"));
 	if (nSekActive == -1) bprintf(PRINT_ERROR, (TCHAR*)_T("SekTotalCycles called when no CPU open\n"));
 #endif
@@ -197,7 +197,7 @@ inline static INT32 SekTotalCycles()
 inline static INT32 SekCurrentScanline()
 {
 #if defined FBA_DEBUG
-	extern UINT8 DebugCPU_SekInitted;
+	extern BURN_THREAD UINT8 DebugCPU_SekInitted;
 	if (!DebugCPU_SekInitted) bprintf(PRINT_ERROR, (TCHAR*)_T("SekCurrentScanline called without init\n"));
 	if (nSekActive == -1) bprintf(PRINT_ERROR, (TCHAR*)_T("SekCurrentScanline called when no CPU open\n"));
 #endif
@@ -210,6 +210,12 @@ inline static INT32 SekCurrentScanline()
 INT32 SekMapMemory(UINT8* pMemory, UINT32 nStart, UINT32 nEnd, INT32 nType);
 INT32 SekMapHandler(uintptr_t nHandler, UINT32 nStart, UINT32 nEnd, INT32 nType);
 
+// Run the 68000s with the x86-64 recompiler (M68K_X64_DRC builds, off by default),
+// drivers that need the interpreter turn it off after SekInit
+INT32 SekUseRecompiler(bool bUse);
+// blocks the recompiler translated since the driver started (0 without it)
+INT32 SekRecompiledBlocks();
+
 // Set handlers
 INT32 SekSetReadByteHandler(INT32 i, pSekReadByteHandler pHandler);
 INT32 SekSetWriteByteHandler(INT32 i, pSekWriteByteHandler pHandler);
@@ -304,6 +304,28 @@ void m68k_pulse_reset(void);
 /* execute num_cycles worth of instructions.  returns number of cycles used */
 int m68k_execute(int num_cycles);
 
+/* Same as m68k_execute(), but run_block() is called first at every pc.  It
+ * runs the instructions it has a translated block for and returns non zero,
+ * or returns 0 and the instruction is interpreted.  Used by the x86-64 block
+ * recompiler (x64/m68k_x64.cpp), which calls the opcode handlers below.
+ */
+int m68k_execute_blocks(int num_cycles, int (*run_block)(void));
+
+/* The handler and the cycles of an opcode for the current cpu type */
+void (*m68k_get_handler(unsigned int opcode))(void);
+unsigned int m68k_get_cycles(unsigned int opcode);
+
+/* Address of D0-D7, A0-A7, PC, PPC, IR, PREF_ADDR or PREF_DATA in the currently
+ * running context, NULL for the others
+ */
+unsigned int* m68k_get_reg_ptr(m68k_register_t reg);
+
+/* Address of the 'X', 'N', 'Z', 'V' or 'C' flag in the currently running context.
+ * They are kept the way the opcode handlers use them (bit 8 for X and C, bit 7
+ * for N and V, Z is non zero when the flag is clear).
+ */
+unsigned int* m68k_get_flag_ptr(char flag);
+
 /* These functions let you read/write/modify the number of cycles left to run
  * while m68k_execute() is running.
  * These are useful if the 68k accesses a memory-mapped port on another device
@@ -348,6 +370,14 @@ unsigned int m68k_get_context(void* dst);
 /* set the current cpu context */
 void m68k_set_context(void* dst);
 
+/* Run on the cpu context at context from now on, in place: nothing is copied,
+ * the core reads and writes it directly (m68k_context_size() bytes)
+ */
+void m68k_set_context_ptr(void* context);
+
+/* The context the core runs on */
+void* m68k_get_context_ptr(void);
+
 /* Register the CPU state information */
 void m68k_state_register(const char *type, int index);
 
@@ -56,6 +56,7 @@
 #define TRUE		1
 
 #include "driver.h"
+#include "burn_machine.h"
 
 
 /* ======================================================================== */
@@ -43,10 +43,10 @@ extern void m68040_fpu_op1(void);
 /* ================================= DATA ================================= */
 /* ======================================================================== */
 
-int  m68ki_initial_cycles;
-int  m68ki_remaining_cycles = 0;                     /* Number of clocks remaining */
-uint m68ki_tracing = 0;
-uint m68ki_address_space;
+BURN_THREAD int  m68ki_initial_cycles;
+BURN_THREAD int  m68ki_remaining_cycles = 0;         /* Number of clocks remaining */
+BURN_THREAD uint m68ki_tracing = 0;
+BURN_THREAD uint m68ki_address_space;
 
 #ifdef M68K_LOG_ENABLE
 const char *const m68ki_cpu_names[] =
@@ -71,16 +71,16 @@ const char *const m68ki_cpu_names[] =
 };
 #endif /* M68K_LOG_ENABLE */
 
-/* The CPU core */
-m68ki_cpu_core m68ki_cpu = {0};
+/* The CPU core, it runs on the context of the open cpu */
+BURN_THREAD m68ki_cpu_core* m68ki_cpu_p = NULL;
 
 #if M68K_EMULATE_ADDRESS_ERROR
-jmp_buf m68ki_aerr_trap;
+BURN_THREAD jmp_buf m68ki_aerr_trap;
 #endif /* M68K_EMULATE_ADDRESS_ERROR */
 
-uint    m68ki_aerr_address;
-uint    m68ki_aerr_write_mode;
-uint    m68ki_aerr_fc;
+BURN_THREAD uint    m68ki_aerr_address;
+BURN_THREAD uint    m68ki_aerr_write_mode;
+BURN_THREAD uint    m68ki_aerr_fc;
 
 /* Used by shift & rotate instructions */
 const uint8 m68ki_shift_8_table[65] =
@@ -836,6 +836,84 @@ int m68k_execute(int num_cycles)
 }
 
 
+int m68k_execute_blocks(int num_cycles, int (*run_block)(void))
+{
+	/* Set our pool of clock cycles available */
+	SET_CYCLES(num_cycles);
+	m68ki_initial_cycles = num_cycles;
+
+	/* See if interrupts came in */
+	m68ki_check_interrupts();
+
+	/* Make sure we're not stopped */
+	if(!CPU_STOPPED)
+	{
+		/* Main loop.  Keep going until we run out of clock cycles */
+		do
+		{
+			/* The block does what the loop below does for each of its instructions */
+			if(run_block())
+				continue;
+
+			/* Record previous program counter */
+			REG_PPC = REG_PC;
+
+			/* Read an instruction and call its handler */
+			REG_IR = m68ki_read_imm_16();
+			m68ki_instruction_jump_table[REG_IR]();
+			USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+		} while(GET_CYCLES() > 0);
+
+		/* set previous PC to current PC for the next entry into the loop */
+		REG_PPC = REG_PC;
+	}
+	else
+		SET_CYCLES(0);
+
+	/* return how many clocks we used */
+	return m68ki_initial_cycles - GET_CYCLES();
+}
+
+void (*m68k_get_handler(unsigned int opcode))(void)
+{
+	return m68ki_instruction_jump_table[opcode & 0xffff];
+}
+
+unsigned int m68k_get_cycles(unsigned int opcode)
+{
+	return CYC_INSTRUCTION[opcode & 0xffff];
+}
+
+unsigned int* m68k_get_reg_ptr(m68k_register_t reg)
+{
+	if(reg >= M68K_REG_D0 && reg <= M68K_REG_A7)
+		return &REG_DA[reg - M68K_REG_D0];
+
+	switch(reg)
+	{
+		case M68K_REG_PC:	return &REG_PC;
+		case M68K_REG_PPC:	return &REG_PPC;
+		case M68K_REG_IR:	return &REG_IR;
+		case M68K_REG_PREF_ADDR:	return &CPU_PREF_ADDR;
+		case M68K_REG_PREF_DATA:	return &CPU_PREF_DATA;
+		default:			return NULL;
+	}
+}
+
+unsigned int* m68k_get_flag_ptr(char flag)
+{
+	switch(flag)
+	{
+		case 'X':	return &FLAG_X;
+		case 'N':	return &FLAG_N;
+		case 'Z':	return &FLAG_Z;
+		case 'V':	return &FLAG_V;
+		case 'C':	return &FLAG_C;
+		default:	return NULL;
+	}
+}
+
+
 int m68k_cycles_run(void)
 {
 	return m68ki_initial_cycles - GET_CYCLES();
@@ -973,7 +1051,7 @@ unsigned int m68k_context_size()
 /* Used to calculate the context size minus the system-specific pointers, for savestates */
 unsigned int m68k_context_size_no_pointers()
 {
-	return (int)&m68ki_cpu.pointer_block_divider - (int)&m68ki_cpu;
+	return offsetof(m68ki_cpu_core, pointer_block_divider);
 }
 
 unsigned int m68k_get_context(void* dst)
@@ -987,6 +1065,16 @@ void m68k_set_context(void* src)
 	if(src) m68ki_cpu = *(m68ki_cpu_core*)src;
 }
 
+void m68k_set_context_ptr(void* context)
+{
+	m68ki_cpu_p = (m68ki_cpu_core*)context;
+}
+
+void* m68k_get_context_ptr(void)
+{
+	return m68ki_cpu_p;
+}
+
 
 
 /* ======================================================================== */
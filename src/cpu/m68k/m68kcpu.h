@@ -28,6 +28,7 @@
 
 #include "m68k.h"
 #include <limits.h>
+#include <stddef.h>
 
 #if M68K_EMULATE_ADDRESS_ERROR
 #include <setjmp.h>
@@ -552,7 +553,7 @@
 /* Address error */
 #if M68K_EMULATE_ADDRESS_ERROR
 	#include <setjmp.h>
-	extern jmp_buf m68ki_aerr_trap;
+	extern BURN_THREAD jmp_buf m68ki_aerr_trap;
 
 	#define m68ki_set_address_error_trap() \
 		if(setjmp(m68ki_aerr_trap) != 0) \
@@ -918,19 +919,20 @@ struct _m68ki_cpu_core
 };
 
 
-extern m68ki_cpu_core m68ki_cpu;
-extern sint           m68ki_remaining_cycles;
-extern uint           m68ki_tracing;
+extern BURN_THREAD m68ki_cpu_core* m68ki_cpu_p;
+#define m68ki_cpu (*m68ki_cpu_p)      /* the context set with m68k_set_context_ptr() */
+extern BURN_THREAD sint           m68ki_remaining_cycles;
+extern BURN_THREAD uint           m68ki_tracing;
 extern const uint8    m68ki_shift_8_table[];
 extern const uint16   m68ki_shift_16_table[];
 extern const uint     m68ki_shift_32_table[];
 extern const uint8    m68ki_exception_cycle_table[][256];
-extern uint           m68ki_address_space;
+extern BURN_THREAD uint           m68ki_address_space;
 extern const uint8    m68ki_ea_idx_cycle_table[];
 
-extern uint           m68ki_aerr_address;
-extern uint           m68ki_aerr_write_mode;
-extern uint           m68ki_aerr_fc;
+extern BURN_THREAD uint           m68ki_aerr_address;
+extern BURN_THREAD uint           m68ki_aerr_write_mode;
+extern BURN_THREAD uint           m68ki_aerr_fc;
 
 /* Read data immediately after the program counter */
 INLINE uint m68ki_read_imm_16(void);
@@ -0,0 +1,1527 @@
+// 68000 x86-64 block recompiler
+
+#include <deque>
+#include <vector>
+#include "burnint.h"
+#include "m68000_intf.h"
+#include "m68k_x64.h"
+#include "../../mips3/x64/xbyak/xbyak.h"
+
+#define X64_CACHE_SIZE		(8 * 1024 * 1024)
+#define X64_BLOCK_MAX		64					// instructions per block
+#define X64_REMAP_MAX		32					// stop translating pages the driver keeps remapping (banks)
+
+#define X64_NO_BLOCK		((void*)1)			// nothing to translate at this pc, interpret it
+
+#define X64_PAGE_UNKNOWN	0
+#define X64_PAGE_CODE		1					// fetch mapped to memory the cpu can't write
+#define X64_PAGE_DATA		2					// handled or writable, interpreted
+
+struct X64Page {
+	void* pBlock[SEK_PAGE_SIZE / 2];
+	UINT8* pSource;								// the fetch memory the blocks were made from, NULL for a handler
+	UINT8 nSource[SEK_PAGE_SIZE];				// and what it held then
+};
+
+struct X64Cpu {
+	X64Page* pPage[SEK_PAGE_COUNT];
+	UINT8 nState[SEK_PAGE_COUNT];
+	UINT8 nRemaps[SEK_PAGE_COUNT];
+	UINT8 bListed[SEK_PAGE_COUNT];
+	UINT16 nListed[SEK_PAGE_COUNT];				// the pages M68KX64CheckPages() looks at
+	INT32 nListedCount;
+};
+
+static X64Cpu* pX64Cpu[SEK_MAX] = { NULL, };
+static X64Cpu* pX64 = NULL;						// the open cpu
+
+INT32 nM68KX64Blocks = 0;
+
+static UINT32* pRegPC = NULL;
+static UINT32* pRegPPC = NULL;
+static UINT32* pRegIR = NULL;
+static UINT32* pRegPrefAddr = NULL;
+static UINT32* pRegPrefData = NULL;
+static UINT32* pRegDA = NULL;					// d0-d7 then a0-a7
+static UINT32* pFlagX = NULL;
+static UINT32* pFlagN = NULL;
+static UINT32* pFlagZ = NULL;
+static UINT32* pFlagV = NULL;
+static UINT32* pFlagC = NULL;
+static UINT32* pRunPC = NULL;					// REG_PC of the cpu running, the others are at the same offsets
+
+static UINT8 nMapChanged = 0;					// set by the map functions, ends the running block
+
+// ----------------------------------------------------------------------------
+// Instruction length, 68000 only: it only depends on the opcode
+
+// extension words of an effective address
+static INT32 EaLength(INT32 nMode, INT32 nReg, INT32 nSize)
+{
+	switch (nMode) {
+		case 5:											// (d16,An)
+		case 6:											// (d8,An,Xn)
+			return 2;
+		case 7:
+			switch (nReg) {
+				case 0: return 2;						// (xxx).w
+				case 1: return 4;						// (xxx).l
+				case 2: return 2;						// (d16,PC)
+				case 3: return 2;						// (d8,PC,Xn)
+				case 4: return nSize == 4 ? 4 : 2;		// #imm
+				default: return -1;
+			}
+	}
+
+	return 0;
+}
+
+// size of the usual size field (bits 6-7), 0 if it is 3
+static INT32 OpSize(UINT16 op)
+{
+	static const INT32 nSizes[4] = { 1, 2, 4, 0 };
+
+	return nSizes[(op >> 6) & 3];
+}
+
+// length in bytes, 0 if the opcode isn't known (the block stops before it)
+static INT32 M68KX64Length(UINT16 op)
+{
+	INT32 nMode = (op >> 3) & 7;
+	INT32 nReg = op & 7;
+	INT32 nSize = OpSize(op);
+	INT32 nEa = EaLength(nMode, nReg, nSize ? nSize : 2);
+	INT32 nLen = 0;
+
+	switch (op >> 12) {
+		case 0x0:
+			if ((op & 0xff3f) == 0x003c || (op & 0xff3f) == 0x023c || (op & 0xff3f) == 0x0a3c) {
+				return (op & 0x0080) ? 0 : 4;			// ori/andi/eori to ccr/sr
+			}
+			if ((op & 0xf138) == 0x0108) return 4;		// movep
+			if (op & 0x0100) {							// btst/bchg/bclr/bset dn,<ea>
+				nLen = 2 + EaLength(nMode, nReg, 1);
+				break;
+			}
+			if ((op & 0xff00) == 0x0800) {				// btst/bchg/bclr/bset #,<ea>
+				nLen = 4 + EaLength(nMode, nReg, 1);
+				break;
+			}
+			switch (op & 0x0f00) {
+				case 0x0000: case 0x0200: case 0x0400: case 0x0600: case 0x0a00: case 0x0c00:
+					if (nSize == 0) return 0;
+					nLen = 2 + (nSize == 4 ? 4 : 2) + nEa;
+					break;
+				default:
+					return 0;							// moves (68010+)
+			}
+			break;
+
+		case 0x1: case 0x2: case 0x3: {					// move
+			static const INT32 nMoveSizes[4] = { 0, 1, 4, 2 };
+			INT32 nMoveSize = nMoveSizes[op >> 12];
+			INT32 nSrc = EaLength(nMode, nReg, nMoveSize);
+			INT32 nDst = EaLength((op >> 6) & 7, (op >> 9) & 7, nMoveSize);
+			if (nSrc < 0 || nDst < 0) return 0;
+			nLen = 2 + nSrc + nDst;
+			break;
+		}
+
+		case 0x4:
+			if ((op & 0xf1c0) == 0x41c0 || (op & 0xf1c0) == 0x4180) {	// lea, chk
+				nLen = 2 + EaLength(nMode, nReg, 2);
+				break;
+			}
+			switch (op & 0xffc0) {
+				case 0x40c0: case 0x44c0: case 0x46c0:	// move from sr, to ccr, to sr
+				case 0x4800:							// nbcd
+				case 0x4ac0:							// tas
+				case 0x4e80: case 0x4ec0:				// jsr, jmp
+					nLen = (op == 0x4afc) ? 2 : 2 + EaLength(nMode, nReg, 2);
+					break;
+				case 0x4840:							// swap, pea
+					if (nMode == 1) return 0;			// bkpt (68010+)
+					nLen = nMode == 0 ? 2 : 2 + nEa;
+					break;
+				case 0x4880: case 0x48c0:				// ext, movem to memory
+					nLen = nMode == 0 ? 2 : 4 + nEa;
+					break;
+				case 0x4c80: case 0x4cc0:				// movem to registers
+					nLen = 4 + EaLength(nMode, nReg, 2);
+					break;
+				case 0x4e40:							// trap, link, unlk, move usp, reset .. rtr
+					if ((op & 0xfff8) == 0x4e50 || op == 0x4e72) return 4;	// link, stop
+					if ((op & 0xfff8) == 0x4e78 || op == 0x4e74) return 0;	// movec, rtd (68010+)
+					return 2;
+				default:
+					if ((op & 0xf900) == 0x4000 && nSize) {		// negx, clr, neg, not
+						nLen = 2 + nEa;
+						break;
+					}
+					if ((op & 0xff00) == 0x4a00 && nSize) {		// tst
+						nLen = 2 + nEa;
+						break;
+					}
+					return 0;
+			}
+			break;
+
+		case 0x5:
+			if ((op & 0x00c0) == 0x00c0) {
+				nLen = nMode == 1 ? 4 : 2 + EaLength(nMode, nReg, 1);	// dbcc, scc
+			} else {
+				nLen = 2 + nEa;							// addq, subq
+			}
+			break;
+
+		case 0x6:
+			return (op & 0xff) == 0 ? 4 : 2;			// bra, bsr, bcc
+
+		case 0x7:
+			return 2;									// moveq
+
+		case 0x8: case 0xc:
+			if ((op & 0x00c0) == 0x00c0) {				// divu, divs, mulu, muls
+				nLen = 2 + EaLength(nMode, nReg, 2);
+				break;
+			}
+			if ((op & 0x01f0) == 0x0100) return 2;		// sbcd, abcd
+			if ((op >> 12) == 0xc && ((op & 0x01f8) == 0x0140 || (op & 0x01f8) == 0x0148 || (op & 0x01f8) == 0x0188)) {
+				return 2;								// exg
+			}
+			nLen = 2 + nEa;								// or, and
+			break;
+
+		case 0x9: case 0xd: case 0xb:
+			if ((op & 0x00c0) == 0x00c0) {				// suba, adda, cmpa
+				nLen = 2 + EaLength(nMode, nReg, (op & 0x0100) ? 4 : 2);
+				break;
+			}
+			if ((op >> 12) != 0xb && (op & 0x0130) == 0x0100) return 2;	// subx, addx
+			if ((op >> 12) == 0xb && (op & 0x0138) == 0x0108) return 2;	// cmpm
+			nLen = 2 + nEa;								// sub, add, cmp, eor
+			break;
+
+		case 0xe:
+			if ((op & 0x00c0) == 0x00c0) {				// shifts / rotates in memory
+				nLen = 2 + EaLength(nMode, nReg, 2);
+			} else {
+				return 2;
+			}
+			break;
+
+		default:
+			return 0;									// line a, line f
+	}
+
+	// an invalid mode makes the length odd
+	return (nLen < 2 || (nLen & 1)) ? 0 : nLen;
+}
+
+// the pc is not the next one after these
+static bool M68KX64EndsBlock(UINT16 op)
+{
+	if ((op & 0xf000) == 0x6000) return (op & 0x0f00) < 0x0200;	// bra, bsr (bcc may fall through)
+	if ((op & 0xff80) == 0x4e80) return true;						// jsr, jmp
+	if ((op & 0xfff0) == 0x4e40) return true;						// trap
+	if ((op & 0xfff8) == 0x4e70) return op != 0x4e71 && op != 0x4e76;	// reset, stop, rte, rts, rtr
+	if (op == 0x4afc) return true;									// illegal
+
+	return false;
+}
+
+// ----------------------------------------------------------------------------
+// Instructions translated to x86 code, the others call their Musashi handler
+
+#define X64_EA_NONE			-1
+#define X64_EA_DN			0
+#define X64_EA_AN			1
+#define X64_EA_AI			2					// (An)
+#define X64_EA_PI			3					// (An)+
+#define X64_EA_PD			4					// -(An)
+#define X64_EA_DI			5					// (d16,An)
+#define X64_EA_IX			6					// (d8,An,Xn)
+#define X64_EA_AW			7					// (xxx).w
+#define X64_EA_AL			8					// (xxx).l
+#define X64_EA_PCDI			9					// (d16,PC)
+#define X64_EA_PCIX			10					// (d8,PC,Xn)
+#define X64_EA_IMM			11					// #imm
+
+// the modes an instruction accepts
+#define X64_EA_MEMALT		0x01fc				// (An) .. (xxx).l
+#define X64_EA_DATAALT		(X64_EA_MEMALT | 0x0001)
+#define X64_EA_DATA			(X64_EA_DATAALT | 0x0e00)
+#define X64_EA_ALL			(X64_EA_DATA | 0x0002)
+#define X64_EA_CONTROL		0x07e4				// (An), (d16,An) .. (d8,PC,Xn)
+
+#define X64_MOVE			0					// move, moveq, clr (#0 source), tst (no destination)
+#define X64_MOVEA			1
+#define X64_LEA				2
+#define X64_ALU				3					// add, sub, cmp, and, or, eor to Dn or memory
+#define X64_ALUA			4					// adda, suba, cmpa, addq/subq to An
+#define X64_BCC				5					// bra, bcc
+#define X64_DBCC			6
+
+#define X64_ADD				0
+#define X64_SUB				1
+#define X64_CMP				2
+#define X64_AND				3
+#define X64_OR				4
+#define X64_EOR				5
+
+struct X64Ea {
+	INT32 nMode;
+	INT32 nReg;
+	UINT32 nExt;								// address of the extension words, the value for #imm
+};
+
+struct X64Insn {
+	INT32 nKind;
+	INT32 nAlu;
+	INT32 nSize;								// 1, 2 or 4
+	X64Ea Src;
+	X64Ea Dst;
+	INT32 nCond;
+	UINT32 nTarget;
+};
+
+// an effective address, nPos is the address of its extension words and is moved past them
+static bool M68KX64DecodeEa(INT32 nMode, INT32 nReg, INT32 nSize, INT32 nValid, UINT32& nPos, X64Ea& Ea)
+{
+	Ea.nMode = nMode < 7 ? nMode : (nReg < 5 ? X64_EA_AW + nReg : X64_EA_NONE);
+	Ea.nReg = nReg;
+	Ea.nExt = nPos;
+
+	if (Ea.nMode == X64_EA_NONE || !(nValid & (1 << Ea.nMode))) {
+		return false;
+	}
+	if (Ea.nMode == X64_EA_AN && nSize == 1) {
+		return false;
+	}
+
+	switch (Ea.nMode) {
+		case X64_EA_DI: case X64_EA_IX: case X64_EA_AW: case X64_EA_PCDI: case X64_EA_PCIX:
+			nPos += 2;
+			break;
+		case X64_EA_AL:
+			nPos += 4;
+			break;
+		case X64_EA_IMM:
+			if (nSize == 4) {
+				Ea.nExt = (SekFetchWord(nPos) << 16) | SekFetchWord(nPos + 2);
+				nPos += 4;
+			} else {
+				Ea.nExt = SekFetchWord(nPos) & (nSize == 1 ? 0xff : 0xffff);
+				nPos += 2;
+			}
+			break;
+	}
+
+	return true;
+}
+
+static bool M68KX64IsMemory(const X64Ea& Ea)
+{
+	return Ea.nMode >= X64_EA_AI && Ea.nMode <= X64_EA_PCIX;
+}
+
+// false if the instruction isn't one of the translated ones
+static bool M68KX64Decode(UINT32 nPc, UINT16 op, INT32 nLen, X64Insn* pInsn)
+{
+	static const INT32 nImmAlu[8] = { X64_OR, X64_AND, X64_SUB, X64_ADD, -1, X64_EOR, X64_CMP, -1 };
+	static const INT32 nMoveSizes[4] = { 0, 1, 4, 2 };
+
+	X64Insn& I = *pInsn;
+	INT32 nMode = (op >> 3) & 7;
+	INT32 nReg = op & 7;
+	INT32 nSize = OpSize(op);
+	UINT32 nPos = nPc + 2;
+
+	I.nKind = X64_MOVE;
+	I.nAlu = X64_ADD;
+	I.nSize = nSize;
+	I.Src.nMode = I.Dst.nMode = X64_EA_NONE;
+	I.nCond = 0;
+	I.nTarget = 0;
+
+	switch (op >> 12) {
+		case 0x0:											// ori, andi, subi, addi, eori, cmpi
+			if ((op & 0x0100) || nSize == 0 || nImmAlu[(op >> 9) & 7] < 0) return false;
+			I.nKind = X64_ALU;
+			I.nAlu = nImmAlu[(op >> 9) & 7];
+			if (!M68KX64DecodeEa(7, 4, nSize, X64_EA_ALL, nPos, I.Src)) return false;
+			if (!M68KX64DecodeEa(nMode, nReg, nSize, X64_EA_DATAALT, nPos, I.Dst)) return false;
+			if (I.nAlu == X64_CMP && nSize == 4 && I.Dst.nMode == X64_EA_DN) return false;	// cmpi.l callback
+			break;
+
+		case 0x1: case 0x2: case 0x3:						// move, movea
+			I.nSize = nMoveSizes[op >> 12];
+			if (!M68KX64DecodeEa(nMode, nReg, I.nSize, X64_EA_ALL, nPos, I.Src)) return false;
+			if (!M68KX64DecodeEa((op >> 6) & 7, (op >> 9) & 7, I.nSize, X64_EA_DATAALT | 0x0002, nPos, I.Dst)) return false;
+			if (I.Dst.nMode == X64_EA_AN) {
+				I.nKind = X64_MOVEA;
+			}
+			// the interpreter fetches the destination extension words after the source read
+			if (M68KX64IsMemory(I.Src) && I.Dst.nExt != nPos) return false;
+			break;
+
+		case 0x4:
+			if ((op & 0xf1c0) == 0x41c0) {					// lea
+				I.nKind = X64_LEA;
+				if (!M68KX64DecodeEa(nMode, nReg, 4, X64_EA_CONTROL, nPos, I.Src)) return false;
+				I.Dst.nMode = X64_EA_AN;
+				I.Dst.nReg = (op >> 9) & 7;
+				break;
+			}
+			if ((op & 0xff00) == 0x4200 && nSize) {			// clr
+				I.Src.nMode = X64_EA_IMM;
+				I.Src.nExt = 0;
+				if (!M68KX64DecodeEa(nMode, nReg, nSize, X64_EA_DATAALT, nPos, I.Dst)) return false;
+				break;
+			}
+			if ((op & 0xff00) == 0x4a00 && nSize) {			// tst
+				if (!M68KX64DecodeEa(nMode, nReg, nSize, X64_EA_DATAALT, nPos, I.Src)) return false;
+				break;
+			}
+			return false;
+
+		case 0x5:
+			if (nSize == 0) {
+				if (nMode != 1) return false;				// scc
+				I.nKind = X64_DBCC;
+				I.nCond = (op >> 8) & 0x0f;
+				I.Dst.nMode = X64_EA_DN;
+				I.Dst.nReg = nReg;
+				I.nTarget = nPc + 2 + (INT16)SekFetchWord(nPc + 2);
+				nPos += 2;
+				break;
+			}
+			I.nAlu = (op & 0x0100) ? X64_SUB : X64_ADD;		// addq, subq
+			I.Src.nMode = X64_EA_IMM;
+			I.Src.nExt = (((op >> 9) - 1) & 7) + 1;
+			if (!M68KX64DecodeEa(nMode, nReg, nSize, X64_EA_DATAALT | 0x0002, nPos, I.Dst)) return false;
+			I.nKind = I.Dst.nMode == X64_EA_AN ? X64_ALUA : X64_ALU;
+			break;
+
+		case 0x6:
+			I.nKind = X64_BCC;
+			I.nCond = (op >> 8) & 0x0f;
+			if (I.nCond == 1) return false;					// bsr
+			if (op & 0xff) {
+				I.nSize = 1;
+				I.nTarget = nPc + 2 + (INT8)(op & 0xff);
+			} else {
+				I.nSize = 2;
+				I.nTarget = nPc + 2 + (INT16)SekFetchWord(nPc + 2);
+				nPos += 2;
+			}
+			break;
+
+		case 0x7:											// moveq
+			if (op & 0x0100) return false;
+			I.nSize = 4;
+			I.Src.nMode = X64_EA_IMM;
+			I.Src.nExt = (UINT32)(INT32)(INT8)(op & 0xff);
+			I.Dst.nMode = X64_EA_DN;
+			I.Dst.nReg = (op >> 9) & 7;
+			break;
+
+		case 0x8: case 0x9: case 0xb: case 0xc: case 0xd: {
+			static const INT32 nLineAlu[16] = { -1, -1, -1, -1, -1, -1, -1, -1, X64_OR, X64_SUB, -1, X64_CMP, X64_AND, X64_ADD, -1, -1 };
+			I.nKind = X64_ALU;
+			I.nAlu = nLineAlu[op >> 12];
+			if (nSize == 0) {								// adda, suba, cmpa
+				if (I.nAlu != X64_ADD && I.nAlu != X64_SUB && I.nAlu != X64_CMP) return false;
+				I.nKind = X64_ALUA;
+				I.nSize = (op & 0x0100) ? 4 : 2;
+				if (!M68KX64DecodeEa(nMode, nReg, I.nSize, X64_EA_ALL, nPos, I.Src)) return false;
+				I.Dst.nMode = X64_EA_AN;
+				I.Dst.nReg = (op >> 9) & 7;
+				break;
+			}
+			if (op & 0x0100) {								// Dn,<ea> (eor for cmp)
+				if (I.nAlu == X64_CMP) I.nAlu = X64_EOR;
+				I.Src.nMode = X64_EA_DN;
+				I.Src.nReg = (op >> 9) & 7;
+				if (!M68KX64DecodeEa(nMode, nReg, nSize, I.nAlu == X64_EOR ? X64_EA_DATAALT : X64_EA_MEMALT, nPos, I.Dst)) return false;
+				break;
+			}
+			if (!M68KX64DecodeEa(nMode, nReg, nSize, (I.nAlu == X64_AND || I.nAlu == X64_OR) ? X64_EA_DATA : X64_EA_ALL, nPos, I.Src)) return false;
+			I.Dst.nMode = X64_EA_DN;
+			I.Dst.nReg = (op >> 9) & 7;
+			break;
+		}
+
+		default:
+			return false;
+	}
+
+	// opcodes the 68000 doesn't have go to the illegal instruction handler
+	if (m68k_get_handler(op) == m68k_get_handler(0x4afc)) {
+		return false;
+	}
+
+	return nPos == nPc + nLen;
+}
+
+// ----------------------------------------------------------------------------
+// Code generation
+
+// The entry saves the registers and jumps to the first block, the blocks jump
+// back to the dispatch loop, which looks the next block up in the page tables
+// and only returns to m68k_execute_blocks() when the cycles are done or when
+// there is no block (yet) at the pc.
+//
+// rbx = &REG_PC of the cpu (the other registers are addressed from it), r12 = &m68k_ICount,
+// r13 = &nMapChanged, r14 = the page tables of the running cpu, r15 = its memory
+// map, ebp = non zero once a handler changed the pc or the map.
+//
+// The 68000 registers stay in the Musashi context. Memory accesses go straight
+// to the mapped pages, the handlers are called through M68KRead* / M68KWrite*
+// with PPC, IR, PC and the prefetch set as the interpreter would have them.
+
+#ifdef _WIN32
+#define X64_FRAME			56					// home space and two slots
+#define X64_SLOT			32
+#else
+#define X64_FRAME			24
+#define X64_SLOT			0
+#endif
+
+#define X64_MAP_READ		0
+#define X64_MAP_FETCH		2
+
+class M68KX64Compiler : public Xbyak::CodeGenerator
+{
+public:
+	M68KX64Compiler() : CodeGenerator(X64_CACHE_SIZE) { }
+
+	void (*pEntry)(void* pBlock);
+
+	void Prologue();
+	void* Compile(UINT32 nAddress, INT32 nCount, const UINT16* pOps, const INT32* pLens);
+
+private:
+	// out of line code, emitted after the block
+	struct Stub {
+		INT32 nType;
+		INT32 nSize;
+		INT32 nMap;
+		Xbyak::Label* pEntry;
+		Xbyak::Label* pBack;
+		UINT32 nPpc;
+		UINT16 nOp;
+		UINT32 nPc;
+		UINT32 nPref;
+		bool bMemory;
+	};
+	enum { STUB_EXIT, STUB_READ, STUB_WRITE, STUB_WRITE_PD };
+
+	Xbyak::Label lDispatch;
+
+	std::deque<Xbyak::Label> Labels;
+	std::vector<Stub> Stubs;
+
+	UINT32 nPage;								// the block stays in this page
+	INT32 nInsns;
+	UINT32 nInsnPc[X64_BLOCK_MAX];
+	Xbyak::Label* pInsnLabel[X64_BLOCK_MAX];
+
+	UINT32 nCurPc;								// the instruction being translated
+	UINT16 nCurOp;
+	UINT32 nCurNext;
+	bool bCurMemory;							// it may call a handler
+
+	INT32 Reg(UINT32* pReg) { return (INT32)((UINT8*)pReg - (UINT8*)pRegPC); }
+	Xbyak::Address D(INT32 n) { return dword[rbx + Reg(pRegDA + n)]; }
+	Xbyak::Address A(INT32 n) { return dword[rbx + Reg(pRegDA + 8 + n)]; }
+	Xbyak::Address Flag(UINT32* pFlag) { return dword[rbx + Reg(pFlag)]; }
+	Xbyak::Reg Sized(const Xbyak::Reg32& r, INT32 nSize);
+
+	Xbyak::Label& NewLabel();
+	Xbyak::Label& Exit(UINT32 nPc, UINT32 nPref);
+	void Sync(UINT32 nPpc, UINT16 op, UINT32 nPc, UINT32 nPref);
+	void EmitStubs();
+
+	void Call(bool bLast);
+	void Native(const X64Insn& I, bool bLast);
+	void End(INT32 nCycles, Xbyak::Label& lExit, bool bLast);
+	void JumpTo(UINT32 nTarget, Xbyak::Label& lExit);
+	void JumpCond(INT32 nCond, Xbyak::Label& l, bool bWhen);
+
+	void ZeroExtend(const Xbyak::Reg32& r, INT32 nSize);
+	void EaAddress(const X64Ea& Ea, INT32 nSize);
+	void Load(const X64Ea& Ea, INT32 nSize);
+	void Read(INT32 nSize, INT32 nMap);
+	void Write(INT32 nSize, bool bLowFirst = false);
+	void StoreD(INT32 n, INT32 nSize, const Xbyak::Reg32& r);
+	void LogicFlags(INT32 nSize, const Xbyak::Reg32& r);
+	void ArithFlags(INT32 nSize, bool bX);
+};
+
+static M68KX64Compiler* pCompiler = NULL;
+
+// once at the start of the code buffer
+void M68KX64Compiler::Prologue()
+{
+	Xbyak::Label lExit;
+
+	pEntry = (void (*)(void*))getCurr();
+
+	push(rbx);
+	push(rbp);
+	push(r12);
+	push(r13);
+	push(r14);
+	push(r15);
+	sub(rsp, X64_FRAME);
+#ifdef _WIN32
+	mov(rax, rcx);
+#else
+	mov(rax, rdi);
+#endif
+	mov(rbx, (size_t)&pRunPC);
+	mov(rbx, ptr[rbx]);
+	mov(r12, (size_t)&m68k_ICount);
+	mov(r13, (size_t)&nMapChanged);
+	mov(r14, (size_t)&pX64);
+	mov(r14, ptr[r14]);
+	mov(r15, (size_t)&pSekExt);
+	mov(r15, ptr[r15]);
+	xor_(ebp, ebp);
+	jmp(rax);
+
+	L(lDispatch);
+	xor_(ebp, ebp);
+	cmp(dword[r12], 0);
+	jle(lExit);
+	mov(eax, dword[rbx]);
+	test(eax, 0xff000001);
+	jnz(lExit);
+	mov(edx, eax);
+	shr(edx, SEK_SHIFT);
+	mov(rdx, ptr[r14 + rdx * 8]);
+	test(rdx, rdx);
+	jz(lExit);
+	and_(eax, SEK_PAGEM);
+	mov(rax, ptr[rdx + rax * 4]);
+	cmp(rax, (size_t)X64_NO_BLOCK);
+	jbe(lExit);
+	mov(byte[r13], 0);
+	jmp(rax);
+
+	L(lExit);
+	add(rsp, X64_FRAME);
+	pop(r15);
+	pop(r14);
+	pop(r13);
+	pop(r12);
+	pop(rbp);
+	pop(rbx);
+	ret();
+}
+
+void* M68KX64Compiler::Compile(UINT32 nAddress, INT32 nCount, const UINT16* pOps, const INT32* pLens)
+{
+	void* pBlock = (void*)getCurr();
+
+	Labels.clear();
+	Stubs.clear();
+	nPage = nAddress >> SEK_SHIFT;
+	nInsns = nCount;
+
+	for (INT32 i = 0; i < nCount; i++) {
+		nInsnPc[i] = i ? nInsnPc[i - 1] + pLens[i - 1] : nAddress;
+		pInsnLabel[i] = &NewLabel();
+	}
+
+	for (INT32 i = 0; i < nCount; i++) {
+		X64Insn I;
+
+		nCurPc = nInsnPc[i];
+		nCurOp = pOps[i];
+		nCurNext = nCurPc + pLens[i];
+		bCurMemory = false;
+
+		L(*pInsnLabel[i]);
+		if (M68KX64Decode(nCurPc, nCurOp, pLens[i], &I)) {
+			Native(I, i == nCount - 1);
+		} else {
+			Call(i == nCount - 1);
+		}
+	}
+
+	EmitStubs();
+
+	ready();
+
+	return pBlock;
+}
+
+Xbyak::Label& M68KX64Compiler::NewLabel()
+{
+	// a deque doesn't move its elements, the jumps keep pointing at them
+	Labels.push_back(Xbyak::Label());
+
+	return Labels.back();
+}
+
+Xbyak::Reg M68KX64Compiler::Sized(const Xbyak::Reg32& r, INT32 nSize)
+{
+	if (nSize == 1) return r.cvt8();
+	if (nSize == 2) return r.cvt16();
+
+	return r;
+}
+
+// what the interpreter leaves in the context, nPref is the address of the prefetched word
+void M68KX64Compiler::Sync(UINT32 nPpc, UINT16 op, UINT32 nPc, UINT32 nPref)
+{
+	mov(dword[rbx + Reg(pRegPPC)], nPpc);
+	mov(dword[rbx + Reg(pRegIR)], op);
+	mov(dword[rbx], nPc);
+	if ((nPref >> SEK_SHIFT) == nPage) {
+		mov(dword[rbx + Reg(pRegPrefAddr)], nPref);
+		mov(dword[rbx + Reg(pRegPrefData)], SekFetchWord(nPref));
+	} else {
+		// the next page may be a handler, the interpreter fetches it again
+		mov(dword[rbx + Reg(pRegPrefAddr)], 1);
+	}
+}
+
+// leaves the block after the current instruction, with the pc at nPc
+Xbyak::Label& M68KX64Compiler::Exit(UINT32 nPc, UINT32 nPref)
+{
+	Stub s = { STUB_EXIT, 0, 0, &NewLabel(), NULL, nCurPc, nCurOp, nPc, nPref, bCurMemory };
+	Stubs.push_back(s);
+
+	return *s.pEntry;
+}
+
+void M68KX64Compiler::EmitStubs()
+{
+	for (UINT32 i = 0; i < Stubs.size(); i++) {
+		const Stub& s = Stubs[i];
+
+		L(*s.pEntry);
+
+		if (s.nType == STUB_EXIT) {
+			if (s.bMemory) {
+				// a handler changed the pc or the map, the context is already right
+				test(ebp, ebp);
+				jnz(lDispatch, T_NEAR);
+			}
+			Sync(s.nPpc, s.nOp, s.nPc, s.nPref);
+			jmp(lDispatch, T_NEAR);
+			continue;
+		}
+
+		static void* pRead[3][5] = {
+			{ NULL, (void*)M68KReadByte, (void*)M68KReadWord, NULL, (void*)M68KReadLong },
+			{ NULL, },
+			{ NULL, (void*)M68KFetchByte, (void*)M68KFetchWord, NULL, (void*)M68KFetchLong },
+		};
+		static void* pWrite[5] = { NULL, (void*)M68KWriteByte, (void*)M68KWriteWord, NULL, (void*)M68KWriteLong };
+
+		Sync(s.nPpc, s.nOp, s.nPc, s.nPref);
+		mov(dword[rsp + X64_SLOT], ecx);
+		if (s.nType != STUB_READ) {
+			mov(dword[rsp + X64_SLOT + 4], eax);
+		}
+		if (s.nType == STUB_WRITE_PD) {
+			add(ecx, 2);
+			movzx(eax, ax);
+		}
+#ifdef _WIN32
+		mov(edx, eax);
+#else
+		mov(edi, ecx);
+		mov(esi, eax);
+#endif
+		mov(rax, (size_t)(s.nType == STUB_READ ? pRead[s.nMap][s.nSize] : pWrite[s.nType == STUB_WRITE_PD ? 2 : s.nSize]));
+		call(rax);
+		if (s.nType == STUB_WRITE_PD) {
+#ifdef _WIN32
+			mov(ecx, dword[rsp + X64_SLOT]);
+			movzx(edx, word[rsp + X64_SLOT + 6]);
+#else
+			mov(edi, dword[rsp + X64_SLOT]);
+			movzx(esi, word[rsp + X64_SLOT + 6]);
+#endif
+			mov(rax, (size_t)M68KWriteWord);
+			call(rax);
+		}
+		if (s.nType != STUB_READ) {
+			mov(eax, dword[rsp + X64_SLOT + 4]);
+		}
+		mov(ecx, dword[rsp + X64_SLOT]);
+
+		// an interrupt or a bank switch, the instruction still finishes
+		Xbyak::Label lChanged;
+		cmp(byte[r13], 0);
+		jne(lChanged);
+		cmp(dword[rbx], s.nPc);
+		je(*s.pBack, T_NEAR);
+		L(lChanged);
+		mov(ebp, 1);
+		jmp(*s.pBack, T_NEAR);
+	}
+}
+
+// an instruction run by its handler, as m68k_execute does it
+void M68KX64Compiler::Call(bool bLast)
+{
+	Sync(nCurPc, nCurOp, nCurPc + 2, nCurPc + 2);
+	mov(rax, (size_t)m68k_get_handler(nCurOp));
+	call(rax);
+	sub(dword[r12], m68k_get_cycles(nCurOp));
+
+	// out of cycles, the code may have been banked out, or the pc went
+	// elsewhere (branch taken, exception, interrupt)
+	jle(lDispatch, T_NEAR);
+	if (bLast) {
+		jmp(lDispatch, T_NEAR);
+		return;
+	}
+	cmp(byte[r13], 0);
+	jne(lDispatch, T_NEAR);
+	cmp(dword[rbx], nCurNext);
+	jne(lDispatch, T_NEAR);
+}
+
+// the cycles of a translated instruction, then on to the next one
+void M68KX64Compiler::End(INT32 nCycles, Xbyak::Label& lExit, bool bLast)
+{
+	sub(dword[r12], nCycles);
+	jle(lExit, T_NEAR);
+	if (bCurMemory) {
+		test(ebp, ebp);
+		jnz(lDispatch, T_NEAR);
+	}
+	if (bLast) {
+		jmp(lExit, T_NEAR);
+	}
+}
+
+// a branch inside the block doesn't go through the dispatch loop
+void M68KX64Compiler::JumpTo(UINT32 nTarget, Xbyak::Label& lExit)
+{
+	for (INT32 i = 0; i < nInsns; i++) {
+		if (nInsnPc[i] == nTarget) {
+			jmp(*pInsnLabel[i], T_NEAR);
+			return;
+		}
+	}
+
+	jmp(lExit, T_NEAR);
+}
+
+// jumps to l if the condition is bWhen, uses eax and edx
+void M68KX64Compiler::JumpCond(INT32 nCond, Xbyak::Label& l, bool bWhen)
+{
+	switch (nCond) {
+		case 0x0:											// t
+			if (bWhen) jmp(l, T_NEAR);
+			return;
+		case 0x1:											// f
+			if (!bWhen) jmp(l, T_NEAR);
+			return;
+		case 0x2: case 0x3:									// hi, ls
+			test(Flag(pFlagC), 0x100);
+			setnz(al);
+			cmp(Flag(pFlagZ), 0);
+			sete(dl);
+			or_(al, dl);
+			if (nCond == 0x2) bWhen = !bWhen;
+			break;
+		case 0x4: case 0x5:									// cc, cs
+			test(Flag(pFlagC), 0x100);
+			setnz(al);
+			if (nCond == 0x4) bWhen = !bWhen;
+			break;
+		case 0x6: case 0x7:									// ne, eq
+			cmp(Flag(pFlagZ), 0);
+			setne(al);
+			if (nCond == 0x7) bWhen = !bWhen;
+			break;
+		case 0x8: case 0x9:									// vc, vs
+			test(Flag(pFlagV), 0x80);
+			setnz(al);
+			if (nCond == 0x8) bWhen = !bWhen;
+			break;
+		case 0xa: case 0xb:									// pl, mi
+			test(Flag(pFlagN), 0x80);
+			setnz(al);
+			if (nCond == 0xa) bWhen = !bWhen;
+			break;
+		case 0xc: case 0xd:									// ge, lt
+			mov(eax, Flag(pFlagN));
+			xor_(eax, Flag(pFlagV));
+			test(eax, 0x80);
+			setnz(al);
+			if (nCond == 0xc) bWhen = !bWhen;
+			break;
+		case 0xe: case 0xf:									// gt, le
+			mov(eax, Flag(pFlagN));
+			xor_(eax, Flag(pFlagV));
+			test(eax, 0x80);
+			setnz(al);
+			cmp(Flag(pFlagZ), 0);
+			sete(dl);
+			or_(al, dl);
+			if (nCond == 0xe) bWhen = !bWhen;
+			break;
+	}
+
+	test(al, al);
+	if (bWhen) {
+		jnz(l, T_NEAR);
+	} else {
+		jz(l, T_NEAR);
+	}
+}
+
+void M68KX64Compiler::ZeroExtend(const Xbyak::Reg32& r, INT32 nSize)
+{
+	if (nSize == 1) movzx(r, r.cvt8());
+	if (nSize == 2) movzx(r, r.cvt16());
+}
+
+// the address in ecx, with (An)+ and -(An) done, uses edx
+void M68KX64Compiler::EaAddress(const X64Ea& Ea, INT32 nSize)
+{
+	INT32 nStep = (nSize == 1 && Ea.nReg == 7) ? 2 : nSize;	// a7 stays even
+	UINT16 nExt = 0;
+
+	if (Ea.nMode == X64_EA_DI || Ea.nMode == X64_EA_IX || Ea.nMode == X64_EA_AW || Ea.nMode == X64_EA_PCDI || Ea.nMode == X64_EA_PCIX) {
+		nExt = SekFetchWord(Ea.nExt);
+	}
+
+	switch (Ea.nMode) {
+		case X64_EA_AI:
+			mov(ecx, A(Ea.nReg));
+			break;
+		case X64_EA_PI:
+			mov(ecx, A(Ea.nReg));
+			add(A(Ea.nReg), nStep);
+			break;
+		case X64_EA_PD:
+			mov(ecx, A(Ea.nReg));
+			sub(ecx, nStep);
+			mov(A(Ea.nReg), ecx);
+			break;
+		case X64_EA_DI:
+			mov(ecx, A(Ea.nReg));
+			add(ecx, (UINT32)(INT32)(INT16)nExt);
+			break;
+		case X64_EA_AW:
+			mov(ecx, (UINT32)(INT32)(INT16)nExt);
+			break;
+		case X64_EA_AL:
+			mov(ecx, (SekFetchWord(Ea.nExt) << 16) | SekFetchWord(Ea.nExt + 2));
+			break;
+		case X64_EA_PCDI:
+			mov(ecx, Ea.nExt + (INT16)nExt);
+			break;
+		case X64_EA_IX: case X64_EA_PCIX:
+			// 68000 brief format: index register, word or long index, 8 bit displacement
+			if (Ea.nMode == X64_EA_IX) {
+				mov(ecx, A(Ea.nReg));
+			} else {
+				mov(ecx, Ea.nExt);
+			}
+			mov(edx, D(nExt >> 12));
+			if (!(nExt & 0x0800)) {
+				movsx(edx, dx);
+			}
+			lea(ecx, ptr[rcx + rdx + (INT8)(nExt & 0xff)]);
+			break;
+	}
+}
+
+// the operand in eax, zero extended
+void M68KX64Compiler::Load(const X64Ea& Ea, INT32 nSize)
+{
+	switch (Ea.nMode) {
+		case X64_EA_DN:
+			mov(eax, D(Ea.nReg));
+			ZeroExtend(eax, nSize);
+			break;
+		case X64_EA_AN:
+			mov(eax, A(Ea.nReg));
+			ZeroExtend(eax, nSize);
+			break;
+		case X64_EA_IMM:
+			mov(eax, Ea.nExt);
+			break;
+		default:
+			EaAddress(Ea, nSize);
+			Read(nSize, (Ea.nMode == X64_EA_PCDI || Ea.nMode == X64_EA_PCIX) ? X64_MAP_FETCH : X64_MAP_READ);
+			break;
+	}
+}
+
+// eax = (ecx), as ReadByte / ReadWord / ReadLong do it, ecx is kept
+void M68KX64Compiler::Read(INT32 nSize, INT32 nMap)
+{
+	Stub s = { STUB_READ, nSize, nMap, &NewLabel(), &NewLabel(), nCurPc, nCurOp, nCurNext, nCurNext, false };
+	Stubs.push_back(s);
+	bCurMemory = true;
+
+	mov(edx, ecx);
+	and_(edx, 0xffffff);
+	shr(edx, SEK_SHIFT);
+	mov(rdx, ptr[r15 + rdx * 8 + (INT32)(offsetof(struct SekExt, MemMap) + nMap * SEK_PAGE_COUNT * sizeof(UINT8*))]);
+	cmp(rdx, SEK_MAXHANDLER);
+	jb(*s.pEntry, T_NEAR);
+	if (nSize > 1) {
+		test(cl, 1);
+		jnz(*s.pEntry, T_NEAR);
+	}
+	mov(eax, ecx);
+	if (nSize == 1) {
+		xor_(eax, 1);
+	}
+	and_(eax, SEK_PAGEM);
+	switch (nSize) {
+		case 1: movzx(eax, byte[rdx + rax]); break;
+		case 2: movzx(eax, word[rdx + rax]); break;
+		case 4: mov(eax, dword[rdx + rax]); rol(eax, 16); break;
+	}
+	L(*s.pBack);
+}
+
+// (ecx) = eax, as WriteByte / WriteWord / WriteLong do it, eax and ecx are kept.
+// move.l to -(An) writes the low word first, handlers see the two word writes
+void M68KX64Compiler::Write(INT32 nSize, bool bLowFirst)
+{
+	Stub s = { bLowFirst ? STUB_WRITE_PD : STUB_WRITE, nSize, 0, &NewLabel(), &NewLabel(), nCurPc, nCurOp, nCurNext, nCurNext, false };
+	Stubs.push_back(s);
+	bCurMemory = true;
+
+	mov(edx, ecx);
+	and_(edx, 0xffffff);
+	shr(edx, SEK_SHIFT);
+	mov(rdx, ptr[r15 + rdx * 8 + (INT32)(offsetof(struct SekExt, MemMap) + SEK_WADD * sizeof(UINT8*))]);
+	cmp(rdx, SEK_MAXHANDLER);
+	jb(*s.pEntry, T_NEAR);
+	if (nSize > 1) {
+		test(cl, 1);
+		jnz(*s.pEntry, T_NEAR);
+	}
+	mov(r8d, ecx);
+	if (nSize == 1) {
+		xor_(r8d, 1);
+	}
+	and_(r8d, SEK_PAGEM);
+	if (bLowFirst) {
+		// the two words go through the map separately, they may be in different pages
+		cmp(r8d, SEK_PAGEM - 1);
+		je(*s.pEntry, T_NEAR);
+	}
+	switch (nSize) {
+		case 1: mov(byte[rdx + r8], al); break;
+		case 2: mov(word[rdx + r8], ax); break;
+		case 4: mov(r9d, eax); rol(r9d, 16); mov(dword[rdx + r8], r9d); break;
+	}
+	L(*s.pBack);
+}
+
+void M68KX64Compiler::StoreD(INT32 n, INT32 nSize, const Xbyak::Reg32& r)
+{
+	switch (nSize) {
+		case 1: mov(byte[rbx + Reg(pRegDA + n)], r.cvt8()); break;
+		case 2: mov(word[rbx + Reg(pRegDA + n)], r.cvt16()); break;
+		case 4: mov(D(n), r); break;
+	}
+}
+
+// N and Z from the result in r, V and C cleared (move, tst, and, or, eor)
+void M68KX64Compiler::LogicFlags(INT32 nSize, const Xbyak::Reg32& r)
+{
+	if (nSize == 4) {
+		mov(r8d, r);
+	} else {
+		movzx(r8d, Sized(r, nSize));
+	}
+	mov(Flag(pFlagZ), r8d);
+	if (nSize > 1) {
+		shr(r8d, nSize == 2 ? 8 : 24);
+	}
+	mov(Flag(pFlagN), r8d);
+	mov(Flag(pFlagV), 0);
+	mov(Flag(pFlagC), 0);
+}
+
+// right after the add / sub of edx, the x86 carry and overflow are the 68000 ones
+void M68KX64Compiler::ArithFlags(INT32 nSize, bool bX)
+{
+	setc(r9b);
+	seto(r10b);
+	movzx(r9d, r9b);
+	shl(r9d, 8);
+	mov(Flag(pFlagC), r9d);
+	if (bX) {
+		mov(Flag(pFlagX), r9d);
+	}
+	movzx(r10d, r10b);
+	shl(r10d, 7);
+	mov(Flag(pFlagV), r10d);
+	if (nSize == 4) {
+		mov(r8d, edx);
+	} else {
+		movzx(r8d, Sized(edx, nSize));
+	}
+	mov(Flag(pFlagZ), r8d);
+	if (nSize > 1) {
+		shr(r8d, nSize == 2 ? 8 : 24);
+	}
+	mov(Flag(pFlagN), r8d);
+}
+
+// same results, flags and memory accesses (in the same order) as the handler
+void M68KX64Compiler::Native(const X64Insn& I, bool bLast)
+{
+	INT32 nCycles = m68k_get_cycles(nCurOp);
+	INT32 nSize = I.nSize;
+
+	switch (I.nKind) {
+		case X64_MOVE:
+			Load(I.Src, nSize);
+			if (I.Dst.nMode == X64_EA_DN) {
+				StoreD(I.Dst.nReg, nSize, eax);
+			} else if (I.Dst.nMode != X64_EA_NONE) {
+				EaAddress(I.Dst, nSize);
+				Write(nSize, (nCurOp >> 12) == 2 && I.Dst.nMode == X64_EA_PD);
+			}
+			LogicFlags(nSize, eax);
+			break;
+
+		case X64_MOVEA:
+			Load(I.Src, nSize);
+			if (nSize == 2) {
+				movsx(eax, ax);
+			}
+			mov(A(I.Dst.nReg), eax);
+			break;
+
+		case X64_LEA:
+			EaAddress(I.Src, 4);
+			mov(A(I.Dst.nReg), ecx);
+			break;
+
+		case X64_ALU: {
+			bool bMemory = I.Dst.nMode != X64_EA_DN;
+			Xbyak::Reg d = Sized(edx, nSize);
+			Xbyak::Reg s = Sized(eax, nSize);
+
+			// edx = destination, eax = source
+			if (bMemory) {
+				EaAddress(I.Dst, nSize);
+				Read(nSize, X64_MAP_READ);
+				mov(edx, eax);
+				Load(I.Src, nSize);
+			} else {
+				Load(I.Src, nSize);
+				mov(edx, D(I.Dst.nReg));
+			}
+
+			switch (I.nAlu) {
+				case X64_ADD: add(d, s); ArithFlags(nSize, true); break;
+				case X64_SUB: sub(d, s); ArithFlags(nSize, true); break;
+				case X64_CMP: sub(d, s); ArithFlags(nSize, false); break;
+				case X64_AND: and_(d, s); break;
+				case X64_OR:  or_(d, s); break;
+				case X64_EOR: xor_(d, s); break;
+			}
+
+			if (I.nAlu == X64_CMP) {
+				break;
+			}
+			if (!bMemory) {
+				StoreD(I.Dst.nReg, nSize, edx);
+				if (I.nAlu >= X64_AND) {
+					LogicFlags(nSize, edx);
+				}
+				break;
+			}
+
+			// and sets the flags before the write, or and eor after it
+			if (I.nAlu == X64_AND) {
+				LogicFlags(nSize, edx);
+			}
+			mov(eax, edx);
+			Write(nSize);
+			if (I.nAlu == X64_OR || I.nAlu == X64_EOR) {
+				LogicFlags(nSize, eax);
+			}
+			break;
+		}
+
+		case X64_ALUA:
+			Load(I.Src, nSize);
+			if (nSize == 2) {
+				movsx(eax, ax);
+			}
+			switch (I.nAlu) {
+				case X64_ADD: add(A(I.Dst.nReg), eax); break;
+				case X64_SUB: sub(A(I.Dst.nReg), eax); break;
+				case X64_CMP:
+					mov(edx, A(I.Dst.nReg));
+					sub(edx, eax);
+					ArithFlags(4, false);
+					break;
+			}
+			break;
+
+		case X64_BCC: {
+			// the prefetch is past the displacement word when the branch is taken
+			Xbyak::Label& lTaken = Exit(I.nTarget, nCurPc + (I.nSize == 1 ? 2 : 4));
+			Xbyak::Label& lNotTaken = NewLabel();
+
+			JumpCond(I.nCond, lNotTaken, false);
+			if (I.nCond == 0 && I.nTarget == nCurPc) {
+				// bra to itself, the handler uses all the cycles
+				mov(dword[r12], 0);
+				sub(dword[r12], nCycles);
+				jmp(lTaken, T_NEAR);
+			} else {
+				sub(dword[r12], nCycles);
+				jle(lTaken, T_NEAR);
+				JumpTo(I.nTarget, lTaken);
+			}
+
+			L(lNotTaken);
+			if (I.nCond != 0) {
+				End(nCycles + (I.nSize == 1 ? -2 : 2), Exit(nCurNext, nCurPc + 2), bLast);
+			}
+			return;
+		}
+
+		case X64_DBCC: {
+			Xbyak::Label& lTaken = Exit(I.nTarget, nCurPc + 4);
+			Xbyak::Label& lNext = Exit(nCurNext, nCurPc + 2);
+			Xbyak::Label& lTrue = NewLabel();
+			Xbyak::Label& lExpired = NewLabel();
+
+			JumpCond(I.nCond, lTrue, true);
+			mov(eax, D(I.Dst.nReg));
+			sub(ax, 1);
+			mov(word[rbx + Reg(pRegDA + I.Dst.nReg)], ax);
+			cmp(ax, -1);
+			je(lExpired, T_NEAR);
+			sub(dword[r12], nCycles - 2);
+			jle(lTaken, T_NEAR);
+			JumpTo(I.nTarget, lTaken);
+
+			L(lExpired);
+			sub(dword[r12], 2);
+			L(lTrue);
+			End(nCycles, lNext, bLast);
+			return;
+		}
+	}
+
+	End(nCycles, Exit(nCurNext, nCurNext), bLast);
+}
+
+// ----------------------------------------------------------------------------
+// Block cache
+
+static void M68KX64FreePage(X64Cpu* pCpu, UINT32 nPage)
+{
+	if (pCpu->pPage[nPage]) {
+		free(pCpu->pPage[nPage]);
+		pCpu->pPage[nPage] = NULL;
+	}
+}
+
+static void M68KX64FreePages()
+{
+	for (INT32 i = 0; i < SEK_MAX; i++) {
+		if (pX64Cpu[i] == NULL) continue;
+		for (INT32 j = 0; j < SEK_PAGE_COUNT; j++) {
+			M68KX64FreePage(pX64Cpu[i], j);
+			pX64Cpu[i]->bListed[j] = 0;
+		}
+		pX64Cpu[i]->nListedCount = 0;
+	}
+}
+
+// drop the pages whose memory changed since their blocks were made, whatever
+// wrote it: a handler (dma), another cpu or the driver
+static void M68KX64CheckPages(X64Cpu* pCpu)
+{
+	INT32 nCount = 0;
+
+	for (INT32 i = 0; i < pCpu->nListedCount; i++) {
+		UINT32 nPage = pCpu->nListed[i];
+		X64Page* pPage = pCpu->pPage[nPage];
+
+		if (pPage && pPage->pSource && memcmp(pPage->pSource, pPage->nSource, SEK_PAGE_SIZE) != 0) {
+			M68KX64FreePage(pCpu, nPage);
+			pPage = NULL;
+			nMapChanged = 1;
+		}
+		if (pPage == NULL) {
+			pCpu->bListed[nPage] = 0;
+			continue;
+		}
+		pCpu->nListed[nCount++] = nPage;
+	}
+
+	pCpu->nListedCount = nCount;
+}
+
+static void M68KX64Flush()
+{
+	M68KX64FreePages();
+
+	// a new buffer, reset() doesn't forget the labels
+	delete pCompiler;
+	pCompiler = new M68KX64Compiler();
+	pCompiler->Prologue();
+}
+
+// the fetch page can be translated if it is memory no write page points into,
+// other writes to it are caught by M68KX64CheckPages()
+static INT32 M68KX64PageState(UINT32 nPage)
+{
+	UINT8* pFetch = pSekExt->MemMap[nPage + SEK_WADD * 2];
+	if ((uintptr_t)pFetch < SEK_MAXHANDLER) {
+		return X64_PAGE_DATA;
+	}
+	if (pX64->nRemaps[nPage] >= X64_REMAP_MAX) {
+		return X64_PAGE_DATA;
+	}
+
+	for (INT32 i = 0; i < SEK_PAGE_COUNT; i++) {
+		UINT8* pWrite = pSekExt->MemMap[i + SEK_WADD];
+		if ((uintptr_t)pWrite >= SEK_MAXHANDLER && pWrite < pFetch + SEK_PAGE_SIZE && pFetch < pWrite + SEK_PAGE_SIZE) {
+			return X64_PAGE_DATA;
+		}
+	}
+
+	return X64_PAGE_CODE;
+}
+
+static void* M68KX64Translate(UINT32 nAddress)
+{
+	UINT32 nPage = nAddress >> SEK_SHIFT;
+
+	if (pX64->nState[nPage] == X64_PAGE_UNKNOWN) {
+		pX64->nState[nPage] = M68KX64PageState(nPage);
+	}
+	if (pX64->nState[nPage] != X64_PAGE_CODE || (nAddress & 1)) {
+		return X64_NO_BLOCK;
+	}
+
+	// the block stays in its page, so it goes away with it
+	UINT16 nOps[X64_BLOCK_MAX];
+	INT32 nLens[X64_BLOCK_MAX];
+	INT32 nCount = 0;
+	UINT32 nPc = nAddress;
+
+	while (nCount < X64_BLOCK_MAX && (nPc >> SEK_SHIFT) == nPage) {
+		UINT16 op = SekFetchWord(nPc);
+		INT32 nLen = M68KX64Length(op);
+		if (nLen == 0 || ((nPc & SEK_PAGEM) + nLen) > SEK_PAGE_SIZE) {
+			break;
+		}
+		nOps[nCount] = op;
+		nLens[nCount] = nLen;
+		nCount++;
+		nPc += nLen;
+		if (M68KX64EndsBlock(op)) {
+			break;
+		}
+	}
+
+	if (nCount == 0) {
+		return X64_NO_BLOCK;
+	}
+
+	void* pBlock = NULL;
+	try {
+		pBlock = pCompiler->Compile(nAddress, nCount, nOps, nLens);
+	} catch (Xbyak::Error&) {
+		// cache full, start again
+		M68KX64Flush();
+		pBlock = pCompiler->Compile(nAddress, nCount, nOps, nLens);
+	}
+	nM68KX64Blocks++;
+
+	return pBlock;
+}
+
+static void** M68KX64Slot(UINT32 nAddress)
+{
+	UINT32 nPage = nAddress >> SEK_SHIFT;
+	X64Page* pPage = pX64->pPage[nPage];
+
+	if (pPage == NULL) {
+		pPage = (X64Page*)calloc(1, sizeof(X64Page));
+		pX64->pPage[nPage] = pPage;
+
+		UINT8* pFetch = pSekExt->MemMap[nPage + SEK_WADD * 2];
+		if ((uintptr_t)pFetch >= SEK_MAXHANDLER) {
+			pPage->pSource = pFetch;
+			memcpy(pPage->nSource, pFetch, SEK_PAGE_SIZE);
+		}
+		if (!pX64->bListed[nPage]) {
+			pX64->bListed[nPage] = 1;
+			pX64->nListed[pX64->nListedCount++] = nPage;
+		}
+	}
+
+	return &pPage->pBlock[(nAddress & SEK_PAGEM) >> 1];
+}
+
+// called by m68k_execute_blocks() when the dispatch loop returned, or to start
+static INT32 M68KX64RunBlock()
+{
+	UINT32 nAddress = *pRunPC;
+	if (nAddress & 0xff000001) {
+		return 0;
+	}
+
+	void* pBlock = *M68KX64Slot(nAddress);
+	if (pBlock == NULL) {
+		pBlock = M68KX64Translate(nAddress);
+		// the translation may have flushed the cache
+		*M68KX64Slot(nAddress) = pBlock;
+	}
+
+	if (pBlock == X64_NO_BLOCK) {
+		return 0;
+	}
+
+	nMapChanged = 0;
+	pCompiler->pEntry(pBlock);
+
+	return 1;
+}
+
+// ----------------------------------------------------------------------------
+// Interface
+
+INT32 M68KX64Init(INT32 nCount)
+{
+	pRegPC = m68k_get_reg_ptr(M68K_REG_PC);
+	pRegPPC = m68k_get_reg_ptr(M68K_REG_PPC);
+	pRegIR = m68k_get_reg_ptr(M68K_REG_IR);
+	pRegPrefAddr = m68k_get_reg_ptr(M68K_REG_PREF_ADDR);
+	pRegPrefData = m68k_get_reg_ptr(M68K_REG_PREF_DATA);
+	pRegDA = m68k_get_reg_ptr(M68K_REG_D0);
+	pFlagX = m68k_get_flag_ptr('X');
+	pFlagN = m68k_get_flag_ptr('N');
+	pFlagZ = m68k_get_flag_ptr('Z');
+	pFlagV = m68k_get_flag_ptr('V');
+	pFlagC = m68k_get_flag_ptr('C');
+
+	if (pCompiler == NULL) {
+		pCompiler = new M68KX64Compiler();
+		pCompiler->Prologue();
+		nM68KX64Blocks = 0;
+	}
+
+	if (pX64Cpu[nCount] == NULL) {
+		pX64Cpu[nCount] = (X64Cpu*)calloc(1, sizeof(X64Cpu));
+		if (pX64Cpu[nCount] == NULL) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void M68KX64Exit()
+{
+	M68KX64FreePages();
+
+	for (INT32 i = 0; i < SEK_MAX; i++) {
+		if (pX64Cpu[i]) {
+			free(pX64Cpu[i]);
+			pX64Cpu[i] = NULL;
+		}
+	}
+	pX64 = NULL;
+
+	delete pCompiler;
+	pCompiler = NULL;
+}
+
+INT32 M68KX64Run(INT32 nCycles)
+{
+	pX64 = pX64Cpu[nSekActive];
+	pRunPC = m68k_get_reg_ptr(M68K_REG_PC);
+
+	// what the other cpus and the driver wrote since the last run
+	M68KX64CheckPages(pX64);
+
+	return m68k_execute_blocks(nCycles, M68KX64RunBlock);
+}
+
+void M68KX64MapChanged(UINT32 nStart, UINT32 nEnd, INT32 nType)
+{
+	if (nSekActive < 0 || pX64Cpu[nSekActive] == NULL) {
+		return;
+	}
+	X64Cpu* pCpu = pX64Cpu[nSekActive];
+
+	nMapChanged = 1;
+
+	if (nType & MAP_WRITE) {
+		// drop the code pages the new write pages point into
+		for (INT32 i = 0; i < SEK_PAGE_COUNT; i++) {
+			if (pCpu->nState[i] != X64_PAGE_CODE) continue;
+
+			UINT8* pFetch = pSekExt->MemMap[i + SEK_WADD * 2];
+			for (UINT32 j = (nStart >> SEK_SHIFT); j <= (nEnd >> SEK_SHIFT) && j < SEK_PAGE_COUNT; j++) {
+				UINT8* pWrite = pSekExt->MemMap[j + SEK_WADD];
+				if ((uintptr_t)pWrite >= SEK_MAXHANDLER && pWrite < pFetch + SEK_PAGE_SIZE && pFetch < pWrite + SEK_PAGE_SIZE) {
+					M68KX64FreePage(pCpu, i);
+					pCpu->nState[i] = X64_PAGE_UNKNOWN;
+					break;
+				}
+			}
+		}
+	}
+
+	if (nType & MAP_FETCH) {
+		// a page the driver keeps banking is left to the interpreter
+		for (UINT32 i = (nStart & ~SEK_PAGEM); i <= nEnd && i < 0x1000000; i += SEK_PAGE_SIZE) {
+			UINT32 nPage = i >> SEK_SHIFT;
+			if (pCpu->pPage[nPage]) {
+				free(pCpu->pPage[nPage]);
+				pCpu->pPage[nPage] = NULL;
+				if (pCpu->nRemaps[nPage] < X64_REMAP_MAX) {
+					pCpu->nRemaps[nPage]++;
+				}
+			}
+			pCpu->nState[nPage] = X64_PAGE_UNKNOWN;
+		}
+	}
+}
+
+void M68KX64CodeChanged(UINT32 nAddress)
+{
+	if (nSekActive < 0 || pX64Cpu[nSekActive] == NULL) {
+		return;
+	}
+	X64Cpu* pCpu = pX64Cpu[nSekActive];
+
+	nMapChanged = 1;
+
+	// blocks never cross a page
+	M68KX64FreePage(pCpu, (nAddress & 0xffffff) >> SEK_SHIFT);
+}
+
+void M68KX64HandlerWrote()
+{
+	if (nSekActive < 0 || pX64Cpu[nSekActive] == NULL) {
+		return;
+	}
+
+	M68KX64CheckPages(pX64Cpu[nSekActive]);
+}
@@ -0,0 +1,36 @@
+// 68000 x86-64 block recompiler - header file
+
+#ifndef M68K_X64_H
+#define M68K_X64_H
+
+// Blocks of straight line code are translated to x86-64. The common moves,
+// arithmetic, compares, lea and branches are emitted natively with the flags
+// computed as Musashi does, with an inline path for directly mapped memory and
+// a call to the M68KRead* / M68KWrite* functions for the rest. The other
+// instructions become direct calls to their Musashi handlers, the fetch, decode
+// and cycle table lookups are done once at translation. Only code in pages the
+// cpu can't write to directly is translated, everything else (and the 68EC020)
+// runs in the interpreter. A page whose memory changes anyway (handler dma,
+// another cpu, the driver) loses its blocks at the next check.
+
+INT32 M68KX64Init(INT32 nCount);
+void M68KX64Exit();
+
+// blocks translated since the first cpu was initialised
+extern INT32 nM68KX64Blocks;
+
+// run the open cpu, same as m68k_execute()
+INT32 M68KX64Run(INT32 nCycles);
+
+// the memory map of the open cpu changed (nType: MAP_READ, MAP_WRITE, MAP_FETCH)
+void M68KX64MapChanged(UINT32 nStart, UINT32 nEnd, INT32 nType);
+
+// the code at nAddress was written to (SekWrite*ROM)
+void M68KX64CodeChanged(UINT32 nAddress);
+
+// a write handler of the open cpu returned: it may have stored anywhere (dma),
+// the pages whose memory changed are dropped. The same check runs when a cpu
+// starts a run, for what the other cpus and the driver wrote in between
+void M68KX64HandlerWrote();
+
+#endif // M68K_X64_H
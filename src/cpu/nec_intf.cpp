@@ -5,6 +5,7 @@
 
 #include "burnint.h"
 #include "nec_intf.h"
+#include "burn_prof.h"
 
 #define MAX_VEZ		4
 
@@ -589,6 +590,8 @@ INT32 VezRun(INT32 nCycles)
 	if (nOpenedCPU == -1) bprintf(PRINT_ERROR, _T("VezRun called when no CPU open\n"));
 #endif
 
+	BURN_PROF_SCOPE(BURN_PROF_VEZ);
+
 	if (nCycles <= 0) return 0;
 
 	return VezCurrentCPU->cpu_execute(nCycles);
@@ -29,10 +29,19 @@
  *
  *****************************************************************************/
 
+#include <stddef.h>
 #include "burnint.h"
 #include "sh2_intf.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
+#if defined SH2_X64_DRC && defined BURN_MACHINES
+#undef SH2_X64_DRC										// one code buffer for all the threads
+#endif
+#if defined SH2_X64_DRC
+#include "x64/sh2_x64.h"
+#endif
 
-int has_sh2;
+BURN_THREAD int has_sh2;
 INT32 cps3speedhack; // must be set _after_ Sh2Init();
 INT32 sh2_suprnova_speedhack;
 INT32 sh2_busyloop_speedhack_mode2;
@@ -48,7 +57,7 @@ INT32 sh2_busyloop_speedhack_mode2;
 #endif
 
 #if FAST_OP_FETCH
-	static unsigned char * readop_pr;  // for FAST_OP_FETCH cpu_readop16()
+	static BURN_THREAD unsigned char * readop_pr;  // for FAST_OP_FETCH cpu_readop16()
 
 	#define change_pc(newpc)													\
 		sh2->pc = (newpc);														\
@@ -121,7 +130,7 @@ typedef struct
 
 } SH2;
 
-static SH2 * sh2;
+static BURN_THREAD SH2 * sh2;
 
 static UINT32 sh2_GetTotalCycles()
 {
@@ -167,6 +176,33 @@ static void sh2_internal_w(UINT32 offset, UINT32 data, UINT32 mem_mask);
 
 #define	SH2_MAXHANDLER	(8)
 
+//-- pre-decoded blocks -----------------------------------------
+
+#define SH2_BLOCK_LENGTH	(64)					// instructions per block
+#define SH2_BLOCK_ARENA		(2 << 20)				// block memory per cpu, flushed when full
+
+typedef struct
+{
+	void (*handler)(UINT16 opcode);
+	UINT16 opcode;
+} SH2BLOCKOP;
+
+typedef struct
+{
+	void * code;									// x86-64 code, once compiled
+	unsigned char * page;							// the fetch page it was decoded from
+	UINT32 address;
+	int count;
+	int idle;										// a poll loop starts it (burn_idle.h)
+	SH2BLOCKOP op[1];
+} SH2BLOCK;
+
+typedef struct
+{
+	SH2BLOCK ** page[SH2_PAGE_COUNT];				// a block per even address, allocated per page
+	unsigned char * arena;
+	int arena_used;
+} SH2BLOCKS;
 
 typedef struct 
 {
@@ -181,10 +217,17 @@ typedef struct
 	
 	unsigned char * opbase;
 	int suspend;
+
+	int timer_icount;			// an internal timer may be due once sh2_icount gets down to this
+	SH2BLOCKS * blocks;
 } SH2EXT;
 
-static SH2EXT * pSh2Ext;
-static SH2EXT * Sh2Ext = NULL;
+static BURN_THREAD SH2EXT * pSh2Ext;
+static BURN_THREAD SH2EXT * Sh2Ext = NULL;
+static BURN_THREAD int nSh2Count = 0;
+static int nSh2Core = SH2_CORE_C;
+
+static void sh2_block_exit(void);
 
 /* SH-2 Memory Map:
  * 0x00000000 ~ 0x07ffffff : user
@@ -439,11 +482,13 @@ int Sh2Exit()
 	has_sh2 = 0;
 
 	if (Sh2Ext) {
+		sh2_block_exit();
 		free(Sh2Ext);
 		Sh2Ext = NULL;
 	}
 	pSh2Ext = NULL;
 	
+	nSh2Count = 0;
 	DebugCPU_SH2Initted = 0;
 
 	return 0;
@@ -490,6 +535,7 @@ int Sh2Init(int nCount)
 		return 1;
 	}
 	memset(Sh2Ext, 0, sizeof(SH2EXT) * nCount);
+	nSh2Count = nCount;
 
 	// init default memory handler
 	for (int i=0; i<nCount; i++) {
@@ -2756,6 +2802,37 @@ SH2_INLINE void op1111(UINT16 /*opcode*/)
  *  MAME CPU INTERFACE
  *****************************************************************************/
 
+// sh2_icount at which the first of the running timers is due, Sh2Run() only
+// checks the timers between blocks until then
+static INT64 sh2_timer_due(UINT32 cy, UINT32 base, UINT32 cycles)
+{
+	UINT32 elapsed = cy - base;
+	if (elapsed >= cycles)
+		return 0x7fffffff;
+	return (INT64)sh2->sh2_icount - (cycles - elapsed);
+}
+
+static void sh2_timer_deadline(void)
+{
+	UINT32 cy = sh2_GetTotalCycles();
+	INT64 due = 0;
+
+	if (sh2->dma_timer_active[0]) {
+		INT64 t = sh2_timer_due(cy, sh2->dma_timer_base[0], sh2->dma_timer_cycles[0]);
+		if (t > due) due = t;
+	}
+	if (sh2->dma_timer_active[1]) {
+		INT64 t = sh2_timer_due(cy, sh2->dma_timer_base[1], sh2->dma_timer_cycles[1]);
+		if (t > due) due = t;
+	}
+	if (sh2->timer_active) {
+		INT64 t = sh2_timer_due(cy, sh2->timer_base, sh2->timer_cycles);
+		if (t > due) due = t;
+	}
+
+	pSh2Ext->timer_icount = (due > 0x7fffffff) ? 0x7fffffff : (int)due;
+}
+
 static void sh2_timer_resync(void)
 {
 	int divider = div_tab[(sh2->m[5] >> 8) & 3];
@@ -2811,6 +2888,8 @@ static void sh2_timer_activate(void)
 			//bprintf(0, _T("SH2.0: Timer event in %d cycles of external clock\n"), max_delta);
 		}
 	}
+
+	sh2_timer_deadline();
 }
 
 static void sh2_recalc_irq(void)
@@ -2895,6 +2974,7 @@ static void sh2_dmac_callback(int dma)
 
 	sh2->m[0x63+4*dma] |= 2;
 	sh2->dma_timer_active[dma] = 0;
+	sh2_timer_deadline();
 	sh2_recalc_irq();
 	
 //	cpuintrf_pop_context();
@@ -2930,6 +3010,7 @@ static void sh2_dmac_check(int dma)
 			//timer_adjust(sh2->dma_timer[dma], ATTOTIME_IN_CYCLES(2*count+1, sh2->cpu_number), (sh2->cpu_number<<1)|dma, attotime_zero);
 			sh2->dma_timer_cycles[dma] = 2 * count + 1;
 			sh2->dma_timer_base[dma] = sh2_GetTotalCycles();
+			sh2_timer_deadline();
 			
 			src &= AM;
 			dst &= AM;
@@ -3014,7 +3095,7 @@ static void sh2_dmac_check(int dma)
 			//bprintf(0, _T("SH2: DMA %d cancelled in-flight"), dma);
 			//timer_adjust(sh2->dma_timer[dma], attotime_never, 0, attotime_zero);
 			sh2->dma_timer_active[dma] = 0;
-
+			sh2_timer_deadline();
 		}
 	}
 }
@@ -3226,14 +3307,455 @@ static UINT32 sh2_internal_r(UINT32 offset, UINT32 /*mem_mask*/)
 
 // -------------------------------------------------------
 
-int Sh2Run(int cycles)
+// what Sh2Run does after every instruction
+SH2_INLINE void sh2_op_done(void)
 {
-#if defined FBA_DEBUG
-	if (!DebugCPU_SH2Initted) bprintf(PRINT_ERROR, _T("Sh2Run called without init\n"));
+	if(sh2->test_irq && !sh2->delay)
+	{
+		CHECK_PENDING_IRQ(/*"mame_sh2_execute"*/);
+		sh2->test_irq = 0;
+	}
+
+	sh2->sh2_total_cycles++;
+	sh2->sh2_icount -= (sh2_suprnova_speedhack) ? 4 : 1;
+}
+
+SH2_INLINE void sh2_check_timers(void)
+{
+	unsigned int cy = sh2_GetTotalCycles();
+
+	if (sh2->dma_timer_active[0])
+		if ((cy - sh2->dma_timer_base[0]) >= sh2->dma_timer_cycles[0])
+			sh2_dmac_callback(0);
+
+	if (sh2->dma_timer_active[1])
+		if ((cy - sh2->dma_timer_base[1]) >= sh2->dma_timer_cycles[1])
+			sh2_dmac_callback(1);
+
+	if ( sh2->timer_active )
+		if ((cy - sh2->timer_base) >= sh2->timer_cycles)
+			sh2_timer_callback();
+}
+
+SH2_INLINE void sh2_execute_one(void)
+{
+	if (pSh2Ext->suspend == 0) {
+		UINT16 opcode;
+
+		if (sh2->delay) {
+			opcode = cpu_readop16(sh2->delay & AM);
+			change_pc(sh2->pc & AM);
+			sh2->delay = 0;
+		} else {
+			opcode = cpu_readop16(sh2->pc & AM);
+			sh2->pc += 2;
+		}
+
+		sh2->ppc = sh2->pc;
+
+		switch (opcode & ( 15 << 12))
+		{
+			case  0<<12: op0000(opcode); break;
+			case  1<<12: op0001(opcode); break;
+			case  2<<12: op0010(opcode); break;
+			case  3<<12: op0011(opcode); break;
+			case  4<<12: op0100(opcode); break;
+			case  5<<12: op0101(opcode); break;
+			case  6<<12: op0110(opcode); break;
+			case  7<<12: op0111(opcode); break;
+			case  8<<12: op1000(opcode); break;
+			case  9<<12: op1001(opcode); break;
+			case 10<<12: op1010(opcode); break;
+			case 11<<12: op1011(opcode); break;
+			case 12<<12: op1100(opcode); break;
+			case 13<<12: op1101(opcode); break;
+			case 14<<12: op1110(opcode); break;
+		default: op1111(opcode); break;
+		}
+	}
+
+	sh2_op_done();
+
+	// timer check
+	sh2_check_timers();
+}
+
+//-- pre-decoded blocks -----------------------------------------
+//
+// Straight line code in memory mapped pages is decoded once into a list of
+// opcode group handlers (SH2_CORE_BLOCK), or compiled to x86-64 (SH2_CORE_DRC).
+// A block is checked against the fetch map and the code bytes every time it is
+// entered, so code in RAM, DMA, bank switches and savestates need no hooks.
+// Delay slots, irqs and the timers are handled as in the interpreter; the
+// timers are only checked once sh2_icount is down to timer_icount.
+
+static BURN_THREAD int nSh2BlockDepth = 0;	// a Sh2Run() nested in a handler interprets, the blocks stay put
+static BURN_THREAD int nSh2BlockCycles = 1;	// cycles per instruction the blocks were compiled for
+
+#define SH2_OP_DELAYED		1				// a delayed branch, the next op is its slot
+#define SH2_OP_ALWAYS		2				// the block can't go on after it (or its slot)
+#define SH2_OP_BRANCH		4				// changes pc, not allowed in a slot
+#define SH2_OP_END			8				// ends the block
+
+static void (* const sh2_op_group[16])(UINT16 opcode) = {
+	op0000, op0001, op0010, op0011, op0100, op0101, op0110, op0111,
+	op1000, op1001, op1010, op1011, op1100, op1101, op1110, op1111
+};
+
+static int sh2_block_op_type(UINT16 opcode)
+{
+	switch (opcode >> 12) {
+		case 0x0:
+			switch (opcode & 0x3f) {
+				case 0x03: case 0x23: case 0x0b: case 0x2b:		// BSRF, BRAF, RTS, RTE
+					return SH2_OP_DELAYED | SH2_OP_ALWAYS | SH2_OP_BRANCH;
+				case 0x1b:										// SLEEP
+					return SH2_OP_BRANCH | SH2_OP_END;
+			}
+			break;
+		case 0x4:
+			switch (opcode & 0x3f) {
+				case 0x0b: case 0x2b:							// JSR, JMP
+					return SH2_OP_DELAYED | SH2_OP_ALWAYS | SH2_OP_BRANCH;
+				case 0x07: case 0x0e:							// LDC.L @Rm+,SR  LDC Rm,SR
+					return SH2_OP_END;
+			}
+			break;
+		case 0x8:
+			switch (opcode & 0x0f00) {
+				case 0x0900: case 0x0b00:						// BT, BF
+					return SH2_OP_BRANCH;
+				case 0x0d00: case 0x0f00:						// BT/S, BF/S
+					return SH2_OP_DELAYED | SH2_OP_BRANCH;
+			}
+			break;
+		case 0xa: case 0xb:										// BRA, BSR
+			return SH2_OP_DELAYED | SH2_OP_ALWAYS | SH2_OP_BRANCH;
+		case 0xc:
+			if ((opcode & 0x0f00) == 0x0300)					// TRAPA
+				return SH2_OP_BRANCH | SH2_OP_END;
+			break;
+	}
+
+	return 0;
+}
+
+SH2_INLINE UINT16 sh2_block_fetch(unsigned char * pr, UINT32 A)
+{
+#ifdef LSB_FIRST
+	A ^= 2;
 #endif
+	return *((unsigned short *)(pr + (A & SH2_PAGEM)));
+}
 
-	sh2->sh2_icount = cycles;
-	sh2->sh2_cycles_to_run = cycles;
+static void sh2_block_flush(void)
+{
+	// all of them, the cpus share the x86-64 code buffer
+	for (int i = 0; i < nSh2Count; i++) {
+		SH2BLOCKS * blocks = Sh2Ext[i].blocks;
+		if (blocks == NULL) continue;
+
+		for (int j = 0; j < SH2_PAGE_COUNT; j++) {
+			if (blocks->page[j]) {
+				free(blocks->page[j]);
+				blocks->page[j] = NULL;
+			}
+		}
+		blocks->arena_used = 0;
+	}
+
+#if defined SH2_X64_DRC
+	Sh2X64Flush();
+#endif
+}
+
+static void sh2_block_exit(void)
+{
+#if defined SH2_X64_DRC
+	Sh2X64Exit();
+#endif
+
+	sh2_block_flush();
+
+	for (int i = 0; i < nSh2Count; i++) {
+		if (Sh2Ext[i].blocks) {
+			free(Sh2Ext[i].blocks->arena);
+			free(Sh2Ext[i].blocks);
+			Sh2Ext[i].blocks = NULL;
+		}
+	}
+}
+
+static UINT8 * sh2_idle_fetch(UINT32 a)
+{
+	unsigned char * pr = pSh2Ext->MemMap[ ((a & AM) >> SH2_SHIFT) + SH2_WADD * 2 ];
+	return ((uintptr_t)pr >= SH2_MAXHANDLER) ? pr : NULL;
+}
+
+static UINT8 * sh2_idle_read(UINT32 a)
+{
+	unsigned char * pr = pSh2Ext->MemMap[ a >> SH2_SHIFT ];
+	return ((uintptr_t)pr >= SH2_MAXHANDLER) ? pr : NULL;
+}
+
+static UINT32 sh2_idle_reg(INT32 n)
+{
+	return (n < 16) ? sh2->r[n] : sh2->gbr;
+}
+
+static UINT32 sh2_idle_pc(void)
+{
+	return sh2->pc;
+}
+
+static const BurnIdleCpu Sh2IdleCpu =
+{
+	BURN_IDLE_SH2,
+	sh2_idle_fetch,
+	sh2_idle_read,
+	SH2_PAGE_SIZE,
+#ifdef LSB_FIRST
+	3,
+#else
+	0,
+#endif
+	sh2_idle_reg,
+	sh2_idle_pc,
+	NULL
+};
+
+// the block is a poll loop back to its start, the registers only matter once it runs
+static int sh2_block_idle(SH2BLOCK * b)
+{
+	BurnIdleLoop loop;
+
+	if (!BurnIdleEnabled(BURN_IDLE_SH2) || !BurnIdleFind(&Sh2IdleCpu, b->address, &loop))
+		return 0;
+
+	return loop.nStart == b->address && loop.nEnd <= b->address + b->count * 2;
+}
+
+static SH2BLOCK * sh2_block_translate(UINT32 pc, unsigned char * pr)
+{
+	UINT16 op[SH2_BLOCK_LENGTH];
+	UINT32 end = (pc & ~SH2_PAGEM) + SH2_PAGE_SIZE;
+	int count = 0;
+
+	// the block stays in its page, a delayed branch only goes in with its slot
+	while (count < SH2_BLOCK_LENGTH && pc + count * 2 < end) {
+		UINT16 opcode = sh2_block_fetch(pr, pc + count * 2);
+		int type = sh2_block_op_type(opcode);
+
+		if (type & SH2_OP_DELAYED) {
+			UINT32 slot = pc + count * 2 + 2;
+			if (slot >= end || count + 2 > SH2_BLOCK_LENGTH)
+				break;
+			if (sh2_block_op_type(sh2_block_fetch(pr, slot)) & SH2_OP_BRANCH)
+				break;
+
+			op[count++] = opcode;
+			op[count++] = sh2_block_fetch(pr, slot);
+			if (type & SH2_OP_ALWAYS)
+				break;
+			continue;
+		}
+
+		op[count++] = opcode;
+		if (type & SH2_OP_END)
+			break;
+	}
+
+	if (count == 0)
+		return NULL;
+
+	int size = (offsetof(SH2BLOCK, op) + count * sizeof(SH2BLOCKOP) + 7) & ~7;
+	if (pSh2Ext->blocks->arena_used + size > SH2_BLOCK_ARENA)
+		sh2_block_flush();
+
+	SH2BLOCK * b = (SH2BLOCK *)(pSh2Ext->blocks->arena + pSh2Ext->blocks->arena_used);
+	pSh2Ext->blocks->arena_used += size;
+
+	b->code = NULL;
+	b->page = pr;
+	b->address = pc;
+	b->count = count;
+	for (int i = 0; i < count; i++) {
+		b->op[i].handler = sh2_op_group[op[i] >> 12];
+		b->op[i].opcode = op[i];
+	}
+	b->idle = sh2_block_idle(b);
+
+	return b;
+}
+
+// the block at pc, NULL if it has to be interpreted
+static SH2BLOCK * sh2_block_find(UINT32 pc)
+{
+	unsigned char * pr = pSh2Ext->MemMap[ (pc >> SH2_SHIFT) + SH2_WADD * 2 ];
+	if ((uintptr_t)pr < SH2_MAXHANDLER || (pc & 1) || pc != (pc & AM))
+		return NULL;
+
+	SH2BLOCK ** page = pSh2Ext->blocks->page[pc >> SH2_SHIFT];
+	SH2BLOCK * b = page ? page[(pc & SH2_PAGEM) >> 1] : NULL;
+
+	if (b && b->page == pr) {
+		int i;
+		for (i = 0; i < b->count; i++) {
+			if (b->op[i].opcode != sh2_block_fetch(pr, pc + i * 2))
+				break;
+		}
+		if (i == b->count)
+			return b;
+	}
+
+	// new code (or it changed), the translation may have flushed the page tables
+	b = sh2_block_translate(pc, pr);
+	if (b == NULL)
+		return NULL;
+
+	page = pSh2Ext->blocks->page[pc >> SH2_SHIFT];
+	if (page == NULL) {
+		page = (SH2BLOCK **)calloc(SH2_PAGE_SIZE / 2, sizeof(SH2BLOCK *));
+		if (page == NULL)
+			return NULL;
+		pSh2Ext->blocks->page[pc >> SH2_SHIFT] = page;
+	}
+	page[(pc & SH2_PAGEM) >> 1] = b;
+
+	return b;
+}
+
+static void sh2_block_run(SH2BLOCK * b)
+{
+	SH2BLOCKOP * op = b->op;
+	UINT32 pc = b->address;
+
+	for (int i = 0; i < b->count; i++, op++, pc += 2) {
+		if (sh2->delay) {
+			// the slot of the branch before it, then the block is done
+			if (sh2->delay != pc)
+				return;
+
+			change_pc(sh2->pc & AM);
+			sh2->delay = 0;
+			sh2->ppc = sh2->pc;
+			op->handler(op->opcode);
+			sh2_op_done();
+			if (sh2->sh2_icount <= pSh2Ext->timer_icount)
+				sh2_check_timers();
+			return;
+		}
+
+		// a branch was taken, or an irq / exception
+		if (sh2->pc != pc)
+			return;
+
+		sh2->pc += 2;
+		sh2->ppc = sh2->pc;
+		op->handler(op->opcode);
+		sh2_op_done();
+		if (sh2->sh2_icount <= pSh2Ext->timer_icount)
+			sh2_check_timers();
+
+		if (sh2->sh2_icount <= 0 || pSh2Ext->suspend)
+			return;
+	}
+}
+
+#if defined SH2_X64_DRC
+
+static int sh2_x64_init(void)
+{
+	Sh2X64Layout l;
+
+	l.nR = offsetof(SH2EXT, sh2.r);
+	l.nPc = offsetof(SH2EXT, sh2.pc);
+	l.nPpc = offsetof(SH2EXT, sh2.ppc);
+	l.nPr = offsetof(SH2EXT, sh2.pr);
+	l.nSr = offsetof(SH2EXT, sh2.sr);
+	l.nGbr = offsetof(SH2EXT, sh2.gbr);
+	l.nMach = offsetof(SH2EXT, sh2.mach);
+	l.nMacl = offsetof(SH2EXT, sh2.macl);
+	l.nEa = offsetof(SH2EXT, sh2.ea);
+	l.nDelay = offsetof(SH2EXT, sh2.delay);
+	l.nTestIrq = offsetof(SH2EXT, sh2.test_irq);
+	l.nIcount = offsetof(SH2EXT, sh2.sh2_icount);
+	l.nTotalCycles = offsetof(SH2EXT, sh2.sh2_total_cycles);
+	l.nTimerIcount = offsetof(SH2EXT, timer_icount);
+	l.nSuspend = offsetof(SH2EXT, suspend);
+	l.nMemMap = offsetof(SH2EXT, MemMap);
+	l.nReadByte = offsetof(SH2EXT, ReadByte);
+	l.nReadWord = offsetof(SH2EXT, ReadWord);
+	l.nReadLong = offsetof(SH2EXT, ReadLong);
+	l.nWriteByte = offsetof(SH2EXT, WriteByte);
+	l.nWriteWord = offsetof(SH2EXT, WriteWord);
+	l.nWriteLong = offsetof(SH2EXT, WriteLong);
+	l.nBlockCode = offsetof(SH2BLOCK, code);
+	for (int i = 0; i < 16; i++)
+		l.pOp[i] = sh2_op_group[i];
+
+	return Sh2X64Init(&l);
+}
+
+static void * sh2_block_compile(SH2BLOCK * b)
+{
+	UINT16 op[SH2_BLOCK_LENGTH];
+
+	for (int i = 0; i < b->count; i++)
+		op[i] = b->op[i].opcode;
+
+	return Sh2X64Compile(b->address, b->count, op, b->page, nSh2BlockCycles);
+}
+
+#endif
+
+// the block memory of the open cpu, 0 if it can't have any
+static int sh2_block_init(void)
+{
+	int cycles = (sh2_suprnova_speedhack) ? 4 : 1;
+
+	if (pSh2Ext->blocks == NULL) {
+#if defined SH2_X64_DRC
+		if (nSh2Core == SH2_CORE_DRC && sh2_x64_init())
+			nSh2Core = SH2_CORE_BLOCK;
+#endif
+		pSh2Ext->blocks = (SH2BLOCKS *)calloc(1, sizeof(SH2BLOCKS));
+		if (pSh2Ext->blocks == NULL)
+			return 0;
+		pSh2Ext->blocks->arena = (unsigned char *)malloc(SH2_BLOCK_ARENA);
+		if (pSh2Ext->blocks->arena == NULL) {
+			free(pSh2Ext->blocks);
+			pSh2Ext->blocks = NULL;
+			return 0;
+		}
+	}
+
+	// the x86-64 code has the cycles per instruction built in
+	if (cycles != nSh2BlockCycles) {
+		sh2_block_flush();
+		nSh2BlockCycles = cycles;
+	}
+
+	return 1;
+}
+
+// after the x86-64 code, as change_pc() would have left it
+static void sh2_block_sync(void)
+{
+	UINT32 A = (sh2->delay ? sh2->delay : sh2->pc) & AM;
+
+	readop_pr = pSh2Ext->MemMap[ (A >> SH2_SHIFT) + SH2_WADD * 2 ];
+	pSh2Ext->opbase = readop_pr - (A & ~SH2_PAGEM);
+}
+
+static void sh2_run_blocks(int cycles)
+{
+	SH2BLOCK * idle = NULL;					// the poll loop the last block was, and what it read
+	BurnIdleLoop idle_loop;
+	UINT32 idle_value = 0;
+
+	nSh2BlockDepth++;
+	sh2_timer_deadline();
 
 	do
 	{
@@ -3243,72 +3765,122 @@ int Sh2Run(int cycles)
 			break;
 		}
 
-		if (pSh2Ext->suspend == 0) {
-			UINT16 opcode;
+		SH2BLOCK * b = NULL;
+		if (pSh2Ext->suspend == 0 && sh2->delay == 0)
+			b = sh2_block_find(sh2->pc);
 
-			if (sh2->delay) {
-				opcode = cpu_readop16(sh2->delay & AM);
-				change_pc(sh2->pc & AM);
-				sh2->delay = 0;
+		if (b == NULL) {
+			idle = NULL;
+			sh2_execute_one();
+			continue;
+		}
+
+		// a poll loop runs here, not in the x86-64 code, a pass that came back
+		// round with the same value can only be left once a timer is due
+		if (b->idle && BurnIdleEnabled(BURN_IDLE_SH2)) {
+			if (b == idle && BurnIdleValue(&Sh2IdleCpu, &idle_loop) == idle_value) {
+				int burn = sh2->sh2_icount - ((pSh2Ext->timer_icount > 0) ? pSh2Ext->timer_icount : 0);
+				if (burn > 0) {
+					sh2->sh2_icount -= burn;
+					sh2->sh2_total_cycles += burn;
+					BurnIdleSkipped(BURN_IDLE_SH2, burn);
+				}
+			} else if (BurnIdleFind(&Sh2IdleCpu, b->address, &idle_loop)) {
+				idle = b;
+				idle_value = BurnIdleValue(&Sh2IdleCpu, &idle_loop);
 			} else {
-				opcode = cpu_readop16(sh2->pc & AM);
-				sh2->pc += 2;
+				idle = NULL;
 			}
 
-			sh2->ppc = sh2->pc;
+			sh2_block_run(b);
+			continue;
+		}
 
-			switch (opcode & ( 15 << 12))
-			{
-				case  0<<12: op0000(opcode); break;
-				case  1<<12: op0001(opcode); break;
-				case  2<<12: op0010(opcode); break;
-				case  3<<12: op0011(opcode); break;
-				case  4<<12: op0100(opcode); break;
-				case  5<<12: op0101(opcode); break;
-				case  6<<12: op0110(opcode); break;
-				case  7<<12: op0111(opcode); break;
-				case  8<<12: op1000(opcode); break;
-				case  9<<12: op1001(opcode); break;
-				case 10<<12: op1010(opcode); break;
-				case 11<<12: op1011(opcode); break;
-				case 12<<12: op1100(opcode); break;
-				case 13<<12: op1101(opcode); break;
-				case 14<<12: op1110(opcode); break;
-			default: op1111(opcode); break;
+		idle = NULL;
+
+#if defined SH2_X64_DRC
+		// the x86-64 code only looks for irqs after the instructions that can raise them
+		if (nSh2Core == SH2_CORE_DRC && sh2->test_irq == 0) {
+			if (b->code == NULL) {
+				b->code = sh2_block_compile(b);
+				if (b->code == NULL) {
+					// the code buffer is full, start it again
+					sh2_block_flush();
+					b = sh2_block_find(sh2->pc);
+					if (b == NULL) {
+						sh2_execute_one();
+						continue;
+					}
+					b->code = sh2_block_compile(b);
+				}
 			}
-		}
 
-		if(sh2->test_irq && !sh2->delay)
-		{
-			CHECK_PENDING_IRQ(/*"mame_sh2_execute"*/);
-			sh2->test_irq = 0;
+			// a block the code can't be made for runs in C
+			if (b->code) {
+				int icount = sh2->sh2_icount;
+				int state = Sh2X64Run(pSh2Ext, pSh2Ext->blocks);
+				sh2_block_sync();
+
+				if (state == SH2_X64_OP_DONE) {
+					sh2_op_done();
+					sh2_check_timers();
+				} else if (state == SH2_X64_TIMERS) {
+					sh2_check_timers();
+				} else if (sh2->sh2_icount == icount) {
+					// the block wouldn't run at all, step past it
+					sh2_execute_one();
+				}
+				// otherwise it ran off the compiled code, the next pass makes the block
+				continue;
+			}
 		}
+#endif
 
-		sh2->sh2_total_cycles++;
-		sh2->sh2_icount -= (sh2_suprnova_speedhack) ? 4 : 1;
-		
-		// timer check 
-		
+		sh2_block_run(b);
+
+	} while( sh2->sh2_icount > 0 );
+
+	nSh2BlockDepth--;
+}
+
+void Sh2SetCore(int nCore)
+{
+	// the blocks are set up for the core they were made by
+	if (nCore != nSh2Core)
+		sh2_block_exit();
+
+	nSh2Core = nCore;
+}
+
+// -------------------------------------------------------
+
+int Sh2Run(int cycles)
+{
+#if defined FBA_DEBUG
+	if (!DebugCPU_SH2Initted) bprintf(PRINT_ERROR, _T("Sh2Run called without init\n"));
+#endif
+
+	BURN_PROF_SCOPE(BURN_PROF_SH2);
+
+	sh2->sh2_icount = cycles;
+	sh2->sh2_cycles_to_run = cycles;
+
+	if (nSh2Core != SH2_CORE_C && nSh2BlockDepth == 0 && sh2_block_init()) {
+		sh2_run_blocks(cycles);
+	} else {
+		do
 		{
-			unsigned int cy = sh2_GetTotalCycles();
+			if ( pSh2Ext->suspend && cps3speedhack ) {
+				sh2->sh2_total_cycles += cycles;
+				sh2->sh2_icount = 0;
+				break;
+			}
 
+			sh2_execute_one();
 
-			if (sh2->dma_timer_active[0])
-				if ((cy - sh2->dma_timer_base[0]) >= sh2->dma_timer_cycles[0])
-					sh2_dmac_callback(0);
+		} while( sh2->sh2_icount > 0 );
+	}
 
-			if (sh2->dma_timer_active[1])
-				if ((cy - sh2->dma_timer_base[1]) >= sh2->dma_timer_cycles[1])
-					sh2_dmac_callback(1);
-	
-			if ( sh2->timer_active )
-				if ((cy - sh2->timer_base) >= sh2->timer_cycles)
-					sh2_timer_callback();
-		}
-		
-		
-	} while( sh2->sh2_icount > 0 );
-	
 	sh2->cycle_counts += cycles - (UINT32)sh2->sh2_icount;
 	
 	sh2->sh2_cycles_to_run = sh2->sh2_icount;
@@ -3392,6 +3964,7 @@ void Sh2StopRun()
 	sh2->sh2_total_cycles += sh2->sh2_icount;
 	sh2->sh2_icount = 0;
 	sh2->sh2_cycles_to_run = 0;
+	sh2_timer_deadline();
 }
 
 int Sh2TotalCycles()
@@ -3430,6 +4003,7 @@ void Sh2Idle(int cycles)
 
 	sh2->sh2_total_cycles += cycles;
 	sh2->cycle_counts += cycles;
+	sh2_timer_deadline();
 }
 
 void __fastcall Sh2WriteByte(unsigned int a, unsigned char d)
@@ -3493,3 +4067,18 @@ int Sh2Scan(int nAction)
 	
 	return 0;
 }
+
+// the interface state of a machine (burn_machine.h), the cpus run in it
+void Sh2MachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(has_sh2);
+	BURN_MACHINE_AREA(sh2);
+	BURN_MACHINE_AREA(pSh2Ext);
+	BURN_MACHINE_AREA(Sh2Ext);
+	BURN_MACHINE_AREA(nSh2Count);
+#if FAST_OP_FETCH
+	BURN_MACHINE_AREA(readop_pr);
+#endif
+	BURN_MACHINE_AREA(nSh2BlockCycles);
+	BURN_MACHINE_AREA(DebugCPU_SH2Initted);
+}
@@ -0,0 +1,1118 @@
+// SH-2 x86-64 block recompiler
+
+#include <deque>
+#include <vector>
+#include "burnint.h"
+#include "sh2_x64.h"
+#include "../../mips3/x64/xbyak/xbyak.h"
+
+#define X64_CACHE_SIZE		(8 * 1024 * 1024)
+#define X64_BLOCK_MAX		64					// instructions per block, as sh2.cpp
+
+#define X64_PAGE_SHIFT		16					// the sh2.cpp memory map
+#define X64_PAGE_MASK		0xffff
+#define X64_PAGE_COUNT		0x10000
+#define X64_MAXHANDLER		8
+
+#define X64_AM				0xc7ffffff
+#define X64_T				0x00000001
+
+#ifdef _WIN32
+#define X64_FRAME			40					// home space
+#else
+#define X64_FRAME			8
+#endif
+
+static Sh2X64Layout Layout;
+
+// ----------------------------------------------------------------------------
+// Decoding
+
+#define X64_OP_DELAYED		1					// a delayed branch
+#define X64_OP_ALWAYS		2					// it always branches
+#define X64_OP_COND			4					// bt, bf
+
+static INT32 Sh2X64OpType(UINT16 op)
+{
+	switch (op >> 12) {
+		case 0x0:
+			switch (op & 0x3f) {
+				case 0x03: case 0x23: case 0x0b: case 0x2b:		// bsrf, braf, rts, rte
+					return X64_OP_DELAYED | X64_OP_ALWAYS;
+			}
+			break;
+		case 0x4:
+			switch (op & 0x3f) {
+				case 0x0b: case 0x2b:							// jsr, jmp
+					return X64_OP_DELAYED | X64_OP_ALWAYS;
+			}
+			break;
+		case 0x8:
+			switch (op & 0x0f00) {
+				case 0x0900: case 0x0b00:						// bt, bf
+					return X64_OP_COND;
+				case 0x0d00: case 0x0f00:						// bt/s, bf/s
+					return X64_OP_DELAYED;
+			}
+			break;
+		case 0xa: case 0xb:										// bra, bsr
+			return X64_OP_DELAYED | X64_OP_ALWAYS;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Code generation
+
+#define X64_NO_PC			0xffffffff			// the pc is only known at run time
+
+class Sh2X64Compiler : public Xbyak::CodeGenerator
+{
+public:
+	Sh2X64Compiler() : CodeGenerator(X64_CACHE_SIZE) { }
+
+	INT32 (*pEntry)(void* pCpu, void* pBlocks);
+
+	void Prologue();
+	void* Compile(UINT32 nAddress, INT32 nCount, const UINT16* pOps, unsigned char* pPage, INT32 nCycles);
+
+private:
+	// what a call out checks when it returns
+	enum { POST_OP, POST_SLOT, POST_BRANCH };
+
+	// out of line code, emitted after the block
+	struct Stub {
+		INT32 nType;
+		INT32 nSize;
+		Xbyak::Label* pEntry;
+		Xbyak::Label* pBack;
+		INT32 nPost;
+		UINT32 nPc;								// exit: the pc to store, memory: the pc the instruction runs with
+		UINT32 nPpc;
+		bool bPc;
+		bool bPpc;
+	};
+	enum { STUB_EXIT, STUB_READ, STUB_WRITE };
+
+	// the taken path of a bt/s or bf/s, emitted after the block
+	struct Slot {
+		Xbyak::Label* pEntry;
+		INT32 nInsn;
+		UINT32 nTarget;
+	};
+
+	Xbyak::Label lDispatch;
+	Xbyak::Label lNone;
+	Xbyak::Label lOpDone;
+	Xbyak::Label lExit;
+
+	std::deque<Xbyak::Label> Labels;
+	std::vector<Stub> Stubs;
+	std::vector<Slot> Slots;
+
+	const UINT16* pOp;
+	INT32 nInsns;
+	UINT32 nStart;
+	INT32 nOpCycles;
+	Xbyak::Label* pInsnLabel[X64_BLOCK_MAX];
+	bool bInsnLabel[X64_BLOCK_MAX];				// the instruction can be jumped to
+
+	UINT32 nCurPc;								// the instruction being translated
+	UINT16 nCurOp;
+	bool bCurSlot;								// it is a delay slot, pc is the branch target
+	UINT32 nCurTarget;							// the target, or X64_NO_PC
+	bool bCurCall;								// it called out
+
+	Xbyak::Address Ctx(INT32 nOffset) { return dword[rbx + nOffset]; }
+	Xbyak::Address R(INT32 n) { return dword[rbx + Layout.nR + n * 4]; }
+
+	Xbyak::Label& NewLabel();
+	Xbyak::Label& Exit(bool bPc, UINT32 nPc, bool bPpc, UINT32 nPpc);
+	void EmitStubs();
+	void PostCall(INT32 nPost, UINT32 nPc);
+
+	INT32 Insn(INT32 i);
+	void Begin(INT32 i, bool bSlot, UINT32 nTarget);
+	void Call(INT32 nPost = POST_OP);
+	void End(INT32 nExtra, Xbyak::Label& lTimers);
+	void DelaySlot(INT32 i, UINT32 nTarget, bool bAfterCall);
+	void JumpTo(UINT32 nTarget);
+
+	void SetT(void (Xbyak::CodeGenerator::*pSet)(const Xbyak::Operand&));
+	void Read(INT32 nSize);
+	void Write(INT32 nSize);
+	bool Native(INT32& nExtra);
+	bool Branch(UINT32& nTarget, INT32& nExtra);
+};
+
+static Sh2X64Compiler* pCompiler = NULL;
+
+// once at the start of the code buffer
+void Sh2X64Compiler::Prologue()
+{
+	pEntry = (INT32 (*)(void*, void*))getCurr();
+
+	push(rbx);
+	push(rbp);
+	push(r12);
+	push(r13);
+	push(r14);
+	push(r15);
+	sub(rsp, X64_FRAME);
+#ifdef _WIN32
+	mov(rbx, rcx);
+	mov(r14, rdx);
+#else
+	mov(rbx, rdi);
+	mov(r14, rsi);
+#endif
+
+	// the block at pc, if there is code for it
+	L(lDispatch);
+	xor_(ebp, ebp);
+	cmp(Ctx(Layout.nDelay), 0);
+	jne(lNone);
+	mov(eax, Ctx(Layout.nPc));
+	test(eax, ~X64_AM | 1);
+	jnz(lNone);
+	mov(edx, eax);
+	shr(edx, X64_PAGE_SHIFT);
+	mov(rdx, ptr[r14 + rdx * 8]);
+	test(rdx, rdx);
+	jz(lNone);
+	and_(eax, X64_PAGE_MASK);
+	mov(rdx, ptr[rdx + rax * 4]);
+	test(rdx, rdx);
+	jz(lNone);
+	mov(rax, ptr[rdx + Layout.nBlockCode]);
+	test(rax, rax);
+	jz(lNone);
+	jmp(rax);
+
+	L(lNone);
+	mov(eax, SH2_X64_NONE);
+	jmp(lExit);
+
+	// a handler changed something (pc, irq, suspend), the C side finishes the instruction
+	L(lOpDone);
+	mov(eax, SH2_X64_OP_DONE);
+
+	L(lExit);
+	add(rsp, X64_FRAME);
+	pop(r15);
+	pop(r14);
+	pop(r13);
+	pop(r12);
+	pop(rbp);
+	pop(rbx);
+	ret();
+}
+
+void* Sh2X64Compiler::Compile(UINT32 nAddress, INT32 nCount, const UINT16* pOps, unsigned char* pPage, INT32 nCycles)
+{
+	void* pBlock = (void*)getCurr();
+
+	Labels.clear();
+	Stubs.clear();
+	Slots.clear();
+	pOp = pOps;
+	nInsns = nCount;
+	nStart = nAddress;
+	nOpCycles = nCycles;
+
+	// only the slot of a bra, jmp... (the last instruction) has no entry of its own
+	for (INT32 i = 0; i < nCount; i++) {
+		pInsnLabel[i] = &NewLabel();
+		bInsnLabel[i] = !(i > 0 && (Sh2X64OpType(pOps[i - 1]) & X64_OP_ALWAYS));
+	}
+
+	// still the same page and the same code
+	UINT32 nPage = nAddress >> X64_PAGE_SHIFT;
+	mov(rax, (size_t)pPage);
+	cmp(ptr[rbx + (INT32)(Layout.nMemMap + (X64_PAGE_COUNT * 2 + nPage) * sizeof(UINT8*))], rax);
+	jne(lNone, T_NEAR);
+
+	UINT32 nFirst = (nAddress & X64_PAGE_MASK) & ~3;
+	UINT32 nLast = ((nAddress & X64_PAGE_MASK) + nCount * 2 + 3) & ~3;
+	UINT8 nCode[X64_BLOCK_MAX * 2 + 8];
+	UINT8 nMask[X64_BLOCK_MAX * 2 + 8];
+	memset(nCode, 0, sizeof(nCode));
+	memset(nMask, 0, sizeof(nMask));
+	for (INT32 i = 0; i < nCount; i++) {
+		UINT32 nOffset = (((nAddress + i * 2) & X64_PAGE_MASK) ^ 2) - nFirst;
+		nCode[nOffset + 0] = pOps[i] & 0xff;
+		nCode[nOffset + 1] = pOps[i] >> 8;
+		nMask[nOffset + 0] = 0xff;
+		nMask[nOffset + 1] = 0xff;
+	}
+	mov(rcx, (size_t)(pPage + nFirst));
+	for (UINT32 i = 0; i < nLast - nFirst; ) {
+		INT32 nSize = (nLast - nFirst - i >= 8) ? 8 : 4;
+		UINT64 nValue = 0, nBits = 0;
+		memcpy(&nValue, nCode + i, nSize);
+		memcpy(&nBits, nMask + i, nSize);
+		if (nSize == 8) {
+			if (nBits == ~(UINT64)0) {
+				mov(rdx, nValue);
+				cmp(ptr[rcx + i], rdx);
+			} else {
+				mov(rax, ptr[rcx + i]);
+				mov(rdx, nBits);
+				and_(rax, rdx);
+				mov(rdx, nValue);
+				cmp(rax, rdx);
+			}
+		} else {
+			mov(eax, dword[rcx + i]);
+			if (nBits != 0xffffffff) {
+				and_(eax, (UINT32)nBits);
+			}
+			cmp(eax, (UINT32)nValue);
+		}
+		jne(lNone, T_NEAR);
+		i += nSize;
+	}
+
+	bool bOpen = true;
+	for (INT32 i = 0; i < nCount; ) {
+		INT32 nNext = Insn(i);
+		if (nNext < 0) {
+			bOpen = false;
+			break;
+		}
+		i = nNext;
+	}
+	if (bOpen) {
+		JumpTo(nAddress + nCount * 2);
+	}
+
+	for (UINT32 i = 0; i < Slots.size(); i++) {
+		Slot s = Slots[i];
+		L(*s.pEntry);
+		DelaySlot(s.nInsn, s.nTarget, false);
+	}
+
+	EmitStubs();
+
+	ready();
+
+	return pBlock;
+}
+
+Xbyak::Label& Sh2X64Compiler::NewLabel()
+{
+	// a deque doesn't move its elements, the jumps keep pointing at them
+	Labels.push_back(Xbyak::Label());
+
+	return Labels.back();
+}
+
+// leaves for the timer check, with pc / ppc stored if they aren't already
+Xbyak::Label& Sh2X64Compiler::Exit(bool bPc, UINT32 nPc, bool bPpc, UINT32 nPpc)
+{
+	Stub s = { STUB_EXIT, 0, &NewLabel(), NULL, POST_OP, nPc, nPpc, bPc, bPpc };
+	Stubs.push_back(s);
+
+	return *s.pEntry;
+}
+
+// sets ebp if the handler did something the block can't go on after:
+// raised an irq, suspended the cpu, or moved pc
+void Sh2X64Compiler::PostCall(INT32 nPost, UINT32 nPc)
+{
+	Xbyak::Label lSame;
+
+	mov(edx, Ctx(Layout.nSuspend));
+	if (nPost == POST_BRANCH) {
+		// the branch set delay and pc, the irq check waits for the slot
+		mov(ecx, Ctx(Layout.nDelay));
+		xor_(ecx, nCurPc + 2);
+		or_(edx, ecx);
+	} else {
+		or_(edx, Ctx(Layout.nTestIrq));
+		or_(edx, Ctx(Layout.nDelay));
+		mov(ecx, Ctx(Layout.nPc));
+		if (nPc != X64_NO_PC) {
+			xor_(ecx, nPc);
+		} else {
+			xor_(ecx, Ctx(Layout.nPpc));
+		}
+		or_(edx, ecx);
+	}
+	jz(lSame);
+	mov(ebp, 1);
+	L(lSame);
+}
+
+void Sh2X64Compiler::EmitStubs()
+{
+	for (UINT32 i = 0; i < Stubs.size(); i++) {
+		const Stub& s = Stubs[i];
+
+		L(*s.pEntry);
+
+		if (s.nType == STUB_EXIT) {
+			if (s.bPc) mov(Ctx(Layout.nPc), s.nPc);
+			if (s.bPpc) mov(Ctx(Layout.nPpc), s.nPpc);
+			mov(eax, SH2_X64_TIMERS);
+			jmp(lExit, T_NEAR);
+			continue;
+		}
+
+		// ecx = address, eax = data, rdx = handler
+		if (s.nPost == POST_OP) {
+			mov(Ctx(Layout.nPc), s.nPc);
+			mov(Ctx(Layout.nPpc), s.nPc);
+		}
+
+		if (s.nType == STUB_READ) {
+			INT32 nTable = (s.nSize == 1) ? Layout.nReadByte : (s.nSize == 2) ? Layout.nReadWord : Layout.nReadLong;
+#ifndef _WIN32
+			mov(edi, ecx);
+#endif
+			call(ptr[rbx + rdx * 8 + nTable]);
+			if (s.nSize == 1) movsx(eax, al);
+			if (s.nSize == 2) movsx(eax, ax);
+			mov(dword[rsp], eax);
+		} else {
+			INT32 nTable = (s.nSize == 1) ? Layout.nWriteByte : (s.nSize == 2) ? Layout.nWriteWord : Layout.nWriteLong;
+			mov(r10, ptr[rbx + rdx * 8 + nTable]);
+#ifdef _WIN32
+			if (s.nSize == 1) movzx(edx, al);
+			if (s.nSize == 2) movzx(edx, ax);
+			if (s.nSize == 4) mov(edx, eax);
+#else
+			mov(edi, ecx);
+			if (s.nSize == 1) movzx(esi, al);
+			if (s.nSize == 2) movzx(esi, ax);
+			if (s.nSize == 4) mov(esi, eax);
+#endif
+			call(r10);
+		}
+
+		PostCall(s.nPost, s.nPc);
+		if (s.nType == STUB_READ) {
+			mov(eax, dword[rsp]);
+		}
+		jmp(*s.pBack, T_NEAR);
+	}
+}
+
+// pc, ppc and delay for the instruction
+void Sh2X64Compiler::Begin(INT32 i, bool bSlot, UINT32 nTarget)
+{
+	nCurPc = nStart + i * 2;
+	nCurOp = pOp[i];
+	bCurSlot = bSlot;
+	nCurTarget = nTarget;
+	bCurCall = false;
+
+	if (bSlot) {
+		// the branch is taken now, the slot runs with pc at the target
+		if (nTarget != X64_NO_PC) {
+			mov(Ctx(Layout.nPc), nTarget);
+			mov(Ctx(Layout.nPpc), nTarget);
+		} else {
+			mov(eax, Ctx(Layout.nPc));
+			and_(eax, X64_AM);
+			mov(Ctx(Layout.nPc), eax);
+			mov(Ctx(Layout.nPpc), eax);
+		}
+		mov(Ctx(Layout.nDelay), 0);
+	}
+}
+
+// an instruction run by its opcode group handler
+void Sh2X64Compiler::Call(INT32 nPost)
+{
+	if (!bCurSlot) {
+		mov(Ctx(Layout.nPc), nCurPc + 2);
+		mov(Ctx(Layout.nPpc), nCurPc + 2);
+	}
+#ifdef _WIN32
+	mov(ecx, nCurOp);
+#else
+	mov(edi, nCurOp);
+#endif
+	mov(rax, (size_t)Layout.pOp[nCurOp >> 12]);
+	call(rax);
+
+	PostCall(nPost, bCurSlot ? nCurTarget : nCurPc + 2);
+	bCurCall = true;
+}
+
+// the end of an instruction as Sh2Run does it, lTimers once a timer may be due
+void Sh2X64Compiler::End(INT32 nExtra, Xbyak::Label& lTimers)
+{
+	if (bCurCall) {
+		// lOpDone only takes the cycles every instruction does
+		if (nExtra) {
+			sub(Ctx(Layout.nIcount), nExtra);
+			nExtra = 0;
+		}
+		test(ebp, ebp);
+		jnz(lOpDone, T_NEAR);
+	}
+	add(Ctx(Layout.nTotalCycles), 1);
+	mov(eax, Ctx(Layout.nIcount));
+	sub(eax, nOpCycles + nExtra);
+	mov(Ctx(Layout.nIcount), eax);
+	cmp(eax, Ctx(Layout.nTimerIcount));
+	jle(lTimers, T_NEAR);
+}
+
+// the slot of a taken branch, then on to the target
+void Sh2X64Compiler::DelaySlot(INT32 i, UINT32 nTarget, bool bAfterCall)
+{
+	INT32 nExtra;
+
+	Begin(i, true, nTarget);
+	if (!Native(nExtra)) {
+		Call(POST_SLOT);
+		nExtra = 0;
+	}
+	if (nExtra && (bCurCall || bAfterCall)) {
+		sub(Ctx(Layout.nIcount), nExtra);
+		nExtra = 0;
+	}
+	if (bCurCall) {
+		test(ebp, ebp);
+		jnz(lOpDone, T_NEAR);
+	}
+	if (bAfterCall) {
+		// rte, the irq check it asked for
+		cmp(Ctx(Layout.nTestIrq), 0);
+		jne(lOpDone, T_NEAR);
+	}
+	bCurCall = false;
+	End(nExtra, Exit(false, 0, false, 0));
+
+	if (nTarget != X64_NO_PC) {
+		JumpTo(nTarget);
+	} else {
+		jmp(lDispatch, T_NEAR);
+	}
+}
+
+// a jump inside the block doesn't go through the dispatcher
+void Sh2X64Compiler::JumpTo(UINT32 nTarget)
+{
+	for (INT32 i = 0; i < nInsns; i++) {
+		if (nStart + i * 2 == nTarget && bInsnLabel[i]) {
+			jmp(*pInsnLabel[i], T_NEAR);
+			return;
+		}
+	}
+
+	mov(Ctx(Layout.nPc), nTarget);
+	jmp(lDispatch, T_NEAR);
+}
+
+// T from the condition the last instruction left
+void Sh2X64Compiler::SetT(void (Xbyak::CodeGenerator::*pSet)(const Xbyak::Operand&))
+{
+	(this->*pSet)(al);
+	and_(byte[rbx + Layout.nSr], ~X64_T & 0xff);
+	or_(byte[rbx + Layout.nSr], al);
+}
+
+// eax = (ecx) as RB / RW / RL, sign extended
+void Sh2X64Compiler::Read(INT32 nSize)
+{
+	Stub s = { STUB_READ, nSize, &NewLabel(), &NewLabel(), bCurSlot ? POST_SLOT : POST_OP, bCurSlot ? nCurTarget : nCurPc + 2, 0, false, false };
+	Stubs.push_back(s);
+	bCurCall = true;
+
+	mov(edx, ecx);
+	shr(edx, X64_PAGE_SHIFT);
+	mov(rdx, ptr[rbx + rdx * 8 + Layout.nMemMap]);
+	cmp(rdx, X64_MAXHANDLER);
+	jb(*s.pEntry, T_NEAR);
+	mov(eax, ecx);
+	and_(eax, X64_PAGE_MASK);
+	switch (nSize) {
+		case 1: xor_(eax, 3); movsx(eax, byte[rdx + rax]); break;
+		case 2: xor_(eax, 2); movsx(eax, word[rdx + rax]); break;
+		case 4: mov(eax, dword[rdx + rax]); break;
+	}
+	L(*s.pBack);
+}
+
+// (ecx) = eax as WB / WW / WL
+void Sh2X64Compiler::Write(INT32 nSize)
+{
+	Stub s = { STUB_WRITE, nSize, &NewLabel(), &NewLabel(), bCurSlot ? POST_SLOT : POST_OP, bCurSlot ? nCurTarget : nCurPc + 2, 0, false, false };
+	Stubs.push_back(s);
+	bCurCall = true;
+
+	mov(edx, ecx);
+	shr(edx, X64_PAGE_SHIFT);
+	mov(rdx, ptr[rbx + rdx * 8 + (INT32)(Layout.nMemMap + X64_PAGE_COUNT * sizeof(UINT8*))]);
+	cmp(rdx, X64_MAXHANDLER);
+	jb(*s.pEntry, T_NEAR);
+	mov(r8d, ecx);
+	and_(r8d, X64_PAGE_MASK);
+	switch (nSize) {
+		case 1: xor_(r8d, 3); mov(byte[rdx + r8], al); break;
+		case 2: xor_(r8d, 2); mov(word[rdx + r8], ax); break;
+		case 4: mov(dword[rdx + r8], eax); break;
+	}
+	L(*s.pBack);
+}
+
+// the instructions done inline, false (and nothing emitted) for the others
+bool Sh2X64Compiler::Native(INT32& nExtra)
+{
+	UINT16 op = nCurOp;
+	INT32 n = (op >> 8) & 15;
+	INT32 m = (op >> 4) & 15;
+	INT32 nImm = op & 0xff;
+	INT32 nSimm = (INT8)(op & 0xff);
+	static const INT32 nSizes[3] = { 1, 2, 4 };
+
+	nExtra = 0;
+
+	switch (op >> 12) {
+		case 0x0:
+			switch (op & 0x3f) {
+				case 0x00: case 0x01: case 0x09: case 0x10: case 0x11: case 0x13:
+				case 0x20: case 0x21: case 0x30: case 0x31: case 0x32: case 0x33:
+				case 0x38: case 0x39: case 0x3a: case 0x3b:
+					return true;									// nop
+				case 0x02: mov(eax, Ctx(Layout.nSr)); mov(R(n), eax); return true;		// stc sr,rn
+				case 0x12: mov(eax, Ctx(Layout.nGbr)); mov(R(n), eax); return true;	// stc gbr,rn
+				case 0x0a: mov(eax, Ctx(Layout.nMach)); mov(R(n), eax); return true;	// sts mach,rn
+				case 0x1a: mov(eax, Ctx(Layout.nMacl)); mov(R(n), eax); return true;	// sts macl,rn
+				case 0x2a: mov(eax, Ctx(Layout.nPr)); mov(R(n), eax); return true;		// sts pr,rn
+				case 0x04: case 0x14: case 0x24: case 0x34:			// mov.b rm,@(r0,rn)
+				case 0x05: case 0x15: case 0x25: case 0x35:
+				case 0x06: case 0x16: case 0x26: case 0x36:
+					mov(ecx, R(n));
+					add(ecx, R(0));
+					mov(Ctx(Layout.nEa), ecx);
+					mov(eax, R(m));
+					Write(nSizes[(op & 0x0f) - 4]);
+					return true;
+				case 0x0c: case 0x1c: case 0x2c: case 0x3c:			// mov.b @(r0,rm),rn
+				case 0x0d: case 0x1d: case 0x2d: case 0x3d:
+				case 0x0e: case 0x1e: case 0x2e: case 0x3e:
+					mov(ecx, R(m));
+					add(ecx, R(0));
+					mov(Ctx(Layout.nEa), ecx);
+					Read(nSizes[(op & 0x0f) - 0x0c]);
+					mov(R(n), eax);
+					return true;
+				case 0x08: and_(byte[rbx + Layout.nSr], ~X64_T & 0xff); return true;	// clrt
+				case 0x18: or_(byte[rbx + Layout.nSr], X64_T); return true;			// sett
+				case 0x19: and_(Ctx(Layout.nSr), ~0x301); return true;				// div0u
+				case 0x28: mov(Ctx(Layout.nMach), 0); mov(Ctx(Layout.nMacl), 0); return true;	// clrmac
+				case 0x29: mov(eax, Ctx(Layout.nSr)); and_(eax, X64_T); mov(R(n), eax); return true;	// movt
+				case 0x07: case 0x17: case 0x27: case 0x37:			// mul.l
+					mov(eax, R(n));
+					imul(eax, R(m));
+					mov(Ctx(Layout.nMacl), eax);
+					nExtra = 1;
+					return true;
+			}
+			return false;
+
+		case 0x1:													// mov.l rm,@(disp,rn)
+			mov(ecx, R(n));
+			add(ecx, (op & 0x0f) * 4);
+			mov(Ctx(Layout.nEa), ecx);
+			mov(eax, R(m));
+			Write(4);
+			return true;
+
+		case 0x2:
+			switch (op & 0x0f) {
+				case 0x0: case 0x1: case 0x2:						// mov.b rm,@rn
+					mov(ecx, R(n));
+					mov(Ctx(Layout.nEa), ecx);
+					mov(eax, R(m));
+					Write(nSizes[op & 0x0f]);
+					return true;
+				case 0x3:
+					return true;
+				case 0x4: case 0x5: case 0x6: {						// mov.b rm,@-rn
+					INT32 nSize = nSizes[(op & 0x0f) - 4];
+					mov(eax, R(m));
+					mov(ecx, R(n));
+					sub(ecx, nSize);
+					mov(R(n), ecx);
+					Write(nSize);
+					return true;
+				}
+				case 0x8: mov(eax, R(n)); test(R(m), eax); SetT(&Xbyak::CodeGenerator::setz); return true;	// tst
+				case 0x9: mov(eax, R(m)); and_(R(n), eax); return true;	// and
+				case 0xa: mov(eax, R(m)); xor_(R(n), eax); return true;	// xor
+				case 0xb: mov(eax, R(m)); or_(R(n), eax); return true;	// or
+				case 0xd:											// xtrct
+					mov(eax, R(n));
+					shr(eax, 16);
+					mov(ecx, R(m));
+					shl(ecx, 16);
+					or_(eax, ecx);
+					mov(R(n), eax);
+					return true;
+				case 0xe:											// mulu.w
+					movzx(eax, word[rbx + Layout.nR + n * 4]);
+					movzx(ecx, word[rbx + Layout.nR + m * 4]);
+					imul(eax, ecx);
+					mov(Ctx(Layout.nMacl), eax);
+					return true;
+				case 0xf:											// muls.w
+					movsx(eax, word[rbx + Layout.nR + n * 4]);
+					movsx(ecx, word[rbx + Layout.nR + m * 4]);
+					imul(eax, ecx);
+					mov(Ctx(Layout.nMacl), eax);
+					return true;
+			}
+			return false;
+
+		case 0x3:
+			switch (op & 0x0f) {
+				case 0x0: mov(eax, R(n)); cmp(eax, R(m)); SetT(&Xbyak::CodeGenerator::sete); return true;	// cmp/eq
+				case 0x2: mov(eax, R(n)); cmp(eax, R(m)); SetT(&Xbyak::CodeGenerator::setae); return true;	// cmp/hs
+				case 0x3: mov(eax, R(n)); cmp(eax, R(m)); SetT(&Xbyak::CodeGenerator::setge); return true;	// cmp/ge
+				case 0x6: mov(eax, R(n)); cmp(eax, R(m)); SetT(&Xbyak::CodeGenerator::seta); return true;	// cmp/hi
+				case 0x7: mov(eax, R(n)); cmp(eax, R(m)); SetT(&Xbyak::CodeGenerator::setg); return true;	// cmp/gt
+				case 0x1: case 0x9:
+					return true;
+				case 0x5: case 0xd:									// dmulu.l, dmuls.l
+					mov(eax, R(n));
+					if (op & 0x8) {
+						imul(R(m));
+					} else {
+						mul(R(m));
+					}
+					mov(Ctx(Layout.nMach), edx);
+					mov(Ctx(Layout.nMacl), eax);
+					nExtra = 1;
+					return true;
+				case 0x8: mov(eax, R(m)); sub(R(n), eax); return true;	// sub
+				case 0xc: mov(eax, R(m)); add(R(n), eax); return true;	// add
+				case 0xa: case 0xe:									// subc, addc
+					mov(eax, R(n));
+					mov(ecx, R(m));
+					bt(Ctx(Layout.nSr), 0);
+					if (op & 0x4) {
+						adc(eax, ecx);
+					} else {
+						sbb(eax, ecx);
+					}
+					mov(R(n), eax);
+					SetT(&Xbyak::CodeGenerator::setc);
+					return true;
+			}
+			return false;
+
+		case 0x4:
+			switch (op & 0x3f) {
+				case 0x00: case 0x20: case 0x01: case 0x21:			// shll, shal, shlr, shar
+				case 0x04: case 0x05: case 0x24: case 0x25:			// rotl, rotr, rotcl, rotcr
+					mov(eax, R(n));
+					switch (op & 0x3f) {
+						case 0x00: case 0x20: shl(eax, 1); break;
+						case 0x01: shr(eax, 1); break;
+						case 0x21: sar(eax, 1); break;
+						case 0x04: rol(eax, 1); break;
+						case 0x05: ror(eax, 1); break;
+						case 0x24: bt(Ctx(Layout.nSr), 0); rcl(eax, 1); break;
+						case 0x25: bt(Ctx(Layout.nSr), 0); rcr(eax, 1); break;
+					}
+					mov(R(n), eax);
+					SetT(&Xbyak::CodeGenerator::setc);
+					return true;
+				case 0x08: shl(R(n), 2); return true;
+				case 0x09: shr(R(n), 2); return true;
+				case 0x18: shl(R(n), 8); return true;
+				case 0x19: shr(R(n), 8); return true;
+				case 0x28: shl(R(n), 16); return true;
+				case 0x29: shr(R(n), 16); return true;
+				case 0x0a: mov(eax, R(n)); mov(Ctx(Layout.nMach), eax); return true;	// lds rn,mach
+				case 0x1a: mov(eax, R(n)); mov(Ctx(Layout.nMacl), eax); return true;	// lds rn,macl
+				case 0x2a: mov(eax, R(n)); mov(Ctx(Layout.nPr), eax); return true;		// lds rn,pr
+				case 0x1e: mov(eax, R(n)); mov(Ctx(Layout.nGbr), eax); return true;	// ldc rn,gbr
+				case 0x11: cmp(R(n), 0); SetT(&Xbyak::CodeGenerator::setge); return true;	// cmp/pz
+				case 0x15: cmp(R(n), 0); SetT(&Xbyak::CodeGenerator::setg); return true;	// cmp/pl
+				case 0x0c: case 0x0d: case 0x14: case 0x1c: case 0x1d: case 0x2c: case 0x2d:
+				case 0x30: case 0x31: case 0x32: case 0x33: case 0x34: case 0x35: case 0x36: case 0x37:
+				case 0x38: case 0x39: case 0x3a: case 0x3b: case 0x3c: case 0x3d: case 0x3e:
+					return true;
+				case 0x02: case 0x12: case 0x22: case 0x13: {		// sts.l mach,@-rn .. stc.l gbr,@-rn
+					INT32 nReg = (op & 0x3f) == 0x02 ? Layout.nMach : (op & 0x3f) == 0x12 ? Layout.nMacl : (op & 0x3f) == 0x22 ? Layout.nPr : Layout.nGbr;
+					mov(ecx, R(n));
+					sub(ecx, 4);
+					mov(R(n), ecx);
+					mov(Ctx(Layout.nEa), ecx);
+					mov(eax, Ctx(nReg));
+					Write(4);
+					if ((op & 0x3f) == 0x13) nExtra = 1;
+					return true;
+				}
+				case 0x06: case 0x16: case 0x26: case 0x17: {		// lds.l @rn+,mach .. ldc.l @rn+,gbr
+					INT32 nReg = (op & 0x3f) == 0x06 ? Layout.nMach : (op & 0x3f) == 0x16 ? Layout.nMacl : (op & 0x3f) == 0x26 ? Layout.nPr : Layout.nGbr;
+					mov(ecx, R(n));
+					mov(Ctx(Layout.nEa), ecx);
+					Read(4);
+					mov(Ctx(nReg), eax);
+					add(R(n), 4);
+					if ((op & 0x3f) == 0x17) nExtra = 2;
+					return true;
+				}
+			}
+			return false;
+
+		case 0x5:													// mov.l @(disp,rm),rn
+			mov(ecx, R(m));
+			add(ecx, (op & 0x0f) * 4);
+			mov(Ctx(Layout.nEa), ecx);
+			Read(4);
+			mov(R(n), eax);
+			return true;
+
+		case 0x6:
+			switch (op & 0x0f) {
+				case 0x0: case 0x1: case 0x2:						// mov.b @rm,rn
+					mov(ecx, R(m));
+					mov(Ctx(Layout.nEa), ecx);
+					Read(nSizes[op & 0x0f]);
+					mov(R(n), eax);
+					return true;
+				case 0x3: mov(eax, R(m)); mov(R(n), eax); return true;	// mov
+				case 0x4: case 0x5: case 0x6:						// mov.b @rm+,rn
+					mov(ecx, R(m));
+					Read(nSizes[(op & 0x0f) - 4]);
+					mov(R(n), eax);
+					if (n != m) {
+						add(R(m), nSizes[(op & 0x0f) - 4]);
+					}
+					return true;
+				case 0x7: mov(eax, R(m)); not_(eax); mov(R(n), eax); return true;	// not
+				case 0x8: mov(eax, R(m)); rol(ax, 8); mov(R(n), eax); return true;	// swap.b
+				case 0x9: mov(eax, R(m)); rol(eax, 16); mov(R(n), eax); return true;	// swap.w
+				case 0xb: mov(eax, R(m)); neg(eax); mov(R(n), eax); return true;	// neg
+				case 0xc: movzx(eax, byte[rbx + Layout.nR + m * 4]); mov(R(n), eax); return true;	// extu.b
+				case 0xd: movzx(eax, word[rbx + Layout.nR + m * 4]); mov(R(n), eax); return true;	// extu.w
+				case 0xe: movsx(eax, byte[rbx + Layout.nR + m * 4]); mov(R(n), eax); return true;	// exts.b
+				case 0xf: movsx(eax, word[rbx + Layout.nR + m * 4]); mov(R(n), eax); return true;	// exts.w
+			}
+			return false;
+
+		case 0x7:													// add #imm,rn
+			add(R(n), nSimm);
+			return true;
+
+		case 0x8:
+			switch (op & 0x0f00) {
+				case 0x0000: case 0x0100: {							// mov.b r0,@(disp,rm)
+					INT32 nSize = (op & 0x0100) ? 2 : 1;
+					mov(ecx, R(m));
+					add(ecx, (op & 0x0f) * nSize);
+					mov(Ctx(Layout.nEa), ecx);
+					mov(eax, R(0));
+					Write(nSize);
+					return true;
+				}
+				case 0x0400: case 0x0500: {							// mov.b @(disp,rm),r0
+					INT32 nSize = (op & 0x0100) ? 2 : 1;
+					mov(ecx, R(m));
+					add(ecx, (op & 0x0f) * nSize);
+					mov(Ctx(Layout.nEa), ecx);
+					Read(nSize);
+					mov(R(0), eax);
+					return true;
+				}
+				case 0x0800:										// cmp/eq #imm,r0
+					cmp(R(0), nSimm);
+					SetT(&Xbyak::CodeGenerator::sete);
+					return true;
+				case 0x0200: case 0x0300: case 0x0600: case 0x0700:
+				case 0x0a00: case 0x0c00: case 0x0e00:
+					return true;
+			}
+			return false;
+
+		case 0x9: {													// mov.w @(disp,pc),rn
+			if (bCurSlot) return false;
+			UINT32 nEa = nCurPc + 4 + nImm * 2;
+			mov(Ctx(Layout.nEa), nEa);
+			mov(ecx, nEa);
+			Read(2);
+			mov(R(n), eax);
+			return true;
+		}
+
+		case 0xc:
+			switch (op & 0x0f00) {
+				case 0x0000: case 0x0100: case 0x0200: {			// mov.b r0,@(disp,gbr)
+					INT32 nSize = nSizes[(op >> 8) & 3];
+					mov(ecx, Ctx(Layout.nGbr));
+					add(ecx, nImm * nSize);
+					mov(Ctx(Layout.nEa), ecx);
+					mov(eax, R(0));
+					Write(nSize);
+					return true;
+				}
+				case 0x0400: case 0x0500: case 0x0600: {			// mov.b @(disp,gbr),r0
+					INT32 nSize = nSizes[(op >> 8) & 3];
+					mov(ecx, Ctx(Layout.nGbr));
+					add(ecx, nImm * nSize);
+					mov(Ctx(Layout.nEa), ecx);
+					Read(nSize);
+					mov(R(0), eax);
+					return true;
+				}
+				case 0x0700: {										// mova @(disp,pc),r0
+					if (bCurSlot) return false;
+					UINT32 nEa = ((nCurPc + 4) & ~3) + nImm * 4;
+					mov(Ctx(Layout.nEa), nEa);
+					mov(R(0), nEa);
+					return true;
+				}
+				case 0x0800: test(R(0), nImm); SetT(&Xbyak::CodeGenerator::setz); return true;	// tst #imm,r0
+				case 0x0900: and_(R(0), nImm); return true;			// and #imm,r0
+				case 0x0a00: xor_(R(0), nImm); return true;			// xor #imm,r0
+				case 0x0b00: or_(R(0), nImm); return true;			// or #imm,r0
+			}
+			return false;
+
+		case 0xd: {													// mov.l @(disp,pc),rn
+			if (bCurSlot) return false;
+			UINT32 nEa = ((nCurPc + 4) & ~3) + nImm * 4;
+			mov(Ctx(Layout.nEa), nEa);
+			mov(ecx, nEa);
+			Read(4);
+			mov(R(n), eax);
+			return true;
+		}
+
+		case 0xe:													// mov #imm,rn
+			mov(R(n), nSimm);
+			return true;
+
+		case 0xf:
+			return true;
+	}
+
+	return false;
+}
+
+// a delayed branch, nTarget is set if it is known now. false if the handler has to do it
+bool Sh2X64Compiler::Branch(UINT32& nTarget, INT32& nExtra)
+{
+	UINT16 op = nCurOp;
+	INT32 n = (op >> 8) & 15;
+
+	nTarget = X64_NO_PC;
+	nExtra = 1;
+
+	switch (op >> 12) {
+		case 0xa: case 0xb: {										// bra, bsr
+			INT32 nDisp = ((INT32)(op & 0xfff) << 20) >> 20;
+			if (nDisp == -2) {
+				return false;										// the busy loop check
+			}
+			nTarget = nCurPc + 4 + nDisp * 2;
+			if (op & 0x1000) {
+				mov(Ctx(Layout.nPr), nCurPc + 4);
+			}
+			mov(Ctx(Layout.nPc), nTarget);
+			mov(Ctx(Layout.nEa), nTarget);
+			break;
+		}
+
+		case 0x0:
+			switch (op & 0x3f) {
+				case 0x03: case 0x23:								// bsrf, braf
+					if ((op & 0x3f) == 0x03) {
+						mov(Ctx(Layout.nPr), nCurPc + 4);
+					}
+					mov(eax, R(n));
+					add(eax, nCurPc + 4);
+					mov(Ctx(Layout.nPc), eax);
+					break;
+				case 0x0b:											// rts
+					mov(eax, Ctx(Layout.nPr));
+					mov(Ctx(Layout.nPc), eax);
+					mov(Ctx(Layout.nEa), eax);
+					break;
+				default:
+					return false;									// rte
+			}
+			break;
+
+		case 0x4:													// jsr, jmp
+			mov(eax, R(n));
+			if ((op & 0x3f) == 0x0b) {
+				mov(Ctx(Layout.nPr), nCurPc + 4);
+			} else {
+				nExtra = 0;
+			}
+			mov(Ctx(Layout.nPc), eax);
+			mov(Ctx(Layout.nEa), eax);
+			break;
+
+		default:
+			return false;
+	}
+
+	mov(Ctx(Layout.nDelay), nCurPc + 2);
+
+	return true;
+}
+
+// instruction i, returns the next one, or -1 if the block doesn't go on after it
+INT32 Sh2X64Compiler::Insn(INT32 i)
+{
+	L(*pInsnLabel[i]);
+	Begin(i, false, X64_NO_PC);
+
+	UINT16 op = nCurOp;
+	INT32 nType = Sh2X64OpType(op);
+	UINT32 nNext = nCurPc + 2;
+	INT32 nExtra = 0;
+
+	if (nType & X64_OP_COND) {
+		// bt, bf
+		Xbyak::Label& lNot = NewLabel();
+		UINT32 nTarget = nCurPc + 4 + (INT8)(op & 0xff) * 2;
+		test(byte[rbx + Layout.nSr], X64_T);
+		if ((op & 0x0f00) == 0x0900) {
+			jz(lNot, T_NEAR);
+		} else {
+			jnz(lNot, T_NEAR);
+		}
+		mov(Ctx(Layout.nEa), nTarget);
+		End(2, Exit(true, nTarget & X64_AM, true, nNext));
+		JumpTo(nTarget & X64_AM);
+		L(lNot);
+		End(0, Exit(true, nNext, true, nNext));
+		return i + 1;
+	}
+
+	if ((nType & X64_OP_DELAYED) && !(nType & X64_OP_ALWAYS)) {
+		// bt/s, bf/s: the taken path runs the slot out of line, the other one goes on with it
+		Xbyak::Label& lNot = NewLabel();
+		UINT32 nTarget = nCurPc + 4 + (INT8)(op & 0xff) * 2;
+		test(byte[rbx + Layout.nSr], X64_T);
+		if ((op & 0x0f00) == 0x0d00) {
+			jz(lNot, T_NEAR);
+		} else {
+			jnz(lNot, T_NEAR);
+		}
+		mov(Ctx(Layout.nDelay), nNext);
+		mov(Ctx(Layout.nPc), nTarget);
+		mov(Ctx(Layout.nEa), nTarget);
+		End(1, Exit(false, 0, true, nNext));
+		Slot s = { &NewLabel(), i + 1, nTarget & X64_AM };
+		Slots.push_back(s);
+		jmp(*s.pEntry, T_NEAR);
+		L(lNot);
+		End(0, Exit(true, nNext, true, nNext));
+		return i + 1;
+	}
+
+	if (nType & X64_OP_DELAYED) {
+		UINT32 nTarget;
+		bool bCall = false;
+		if (!Branch(nTarget, nExtra)) {
+			Call(POST_BRANCH);
+			nExtra = 0;
+			bCall = true;
+		}
+		End(nExtra, Exit(false, 0, true, nNext));
+		DelaySlot(i + 1, nTarget != X64_NO_PC ? nTarget & X64_AM : X64_NO_PC, bCall);
+		return -1;
+	}
+
+	if (op >> 12 == 0x4 && (op & 0x3f) == 0x10 && !bCurSlot) {
+		// dt, the interpreter burns the cycles of a "dt rn; bf $-2" loop at once.
+		// it looks at the next word through the read map, so it is done at run time
+		Xbyak::Label& lCall = NewLabel();
+		Xbyak::Label& lDone = NewLabel();
+		UINT32 nNextAm = nNext & X64_AM;
+		mov(rdx, ptr[rbx + (INT32)(Layout.nMemMap + (nNextAm >> X64_PAGE_SHIFT) * sizeof(UINT8*))]);
+		cmp(rdx, X64_MAXHANDLER);
+		jb(lCall, T_NEAR);
+		cmp(word[rdx + ((nNextAm & X64_PAGE_MASK) ^ 2)], (INT16)0x8bfd);
+		je(lCall, T_NEAR);
+		sub(R((op >> 8) & 15), 1);
+		SetT(&Xbyak::CodeGenerator::setz);
+		jmp(lDone, T_NEAR);
+		L(lCall);
+		Call();
+		L(lDone);
+	} else if (!Native(nExtra)) {
+		Call();
+	}
+
+	End(nExtra, Exit(true, nNext, true, nNext));
+
+	return i + 1;
+}
+
+// ----------------------------------------------------------------------------
+// Interface
+
+INT32 Sh2X64Init(const Sh2X64Layout* pLayout)
+{
+	Layout = *pLayout;
+
+	if (pCompiler == NULL) {
+		try {
+			pCompiler = new Sh2X64Compiler();
+			pCompiler->Prologue();
+		} catch (...) {
+			delete pCompiler;
+			pCompiler = NULL;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void Sh2X64Exit()
+{
+	delete pCompiler;
+	pCompiler = NULL;
+}
+
+void Sh2X64Flush()
+{
+	if (pCompiler == NULL) {
+		return;
+	}
+
+	// a new buffer, reset() doesn't forget the labels
+	delete pCompiler;
+	pCompiler = NULL;
+	try {
+		pCompiler = new Sh2X64Compiler();
+		pCompiler->Prologue();
+	} catch (...) {
+		delete pCompiler;
+		pCompiler = NULL;
+	}
+}
+
+void* Sh2X64Compile(UINT32 nAddress, INT32 nCount, const UINT16* pOps, unsigned char* pPage, INT32 nCycles)
+{
+	if (pCompiler == NULL) {
+		return NULL;
+	}
+
+	try {
+		return pCompiler->Compile(nAddress, nCount, pOps, pPage, nCycles);
+	} catch (Xbyak::Error&) {
+		return NULL;
+	}
+}
+
+INT32 Sh2X64Run(void* pCpu, void* pBlocks)
+{
+	return pCompiler->pEntry(pCpu, pBlocks);
+}
@@ -0,0 +1,40 @@
+// SH-2 x86-64 block recompiler - header file
+
+#ifndef SH2_X64_H
+#define SH2_X64_H
+
+// The blocks sh2.cpp decodes are compiled to x86-64. Register moves, the ALU
+// ops, compares, shifts, the loads and stores and the branches are emitted
+// natively against the cpu context in memory, with an inline path for memory
+// mapped pages and a call to the map handlers for the rest. The other
+// instructions call the interpreter's opcode group handlers. Blocks chain
+// through a dispatcher, and check they are still the code they were compiled
+// from (same fetch page, same opcodes) every time they are entered.
+
+// where the code finds things, offsets from the cpu context (SH2EXT)
+struct Sh2X64Layout {
+	INT32 nR, nPc, nPpc, nPr, nSr, nGbr, nMach, nMacl, nEa, nDelay, nTestIrq;
+	INT32 nIcount, nTotalCycles, nTimerIcount, nSuspend;
+	INT32 nMemMap, nReadByte, nReadWord, nReadLong, nWriteByte, nWriteWord, nWriteLong;
+	INT32 nBlockCode;							// the code pointer in a block
+	void (*pOp[16])(UINT16 opcode);				// the opcode group handlers
+};
+
+// what Sh2X64Run() leaves to its caller
+#define SH2_X64_NONE		0					// nothing, there is no code for pc
+#define SH2_X64_OP_DONE		1					// the end of the last instruction (irq check, cycles, timers)
+#define SH2_X64_TIMERS		2					// the timer check
+
+INT32 Sh2X64Init(const Sh2X64Layout* pLayout);
+void Sh2X64Exit();
+
+// forget all the code
+void Sh2X64Flush();
+
+// code for a block, NULL if the code buffer is full
+void* Sh2X64Compile(UINT32 nAddress, INT32 nCount, const UINT16* pOps, unsigned char* pPage, INT32 nCycles);
+
+// runs the cpu from the block at pc, until it is out of cycles or off the compiled code
+INT32 Sh2X64Run(void* pCpu, void* pBlocks);
+
+#endif // SH2_X64_H
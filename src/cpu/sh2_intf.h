@@ -11,7 +11,7 @@ typedef void (__fastcall *pSh2WriteWordHandler)(unsigned int a, unsigned short d
 typedef unsigned int (__fastcall *pSh2ReadLongHandler)(unsigned int a);
 typedef void (__fastcall *pSh2WriteLongHandler)(unsigned int a, unsigned int d);
 
-extern int has_sh2;
+extern BURN_THREAD int has_sh2;
 extern INT32 cps3speedhack;
 extern INT32 sh2_suprnova_speedhack;
 extern INT32 sh2_busyloop_speedhack_mode2;
@@ -55,3 +55,9 @@ void Sh2Idle(int cycles);
 
 int Sh2Scan(int);
 
+// the core Sh2Run() uses, the interpreter by default: the block cores are opt-in
+#define SH2_CORE_C			0		// interpreter
+#define SH2_CORE_BLOCK		1		// pre-decoded blocks, any host
+#define SH2_CORE_DRC		2		// x86-64 recompiler (SH2_X64_DRC builds), else SH2_CORE_BLOCK
+void Sh2SetCore(int nCore);
+
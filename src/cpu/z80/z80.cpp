@@ -102,14 +102,14 @@
 #define Z80_INLINE		static
 #define change_pc(newpc)	Z80.pc.w.l = (newpc)
 
-static Z80ReadIoHandler Z80IORead;
-static Z80WriteIoHandler Z80IOWrite;
-static Z80ReadProgHandler Z80ProgramRead;
-static Z80WriteProgHandler Z80ProgramWrite;
-static Z80ReadOpHandler Z80CPUReadOp;
-static Z80ReadOpArgHandler Z80CPUReadOpArg;
+static BURN_THREAD Z80ReadIoHandler Z80IORead;
+static BURN_THREAD Z80WriteIoHandler Z80IOWrite;
+static BURN_THREAD Z80ReadProgHandler Z80ProgramRead;
+static BURN_THREAD Z80WriteProgHandler Z80ProgramWrite;
+static BURN_THREAD Z80ReadOpHandler Z80CPUReadOp;
+static BURN_THREAD Z80ReadOpArgHandler Z80CPUReadOpArg;
 
-unsigned char Z80Vector = 0xff;
+BURN_THREAD unsigned char Z80Vector = 0xff;
 
 #define VERBOSE 0
 
@@ -190,22 +190,23 @@ unsigned char Z80Vector = 0xff;
 #define IFF2 Z80.iff2
 #define HALT Z80.halt
 
-int z80_ICount;
-static INT32 end_run;
-static Z80_Regs Z80;
-UINT32 EA;
+BURN_THREAD int z80_ICount;
+static BURN_THREAD INT32 end_run;
+static BURN_THREAD Z80_Regs *Z80Context;	/* the registers the core runs on, Z80SetContextPtr() */
+#define Z80 (*Z80Context)
+BURN_THREAD UINT32 EA;
 
-void (*z80edfe_callback)(Z80_Regs *Regs) = NULL;
+BURN_THREAD void (*z80edfe_callback)(Z80_Regs *Regs) = NULL;
 
-static UINT8 SZ[256];		/* zero and sign flags */
-static UINT8 SZ_BIT[256];	/* zero, sign and parity/overflow (=zero) flags for BIT opcode */
-static UINT8 SZP[256];		/* zero, sign and parity flags */
-static UINT8 SZHV_inc[256]; /* zero, sign, half carry and overflow flags INC r8 */
-static UINT8 SZHV_dec[256]; /* zero, sign, half carry and overflow flags DEC r8 */
+static BURN_THREAD UINT8 SZ[256];		/* zero and sign flags */
+static BURN_THREAD UINT8 SZ_BIT[256];	/* zero, sign and parity/overflow (=zero) flags for BIT opcode */
+static BURN_THREAD UINT8 SZP[256];		/* zero, sign and parity flags */
+static BURN_THREAD UINT8 SZHV_inc[256]; /* zero, sign, half carry and overflow flags INC r8 */
+static BURN_THREAD UINT8 SZHV_dec[256]; /* zero, sign, half carry and overflow flags DEC r8 */
 
 #if BIG_FLAGS_ARRAY
-static UINT8 *SZHVC_add = 0;
-static UINT8 *SZHVC_sub = 0;
+static BURN_THREAD UINT8 *SZHVC_add = 0;
+static BURN_THREAD UINT8 *SZHVC_sub = 0;
 #endif
 
 static const UINT8 cc_op[0x100] = {
@@ -317,7 +318,7 @@ static const UINT8 cc_ex[0x100] = {
  6, 0, 0, 0, 7, 0, 0, 2, 6, 0, 0, 0, 7, 0, 0, 2,
  6, 0, 0, 0, 7, 0, 0, 2, 6, 0, 0, 0, 7, 0, 0, 2};
 
-static const UINT8 *cc[6];
+static BURN_THREAD const UINT8 *cc[6];
 #define Z80_TABLE_dd	Z80_TABLE_xy
 #define Z80_TABLE_fd	Z80_TABLE_xy
 
@@ -3493,7 +3494,12 @@ void Z80Init()
 		if( (i & 0x0f) == 0x0f ) SZHV_dec[i] |= HF;
 	}
 
-	/* Reset registers to their initial values */
+	Z80InitContext();
+}
+
+/* Reset registers to their initial values */
+void Z80InitContext()
+{
 	memset(&Z80, 0, sizeof(Z80));
 	Z80.hold_irq = 0;
 //	Z80.daisy = config;
@@ -3539,6 +3545,28 @@ void Z80Exit()
 	z80edfe_callback = NULL;
 }
 
+// what Z80Init() sets up, the registers are the open cpu's (burn_machine.h)
+void Z80MachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(Z80IORead);
+	BURN_MACHINE_AREA(Z80IOWrite);
+	BURN_MACHINE_AREA(Z80ProgramRead);
+	BURN_MACHINE_AREA(Z80ProgramWrite);
+	BURN_MACHINE_AREA(Z80CPUReadOp);
+	BURN_MACHINE_AREA(Z80CPUReadOpArg);
+	BURN_MACHINE_AREA(z80edfe_callback);
+	BURN_MACHINE_AREA(SZ);
+	BURN_MACHINE_AREA(SZ_BIT);
+	BURN_MACHINE_AREA(SZP);
+	BURN_MACHINE_AREA(SZHV_inc);
+	BURN_MACHINE_AREA(SZHV_dec);
+#if BIG_FLAGS_ARRAY
+	BURN_MACHINE_AREA(SZHVC_add);
+	BURN_MACHINE_AREA(SZHVC_sub);
+#endif
+	BURN_MACHINE_AREA(cc);
+}
+
 int Z80Execute(int cycles)
 {
 	z80_ICount = cycles;
@@ -3634,6 +3662,11 @@ void Z80SetContext (void *src)
 	change_pc(PCD);
 }
 
+void Z80SetContextPtr (Z80_Regs *context)
+{
+	Z80Context = context;
+}
+
 int Z80Scan(int nAction)
 {
 	if ((nAction & ACB_DRIVER_DATA) == 0) {
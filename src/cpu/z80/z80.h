@@ -58,6 +58,7 @@ enum
 };
 
 void Z80Init();
+void Z80InitContext();
 void Z80Reset();
 void Z80Exit();
 int  Z80Execute(int cycles);
@@ -65,14 +66,17 @@ void Z80Burn(int cycles);
 void Z80SetIrqLine(int irqline, int state);
 void Z80GetContext (void *dst);
 void Z80SetContext (void *src);
+void Z80SetContextPtr (Z80_Regs *context);	/* run on these registers in place, nothing is copied */
 int Z80Scan(int nAction);
 INT32 z80TotalCycles();
 void Z80StopExecute();
 
-extern unsigned char Z80Vector;
-extern void (*z80edfe_callback)(Z80_Regs *Regs);
-extern int z80_ICount;
-extern UINT32 EA;
+extern BURN_THREAD unsigned char Z80Vector;
+extern BURN_THREAD void (*z80edfe_callback)(Z80_Regs *Regs);
+extern BURN_THREAD int z80_ICount;
+extern BURN_THREAD UINT32 EA;
+
+void Z80MachineAreas(BurnMachineAreaCallback pArea);
 
 typedef unsigned char (__fastcall *Z80ReadIoHandler)(unsigned int a);
 typedef void (__fastcall *Z80WriteIoHandler)(unsigned int a, unsigned char v);
@@ -1,9 +1,11 @@
 // Z80 (Zed Eight-Ty) Interface
 #include "burnint.h"
 #include "z80_intf.h"
+#include "burn_prof.h"
+#include "burn_idle.h"
 
 #define MAX_Z80		8
-static struct ZetExt * ZetCPUContext[MAX_Z80] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+static BURN_THREAD struct ZetExt * ZetCPUContext[MAX_Z80] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
  
 typedef UINT8 (__fastcall *pZetInHandler)(UINT16 a);
 typedef void (__fastcall *pZetOutHandler)(UINT16 a, UINT8 d);
@@ -23,14 +25,14 @@ struct ZetExt {
 	UINT8 BusReq;
 };
  
-static INT32 nZetCyclesDone[MAX_Z80];
-static INT32 nZetCyclesTotal;
-static INT32 nZ80ICount[MAX_Z80];
-static UINT32 Z80EA[MAX_Z80];
+static BURN_THREAD INT32 nZetCyclesDone[MAX_Z80];
+static BURN_THREAD INT32 nZetCyclesTotal;
+static BURN_THREAD INT32 nZ80ICount[MAX_Z80];
+static BURN_THREAD UINT32 Z80EA[MAX_Z80];
 
-static INT32 nOpenedCPU = -1;
-static INT32 nCPUCount = 0;
-INT32 nHasZet = -1;
+static BURN_THREAD INT32 nOpenedCPU = -1;
+static BURN_THREAD INT32 nCPUCount = 0;
+BURN_THREAD INT32 nHasZet = -1;
 
 UINT8 __fastcall ZetDummyReadHandler(UINT16) { return 0; }
 void __fastcall ZetDummyWriteHandler(UINT16, UINT8) { }
@@ -179,6 +181,49 @@ static UINT8 ZetCheatRead(UINT32 a)
 	return ZetReadByte(a);
 }
 
+static UINT8 *ZetCheatPage(UINT32 a)
+{
+	if (nOpenedCPU < 0) return NULL;
+
+	return ZetCPUContext[nOpenedCPU]->pZetMemMap[0x000 | ((a & 0xffff) >> 8)];
+}
+
+static UINT8 *ZetIdleFetch(UINT32 a)
+{
+	UINT8 **pMemMap = ZetCPUContext[nOpenedCPU]->pZetMemMap;
+
+	// opcodes and arguments from the same memory (not decrypted opcodes)
+	if (pMemMap[0x200 | ((a & 0xffff) >> 8)] != pMemMap[0x300 | ((a & 0xffff) >> 8)]) return NULL;
+
+	return pMemMap[0x200 | ((a & 0xffff) >> 8)];
+}
+
+static UINT32 ZetIdleReg(INT32 n)
+{
+	switch (n) {
+		case 0: return ZetBc(-1);
+		case 1: return ZetDe(-1);
+	}
+	return ZetHL(-1);
+}
+
+static UINT32 ZetIdlePC()
+{
+	return ZetGetPC(-1);
+}
+
+static BurnIdleCpu ZetIdleCpu =
+{
+	BURN_IDLE_Z80,
+	ZetIdleFetch,
+	ZetCheatPage,
+	0x100,
+	0,
+	ZetIdleReg,
+	ZetIdlePC,
+	ZetIdle
+};
+
 static cpu_core_config ZetCheatCpuConfig =
 {
 	ZetOpen,
@@ -192,6 +237,9 @@ static cpu_core_config ZetCheatCpuConfig =
 	ZetRunEnd,
 	ZetReset,
 	(1<<16),	// 0x10000
+	0,
+	ZetCheatPage,
+	0x100,
 	0
 };
 
@@ -204,8 +252,13 @@ INT32 ZetInit(INT32 nCPU)
 	ZetCPUContext[nCPU] = (struct ZetExt*)BurnMalloc(sizeof(ZetExt));
 	memset (ZetCPUContext[nCPU], 0, sizeof(ZetExt));
 
+	// the core runs on the registers in place, ZetOpen() only points it there
+	Z80SetContextPtr(&ZetCPUContext[nCPU]->reg);
+
 	if (nCPU == 0) { // not safe!
 		Z80Init();
+	} else {
+		Z80InitContext();
 	}
 
 	{
@@ -214,8 +267,6 @@ INT32 ZetInit(INT32 nCPU)
 		ZetCPUContext[nCPU]->ZetRead = ZetDummyReadHandler;
 		ZetCPUContext[nCPU]->ZetWrite = ZetDummyWriteHandler;
 		ZetCPUContext[nCPU]->BusReq = 0;
-		// TODO: Z80Init() will set IX IY F regs with default value, so get them ...
-		Z80GetContext(&ZetCPUContext[nCPU]->reg);
 		
 		nZetCyclesDone[nCPU] = 0;
 		nZ80ICount[nCPU] = 0;
@@ -334,7 +385,7 @@ void ZetClose()
 	if (nOpenedCPU == -1) bprintf(PRINT_ERROR, _T("ZetClose called when no CPU open\n"));
 #endif
 
-	Z80GetContext(&ZetCPUContext[nOpenedCPU]->reg);
+	// the registers were run on in place, only the counters are copied
 	nZetCyclesDone[nOpenedCPU] = nZetCyclesTotal;
 	nZ80ICount[nOpenedCPU] = z80_ICount;
 	Z80EA[nOpenedCPU] = EA;
@@ -351,7 +402,7 @@ void ZetOpen(INT32 nCPU)
 	if (ZetCPUContext[nCPU] == NULL) bprintf (PRINT_ERROR, _T("ZetOpen called for uninitialized cpu %x\n"), nCPU);
 #endif
 
-	Z80SetContext(&ZetCPUContext[nCPU]->reg);
+	Z80SetContextPtr(&ZetCPUContext[nCPU]->reg);
 	nZetCyclesTotal = nZetCyclesDone[nCPU];
 	z80_ICount = nZ80ICount[nCPU];
 	EA = Z80EA[nCPU];
@@ -369,6 +420,15 @@ INT32 ZetGetActive()
 	return nOpenedCPU;
 }
 
+static INT32 ZetRunSlice(INT32 nCycles)
+{
+	nCycles = Z80Execute(nCycles);
+
+	nZetCyclesTotal += nCycles;
+
+	return nCycles;
+}
+
 INT32 ZetRun(INT32 nCycles)
 {
 #if defined FBA_DEBUG
@@ -376,6 +436,8 @@ INT32 ZetRun(INT32 nCycles)
 	if (nOpenedCPU == -1) bprintf(PRINT_ERROR, _T("ZetRun called when no CPU open\n"));
 #endif
 
+	BURN_PROF_SCOPE(BURN_PROF_Z80);
+
 	if (nCycles <= 0) return 0;
 	
 	if (ZetCPUContext[nOpenedCPU]->BusReq) {
@@ -383,11 +445,7 @@ INT32 ZetRun(INT32 nCycles)
 		return nCycles;
 	}
 	
-	nCycles = Z80Execute(nCycles);
-	
-	nZetCyclesTotal += nCycles;
-	
-	return nCycles;
+	return BurnIdleRun(&ZetIdleCpu, ZetRunSlice, nCycles);
 }
 
 void ZetRunAdjust(INT32 /*nCycles*/)
@@ -454,12 +512,30 @@ void ZetExit()
 		}
 	}
 
+	Z80SetContextPtr(NULL);
+
 	nCPUCount = 0;
 	nHasZet = -1;
 	
 	DebugCPU_ZetInitted = 0;
 }
 
+// the interface state of a machine (burn_machine.h)
+void ZetMachineAreas(BurnMachineAreaCallback pArea)
+{
+	BURN_MACHINE_AREA(ZetCPUContext);
+	BURN_MACHINE_AREA(nZetCyclesDone);
+	BURN_MACHINE_AREA(nZetCyclesTotal);
+	BURN_MACHINE_AREA(nZ80ICount);
+	BURN_MACHINE_AREA(Z80EA);
+	BURN_MACHINE_AREA(nOpenedCPU);
+	BURN_MACHINE_AREA(nCPUCount);
+	BURN_MACHINE_AREA(nHasZet);
+	BURN_MACHINE_AREA(DebugCPU_ZetInitted);
+
+	Z80MachineAreas(pArea);
+}
+
 
 // This function will make an area callback ZetRead/ZetWrite
 INT32 ZetUnmapMemory(INT32 nStart, INT32 nEnd, INT32 nFlags)
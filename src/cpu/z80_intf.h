@@ -7,7 +7,7 @@
 
 #include "z80/z80.h"
 
-extern INT32 nHasZet;
+extern BURN_THREAD INT32 nHasZet;
 void ZetWriteByte(UINT16 address, UINT8 data);
 UINT8 ZetReadByte(UINT16 address);
 void ZetWriteRom(UINT16 address, UINT8 data);
@@ -79,19 +79,7 @@ extern UINT32 nCDEmuSelect;
 
 extern CDEmuStatusValue CDEmuStatus;
 
-// Profiling plugin
-struct ProfileDo {
-	INT32    (*ProfileExit)();
-	INT32    (*ProfileInit)();
-	INT32    (*ProfileStart)(INT32 nSubSystem);
-	INT32    (*ProfileEnd)(INT32 nSubSystem);
-	double (*ProfileReadLast)(INT32 nSubSystem);
-	double (*ProfileReadAverage)(INT32 nSubSystem);
-	// Get plugin info
-	INT32    (*GetPluginSettings)(InterfaceInfo* pInfo);
-	const  TCHAR* szModuleName;
-};
-
+// Profiling (subsystems 0 to 3, see burn_prof.h)
 extern bool bProfileOkay;
 extern UINT32 nProfileSelect;
 
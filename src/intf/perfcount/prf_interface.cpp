@@ -1,93 +1,134 @@
-// Profiling support
+// Profiling support, on top of the core profiler (burn_prof)
 #include "burner.h"
+#include "burn_prof.h"
+
+#if !defined (BUILD_WIN32)
+#include <chrono>
+#endif
+
+#define PRF_SUBSYSTEMS	(BURN_PROF_USER3 - BURN_PROF_USER0 + 1)
+#define PRF_SAMPLES		32
 
 bool bProfileOkay = false;
 UINT32 nProfileSelect = 0;
 
 static InterfaceInfo ProfileInfo = { NULL, NULL, NULL };
 
+static bool bProfileOwnClock = false;					// we started the core profiler, we stop it
+
+static struct { INT64 nStart; INT64 nSample[PRF_SAMPLES]; INT64 nTally; INT32 nIndex; } PrfSubsys[PRF_SUBSYSTEMS];
+
 #if defined (BUILD_WIN32)
-	extern struct ProfileDo cntDoPerfCount;
-#elif defined (BUILD_SDL)
-	extern struct ProfileDo cntDoPerfCount;
-#elif defined (_XBOX)
-	extern struct ProfileDo cntDoPerfCount;
-#endif
+static INT64 PrfClock()
+{
+	LARGE_INTEGER c;
+	QueryPerformanceCounter(&c);
 
-static struct ProfileDo* pProfileDo[] =
+	return c.QuadPart;
+}
+
+static INT64 PrfClockRate()
 {
-#if defined (BUILD_WIN32)
-	&cntDoPerfCount,
-#elif defined (BUILD_SDL)
-	&cntDoPerfCount,
-#elif defined (_XBOX)
-	&cntDoPerfCount,
-#endif
-};
+	LARGE_INTEGER f;
+	QueryPerformanceFrequency(&f);
+
+	return f.QuadPart;
+}
+#else
+static INT64 PrfClock()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-#define PROFILE_LEN (sizeof(pProfileDo) / sizeof(pProfileDo[0]))
+static INT64 PrfClockRate()
+{
+	return 1000000;
+}
+#endif
 
 INT32 ProfileExit()
 {
 	IntInfoFree(&ProfileInfo);
 
-	if (!bProfileOkay || nProfileSelect >= PROFILE_LEN) {
+	if (!bProfileOkay) {
 		return 1;
 	}
 	bProfileOkay = false;
 
-	return pProfileDo[nProfileSelect]->ProfileExit();
+	if (bProfileOwnClock) {
+		BurnProfExit();
+		bProfileOwnClock = false;
+	}
+
+	return 0;
 }
 
 INT32 ProfileInit()
 {
-	INT32 nRet;
+	memset(PrfSubsys, 0, sizeof(PrfSubsys));
 
-	if (nProfileSelect >= PROFILE_LEN) {
-		return 1;
+	// the frontend may have started the core profiler already, share its clock then
+	if (BurnProfClock == NULL) {
+		BurnProfInit(PrfClock, PrfClockRate());
+		bProfileOwnClock = true;
 	}
 
-	if ((nRet = pProfileDo[nProfileSelect]->ProfileInit()) == 0) {
-		bProfileOkay = true;
-	}
+#ifdef PRINT_DEBUG_INFO
+   	dprintf(_T("*** Profiler initialised (timer frequency is %.2lf MHz).\n"), (double)nBurnProfClockRate / 1000000.0);
+#endif
 
-	return nRet;
+	bProfileOkay = true;
+
+	return 0;
 }
 
 INT32 ProfileProfileStart(INT32 nSubSystem)
 {
-	if (!bProfileOkay || nProfileSelect >= PROFILE_LEN) {
+	if (!bProfileOkay || BurnProfClock == NULL || nSubSystem < 0 || nSubSystem >= PRF_SUBSYSTEMS) {
 		return 1;
 	}
 
-	return pProfileDo[nProfileSelect]->ProfileStart(nSubSystem);
+	BurnProfBegin(BURN_PROF_USER0 + nSubSystem);
+	PrfSubsys[nSubSystem].nStart = nBurnProfTime[BURN_PROF_USER0 + nSubSystem];
+
+	return 0;
 }
 
 INT32 ProfileProfileEnd(INT32 nSubSystem)
 {
-	if (!bProfileOkay || nProfileSelect >= PROFILE_LEN) {
+	if (!bProfileOkay || BurnProfClock == NULL || nSubSystem < 0 || nSubSystem >= PRF_SUBSYSTEMS) {
 		return 1;
 	}
 
-	return pProfileDo[nProfileSelect]->ProfileEnd(nSubSystem);
+	BurnProfEnd();
+
+	INT32 i = (PrfSubsys[nSubSystem].nIndex + 1) % PRF_SAMPLES;
+	INT64 nSample = nBurnProfTime[BURN_PROF_USER0 + nSubSystem] - PrfSubsys[nSubSystem].nStart;
+
+	PrfSubsys[nSubSystem].nTally += nSample - PrfSubsys[nSubSystem].nSample[i];
+	PrfSubsys[nSubSystem].nSample[i] = nSample;
+	PrfSubsys[nSubSystem].nIndex = i;
+
+	return 0;
 }
 
+// Times are reported in milliseconds
 double ProfileProfileReadLast(INT32 nSubSystem)
 {
-	if (!bProfileOkay || nProfileSelect >= PROFILE_LEN) {
+	if (!bProfileOkay || nSubSystem < 0 || nSubSystem >= PRF_SUBSYSTEMS) {
 		return 0.0;
 	}
 
-	return pProfileDo[nProfileSelect]->ProfileReadLast(nSubSystem);
+	return (double)PrfSubsys[nSubSystem].nSample[PrfSubsys[nSubSystem].nIndex] * 1000.0 / nBurnProfClockRate;
 }
 
 double ProfileProfileReadAverage(INT32 nSubSystem)
 {
-	if (!bProfileOkay || nProfileSelect >= PROFILE_LEN) {
+	if (!bProfileOkay || nSubSystem < 0 || nSubSystem >= PRF_SUBSYSTEMS) {
 		return 0.0;
 	}
 
-	return pProfileDo[nProfileSelect]->ProfileReadAverage(nSubSystem);
+	return (double)PrfSubsys[nSubSystem].nTally / PRF_SAMPLES * 1000.0 / nBurnProfClockRate;
 }
 
 InterfaceInfo* ProfileGetInfo()
@@ -98,12 +139,12 @@ InterfaceInfo* ProfileGetInfo()
 	}
 
 	if (bProfileOkay) {
+		TCHAR szString[MAX_PATH] = _T("");
 
-		ProfileInfo.pszModuleName = pProfileDo[nProfileSelect]->szModuleName;
+		ProfileInfo.pszModuleName = _T("Core profiler");
 
-	 	if (pProfileDo[nProfileSelect]->GetPluginSettings) {
-			pProfileDo[nProfileSelect]->GetPluginSettings(&ProfileInfo);
-		}
+		_sntprintf(szString, MAX_PATH, _T("timer frequency is %.2lfMHz\n"), (double)nBurnProfClockRate / 1000000.0);
+		IntInfoAddStringModule(&ProfileInfo, szString);
 	} else {
 		IntInfoAddStringInterface(&ProfileInfo, _T("Profiling module not initialised"));
 	}